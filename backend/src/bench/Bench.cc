@@ -0,0 +1,187 @@
+#include "Bench.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+namespace bench {
+
+namespace {
+
+const char* BENCH_USAGE =
+    "usage: webdatabase_backend bench <command> [--key value ...]\n"
+    "load     open-loop HTTP load against a running server, p50/p99/max per path\n"
+    "         --url http://127.0.0.1:8080 --user bench --password bench-password\n"
+    "         --path /api/protected/metrics,/api/protected/configs?limit=20\n"
+    "         --rate 200 --seconds 10 --connections 8\n"
+    "         --stall-db CONNINFO [--stall-table database_configs] [--stall-ms 500] [--stall-every-ms 2000]\n"
+    "             держит LOCK TABLE в отдельной транзакции: запросы к таблице ждут stall-ms\n"
+    "jwt      JwtAuthFilter in process: new tokens vs one repeated token, hits and misses\n"
+    "         --requests 20000 --jwt-secret your-secret-key\n"
+    "ddl      DdlCompiler on a synthetic schema, both dialects, from JSON and from CompactSchema\n"
+    "         --tables 5000 --columns 20 --runs 5\n"
+    "config   GET /configs body from PostgreSQL rows: JSONB spliced vs parsed and reserialized\n"
+    "         --db CONNINFO --tables 300 --columns 40 --rows 20 --runs 5\n"
+    "patch    table drags as PUT bodies vs JSON Patch: bytes, edit parameter, apply time\n"
+    "         --tables 1000 --columns 12 --moves 20\n"
+    "patch-write  the same drags against a running server: WAL bytes and latency per request\n"
+    "         --url ... --user ... --password ... --db CONNINFO --tables 1000 --columns 12 --requests 20\n"
+    "compact  Json::Value vs CompactSchema: heap size, validate, compile and diff times\n"
+    "         --tables 1000 --columns 12 --runs 5\n";
+
+} // namespace
+
+Args::Args(int argc, char* argv[]) {
+    for (int i = 0; i < argc; ++i) {
+        std::string key = argv[i];
+        if (key.rfind("--", 0) != 0 || i + 1 >= argc) {
+            throw std::invalid_argument("Expected --key value, got " + key);
+        }
+        values[key.substr(2)] = argv[++i];
+    }
+}
+
+std::string Args::get(const std::string& key, const std::string& fallback) const {
+    auto it = values.find(key);
+    return it == values.end() ? fallback : it->second;
+}
+
+int64_t Args::getInt(const std::string& key, int64_t fallback) const {
+    auto it = values.find(key);
+    return it == values.end() ? fallback : std::stoll(it->second);
+}
+
+double Args::getDouble(const std::string& key, double fallback) const {
+    auto it = values.find(key);
+    return it == values.end() ? fallback : std::stod(it->second);
+}
+
+double Samples::percentile(double p) const {
+    if (values.empty()) {
+        return 0;
+    }
+    std::vector<double> sorted = values;
+    size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    size_t index = std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0);
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(index), sorted.end());
+    return sorted[index];
+}
+
+std::string Samples::summary() const {
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), "n=%zu p50=%.2f p99=%.2f max=%.2f ms",
+                  values.size(), percentile(0.5), percentile(0.99), percentile(1.0));
+    return buffer;
+}
+
+Json::Value syntheticSchema(int tables, int columns) {
+    static const char* TYPES[] = {"integer", "varchar(255)", "timestamp"};
+    Json::Value schema;
+    schema["tables"] = Json::Value(Json::arrayValue);
+    schema["relations"] = Json::Value(Json::arrayValue);
+    for (int t = 0; t < tables; ++t) {
+        std::string tableId = "t" + std::to_string(t);
+        Json::Value table;
+        table["id"] = tableId;
+        table["name"] = "table_" + std::to_string(t);
+        table["position"]["x"] = (t % 50) * 240;
+        table["position"]["y"] = (t / 50) * 320;
+        Json::Value& list = table["columns"] = Json::Value(Json::arrayValue);
+        for (int c = 0; c < columns; ++c) {
+            Json::Value column;
+            column["id"] = tableId + "c" + std::to_string(c);
+            column["isPrimaryKey"] = c == 0;
+            column["isNotNull"] = c == 0 || c % 2 == 0;
+            if (c == 0) {
+                column["name"] = "id";
+                column["type"] = "integer";
+            } else if (c == 1 && t > 0) {
+                std::string parentId = "t" + std::to_string((t - 1) / 2);
+                column["name"] = "parent_id";
+                column["type"] = "integer";
+                column["references"]["tableId"] = parentId;
+                column["references"]["columnId"] = parentId + "c0";
+                column["references"]["type"] = "one-to-many";
+                Json::Value relation;
+                relation["sourceId"] = tableId + "-" + column["id"].asString();
+                relation["targetId"] = parentId + "-" + parentId + "c0";
+                relation["type"] = "one-to-many";
+                schema["relations"].append(relation);
+            } else {
+                column["name"] = "col_" + std::to_string(c);
+                column["type"] = TYPES[c % 3];
+            }
+            list.append(column);
+        }
+        schema["tables"].append(table);
+    }
+    return schema;
+}
+
+Json::Value dragOperations(const Json::Value& tables, Json::ArrayIndex table, int x, int y) {
+    std::string path = "/tables/" + std::to_string(table);
+    Json::Value operations(Json::arrayValue);
+    Json::Value test;
+    test["op"] = "test";
+    test["path"] = path + "/id";
+    test["value"] = tables[table]["id"];
+    operations.append(test);
+    for (auto [axis, value] : {std::pair<const char*, int>("x", x), std::pair<const char*, int>("y", y)}) {
+        Json::Value replace;
+        replace["op"] = "replace";
+        replace["path"] = path + "/position/" + axis;
+        replace["value"] = value;
+        operations.append(replace);
+    }
+    return operations;
+}
+
+double medianMillis(int runs, const std::function<void()>& fn) {
+    Samples samples;
+    for (int i = 0; i < std::max(runs, 1); ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        samples.add(std::chrono::steady_clock::now() - start);
+    }
+    return samples.percentile(0.5);
+}
+
+int runBenchCommand(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << BENCH_USAGE;
+        return 2;
+    }
+    std::string command = argv[0];
+    try {
+        Args args(argc - 1, argv + 1);
+        if (command == "load") {
+            return runLoad(args);
+        }
+        if (command == "jwt") {
+            return runJwt(args);
+        }
+        if (command == "ddl") {
+            return runDdl(args);
+        }
+        if (command == "config") {
+            return runConfig(args);
+        }
+        if (command == "patch") {
+            return runPatch(args);
+        }
+        if (command == "patch-write") {
+            return runPatchWrite(args);
+        }
+        if (command == "compact") {
+            return runCompact(args);
+        }
+    } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << "\n";
+    }
+    std::cerr << BENCH_USAGE;
+    return 2;
+}
+
+} // namespace bench
@@ -0,0 +1,65 @@
+#pragma once
+#include <json/json.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// webdatabase_backend bench <команда> [--ключ значение ...]: воспроизводимые замеры
+// производительности. Результаты печатаются в stdout, код возврата 2 - неверные аргументы
+int runBenchCommand(int argc, char* argv[]);
+
+// Аргументы вида --ключ значение; бросает invalid_argument на ключе без значения
+class Args {
+public:
+    Args(int argc, char* argv[]);
+
+    bool has(const std::string& key) const { return values.count(key) > 0; }
+    std::string get(const std::string& key, const std::string& fallback = "") const;
+    int64_t getInt(const std::string& key, int64_t fallback) const;
+    double getDouble(const std::string& key, double fallback) const;
+
+private:
+    std::map<std::string, std::string> values;
+};
+
+// Длительности замеров в миллисекундах
+class Samples {
+public:
+    void add(double millis) { values.push_back(millis); }
+    void add(std::chrono::steady_clock::duration elapsed) {
+        add(std::chrono::duration<double, std::milli>(elapsed).count());
+    }
+    size_t size() const { return values.size(); }
+    // p от 0 до 1, ближайший ранг; 0 без замеров
+    double percentile(double p) const;
+    // "n=... p50=... p99=... max=... ms"
+    std::string summary() const;
+
+private:
+    std::vector<double> values;
+};
+
+// Схема в формате конструктора: tables таблиц по columns колонок. У каждой таблицы
+// кроме первой parent_id с FK на таблицу (i - 1) / 2 и связь в relations
+Json::Value syntheticSchema(int tables, int columns);
+
+// Перетаскивание таблицы в конструкторе как JSON Patch: test ее id и replace position.x/y
+Json::Value dragOperations(const Json::Value& tables, Json::ArrayIndex table, int x, int y);
+
+// Медиана времени runs запусков fn в миллисекундах
+double medianMillis(int runs, const std::function<void()>& fn);
+
+int runLoad(const Args& args);
+int runJwt(const Args& args);
+int runDdl(const Args& args);
+int runConfig(const Args& args);
+int runPatch(const Args& args);
+int runPatchWrite(const Args& args);
+int runCompact(const Args& args);
+
+} // namespace bench
@@ -0,0 +1,61 @@
+#include <drogon/orm/DbClient.h>
+#include <cstdio>
+#include "Bench.h"
+#include "../models/DatabaseConfig.h"
+
+namespace bench {
+
+// Список конфигураций двумя способами: writeJson вставляет текст JSONB как есть,
+// toJson разбирает его в дерево и сериализует заново (как было до ленивого разбора).
+// Строки берутся из PostgreSQL, чтобы config был именно тем текстом, что отдает jsonb
+int runConfig(const Args& args) {
+    if (!args.has("db")) {
+        throw std::invalid_argument("--db CONNINFO is required");
+    }
+    int tables = static_cast<int>(args.getInt("tables", 300));
+    int columns = static_cast<int>(args.getInt("columns", 40));
+    int64_t rowCount = args.getInt("rows", 20);
+    int runs = static_cast<int>(args.getInt("runs", 5));
+    if (tables < 1 || columns < 2 || rowCount < 1) {
+        throw std::invalid_argument("--tables and --rows must be positive and --columns at least 2");
+    }
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    std::string configText = Json::writeString(writer, syntheticSchema(tables, columns));
+
+    auto db = drogon::orm::DbClient::newPgClient(args.get("db"), 1);
+    auto rows = db->execSqlSync(
+        "SELECT g AS id, 1 AS user_id, 'bench' AS name, $1::jsonb AS config, "
+        "now()::text AS created_at, now()::text AS updated_at FROM generate_series(1, $2::int) g",
+        configText, static_cast<int>(rowCount));
+
+    size_t splicedBytes = 0;
+    double spliced = medianMillis(runs, [&] {
+        std::string body = "[";
+        for (const auto& row : rows) {
+            if (body.size() > 1) {
+                body += ',';
+            }
+            models::DatabaseConfig(row).writeJson(body);
+        }
+        body += ']';
+        splicedBytes = body.size();
+    });
+    size_t treeBytes = 0;
+    double tree = medianMillis(runs, [&] {
+        Json::Value list(Json::arrayValue);
+        for (const auto& row : rows) {
+            list.append(models::DatabaseConfig(row).toJson());
+        }
+        treeBytes = Json::writeString(writer, list).size();
+    });
+
+    double perRow = static_cast<double>(rowCount);
+    std::printf("config: %lld rows, %zu bytes of JSONB each\n",
+                static_cast<long long>(rowCount), rows[0]["config"].as<std::string>().size());
+    std::printf("writeJson (splice)       %8.2f ms/row, %zu bytes\n", spliced / perRow, splicedBytes);
+    std::printf("toJson + serialize       %8.2f ms/row, %zu bytes\n", tree / perRow, treeBytes);
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,102 @@
+#include "HttpSession.h"
+#include <trantor/net/EventLoopThread.h>
+#include <stdexcept>
+
+namespace bench {
+
+namespace {
+
+const double REQUEST_TIMEOUT_SEC = 60;
+
+Json::Value credentials(const std::string& user, const std::string& password) {
+    Json::Value body;
+    body["username"] = user;
+    body["password"] = password;
+    return body;
+}
+
+} // namespace
+
+HttpSession::HttpSession(const Args& args)
+    : url(args.get("url", "http://127.0.0.1:8080")),
+      loopThread(std::make_unique<trantor::EventLoopThread>("BenchClient")) {
+    loopThread->run();
+    client = newClient();
+
+    std::string username = args.get("user", "bench");
+    Json::Value body = credentials(username, args.get("password", "bench-password"));
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    auto response = send(newRequest(drogon::Post, "/api/auth/login", Json::writeString(writer, body)));
+    if (response->getStatusCode() == drogon::k401Unauthorized) {
+        body["email"] = username + "@bench.local";
+        response = send(newRequest(drogon::Post, "/api/auth/register", Json::writeString(writer, body)));
+    }
+    auto json = response->getJsonObject();
+    if (response->getStatusCode() != drogon::k200OK || !json || !(*json)["token"].isString()) {
+        throw std::runtime_error("Cannot log in as " + username + ": " + std::string(response->getBody()));
+    }
+    bearer = (*json)["token"].asString();
+    user = (*json)["user"]["id"].asInt();
+}
+
+HttpSession::~HttpSession() {
+    client.reset();
+}
+
+trantor::EventLoop* HttpSession::loop() const {
+    return loopThread->getLoop();
+}
+
+drogon::HttpClientPtr HttpSession::newClient() const {
+    return drogon::HttpClient::newHttpClient(url, loop());
+}
+
+drogon::HttpRequestPtr HttpSession::newRequest(drogon::HttpMethod method, const std::string& path,
+                                               std::string body) const {
+    auto request = drogon::HttpRequest::newHttpRequest();
+    request->setMethod(method);
+    size_t query = path.find('?');
+    request->setPath(path.substr(0, query));
+    while (query != std::string::npos) {
+        size_t start = query + 1;
+        query = path.find('&', start);
+        std::string pair = path.substr(start, query == std::string::npos ? std::string::npos : query - start);
+        size_t eq = pair.find('=');
+        request->setParameter(pair.substr(0, eq), eq == std::string::npos ? "" : pair.substr(eq + 1));
+    }
+    if (!bearer.empty()) {
+        request->addHeader("Authorization", "Bearer " + bearer);
+    }
+    if (!body.empty()) {
+        request->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+        request->setBody(std::move(body));
+    }
+    return request;
+}
+
+drogon::HttpResponsePtr HttpSession::send(const drogon::HttpRequestPtr& request) const {
+    auto [result, response] = client->sendRequest(request, REQUEST_TIMEOUT_SEC);
+    if (result != drogon::ReqResult::Ok || !response) {
+        throw std::runtime_error("Request to " + url + std::string(request->path()) + " failed, ReqResult " +
+                                 std::to_string(static_cast<int>(result)));
+    }
+    return response;
+}
+
+Json::Value HttpSession::sendJson(const drogon::HttpRequestPtr& request) const {
+    auto response = send(request);
+    auto json = response->getJsonObject();
+    int status = response->getStatusCode();
+    if (status < 200 || status >= 300 || !json) {
+        throw std::runtime_error(std::string(request->path()) + " answered " + std::to_string(status) + ": " +
+                                 std::string(response->getBody()));
+    }
+    return *json;
+}
+
+Json::Value HttpSession::metrics() const {
+    return sendJson(newRequest(drogon::Get, "/api/protected/metrics"));
+}
+
+} // namespace bench
@@ -0,0 +1,48 @@
+#pragma once
+#include <drogon/HttpClient.h>
+#include <json/json.h>
+#include <memory>
+#include <string>
+#include "Bench.h"
+
+namespace trantor {
+class EventLoopThread;
+}
+
+namespace bench {
+
+// Клиент запущенного сервера для команд bench: свой event loop и токен
+// пользователя --user (регистрируется, если войти не удалось). Синхронные
+// методы нельзя вызывать из потока loop()
+class HttpSession {
+public:
+    // --url (http://127.0.0.1:8080), --user, --password
+    explicit HttpSession(const Args& args);
+    ~HttpSession();
+
+    const std::string& token() const { return bearer; }
+    int userId() const { return user; }
+    trantor::EventLoop* loop() const;
+
+    // Отдельное соединение на общем loop
+    drogon::HttpClientPtr newClient() const;
+    // path может содержать ?a=b&c=d - параметры переносятся в запрос. До входа - без Authorization
+    drogon::HttpRequestPtr newRequest(drogon::HttpMethod method, const std::string& path,
+                                      std::string body = "") const;
+    // Бросает runtime_error при сетевой ошибке
+    drogon::HttpResponsePtr send(const drogon::HttpRequestPtr& request) const;
+    // Ответ 2xx с JSON; иначе runtime_error со статусом и телом
+    Json::Value sendJson(const drogon::HttpRequestPtr& request) const;
+
+    // GET /api/protected/metrics
+    Json::Value metrics() const;
+
+private:
+    std::string url;
+    std::unique_ptr<trantor::EventLoopThread> loopThread;
+    drogon::HttpClientPtr client;
+    std::string bearer;
+    int user = 0;
+};
+
+} // namespace bench
@@ -0,0 +1,83 @@
+#include <drogon/HttpRequest.h>
+#include <jwt-cpp/jwt.h>
+#include <cstdio>
+#include <iostream>
+#include "Bench.h"
+#include "../filters/JwtAuthFilter.h"
+
+namespace bench {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Токен с теми же claims, что выдает AuthController::generateToken
+std::string mintToken(const std::string& secret, int userId) {
+    auto now = std::chrono::system_clock::now();
+    return jwt::create()
+        .set_issuer("auth0")
+        .set_type("JWS")
+        .set_issued_at(now)
+        .set_expires_at(now + std::chrono::hours{24})
+        .set_payload_claim("user_id", jwt::claim(std::to_string(userId)))
+        .set_payload_claim("username", jwt::claim("bench" + std::to_string(userId)))
+        .sign(jwt::algorithm::hs256{secret});
+}
+
+// Время одного JwtAuthFilter::authenticate в микросекундах; бросает, если токен отвергнут
+double authenticateMicros(const std::string& token) {
+    auto request = drogon::HttpRequest::newHttpRequest();
+    bool passed = false;
+    Clock::time_point start = Clock::now();
+    JwtAuthFilter::authenticate(
+        request, token,
+        [](const drogon::HttpResponsePtr&) {},
+        [&passed]() { passed = true; });
+    double micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    if (!passed) {
+        throw std::runtime_error("Token rejected; --jwt-secret must match JwtAuthFilter");
+    }
+    return micros;
+}
+
+void report(const char* name, const Samples& samples, const Json::Value& before, const Json::Value& after) {
+    std::printf("%-9s n=%zu p50=%.2f p99=%.2f max=%.2f us  hits=%llu misses=%llu\n",
+                name, samples.size(), samples.percentile(0.5), samples.percentile(0.99), samples.percentile(1.0),
+                static_cast<unsigned long long>(after["hits"].asUInt64() - before["hits"].asUInt64()),
+                static_cast<unsigned long long>(after["misses"].asUInt64() - before["misses"].asUInt64()));
+}
+
+} // namespace
+
+// Проверка токена фильтром в процессе, без сети: uncached - каждый токен новый
+// (полный decode и HS256), cached - один и тот же токен (поиск по SHA-256 в кэше)
+int runJwt(const Args& args) {
+    int64_t count = args.getInt("requests", 20000);
+    if (count < 1) {
+        throw std::invalid_argument("--requests must be positive");
+    }
+    // Секрет как JWT_SECRET в AuthController и JwtAuthFilter
+    std::string secret = args.get("jwt-secret", "your-secret-key");
+    std::vector<std::string> tokens;
+    tokens.reserve(static_cast<size_t>(count));
+    for (int64_t i = 0; i < count; ++i) {
+        tokens.push_back(mintToken(secret, static_cast<int>(i + 1)));
+    }
+
+    Samples uncached;
+    Json::Value before = JwtAuthFilter::cacheMetrics();
+    for (const auto& token : tokens) {
+        uncached.add(authenticateMicros(token));
+    }
+    Json::Value middle = JwtAuthFilter::cacheMetrics();
+    report("uncached", uncached, before, middle);
+
+    Samples cached;
+    for (int64_t i = 0; i < count; ++i) {
+        cached.add(authenticateMicros(tokens.back()));
+    }
+    report("cached", cached, middle, JwtAuthFilter::cacheMetrics());
+    return 0;
+}
+
+} // namespace bench
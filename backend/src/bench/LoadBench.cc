@@ -0,0 +1,177 @@
+#include <drogon/orm/DbClient.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+#include "Bench.h"
+#include "HttpSession.h"
+#include "../sql/SchemaValidator.h"
+
+namespace bench {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct PathResult {
+    std::string path;
+    Samples latency;
+    size_t errors = 0;
+};
+
+// Раз в every держит ACCESS EXCLUSIVE блокировку таблицы в течение hold:
+// все запросы к ней в это время ждут, как при медленной базе
+class DbStaller {
+public:
+    DbStaller(const std::string& connInfo, std::string table,
+              std::chrono::milliseconds hold, std::chrono::milliseconds every)
+        : db(drogon::orm::DbClient::newPgClient(connInfo, 1)), table(std::move(table)),
+          hold(hold), every(every), thread([this] { run(); }) {}
+
+    ~DbStaller() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopped = true;
+        }
+        wake.notify_all();
+        thread.join();
+    }
+
+    size_t stalls() const { return count; }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!wake.wait_for(lock, every - hold, [this] { return stopped; })) {
+            try {
+                auto transaction = db->newTransaction();
+                transaction->execSqlSync("LOCK TABLE " + table + " IN ACCESS EXCLUSIVE MODE");
+                ++count;
+                // Блокировка снимается фиксацией транзакции при ее удалении
+                wake.wait_for(lock, hold, [this] { return stopped; });
+            } catch (const std::exception& e) {
+                std::cerr << "stall failed: " << e.what() << "\n";
+            }
+        }
+    }
+
+    drogon::orm::DbClientPtr db;
+    std::string table;
+    std::chrono::milliseconds hold;
+    std::chrono::milliseconds every;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopped = false;
+    std::atomic<size_t> count{0};
+    std::thread thread;
+};
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    for (size_t start = 0; start < list.size();) {
+        size_t end = std::min(list.find(',', start), list.size());
+        if (end > start) {
+            items.push_back(list.substr(start, end - start));
+        }
+        start = end + 1;
+    }
+    return items;
+}
+
+} // namespace
+
+// Открытая модель нагрузки: запросы уходят по пуассоновскому расписанию независимо
+// от ответов, задержка считается от запланированного момента отправки. Поэтому
+// очередь за зависшим соединением или IO-потоком попадает в p99, а не прячется
+int runLoad(const Args& args) {
+    double rate = args.getDouble("rate", 200);
+    double seconds = args.getDouble("seconds", 10);
+    int64_t connections = args.getInt("connections", 8);
+    std::vector<std::string> paths =
+        splitList(args.get("path", "/api/protected/metrics,/api/protected/configs?limit=20"));
+    if (rate <= 0 || seconds <= 0 || connections < 1 || paths.empty()) {
+        throw std::invalid_argument("--rate, --seconds and --connections must be positive");
+    }
+
+    HttpSession session(args);
+    std::vector<drogon::HttpClientPtr> clients;
+    for (int64_t i = 0; i < connections; ++i) {
+        clients.push_back(session.newClient());
+    }
+
+    std::unique_ptr<DbStaller> staller;
+    if (args.has("stall-db")) {
+        std::string table = args.get("stall-table", "database_configs");
+        if (!sql::SchemaValidator::isValidIdentifier(sql::Dialect::PostgreSQL, table)) {
+            throw std::invalid_argument("Invalid --stall-table " + table);
+        }
+        std::chrono::milliseconds hold(args.getInt("stall-ms", 500));
+        std::chrono::milliseconds every(args.getInt("stall-every-ms", 2000));
+        if (hold.count() <= 0 || every <= hold) {
+            throw std::invalid_argument("--stall-every-ms must be longer than --stall-ms");
+        }
+        staller = std::make_unique<DbStaller>(args.get("stall-db"), table, hold, every);
+    }
+
+    std::vector<PathResult> results(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        results[i].path = paths[i];
+    }
+    std::mutex resultsMutex;
+    std::condition_variable allDone;
+    size_t pending = 0;
+
+    std::mt19937_64 random(args.getInt("seed", 1));
+    std::exponential_distribution<double> gap(rate);
+    Clock::time_point start = Clock::now();
+    Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+    Clock::time_point scheduled = start;
+    for (size_t sent = 0;; ++sent) {
+        scheduled += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(gap(random)));
+        if (scheduled >= end) {
+            break;
+        }
+        std::this_thread::sleep_until(scheduled);
+        size_t pathIndex = sent % paths.size();
+        {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            ++pending;
+        }
+        clients[sent % clients.size()]->sendRequest(
+            session.newRequest(drogon::Get, paths[pathIndex]),
+            [&, pathIndex, scheduled](drogon::ReqResult result, const drogon::HttpResponsePtr& response) {
+                Clock::duration elapsed = Clock::now() - scheduled;
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                PathResult& path = results[pathIndex];
+                path.latency.add(elapsed);
+                if (result != drogon::ReqResult::Ok || !response || response->getStatusCode() >= 400) {
+                    ++path.errors;
+                }
+                if (--pending == 0) {
+                    allDone.notify_all();
+                }
+            },
+            60);
+    }
+    {
+        std::unique_lock<std::mutex> lock(resultsMutex);
+        allDone.wait(lock, [&] { return pending == 0; });
+    }
+    size_t stalls = staller ? staller->stalls() : 0;
+    staller.reset();
+
+    std::cout << "load: " << rate << " req/s for " << seconds << " s over " << connections << " connections";
+    if (stalls > 0) {
+        std::cout << ", " << stalls << " DB stalls of " << args.getInt("stall-ms", 500) << " ms";
+    }
+    std::cout << "\n";
+    for (const auto& path : results) {
+        std::cout << path.path << "  " << path.latency.summary() << " errors=" << path.errors << "\n";
+    }
+    return 0;
+}
+
+} // namespace bench
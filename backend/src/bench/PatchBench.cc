@@ -0,0 +1,100 @@
+#include <drogon/orm/DbClient.h>
+#include <cstdio>
+#include "Bench.h"
+#include "HttpSession.h"
+#include "../utils/JsonPatch.h"
+
+namespace bench {
+
+namespace {
+
+// Объем WAL кластера с момента lsn; общий для всех баз, поэтому сервер не должен
+// в это время обслуживать другую нагрузку
+int64_t walSince(const drogon::orm::DbClientPtr& db, const std::string& lsn) {
+    return db->execSqlSync("SELECT pg_wal_lsn_diff(pg_current_wal_lsn(), $1::pg_lsn)::bigint", lsn)[0][0]
+        .as<int64_t>();
+}
+
+std::string currentWal(const drogon::orm::DbClientPtr& db) {
+    return db->execSqlSync("SELECT pg_current_wal_lsn()::text")[0][0].as<std::string>();
+}
+
+struct WriteResult {
+    Samples latency;
+    size_t requestBytes = 0;
+    int64_t walBytes = 0;
+};
+
+void report(const char* name, const WriteResult& result, int requests) {
+    std::printf("%-6s %7zu bytes/request, WAL %9lld bytes/request, %s\n", name,
+                result.requestBytes / static_cast<size_t>(requests),
+                static_cast<long long>(result.walBytes / requests), result.latency.summary().c_str());
+}
+
+} // namespace
+
+// --requests перетаскиваний одной схемы через PUT, затем через PATCH. Запись в базу
+// оценивается приростом WAL (строка схемы, TOAST и история версий), задержка - по ответам
+int runPatchWrite(const Args& args) {
+    if (!args.has("db")) {
+        throw std::invalid_argument("--db CONNINFO of the server's database is required");
+    }
+    int tables = static_cast<int>(args.getInt("tables", 1000));
+    int columns = static_cast<int>(args.getInt("columns", 12));
+    int requests = static_cast<int>(args.getInt("requests", 20));
+    if (tables < 1 || columns < 2 || requests < 1) {
+        throw std::invalid_argument("--tables and --requests must be positive and --columns at least 2");
+    }
+    HttpSession session(args);
+    auto db = drogon::orm::DbClient::newPgClient(args.get("db"), 1);
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+
+    Json::Value document = syntheticSchema(tables, columns);
+    document["name"] = "bench patch";
+    document["description"] = "";
+    auto created = session.send(session.newRequest(drogon::Post, "/api/protected/schemas",
+                                                   Json::writeString(writer, document)));
+    auto createdJson = created->getJsonObject();
+    int createdStatus = created->getStatusCode();
+    if (!createdJson || (createdStatus != drogon::k201Created && createdStatus != drogon::k200OK)) {
+        throw std::runtime_error("Cannot create schema: " + std::string(created->getBody()));
+    }
+    std::string path = "/api/protected/schemas/" + (*createdJson)["id"].asString();
+    std::string etag = created->getHeader("ETag");
+
+    // Каждый запрос двигает следующую таблицу; новый ETag берется из ответа
+    auto run = [&](drogon::HttpMethod method) {
+        WriteResult result;
+        std::string lsn = currentWal(db);
+        for (int i = 0; i < requests; ++i) {
+            Json::ArrayIndex table = static_cast<Json::ArrayIndex>(i % tables);
+            Json::Value operations = dragOperations(document["tables"], table, i * 10, i * 5);
+            utils::JsonPatch(operations).apply(document);
+            std::string body = Json::writeString(writer, method == drogon::Put ? document : operations);
+            result.requestBytes += body.size();
+            auto request = session.newRequest(method, path, std::move(body));
+            request->addHeader("If-Match", etag);
+            auto start = std::chrono::steady_clock::now();
+            auto response = session.send(request);
+            result.latency.add(std::chrono::steady_clock::now() - start);
+            if (response->getStatusCode() != drogon::k200OK) {
+                throw std::runtime_error(path + " answered " + std::to_string(response->getStatusCode()) + ": " +
+                                         std::string(response->getBody()));
+            }
+            etag = response->getHeader("ETag");
+        }
+        result.walBytes = walSince(db, lsn);
+        return result;
+    };
+    WriteResult put = run(drogon::Put);
+    WriteResult patch = run(drogon::Patch);
+    session.send(session.newRequest(drogon::Delete, path));
+
+    std::printf("patch-write: %d tables x %d columns, %d drags each\n", tables, columns, requests);
+    report("PUT", put, requests);
+    report("PATCH", patch, requests);
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,194 @@
+#include <cstdio>
+#include <memory>
+#include <random>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "Bench.h"
+#include "../sql/CompactSchema.h"
+#include "../sql/DdlCompiler.h"
+#include "../sql/SchemaDiff.h"
+#include "../sql/SchemaValidator.h"
+#include "../utils/JsonPatch.h"
+
+namespace bench {
+
+namespace {
+
+std::string compactJson(const Json::Value& value) {
+    Json::StreamWriterBuilder writer;
+    writer["indentation"] = "";
+    return Json::writeString(writer, value);
+}
+
+// Параметр $3 запроса Schema::patchAsync: [{"p": путь внутри столбца, "v": значение}]
+Json::Value editParameter(const std::vector<utils::JsonPatch::Edit>& edits) {
+    Json::Value params(Json::arrayValue);
+    for (const auto& edit : edits) {
+        if (edit.path.empty() || (edit.path[0] != "tables" && edit.path[0] != "relations")) {
+            continue;
+        }
+        Json::Value param;
+        param["p"] = Json::Value(Json::arrayValue);
+        for (auto it = edit.path.begin() + 1; it != edit.path.end(); ++it) {
+            param["p"].append(*it);
+        }
+        param["v"] = edit.value;
+        params.append(std::move(param));
+    }
+    return params;
+}
+
+// Занятая память кучи в байтах; 0 - неизвестно (не glibc)
+size_t heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+} // namespace
+
+// DDL синтетической схемы: перегрузка с Json::Value (сборка CompactSchema внутри)
+// и с заранее собранной CompactSchema, медиана по --runs запускам
+int runDdl(const Args& args) {
+    int tables = static_cast<int>(args.getInt("tables", 5000));
+    int columns = static_cast<int>(args.getInt("columns", 20));
+    int runs = static_cast<int>(args.getInt("runs", 5));
+    if (tables < 1 || columns < 2) {
+        throw std::invalid_argument("--tables must be positive and --columns at least 2");
+    }
+    Json::Value schema = syntheticSchema(tables, columns);
+    const Json::Value& tableList = schema["tables"];
+    std::printf("ddl: %d tables x %d columns\n", tables, columns);
+
+    double build = medianMillis(runs, [&] { sql::CompactSchema compact(tableList); });
+    std::printf("build CompactSchema  %8.1f ms\n", build);
+    sql::CompactSchema compact(tableList);
+    for (sql::Dialect dialect : {sql::Dialect::PostgreSQL, sql::Dialect::MySQL}) {
+        sql::DdlCompiler compiler(dialect);
+        size_t bytes = 0;
+        double fromJson = medianMillis(runs, [&] { bytes = compiler.compile(tableList).size(); });
+        double fromCompact = medianMillis(runs, [&] { bytes = compiler.compile(compact).size(); });
+        std::printf("%-10s from JSON %8.1f ms, from CompactSchema %8.1f ms, %zu bytes\n",
+                    sql::dialectName(dialect), fromJson, fromCompact, bytes);
+    }
+    return 0;
+}
+
+// Перетаскивания таблиц: PUT всего документа против PATCH и пачки из --moves
+// перетаскиваний одним PATCH. Применение патча и копия документа - в памяти
+int runPatch(const Args& args) {
+    int tables = static_cast<int>(args.getInt("tables", 1000));
+    int columns = static_cast<int>(args.getInt("columns", 12));
+    int moves = static_cast<int>(args.getInt("moves", 20));
+    // 3 операции на перетаскивание, в PATCH не больше 1000 операций
+    if (tables < 1 || columns < 2 || moves < 1 || moves > 333) {
+        throw std::invalid_argument("--tables must be positive, --columns at least 2, --moves 1..333");
+    }
+    Json::Value document = syntheticSchema(tables, columns);
+    document["name"] = "bench";
+    document["description"] = "";
+    const Json::Value& tableList = document["tables"];
+
+    std::mt19937 random(1);
+    std::uniform_int_distribution<Json::ArrayIndex> pick(0, tableList.size() - 1);
+    Json::Value drag = dragOperations(tableList, pick(random), 120, 80);
+    Json::Value burst(Json::arrayValue);
+    for (int i = 0; i < moves; ++i) {
+        for (const auto& operation : dragOperations(tableList, pick(random), i * 10, i * 5)) {
+            burst.append(operation);
+        }
+    }
+
+    size_t putBytes = compactJson(document).size();
+    Json::Value patched = document;
+    std::vector<utils::JsonPatch::Edit> edits = utils::JsonPatch(drag).apply(patched);
+    std::vector<utils::JsonPatch::Edit> burstEdits = utils::JsonPatch(burst).apply(patched);
+
+    utils::JsonPatch dragPatch(drag);
+    double apply = medianMillis(1001, [&] { dragPatch.apply(patched); });
+    double copy = medianMillis(11, [&] { Json::Value copied = document; });
+
+    std::printf("patch: %d tables x %d columns\n", tables, columns);
+    std::printf("PUT body                    %9zu bytes\n", putBytes);
+    std::printf("PATCH one drag              %9zu bytes, edit parameter %zu bytes\n",
+                compactJson(drag).size(), compactJson(editParameter(edits)).size());
+    std::printf("PATCH burst of %3d drags    %9zu bytes, edit parameter %zu bytes; %d PUTs %zu bytes\n",
+                moves, compactJson(burst).size(), compactJson(editParameter(burstEdits)).size(),
+                moves, putBytes * static_cast<size_t>(moves));
+    std::printf("apply one drag              %9.1f us\n", apply * 1000);
+    std::printf("deep copy of the document   %9.1f ms\n", copy);
+    return 0;
+}
+
+// Json::Value против CompactSchema на одной схеме: память дерева и компактной
+// схемы, затем validate, compile и diff через перегрузки с Json::Value (каждая
+// собирает CompactSchema заново) и по заранее собранным CompactSchema
+int runCompact(const Args& args) {
+    int tables = static_cast<int>(args.getInt("tables", 1000));
+    int columns = static_cast<int>(args.getInt("columns", 12));
+    int runs = static_cast<int>(args.getInt("runs", 5));
+    if (tables < 1 || columns < 3) {
+        throw std::invalid_argument("--tables must be positive and --columns at least 3");
+    }
+    std::string text = compactJson(syntheticSchema(tables, columns));
+
+    size_t before = heapInUse();
+    auto document = std::make_unique<Json::Value>();
+    Json::CharReaderBuilder builder;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    std::string errors;
+    if (!reader->parse(text.data(), text.data() + text.size(), document.get(), &errors)) {
+        throw std::runtime_error("Synthetic schema is not JSON: " + errors);
+    }
+    size_t treeBytes = heapInUse() - before;
+    const Json::Value& tableList = (*document)["tables"];
+    const Json::Value& relations = (*document)["relations"];
+    before = heapInUse();
+    auto compact = std::make_unique<sql::CompactSchema>(tableList, relations);
+    size_t compactBytes = heapInUse() - before;
+
+    // Вторая версия для diff: переименованная колонка и новый тип в каждой десятой таблице
+    Json::Value changed = tableList;
+    for (Json::ArrayIndex t = 0; t < changed.size(); t += 10) {
+        changed[t]["columns"][2]["name"] = "renamed_" + std::to_string(t);
+        changed[t]["columns"][2]["type"] = "bigint";
+    }
+    sql::CompactSchema changedCompact(changed);
+
+    sql::SchemaValidator validator(sql::Dialect::PostgreSQL);
+    sql::DdlCompiler compiler(sql::Dialect::PostgreSQL);
+    sql::SchemaDiff differ(sql::Dialect::PostgreSQL);
+    double build = medianMillis(runs, [&] { sql::CompactSchema schema(tableList, relations); });
+    double validateJson = medianMillis(runs, [&] { validator.validate(tableList, relations); });
+    double validateCompact = medianMillis(runs, [&] { validator.validate(*compact); });
+    double compileJson = medianMillis(runs, [&] { compiler.compile(tableList); });
+    double compileCompact = medianMillis(runs, [&] { compiler.compile(*compact); });
+    double diffJson = medianMillis(runs, [&] { differ.diff(tableList, changed); });
+    double diffCompact = medianMillis(runs, [&] { differ.diff(*compact, changedCompact); });
+    double passesJson = medianMillis(runs, [&] {
+        validator.validate(tableList, relations);
+        compiler.compile(tableList);
+    });
+    double passesCompact = medianMillis(runs, [&] {
+        sql::CompactSchema schema(tableList, relations);
+        validator.validate(schema);
+        compiler.compile(schema);
+    });
+
+    std::printf("compact: %d tables x %d columns, %zu bytes of JSON\n", tables, columns, text.size());
+    if (treeBytes > 0) {
+        std::printf("memory    Json::Value %8.1f MiB, CompactSchema %8.1f MiB\n",
+                    treeBytes / 1048576.0, compactBytes / 1048576.0);
+    }
+    std::printf("build                                   %8.1f ms\n", build);
+    std::printf("validate  JSON %8.1f ms, CompactSchema %8.1f ms\n", validateJson, validateCompact);
+    std::printf("compile   JSON %8.1f ms, CompactSchema %8.1f ms\n", compileJson, compileCompact);
+    std::printf("diff      JSON %8.1f ms, CompactSchema %8.1f ms\n", diffJson, diffCompact);
+    std::printf("validate + compile: JSON twice %8.1f ms, one build %8.1f ms\n", passesJson, passesCompact);
+    return 0;
+}
+
+} // namespace bench
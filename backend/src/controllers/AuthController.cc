@@ -1,7 +1,8 @@
 #include "AuthController.h"
 #include "../models/User.h"
-#include <bcrypt/BCrypt.hpp>
+#include "../services/PasswordHasher.h"
 #include <chrono>
+#include <memory>
 
 const std::string AuthController::JWT_SECRET = "your-secret-key"; // В production использовать безопасный ключ
 
@@ -18,22 +19,47 @@ void AuthController::login(const HttpRequestPtr& req,
     std::string username = (*json)["username"].asString();
     std::string password = (*json)["password"].asString();
 
-    auto user = models::User::findByUsername(username);
-    if (!user || !models::User::validatePassword(password, user->getPasswordHash())) {
-        auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Invalid credentials"));
-        resp->setStatusCode(k401Unauthorized);
-        callback(resp);
-        return;
-    }
+    auto callbackPtr = std::make_shared<std::function<void(const HttpResponsePtr&)>>(std::move(callback));
+    models::User::findByUsernameAsync(
+        username,
+        [this, callbackPtr, password](std::optional<models::User> user) {
+            if (!user) {
+                auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Invalid credentials"));
+                resp->setStatusCode(k401Unauthorized);
+                (*callbackPtr)(resp);
+                return;
+            }
 
-    std::string token = generateToken(std::to_string(user->getId()), user->getUsername());
-    
-    Json::Value result;
-    result["token"] = token;
-    result["user"] = user->toJson();
-    
-    auto resp = HttpResponse::newHttpJsonResponse(result);
-    callback(resp);
+            // bcrypt выполняется в отдельном пуле, IO-поток не блокируется
+            std::string passwordHash = user->getPasswordHash();
+            bool queued = services::PasswordHasher::validateAsync(
+                password, passwordHash,
+                [this, callbackPtr, found = std::move(*user)](bool valid) {
+                    if (!valid) {
+                        auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Invalid credentials"));
+                        resp->setStatusCode(k401Unauthorized);
+                        (*callbackPtr)(resp);
+                        return;
+                    }
+
+                    std::string token = generateToken(std::to_string(found.getId()), found.getUsername());
+
+                    Json::Value result;
+                    result["token"] = token;
+                    result["user"] = found.toJson();
+
+                    auto resp = HttpResponse::newHttpJsonResponse(result);
+                    (*callbackPtr)(resp);
+                });
+            if (!queued) {
+                respondBusy(*callbackPtr);
+            }
+        },
+        [callbackPtr](const std::exception& e) {
+            auto resp = HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
+            resp->setStatusCode(k500InternalServerError);
+            (*callbackPtr)(resp);
+        });
 }
 
 void AuthController::reg(const HttpRequestPtr& req,
@@ -50,28 +76,55 @@ void AuthController::reg(const HttpRequestPtr& req,
     std::string password = (*json)["password"].asString();
     std::string email = (*json)["email"].asString();
 
+    auto callbackPtr = std::make_shared<std::function<void(const HttpResponsePtr&)>>(std::move(callback));
+    auto onError = [callbackPtr](const std::exception& e) {
+        auto resp = HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
+        resp->setStatusCode(k500InternalServerError);
+        (*callbackPtr)(resp);
+    };
+
     // Проверяем существование пользователя
-    if (models::User::findByUsername(username)) {
-        auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Username already exists"));
-        resp->setStatusCode(k400BadRequest);
-        callback(resp);
-        return;
-    }
+    models::User::findByUsernameAsync(
+        username,
+        [this, callbackPtr, onError, username, password, email](std::optional<models::User> existing) {
+            if (existing) {
+                auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Username already exists"));
+                resp->setStatusCode(k400BadRequest);
+                (*callbackPtr)(resp);
+                return;
+            }
 
-    // Хэшируем пароль
-    std::string hashedPassword = BCrypt::generateHash(password);
-    
-    // Создаем пользователя
-    auto user = models::User::create(username, email, hashedPassword);
-    
-    // Генерируем токен
-    std::string token = generateToken(std::to_string(user.getId()), user.getUsername());
-    
-    Json::Value result;
-    result["token"] = token;
-    result["user"] = user.toJson();
-    
-    auto resp = HttpResponse::newHttpJsonResponse(result);
+            // Хэшируем пароль в пуле bcrypt
+            bool queued = services::PasswordHasher::hashAsync(
+                password,
+                [this, callbackPtr, onError, username, email](std::string hashedPassword) {
+                    // Создаем пользователя
+                    models::User::createAsync(
+                        username, email, hashedPassword,
+                        [this, callbackPtr](models::User user) {
+                            // Генерируем токен
+                            std::string token = generateToken(std::to_string(user.getId()), user.getUsername());
+
+                            Json::Value result;
+                            result["token"] = token;
+                            result["user"] = user.toJson();
+
+                            auto resp = HttpResponse::newHttpJsonResponse(result);
+                            (*callbackPtr)(resp);
+                        },
+                        onError);
+                });
+            if (!queued) {
+                respondBusy(*callbackPtr);
+            }
+        },
+        onError);
+}
+
+void AuthController::respondBusy(const std::function<void(const HttpResponsePtr&)>& callback) {
+    auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Server is busy, try again later"));
+    resp->setStatusCode(k503ServiceUnavailable);
+    resp->addHeader("Retry-After", "1");
     callback(resp);
 }
 
@@ -1,9 +1,81 @@
 #include "DeploymentController.h"
+#include "ListResponse.h"
 #include "../models/DatabaseConfig.h"
+#include "../models/ModelCache.h"
 #include "../models/User.h"
-#include <libssh/libssh.h>
-#include <sstream>
+#include "../models/Deployment.h"
+#include "../sql/DdlCompiler.h"
+#include "../sql/SchemaDiff.h"
+#include "../sql/SchemaValidator.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
 #include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace {
+
+// Строковый литерал SQL; в MySQL обратная косая черта тоже экранирует
+std::string sqlLiteral(const std::string& value, bool escapeBackslash) {
+    std::string literal = "'";
+    for (char c : value) {
+        if (c == '\'' || (escapeBackslash && c == '\\')) {
+            literal += c;
+        }
+        literal += c;
+    }
+    literal += '\'';
+    return literal;
+}
+
+// Идентификатор SQL в кавычках диалекта: "..." в PostgreSQL, `...` в MySQL
+std::string sqlIdentifier(const std::string& name, sql::Dialect dialect) {
+    char quote = dialect == sql::Dialect::MySQL ? '`' : '"';
+    std::string identifier(1, quote);
+    for (char c : name) {
+        if (c == quote) {
+            identifier += c;
+        }
+        identifier += c;
+    }
+    identifier += quote;
+    return identifier;
+}
+
+// Значение redis.conf в двойных кавычках: так его разбирает сам Redis
+std::string redisQuote(const std::string& value) {
+    std::string quoted = "\"";
+    for (unsigned char c : value) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+            quoted += static_cast<char>(c);
+        } else if (c < 0x20 || c == 0x7f) {
+            char escaped[5];
+            std::snprintf(escaped, sizeof(escaped), "\\x%02x", c);
+            quoted += escaped;
+        } else {
+            quoted += static_cast<char>(c);
+        }
+    }
+    return quoted + "\"";
+}
+
+bool isNumber(const std::string& value) {
+    return !value.empty() && value.size() <= 9 &&
+           std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c); });
+}
+
+// Пишет stdin шага в файл Redis и один раз подключает его в конце redis.conf
+std::string redisIncludeCommand(const std::string& file) {
+    std::string include = "include " + file;
+    return "sudo install -m 640 -o root -g redis /dev/stdin " + file + " && "
+           "(sudo grep -qxF '" + include + "' /etc/redis/redis.conf || "
+           "echo '" + include + "' | sudo tee -a /etc/redis/redis.conf >/dev/null)";
+}
+
+} // namespace
 
 void DeploymentController::saveConfig(const HttpRequestPtr& req,
                                     std::function<void(const HttpResponsePtr&)>&& callback) {
@@ -21,30 +93,54 @@ void DeploymentController::saveConfig(const HttpRequestPtr& req,
     std::string name = (*json)["name"].asString();
     Json::Value config = (*json)["config"];
 
-    try {
-        auto dbConfig = models::DatabaseConfig::create(userId, name, config);
-        auto resp = HttpResponse::newHttpJsonResponse(dbConfig.toJson());
-        callback(resp);
-    } catch (const std::exception& e) {
-        auto resp = HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
-        resp->setStatusCode(k500InternalServerError);
-        callback(resp);
-    }
+    auto callbackPtr = std::make_shared<std::function<void(const HttpResponsePtr&)>>(std::move(callback));
+    models::DatabaseConfig::createAsync(
+        userId, name, config,
+        [callbackPtr](models::DatabaseConfig dbConfig) {
+            auto resp = HttpResponse::newHttpJsonResponse(dbConfig.toJson());
+            (*callbackPtr)(resp);
+        },
+        [callbackPtr](const std::exception& e) {
+            auto resp = HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
+            resp->setStatusCode(k500InternalServerError);
+            (*callbackPtr)(resp);
+        });
 }
 
 void DeploymentController::getConfigs(const HttpRequestPtr& req,
                                     std::function<void(const HttpResponsePtr&)>&& callback) {
     auto userId = req->getAttributes()->get<int>("user_id");
-    
-    auto configs = models::DatabaseConfig::findByUserId(userId);
-    
-    Json::Value result(Json::arrayValue);
-    for (const auto& config : configs) {
-        result.append(config.toJson());
+
+    listing::ListRequest request;
+    std::string error = listing::parseListRequest(req, request);
+    if (!error.empty()) {
+        auto resp = HttpResponse::newHttpJsonResponse(Json::Value(error));
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
     }
-    
-    auto resp = HttpResponse::newHttpJsonResponse(result);
-    callback(resp);
+
+    // Список без параметров меняется только записями конфигураций пользователя
+    uint64_t generation = models::ModelCache::configListGeneration(userId);
+    if (!request.paged) {
+        if (auto body = models::ModelCache::configList(userId)) {
+            callback(listing::conditionalBody(request, *body));
+            return;
+        }
+    }
+
+    listing::ListSource<models::DatabaseConfig> source;
+    source.fetch = [userId](const std::optional<models::PageCursor>& after, size_t limit,
+                            std::function<void(std::vector<models::DatabaseConfig>)>&& onPage,
+                            models::DbErrorCallback&& onError) {
+        models::DatabaseConfig::findPageByUserIdAsync(userId, after, limit, std::move(onPage), std::move(onError));
+    };
+    source.cursor = [](const models::DatabaseConfig& config) { return config.getCursor(); };
+    source.write = [](const models::DatabaseConfig& config, std::string& out) { config.writeJson(out); };
+    source.whole = [userId, generation](const std::string& body) {
+        models::ModelCache::putConfigList(userId, body, generation);
+    };
+    listing::respondList(request, std::move(source), std::move(callback));
 }
 
 void DeploymentController::deployDatabase(const HttpRequestPtr& req,
@@ -58,235 +154,672 @@ void DeploymentController::deployDatabase(const HttpRequestPtr& req,
     }
 
     int configId = (*json)["config_id"].asInt();
-    std::string host = (*json)["host"].asString();
-    std::string username = (*json)["username"].asString();
-    std::string password = (*json)["password"].asString();
-    int port = (*json)["port"].asInt();
+    // full - развернуть с нуля, auto - применить только разницу с прошлым деплоем
+    bool fullDeploy = (*json).get("mode", "auto").asString() == "full";
+    int retries = (*json).get("retries", -1).asInt();
+    DeployOptions options;
+    options.profile = (*json).get("profile", "").asString();
+    if (!options.profile.empty() && options.profile != "none" && !services::parseWorkloadProfile(options.profile)) {
+        auto resp = HttpResponse::newHttpJsonResponse(
+            Json::Value("Unknown profile: expected oltp, analytics, cache or none"));
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
+    options.partitionsAhead = (*json).get("partitions_ahead", -1).asInt();
+    std::string transport = (*json).get("transport", "ssh").asString();
+    options.direct = transport == "direct";
+    options.connections = (*json).get("connections", 4).asUInt();
+    if ((!options.direct && transport != "ssh") || options.connections == 0 ||
+        options.connections > MAX_DIRECT_CONNECTIONS) {
+        auto resp = HttpResponse::newHttpJsonResponse(
+            Json::Value("transport must be ssh or direct, connections from 1 to " +
+                        std::to_string(MAX_DIRECT_CONNECTIONS)));
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
+    // Повторы держат поток общего пула деплоя: их число ограничено
+    if (json->isMember("retries") && (retries < 0 || retries > MAX_DEPLOY_RETRIES)) {
+        auto resp = HttpResponse::newHttpJsonResponse(
+            Json::Value("retries must be from 0 to " + std::to_string(MAX_DEPLOY_RETRIES)));
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
+    if (options.partitionsAhead > MAX_PARTITIONS_AHEAD) {
+        auto resp = HttpResponse::newHttpJsonResponse(
+            Json::Value("partitions_ahead must not exceed " + std::to_string(MAX_PARTITIONS_AHEAD)));
+        resp->setStatusCode(k400BadRequest);
+        callback(resp);
+        return;
+    }
 
-    auto userId = req->getAttributes()->get<int>("user_id");
-    auto config = models::DatabaseConfig::findById(configId);
-    
-    if (!config) {
-        auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Configuration not found"));
-        resp->setStatusCode(k404NotFound);
+    std::vector<services::SshCredentials> targets;
+    try {
+        targets = parseTargets(*json);
+    } catch (const std::exception& e) {
+        auto resp = HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
+        resp->setStatusCode(k400BadRequest);
         callback(resp);
         return;
     }
 
-    if (config->getUserId() != userId) {
-        auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Access denied"));
-        resp->setStatusCode(k403Forbidden);
+    auto userId = req->getAttributes()->get<int>("user_id");
+    auto callbackPtr = std::make_shared<std::function<void(const HttpResponsePtr&)>>(std::move(callback));
+    models::DatabaseConfig::findByIdAsync(
+        configId,
+        [this, callbackPtr, userId, targets = std::move(targets), fullDeploy, retries,
+         options = std::move(options)](
+            std::optional<models::DatabaseConfig> config) {
+            if (!config) {
+                auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Configuration not found"));
+                resp->setStatusCode(k404NotFound);
+                (*callbackPtr)(resp);
+                return;
+            }
+
+            if (config->getUserId() != userId) {
+                auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Access denied"));
+                resp->setStatusCode(k403Forbidden);
+                (*callbackPtr)(resp);
+                return;
+            }
+
+            // Имя базы и пользователя уходят в SQL, который выполняет суперпользователь СУБД
+            const Json::Value& settings = config->getConfig();
+            if (auto dialect = sql::parseDialect(settings["type"].asString());
+                dialect && (!sql::SchemaValidator::isValidIdentifier(*dialect, settings["name"].asString()) ||
+                            !sql::SchemaValidator::isValidIdentifier(*dialect, settings["user"].asString()))) {
+                auto resp = HttpResponse::newHttpJsonResponse(
+                    Json::Value("Database name and user must be plain SQL identifiers"));
+                resp->setStatusCode(k400BadRequest);
+                (*callbackPtr)(resp);
+                return;
+            }
+
+            // Отвечаем сразу: ход деплоя доступен по GET /deploy/{id} и через WebSocket
+            auto job = services::DeploymentJobs::create(userId, config->getId(), targets);
+            Json::Value accepted;
+            accepted["job_id"] = job->getId();
+            accepted["status"] = "queued";
+            accepted["targets"] = static_cast<Json::UInt64>(targets.size());
+            auto resp = HttpResponse::newHttpJsonResponse(accepted);
+            resp->setStatusCode(k202Accepted);
+            (*callbackPtr)(resp);
+
+            // Прошлые деплои всех серверов одним запросом, дальше - конвейер на каждый сервер
+            models::Deployment::findLatestPerTargetAsync(
+                config->getId(),
+                [this, job, userId, targets, fullDeploy, retries, options, config = std::move(*config)](
+                    std::vector<models::Deployment> deployments) {
+                    std::unordered_map<std::string, models::Deployment> latest;
+                    if (!fullDeploy) {
+                        for (auto& deployment : deployments) {
+                            services::SshCredentials target{deployment.getHost(), deployment.getPort()};
+                            latest.emplace(services::DeploymentJobs::targetKey(target), std::move(deployment));
+                        }
+                    }
+                    services::DeploymentJobs::submit(
+                        job, targets, retries,
+                        [this, userId, options, config, latest = std::move(latest)](
+                            services::DeploymentJob& job, const services::SshCredentials& target) {
+                            auto it = latest.find(services::DeploymentJobs::targetKey(target));
+                            std::optional<models::Deployment> previous;
+                            if (it != latest.end()) {
+                                previous = it->second;
+                            }
+                            return runDeployment(job, userId, target, config, previous, options);
+                        });
+                },
+                [job](const std::exception& e) {
+                    job->fail(e.what());
+                });
+        },
+        [callbackPtr](const std::exception& e) {
+            auto resp = HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
+            resp->setStatusCode(k500InternalServerError);
+            (*callbackPtr)(resp);
+        });
+}
+
+void DeploymentController::getDeployment(const HttpRequestPtr& req,
+                                         std::function<void(const HttpResponsePtr&)>&& callback,
+                                         const std::string& jobId) {
+    auto userId = req->getAttributes()->get<int>("user_id");
+    auto job = services::DeploymentJobs::find(jobId);
+    if (!job || job->getUserId() != userId) {
+        auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Deployment job not found"));
+        resp->setStatusCode(k404NotFound);
         callback(resp);
         return;
     }
 
-    try {
-        // Создаем SSH сессию
-        ssh_session ssh = ssh_new();
-        if (ssh == nullptr) {
-            throw std::runtime_error("Failed to create SSH session");
+    // since - номер первого события, которого у клиента еще нет
+    uint64_t since = 0;
+    std::string sinceParam = req->getParameter("since");
+    if (!sinceParam.empty()) {
+        try {
+            since = std::stoull(sinceParam);
+        } catch (const std::exception&) {
+            auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Invalid since parameter"));
+            resp->setStatusCode(k400BadRequest);
+            callback(resp);
+            return;
         }
+    }
 
-        std::unique_ptr<ssh_session_struct, decltype(&ssh_free)> session(ssh, ssh_free);
+    callback(HttpResponse::newHttpJsonResponse(job->toJson(since)));
+}
 
-        ssh_options_set(ssh, SSH_OPTIONS_HOST, host.c_str());
-        ssh_options_set(ssh, SSH_OPTIONS_PORT, &port);
-        ssh_options_set(ssh, SSH_OPTIONS_USER, username.c_str());
+std::vector<services::SshCredentials> DeploymentController::parseTargets(const Json::Value& json) {
+    // Общие параметры подключения; элемент hosts может их переопределить
+    services::SshCredentials defaults;
+    defaults.port = json.get("port", 22).asInt();
+    defaults.username = json["username"].asString();
+    defaults.password = json["password"].asString();
 
-        int rc = ssh_connect(ssh);
-        if (rc != SSH_OK) {
-            throw std::runtime_error("Failed to connect to server");
+    std::vector<services::SshCredentials> targets;
+    if (!json.isMember("hosts")) {
+        defaults.host = json["host"].asString();
+        targets.push_back(defaults);
+    } else if (json["hosts"].isArray()) {
+        for (const auto& item : json["hosts"]) {
+            services::SshCredentials target = defaults;
+            if (item.isString()) {
+                target.host = item.asString();
+            } else if (item.isObject()) {
+                target.host = item["host"].asString();
+                target.port = item.get("port", defaults.port).asInt();
+                target.username = item.get("username", defaults.username).asString();
+                target.password = item.get("password", defaults.password).asString();
+            }
+            targets.push_back(std::move(target));
         }
+    } else {
+        throw std::invalid_argument("hosts must be an array");
+    }
 
-        rc = ssh_userauth_password(ssh, nullptr, password.c_str());
-        if (rc != SSH_AUTH_SUCCESS) {
-            throw std::runtime_error("Failed to authenticate");
+    if (targets.empty() || targets.size() > MAX_DEPLOY_TARGETS) {
+        throw std::invalid_argument("Expected from 1 to " + std::to_string(MAX_DEPLOY_TARGETS) + " hosts");
+    }
+    std::unordered_set<std::string> seen;
+    for (const auto& target : targets) {
+        if (target.host.empty()) {
+            throw std::invalid_argument("Host is required");
+        }
+        if (!seen.insert(services::DeploymentJobs::targetKey(target)).second) {
+            throw std::invalid_argument("Duplicate host " + services::DeploymentJobs::targetKey(target));
         }
+    }
+    return targets;
+}
 
-        // Генерируем и выполняем команды для развертывания базы данных
-        std::string dbType = config->getConfig()["type"].asString();
-        std::vector<std::string> commands = generateDeploymentCommands(dbType, config->getConfig());
+Json::Value DeploymentController::runDeployment(services::DeploymentJob& job,
+                                                int userId,
+                                                const services::SshCredentials& target,
+                                                const models::DatabaseConfig& config,
+                                                const std::optional<models::Deployment>& previous,
+                                                const DeployOptions& options) {
+    std::string dbType = config.getConfig()["type"].asString();
 
-        for (const auto& cmd : commands) {
-            ssh_channel channel = ssh_channel_new(ssh);
-            if (channel == nullptr) {
-                throw std::runtime_error("Failed to create SSH channel");
-            }
+    bool maintainPartitions = options.partitionsAhead >= 0 && dbType != "redis";
+    std::optional<sql::Dialect> dialect = sql::parseDialect(dbType);
+    bool direct = options.direct && dialect.has_value();
 
-            rc = ssh_channel_open_session(channel);
-            if (rc != SSH_OK) {
-                ssh_channel_free(channel);
-                throw std::runtime_error("Failed to open SSH channel");
-            }
+    Json::Value result;
+    result["mode"] = previous ? "migrate" : "full";
+    // Обслуживание разделов нужно и без изменений схемы: его запускают по расписанию
+    if (previous && previous->getVersion() == config.getUpdatedAt() && !maintainPartitions) {
+        result["message"] = "Database is already up to date";
+        result["steps"] = Json::Value(Json::arrayValue);
+        return result;
+    }
 
-            rc = ssh_channel_request_exec(channel, cmd.c_str());
-            if (rc != SSH_OK) {
-                ssh_channel_close(channel);
-                ssh_channel_free(channel);
-                throw std::runtime_error("Failed to execute command");
-            }
+    // Генерируем и выполняем команды для развертывания базы данных
+    std::vector<services::DeployStep> steps;
+    Json::Value skipped(Json::arrayValue);
+    bool migrate = previous && dbType != "redis";
 
-            ssh_channel_close(channel);
-            ssh_channel_free(channel);
+    // Одна команда проверки сервера; при миграции она нужна только для обслуживания разделов
+    services::RemoteState state;
+    if (!migrate || maintainPartitions) {
+        std::string probe = services::RemoteState::probeCommand(dbType, config.getConfig()["name"].asString());
+        if (probe.empty()) {
+            throw std::runtime_error("Unsupported database type");
         }
+        state = services::RemoteState::parse(services::DeploymentJobs::runProbe(job, target, probe));
+    }
 
-        Json::Value result;
-        result["status"] = "success";
-        result["message"] = "Database deployed successfully";
-        
-        auto resp = HttpResponse::newHttpJsonResponse(result);
-        callback(resp);
-    } catch (const std::exception& e) {
-        auto resp = HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
-        resp->setStatusCode(k500InternalServerError);
-        callback(resp);
+    std::vector<std::string> migration;
+    if (migrate && direct) {
+        // Операторы по одному через соединение с СУБД, в PostgreSQL - одной транзакцией
+        std::string statements;
+        for (const auto& statement : sql::SchemaDiff(*dialect).diff(previous->getConfig()["tables"],
+                                                                   config.getConfig()["tables"])) {
+            statements += statement;
+        }
+        migration = sql::DdlCompiler(*dialect).splitStatements(statements);
+    } else if (migrate) {
+        steps = generateMigrationSteps(dbType, previous->getConfig(), config.getConfig());
+    } else {
+        // План без уже выполненных шагов
+        Json::Value tuningReport;
+        services::PerformanceTuner::Settings tuning =
+            tuningSettings(dbType, config.getConfig(), state, options.profile, tuningReport);
+        if (!tuningReport.isNull()) {
+            result["tuning"] = tuningReport;
+        }
+        steps = generateDeploymentSteps(dbType, config.getConfig(), state, tuning, !direct, skipped);
     }
+    if (maintainPartitions) {
+        if (auto step = generatePartitionStep(dbType, config.getConfig(), state, options.partitionsAhead)) {
+            steps.push_back(std::move(*step));
+        } else {
+            skipped.append("maintain_partitions");
+        }
+    }
+    result["skipped"] = skipped;
+    result["steps"] = steps.empty() ? Json::Value(Json::arrayValue)
+                                    : services::DeploymentJobs::runSteps(job, target, steps);
+
+    // Таблицы - после шагов скрипта: база, пользователь и настройки СУБД уже на месте
+    if (direct) {
+        services::DirectDeployer::Connection connection =
+            directConnection(*dialect, config.getConfig(), options.connections);
+        if (migrate) {
+            if (!migration.empty()) {
+                result["migration"] = services::DirectDeployer::runStatements(job, target, connection,
+                                                                              "migrate_tables", migration);
+            }
+        } else {
+            sql::DdlPlan plan = sql::DdlCompiler(*dialect).planTables(
+                config.getConfig()["tables"],
+                [&state](std::string_view name) { return state.hasTable(name); });
+            if (plan.layers.empty() && plan.deferred.empty()) {
+                result["skipped"].append("create_tables");
+            } else {
+                result["tables"] = services::DirectDeployer::createTables(job, target, connection, plan);
+            }
+        }
+    }
+
+    // Запоминаем развернутую версию для следующего инкрементального деплоя
+    models::Deployment deployment = models::Deployment::record(
+        userId, config.getId(), target.host, target.port, config.getUpdatedAt(), config.getConfig());
+    result["message"] = "Database deployed successfully";
+    result["deployment"] = deployment.toJson();
+    return result;
 }
 
-std::vector<std::string> DeploymentController::generateDeploymentCommands(
+services::PerformanceTuner::Settings DeploymentController::tuningSettings(const std::string& dbType,
+                                                                         const Json::Value& config,
+                                                                         const services::RemoteState& state,
+                                                                         const std::string& profile,
+                                                                         Json::Value& report) {
+    if (profile == "none") {
+        return {};
+    }
+    services::WorkloadProfile workload = profile.empty()
+        ? (dbType == "redis" ? services::WorkloadProfile::Cache : services::WorkloadProfile::Oltp)
+        : *services::parseWorkloadProfile(profile);
+    services::HardwareInfo hardware = services::HardwareInfo::fromState(state);
+
+    report["profile"] = services::workloadProfileName(workload);
+    report["hardware"] = hardware.toJson();
+    if (!hardware.isKnown()) {
+        // Без числа ядер и объема памяти настройки по умолчанию лучше угаданных
+        report["message"] = "Hardware could not be detected, tuning skipped";
+        return {};
+    }
+
+    services::PerformanceTuner tuner(hardware, workload);
+    services::PerformanceTuner::Settings settings;
+    if (dbType == "postgresql") {
+        settings = tuner.postgres();
+    } else if (dbType == "mysql") {
+        settings = tuner.mysql();
+    } else if (dbType == "redis") {
+        // Явный max_memory из конфигурации важнее рассчитанного
+        uint64_t maxMemoryMb = 0;
+        try {
+            maxMemoryMb = std::stoull(config["max_memory"].asString());
+        } catch (const std::exception&) {
+        }
+        settings = tuner.redis(maxMemoryMb);
+    }
+    report["settings"] = services::PerformanceTuner::toJson(settings);
+    return settings;
+}
+
+std::vector<services::DeployStep> DeploymentController::generateDeploymentSteps(
     const std::string& dbType,
-    const Json::Value& config) {
+    const Json::Value& config,
+    const services::RemoteState& state,
+    const services::PerformanceTuner::Settings& tuning,
+    bool scriptTables,
+    Json::Value& skipped) {
     
-    std::vector<std::string> commands;
+    std::vector<services::DeployStep> steps;
     
     if (dbType == "postgresql") {
-        commands = generatePostgresCommands(config);
+        steps = generatePostgresSteps(config, state, tuning, scriptTables, skipped);
     } else if (dbType == "mysql") {
-        commands = generateMysqlCommands(config);
+        steps = generateMysqlSteps(config, state, tuning, scriptTables, skipped);
     } else if (dbType == "redis") {
-        commands = generateRedisCommands(config);
+        steps = generateRedisSteps(config, state, tuning, skipped);
     } else {
         throw std::runtime_error("Unsupported database type");
     }
     
-    return commands;
+    return steps;
+}
+
+std::optional<services::DeployStep> DeploymentController::generatePartitionStep(const std::string& dbType,
+                                                                               const Json::Value& config,
+                                                                               const services::RemoteState& state,
+                                                                               int ahead) {
+    std::optional<sql::Dialect> dialect = sql::parseDialect(dbType);
+    if (!dialect || !config["tables"].isArray()) {
+        return std::nullopt;
+    }
+
+    sql::DdlCompiler compiler(*dialect);
+    sql::CalendarDate today = sql::CalendarDate::today();
+    std::string dbName = config["name"].asString();
+    services::DeployStep step{"maintain_partitions",
+                              *dialect == sql::Dialect::PostgreSQL
+                                  ? "sudo -u postgres psql -v ON_ERROR_STOP=1 -d " + services::DeployScript::shellQuote(dbName)
+                                  : "sudo mysql " + services::DeployScript::shellQuote(dbName),
+                              ""};
+    for (const auto& table : config["tables"]) {
+        std::optional<sql::PartitionSpec> spec = sql::PartitionSpec::fromTable(table);
+        if (!spec) {
+            continue;
+        }
+        // Таблица, которую создает этот же деплой, получит начальный набор разделов
+        std::string name = table["name"].asString();
+        std::vector<std::string> existing = state.partitions(name);
+        if (!state.hasTable(name)) {
+            for (const auto& bound : spec->initialPartitions(today)) {
+                existing.push_back(bound.name);
+            }
+        }
+        compiler.compilePartitionMaintenance(table, existing, today, ahead, step.input);
+    }
+    if (step.input.empty()) {
+        return std::nullopt;
+    }
+    return step;
 }
 
-std::vector<std::string> DeploymentController::generatePostgresCommands(const Json::Value& config) {
-    std::vector<std::string> commands;
+std::vector<services::DeployStep> DeploymentController::generateMigrationSteps(
+    const std::string& dbType,
+    const Json::Value& previousConfig,
+    const Json::Value& config) {
+    std::optional<sql::Dialect> dialect = sql::parseDialect(dbType);
+    if (!dialect) {
+        throw std::runtime_error("Unsupported database type");
+    }
+
+    std::vector<std::string> statements =
+        sql::SchemaDiff(*dialect).diff(previousConfig["tables"], config["tables"]);
+    if (statements.empty()) {
+        return {};
+    }
+
+    // В PostgreSQL миграция идет одной транзакцией: при ошибке схема не остается наполовину измененной
+    std::string dbName = config["name"].asString();
+    services::DeployStep migrate;
+    migrate.name = "migrate_tables";
+    migrate.command = *dialect == sql::Dialect::PostgreSQL
+        ? "sudo -u postgres psql -v ON_ERROR_STOP=1 --single-transaction -d " +
+              services::DeployScript::shellQuote(dbName)
+        : "sudo mysql " + services::DeployScript::shellQuote(dbName);
+    for (const auto& statement : statements) {
+        migrate.input += statement;
+    }
+    return {std::move(migrate)};
+}
+
+std::vector<services::DeployStep> DeploymentController::generatePostgresSteps(const Json::Value& config,
+                                                                            const services::RemoteState& state,
+                                                                            const services::PerformanceTuner::Settings& tuning,
+                                                                            bool scriptTables,
+                                                                            Json::Value& skipped) {
+    std::vector<services::DeployStep> steps;
     
     // Установка PostgreSQL
-    commands.push_back("sudo apt-get update");
-    commands.push_back("sudo apt-get install -y postgresql postgresql-contrib");
+    if (state.hasPackage("postgresql") && state.hasPackage("postgresql-contrib")) {
+        skipped.append("install_postgresql");
+    } else {
+        steps.push_back({"apt_update", "sudo apt-get update", ""});
+        steps.push_back({"install_postgresql", "sudo apt-get install -y postgresql postgresql-contrib", ""});
+    }
     
-    // Создание базы данных и пользователя
+    // Создание базы данных и пользователя: SQL идет через stdin psql, без экранирования в кавычках
     std::string dbName = config["name"].asString();
     std::string dbUser = config["user"].asString();
     std::string dbPassword = config["password"].asString();
+    std::string databaseIdent = sqlIdentifier(dbName, sql::Dialect::PostgreSQL);
+    std::string userIdent = sqlIdentifier(dbUser, sql::Dialect::PostgreSQL);
+    const std::string psql = "sudo -u postgres psql -v ON_ERROR_STOP=1";
+    bool databaseExists = state.hasDatabase(dbName);
+    bool userExists = state.hasRole(dbUser);
     
-    commands.push_back("sudo -u postgres psql -c 'CREATE DATABASE " + dbName + ";'");
-    commands.push_back("sudo -u postgres psql -c \"CREATE USER " + dbUser + " WITH PASSWORD '" + dbPassword + "';\"");
-    commands.push_back("sudo -u postgres psql -c 'GRANT ALL PRIVILEGES ON DATABASE " + dbName + " TO " + dbUser + ";'");
-    
-    // Создание таблиц
-    const Json::Value& tables = config["tables"];
-    std::stringstream sqlStream;
+    if (databaseExists) {
+        skipped.append("create_database");
+    } else {
+        steps.push_back({"create_database", psql, "CREATE DATABASE " + databaseIdent + ";"});
+    }
+    if (userExists) {
+        skipped.append("create_user");
+    } else {
+        steps.push_back({"create_user", psql,
+                         "CREATE USER " + userIdent + " WITH PASSWORD " + sqlLiteral(dbPassword, false) + ";"});
+    }
+    if (databaseExists && userExists) {
+        skipped.append("grant_privileges");
+    } else {
+        steps.push_back({"grant_privileges", psql,
+                         "GRANT ALL PRIVILEGES ON DATABASE " + databaseIdent + " TO " + userIdent + ";"});
+    }
     
-    for (const auto& table : tables) {
-        sqlStream << "CREATE TABLE " << table["name"].asString() << " (";
-        
-        const Json::Value& columns = table["columns"];
-        bool first = true;
-        
-        for (const auto& column : columns) {
-            if (!first) {
-                sqlStream << ", ";
-            }
-            sqlStream << column["name"].asString() << " " << column["type"].asString();
-            
-            if (column["primary_key"].asBool()) {
-                sqlStream << " PRIMARY KEY";
-            }
-            if (column["not_null"].asBool()) {
-                sqlStream << " NOT NULL";
-            }
-            if (column.isMember("default")) {
-                sqlStream << " DEFAULT " << column["default"].asString();
-            }
-            
-            first = false;
+    // Создание таблиц: DDL только для отсутствующих таблиц пишется сразу в stdin шага.
+    // Напрямую таблицы создает владелец базы, а с PostgreSQL 15 схема public ему закрыта:
+    // прав на нее в состоянии сервера не видно, GRANT повторять безопасно
+    if (scriptTables) {
+        services::DeployStep createTables{"create_tables", psql + " -d " + services::DeployScript::shellQuote(dbName), ""};
+        compileMissingTables(sql::Dialect::PostgreSQL, config["tables"], state, createTables.input);
+        if (createTables.input.empty()) {
+            skipped.append("create_tables");
+        } else {
+            steps.push_back(std::move(createTables));
         }
-        
-        sqlStream << ");";
+    } else {
+        steps.push_back({"grant_schema", psql + " -d " + services::DeployScript::shellQuote(dbName),
+                         "GRANT ALL ON SCHEMA public TO " + userIdent + ";"});
     }
     
-    commands.push_back("sudo -u postgres psql -d " + dbName + " -c '" + sqlStream.str() + "'");
+    // Настройки под железо: отдельный файл в conf.d, перезапуск только если файл изменился
+    std::string tuningFile = services::PerformanceTuner::renderPostgres(tuning);
+    if (tuning.empty() || state.tuning() == tuningFile) {
+        skipped.append("tune_postgresql");
+        skipped.append("restart_postgresql");
+    } else {
+        steps.push_back({"tune_postgresql",
+                         std::string("sudo tee ") + services::RemoteState::POSTGRES_TUNING_FILE + " >/dev/null",
+                         tuningFile});
+        steps.push_back({"restart_postgresql", "sudo systemctl restart postgresql", ""});
+    }
     
-    return commands;
+    return steps;
 }
 
-std::vector<std::string> DeploymentController::generateMysqlCommands(const Json::Value& config) {
-    std::vector<std::string> commands;
+std::vector<services::DeployStep> DeploymentController::generateMysqlSteps(const Json::Value& config,
+                                                                         const services::RemoteState& state,
+                                                                         const services::PerformanceTuner::Settings& tuning,
+                                                                         bool scriptTables,
+                                                                         Json::Value& skipped) {
+    std::vector<services::DeployStep> steps;
     
     // Установка MySQL
-    commands.push_back("sudo apt-get update");
-    commands.push_back("sudo apt-get install -y mysql-server");
+    if (state.hasPackage("mysql-server")) {
+        skipped.append("install_mysql");
+    } else {
+        steps.push_back({"apt_update", "sudo apt-get update", ""});
+        steps.push_back({"install_mysql", "sudo apt-get install -y mysql-server", ""});
+    }
     
-    // Создание базы данных и пользователя
+    // Создание базы данных и пользователя: SQL идет через stdin mysql, без экранирования в кавычках
     std::string dbName = config["name"].asString();
     std::string dbUser = config["user"].asString();
     std::string dbPassword = config["password"].asString();
+    std::string databaseIdent = sqlIdentifier(dbName, sql::Dialect::MySQL);
+    std::string account = sqlLiteral(dbUser, true) + "@'localhost'";
+    bool databaseExists = state.hasDatabase(dbName);
+    bool userExists = state.hasRole(dbUser);
     
-    commands.push_back("sudo mysql -e 'CREATE DATABASE " + dbName + ";'");
-    commands.push_back("sudo mysql -e \"CREATE USER '" + dbUser + "'@'localhost' IDENTIFIED BY '" + dbPassword + "';\"");
-    commands.push_back("sudo mysql -e 'GRANT ALL PRIVILEGES ON " + dbName + ".* TO '" + dbUser + "'@'localhost';'");
-    commands.push_back("sudo mysql -e 'FLUSH PRIVILEGES;'");
-    
-    // Создание таблиц
-    const Json::Value& tables = config["tables"];
-    std::stringstream sqlStream;
+    if (databaseExists) {
+        skipped.append("create_database");
+    } else {
+        steps.push_back({"create_database", "sudo mysql", "CREATE DATABASE " + databaseIdent + ";"});
+    }
+    if (userExists) {
+        skipped.append("create_user");
+    } else {
+        steps.push_back({"create_user", "sudo mysql",
+                         "CREATE USER " + account + " IDENTIFIED BY " + sqlLiteral(dbPassword, true) + ";"});
+    }
+    if (databaseExists && userExists) {
+        skipped.append("grant_privileges");
+    } else {
+        steps.push_back({"grant_privileges", "sudo mysql",
+                         "GRANT ALL PRIVILEGES ON " + databaseIdent + ".* TO " + account + ";\nFLUSH PRIVILEGES;"});
+    }
     
-    for (const auto& table : tables) {
-        sqlStream << "CREATE TABLE " << table["name"].asString() << " (";
-        
-        const Json::Value& columns = table["columns"];
-        bool first = true;
-        
-        for (const auto& column : columns) {
-            if (!first) {
-                sqlStream << ", ";
-            }
-            sqlStream << column["name"].asString() << " " << column["type"].asString();
-            
-            if (column["primary_key"].asBool()) {
-                sqlStream << " PRIMARY KEY";
-            }
-            if (column["not_null"].asBool()) {
-                sqlStream << " NOT NULL";
-            }
-            if (column.isMember("default")) {
-                sqlStream << " DEFAULT " << column["default"].asString();
-            }
-            
-            first = false;
+    // Создание таблиц: DDL только для отсутствующих таблиц пишется сразу в stdin шага
+    if (scriptTables) {
+        services::DeployStep createTables{"create_tables", "sudo mysql " + services::DeployScript::shellQuote(dbName), ""};
+        compileMissingTables(sql::Dialect::MySQL, config["tables"], state, createTables.input);
+        if (createTables.input.empty()) {
+            skipped.append("create_tables");
+        } else {
+            steps.push_back(std::move(createTables));
         }
-        
-        sqlStream << ");";
     }
     
-    commands.push_back("sudo mysql " + dbName + " -e '" + sqlStream.str() + "'");
+    // Настройки под железо: отдельный файл в mysql.conf.d, перезапуск только если файл изменился
+    std::string tuningFile = services::PerformanceTuner::renderMysql(tuning);
+    if (tuning.empty() || state.tuning() == tuningFile) {
+        skipped.append("tune_mysql");
+        skipped.append("restart_mysql");
+    } else {
+        steps.push_back({"tune_mysql",
+                         std::string("sudo tee ") + services::RemoteState::MYSQL_TUNING_FILE + " >/dev/null",
+                         tuningFile});
+        steps.push_back({"restart_mysql", "sudo systemctl restart mysql", ""});
+    }
     
-    return commands;
+    return steps;
 }
 
-std::vector<std::string> DeploymentController::generateRedisCommands(const Json::Value& config) {
-    std::vector<std::string> commands;
+std::vector<services::DeployStep> DeploymentController::generateRedisSteps(const Json::Value& config,
+                                                                         const services::RemoteState& state,
+                                                                         const services::PerformanceTuner::Settings& tuning,
+                                                                         Json::Value& skipped) {
+    std::vector<services::DeployStep> steps;
     
     // Установка Redis
-    commands.push_back("sudo apt-get update");
-    commands.push_back("sudo apt-get install -y redis-server");
+    if (state.hasPackage("redis-server")) {
+        skipped.append("install_redis");
+    } else {
+        steps.push_back({"apt_update", "sudo apt-get update", ""});
+        steps.push_back({"install_redis", "sudo apt-get install -y redis-server", ""});
+    }
     
-    // Настройка Redis
-    std::string password = config["password"].asString();
+    // Настройка Redis: пароль, порт и maxmemory - отдельный файл, подключенный в
+    // конце redis.conf (последнее значение директивы побеждает). Значения идут
+    // через stdin и в кавычках Redis, а не в командную строку sed
     std::string port = config["port"].asString();
     std::string maxMemory = config["max_memory"].asString();
+    if (!isNumber(port) || (!maxMemory.empty() && !isNumber(maxMemory))) {
+        throw std::runtime_error("Redis port and max_memory must be numbers");
+    }
+    std::string settingsFile = "# Generated by webdatabase deploy\n";
+    std::string password = redisQuote(config["password"].asString());
+    settingsFile += "requirepass " + password + "\n";
+    settingsFile += "port " + port + "\n";
+    // 0 или пусто - maxmemory рассчитывает PerformanceTuner в своем файле
+    maxMemory = maxMemory.empty() || std::stoull(maxMemory) == 0 ? "" : std::to_string(std::stoull(maxMemory)) + "mb";
+    if (!maxMemory.empty()) {
+        settingsFile += "maxmemory " + maxMemory + "\n";
+    }
+    bool configured = state.setting("requirepass") == password &&
+                      state.setting("port") == port &&
+                      state.setting("maxmemory") == maxMemory;
     
-    commands.push_back("sudo sed -i 's/# requirepass foobared/requirepass " + password + "/g' /etc/redis/redis.conf");
-    commands.push_back("sudo sed -i 's/port 6379/port " + port + "/g' /etc/redis/redis.conf");
-    commands.push_back("sudo sed -i 's/# maxmemory <bytes>/maxmemory " + maxMemory + "mb/g' /etc/redis/redis.conf");
+    if (configured) {
+        skipped.append("configure_redis");
+    } else {
+        steps.push_back({"configure_redis", redisIncludeCommand(services::RemoteState::REDIS_SETTINGS_FILE),
+                         settingsFile});
+    }
+    
+    // Настройки под железо: отдельный файл, подключенный в конце redis.conf
+    std::string tuningFile = services::PerformanceTuner::renderRedis(tuning);
+    bool tuned = tuning.empty() || state.tuning() == tuningFile;
+    if (tuned) {
+        skipped.append("tune_redis");
+    } else {
+        steps.push_back({"tune_redis", redisIncludeCommand(services::RemoteState::REDIS_TUNING_FILE), tuningFile});
+    }
     
-    // Перезапуск Redis
-    commands.push_back("sudo systemctl restart redis-server");
+    // Перезапуск Redis - только если настройки менялись или служба не запущена
+    if (configured && tuned && state.isServiceActive("redis-server")) {
+        skipped.append("restart_redis");
+    } else {
+        steps.push_back({"restart_redis", "sudo systemctl restart redis-server", ""});
+    }
     
-    return commands;
+    return steps;
+}
+
+services::DirectDeployer::Connection DeploymentController::directConnection(sql::Dialect dialect,
+                                                                          const Json::Value& config,
+                                                                          size_t connections) {
+    services::DirectDeployer::Connection connection;
+    connection.dialect = dialect;
+    connection.database = config["name"].asString();
+    connection.user = config["user"].asString();
+    connection.password = config["password"].asString();
+    connection.connections = connections;
+    // Порт СУБД на сервере: из конфигурации (числом или строкой) или стандартный
+    connection.port = dialect == sql::Dialect::PostgreSQL ? 5432 : 3306;
+    const Json::Value& port = config["port"];
+    if (port.isIntegral()) {
+        connection.port = port.asInt();
+    } else if (port.isString()) {
+        try {
+            connection.port = std::stoi(port.asString());
+        } catch (const std::exception&) {
+        }
+    }
+    return connection;
+}
+
+void DeploymentController::compileMissingTables(sql::Dialect dialect,
+                                                const Json::Value& tables,
+                                                const services::RemoteState& state,
+                                                std::string& out) {
+    if (!tables.isArray()) {
+        return;
+    }
+    // Таблицы создаются в порядке FK; на уже существующие можно ссылаться сразу.
+    // Оценка размера и компиляция идут по одной сборке схемы
+    sql::CompactSchema schema(tables);
+    out.reserve(sql::DdlCompiler::estimateSize(schema));
+    sql::DdlCompiler(dialect).compileTables(schema, out, [&state](std::string_view name) {
+        return state.hasTable(name);
+    });
 }
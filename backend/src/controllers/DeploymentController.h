@@ -1,30 +1,111 @@
 #pragma once
 #include <drogon/HttpController.h>
 #include <json/json.h>
+#include <memory>
+#include <optional>
 #include <vector>
+#include "../models/DatabaseConfig.h"
+#include "../models/Deployment.h"
+#include "../services/DeploymentJobs.h"
+#include "../services/DirectDeployer.h"
+#include "../services/PerformanceTuner.h"
+#include "../services/RemoteState.h"
+#include "../sql/Dialect.h"
 
 using namespace drogon;
 
-// TODO: #17 Разобраться как тут что
+// Конфигурации баз данных пользователя и их развертывание на серверы фоновыми заданиями
 class DeploymentController : public drogon::HttpController<DeploymentController> {
 public:
     METHOD_LIST_BEGIN
-        ADD_METHOD_TO(DeploymentController::saveConfig, "/api/protected/config", Post);
-        ADD_METHOD_TO(DeploymentController::getConfigs, "/api/protected/configs", Get);
-        ADD_METHOD_TO(DeploymentController::deployDatabase, "/api/protected/deploy", Post);
+        ADD_METHOD_TO(DeploymentController::saveConfig, "/api/protected/config", Post, "JwtAuthFilter");
+        ADD_METHOD_TO(DeploymentController::getConfigs, "/api/protected/configs", Get, "JwtAuthFilter");
+        ADD_METHOD_TO(DeploymentController::deployDatabase, "/api/protected/deploy", Post, "JwtAuthFilter");
+        ADD_METHOD_TO(DeploymentController::getDeployment, "/api/protected/deploy/{id}", Get, "JwtAuthFilter");
     METHOD_LIST_END
 
     void saveConfig(const HttpRequestPtr& req,
                    std::function<void(const HttpResponsePtr&)>&& callback);
     void getConfigs(const HttpRequestPtr& req,
                    std::function<void(const HttpResponsePtr&)>&& callback);
+    // Ставит деплой на один или несколько серверов в фоновую очередь и сразу отвечает 202 с job_id
     void deployDatabase(const HttpRequestPtr& req,
                        std::function<void(const HttpResponsePtr&)>&& callback);
+    void getDeployment(const HttpRequestPtr& req,
+                      std::function<void(const HttpResponsePtr&)>&& callback,
+                      const std::string& jobId);
 
 private:
-    std::vector<std::string> generateDeploymentCommands(const std::string& dbType,
-                                                       const Json::Value& config);
-    std::vector<std::string> generatePostgresCommands(const Json::Value& config);
-    std::vector<std::string> generateMysqlCommands(const Json::Value& config);
-    std::vector<std::string> generateRedisCommands(const Json::Value& config);
+    static constexpr size_t MAX_DEPLOY_TARGETS = 256;
+    static constexpr int MAX_PARTITIONS_AHEAD = 366;
+    static constexpr size_t MAX_DIRECT_CONNECTIONS = 16;
+    static constexpr int MAX_DEPLOY_RETRIES = 5;
+
+    // Параметры запроса деплоя, общие для всех серверов
+    struct DeployOptions {
+        // Профиль нагрузки для настройки СУБД; пусто - по типу базы, none - не настраивать
+        std::string profile;
+        // Сколько будущих периодов секционированных таблиц создать заранее; -1 - не обслуживать разделы
+        int partitionsAhead = -1;
+        // transport=direct: DDL через соединения с СУБД по SSH-туннелю, а не через psql/mysql в скрипте
+        bool direct = false;
+        // Одновременных соединений при direct: столько таблиц слоя FK создается параллельно
+        size_t connections = 4;
+    };
+
+    // host/port/username/password или список hosts (строки или объекты с переопределениями)
+    static std::vector<services::SshCredentials> parseTargets(const Json::Value& json);
+    // Конвейер одного сервера; выполняется в пуле DeploymentJobs. previous пуст - полный деплой
+    Json::Value runDeployment(services::DeploymentJob& job,
+                              int userId,
+                              const services::SshCredentials& target,
+                              const models::DatabaseConfig& config,
+                              const std::optional<models::Deployment>& previous,
+                              const DeployOptions& options);
+    // Настройки под железо сервера и профиль нагрузки; пусто - настройка не нужна или невозможна.
+    // Профиль по умолчанию: cache для Redis, oltp для остальных; none - без настройки
+    static services::PerformanceTuner::Settings tuningSettings(const std::string& dbType,
+                                                               const Json::Value& config,
+                                                               const services::RemoteState& state,
+                                                               const std::string& profile,
+                                                               Json::Value& report);
+    // План с учетом состояния сервера: выполненные шаги попадают в skipped.
+    // scriptTables=false - таблицы создаст DirectDeployer, шага create_tables нет
+    std::vector<services::DeployStep> generateDeploymentSteps(const std::string& dbType,
+                                                             const Json::Value& config,
+                                                             const services::RemoteState& state,
+                                                             const services::PerformanceTuner::Settings& tuning,
+                                                             bool scriptTables,
+                                                             Json::Value& skipped);
+    // Создание будущих разделов и удаление старых по retention; nullopt - обслуживать нечего
+    static std::optional<services::DeployStep> generatePartitionStep(const std::string& dbType,
+                                                                    const Json::Value& config,
+                                                                    const services::RemoteState& state,
+                                                                    int ahead);
+    // Только ALTER/CREATE/DROP между развернутой и текущей версией конфигурации
+    std::vector<services::DeployStep> generateMigrationSteps(const std::string& dbType,
+                                                            const Json::Value& previousConfig,
+                                                            const Json::Value& config);
+    std::vector<services::DeployStep> generatePostgresSteps(const Json::Value& config,
+                                                           const services::RemoteState& state,
+                                                           const services::PerformanceTuner::Settings& tuning,
+                                                           bool scriptTables,
+                                                           Json::Value& skipped);
+    std::vector<services::DeployStep> generateMysqlSteps(const Json::Value& config,
+                                                        const services::RemoteState& state,
+                                                        const services::PerformanceTuner::Settings& tuning,
+                                                        bool scriptTables,
+                                                        Json::Value& skipped);
+    std::vector<services::DeployStep> generateRedisSteps(const Json::Value& config,
+                                                        const services::RemoteState& state,
+                                                        const services::PerformanceTuner::Settings& tuning,
+                                                        Json::Value& skipped);
+    // Подключение к СУБД сервера для DirectDeployer: пользователь и порт из конфигурации
+    static services::DirectDeployer::Connection directConnection(sql::Dialect dialect,
+                                                                 const Json::Value& config,
+                                                                 size_t connections);
+    static void compileMissingTables(sql::Dialect dialect,
+                                     const Json::Value& tables,
+                                     const services::RemoteState& state,
+                                     std::string& out);
 };
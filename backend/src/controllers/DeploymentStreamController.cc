@@ -0,0 +1,70 @@
+#include "DeploymentStreamController.h"
+#include <drogon/drogon.h>
+#include "../services/DeploymentJobs.h"
+
+namespace {
+
+struct Subscription {
+    std::shared_ptr<services::DeploymentJob> job;
+    uint64_t id = 0;
+};
+
+bool isFinalEvent(const Json::Value& event) {
+    if (event["type"].asString() != "status") {
+        return false;
+    }
+    std::string status = event["status"].asString();
+    return status == "succeeded" || status == "failed";
+}
+
+// Закрываем из event loop: подписчика вызывает поток деплоя
+void closeLater(const std::weak_ptr<WebSocketConnection>& weakConn) {
+    app().getLoop()->queueInLoop([weakConn]() {
+        if (auto conn = weakConn.lock()) {
+            conn->shutdown(CloseCode::kNormalClosure);
+        }
+    });
+}
+
+} // namespace
+
+void DeploymentStreamController::handleNewMessage(const WebSocketConnectionPtr& /*conn*/,
+                                                  std::string&& /*message*/,
+                                                  const WebSocketMessageType& /*type*/) {
+    // Канал только на отправку; входящие сообщения (кроме ping) игнорируются
+}
+
+void DeploymentStreamController::handleNewConnection(const HttpRequestPtr& req,
+                                                     const WebSocketConnectionPtr& conn) {
+    auto userId = req->getAttributes()->get<int>("user_id");
+    auto job = services::DeploymentJobs::find(req->getParameter("job_id"));
+    if (!job || job->getUserId() != userId) {
+        conn->shutdown(CloseCode::kViolation, "Deployment job not found");
+        return;
+    }
+
+    std::weak_ptr<WebSocketConnection> weakConn = conn;
+    auto writer = std::make_shared<Json::StreamWriterBuilder>();
+    (*writer)["indentation"] = "";
+    auto subscription = std::make_shared<Subscription>();
+    subscription->job = job;
+    subscription->id = job->subscribe([weakConn, writer](const Json::Value& event) {
+        auto conn = weakConn.lock();
+        if (!conn) {
+            return;
+        }
+        conn->send(Json::writeString(*writer, event));
+        if (isFinalEvent(event)) {
+            closeLater(weakConn);
+        }
+    });
+    conn->setContext(subscription);
+}
+
+void DeploymentStreamController::handleConnectionClosed(const WebSocketConnectionPtr& conn) {
+    auto subscription = conn->getContext<Subscription>();
+    if (subscription && subscription->id != 0) {
+        subscription->job->unsubscribe(subscription->id);
+    }
+    conn->clearContext();
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <drogon/WebSocketController.h>
+
+using namespace drogon;
+
+// Живой журнал деплоя: /api/protected/deploy/stream?job_id=...
+// Сначала приходят уже накопленные события, затем новые; после финального
+// статуса сервер закрывает соединение.
+class DeploymentStreamController : public drogon::WebSocketController<DeploymentStreamController> {
+public:
+    WS_PATH_LIST_BEGIN
+        WS_PATH_ADD("/api/protected/deploy/stream", "WsJwtAuthFilter");
+    WS_PATH_LIST_END
+
+    void handleNewMessage(const WebSocketConnectionPtr& conn,
+                          std::string&& message,
+                          const WebSocketMessageType& type) override;
+    void handleNewConnection(const HttpRequestPtr& req,
+                             const WebSocketConnectionPtr& conn) override;
+    void handleConnectionClosed(const WebSocketConnectionPtr& conn) override;
+};
@@ -0,0 +1,55 @@
+#include "ETag.h"
+#include <cstdint>
+#include <cstdio>
+
+namespace etag {
+
+std::string forBody(const std::string& body) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : body) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+    return "\"b-" + std::string(hex) + "\"";
+}
+
+bool matches(const std::string& header, const std::string& tag, bool weak) {
+    size_t start = 0;
+    while (start < header.size()) {
+        size_t end = header.find(',', start);
+        if (end == std::string::npos) {
+            end = header.size();
+        }
+        size_t first = header.find_first_not_of(" \t", start);
+        size_t last = header.find_last_not_of(" \t", end - 1);
+        if (first != std::string::npos && first < end && last >= first) {
+            std::string item = header.substr(first, last - first + 1);
+            if (item == "*") {
+                return true;
+            }
+            if (item.compare(0, 2, "W/") == 0) {
+                if (!weak) {
+                    start = end + 1;
+                    continue;
+                }
+                item.erase(0, 2);
+            }
+            if (item == tag) {
+                return true;
+            }
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+drogon::HttpResponsePtr notModified(const std::string& tag) {
+    auto resp = drogon::HttpResponse::newHttpResponse();
+    resp->setStatusCode(drogon::k304NotModified);
+    resp->addHeader("ETag", tag);
+    return resp;
+}
+
+} // namespace etag
@@ -0,0 +1,19 @@
+#pragma once
+#include <drogon/HttpResponse.h>
+#include <string>
+
+// Сильные ETag и условные заголовки (RFC 9110): If-None-Match отвечает 304 без
+// тела, If-Match защищает запись от потерянных обновлений
+namespace etag {
+
+// ETag по байтам готового тела: FNV-1a, одинаковый во всех экземплярах
+std::string forBody(const std::string& body);
+
+// header - значение If-None-Match или If-Match: список тегов через запятую или *.
+// weak - слабое сравнение (If-None-Match): префикс W/ не учитывается;
+// для If-Match сравнение сильное и W/-теги не совпадают ни с чем
+bool matches(const std::string& header, const std::string& tag, bool weak);
+
+drogon::HttpResponsePtr notModified(const std::string& tag);
+
+} // namespace etag
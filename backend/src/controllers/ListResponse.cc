@@ -0,0 +1,60 @@
+#include "ListResponse.h"
+
+namespace listing {
+
+std::string parseListRequest(const drogon::HttpRequestPtr& req, ListRequest& request) {
+    std::string limit = req->getParameter("limit");
+    std::string cursor = req->getParameter("cursor");
+    request.ifNoneMatch = req->getHeader("If-None-Match");
+    request.paged = !limit.empty() || !cursor.empty();
+    if (!limit.empty()) {
+        if (limit.size() > 9 || limit.find_first_not_of("0123456789") != std::string::npos) {
+            return "Invalid limit parameter";
+        }
+        request.limit = std::stoul(limit);
+        if (request.limit == 0 || request.limit > MAX_PAGE_ROWS) {
+            return "limit must be from 1 to " + std::to_string(MAX_PAGE_ROWS);
+        }
+    }
+    if (!cursor.empty()) {
+        request.after = models::PageCursor::decode(cursor);
+        if (!request.after) {
+            return "Invalid cursor parameter";
+        }
+    }
+    return "";
+}
+
+void appendJson(const Json::Value& value, std::string& out) {
+    static const Json::StreamWriterBuilder writer = []() {
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "";
+        return builder;
+    }();
+    out += Json::writeString(writer, value);
+}
+
+drogon::HttpResponsePtr jsonBody(std::string body) {
+    auto resp = drogon::HttpResponse::newHttpResponse();
+    resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+    resp->setBody(std::move(body));
+    return resp;
+}
+
+drogon::HttpResponsePtr conditionalBody(const ListRequest& request, std::string body) {
+    std::string tag = etag::forBody(body);
+    if (!request.ifNoneMatch.empty() && etag::matches(request.ifNoneMatch, tag, true)) {
+        return etag::notModified(tag);
+    }
+    auto resp = jsonBody(std::move(body));
+    resp->addHeader("ETag", tag);
+    return resp;
+}
+
+drogon::HttpResponsePtr errorResponse(const std::string& message) {
+    auto resp = drogon::HttpResponse::newHttpJsonResponse(Json::Value(message));
+    resp->setStatusCode(drogon::k500InternalServerError);
+    return resp;
+}
+
+} // namespace listing
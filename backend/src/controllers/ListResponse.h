@@ -0,0 +1,167 @@
+#pragma once
+#include <drogon/HttpRequest.h>
+#include <drogon/HttpResponse.h>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "ETag.h"
+#include "../models/Database.h"
+
+// Списки пользователя (конфигурации, схемы) по ключу (created_at, id) от новых к старым.
+// С limit или cursor в строке запроса - одна страница {"items": [...], "next_cursor": ...};
+// без них - весь список массивом, как раньше, но по страницам: длинный список уходит
+// chunked-ответом, страница пишется в сокет, как только пришла из базы.
+namespace listing {
+
+constexpr size_t DEFAULT_PAGE_ROWS = 50;
+constexpr size_t MAX_PAGE_ROWS = 500;
+// Строк в одном запросе к базе при выдаче всего списка: столько держим в памяти на ответ
+constexpr size_t STREAM_PAGE_ROWS = 200;
+
+struct ListRequest {
+    bool paged = false;
+    size_t limit = DEFAULT_PAGE_ROWS;
+    std::optional<models::PageCursor> after;
+    // Готовое тело целиком с тем же ETag - 304 без тела
+    std::string ifNoneMatch;
+};
+
+// limit и cursor из строки запроса. Пустая строка - параметры в порядке, иначе текст ошибки
+std::string parseListRequest(const drogon::HttpRequestPtr& req, ListRequest& request);
+
+// Источник строк списка: запрос страницы, ключ строки и ее JSON, дописываемый в out
+template <typename Item>
+struct ListSource {
+    std::function<void(const std::optional<models::PageCursor>&, size_t,
+                       std::function<void(std::vector<Item>)>&&, models::DbErrorCallback&&)> fetch;
+    std::function<models::PageCursor(const Item&)> cursor;
+    std::function<void(const Item&, std::string&)> write;
+    // Необязательно: весь список без параметров уместился в одну страницу, тело готово целиком
+    std::function<void(const std::string&)> whole;
+};
+
+using Callback = std::function<void(const drogon::HttpResponsePtr&)>;
+
+// Однострочный JSON значения в конец out
+void appendJson(const Json::Value& value, std::string& out);
+drogon::HttpResponsePtr jsonBody(std::string body);
+// jsonBody с ETag по байтам тела или 304, если клиент прислал тот же тег
+drogon::HttpResponsePtr conditionalBody(const ListRequest& request, std::string body);
+drogon::HttpResponsePtr errorResponse(const std::string& message);
+
+// Дочитывает список страницами после первой и шлет их в открытый поток ответа
+template <typename Item>
+class ListStream : public std::enable_shared_from_this<ListStream<Item>> {
+public:
+    explicit ListStream(ListSource<Item> source) : source(std::move(source)) {}
+
+    void start(drogon::ResponseStreamPtr opened, const std::string& head, const models::PageCursor& after) {
+        stream = std::move(opened);
+        if (stream->send(head)) {
+            next(after);
+        }
+    }
+
+private:
+    void next(const models::PageCursor& after) {
+        auto self = this->shared_from_this();
+        source.fetch(
+            after, STREAM_PAGE_ROWS,
+            [self](std::vector<Item> items) {
+                std::string chunk;
+                for (const auto& item : items) {
+                    chunk += ',';
+                    self->source.write(item, chunk);
+                }
+                bool last = items.size() < STREAM_PAGE_ROWS;
+                if (last) {
+                    chunk += ']';
+                }
+                // false - клиент отключился, дальше читать незачем
+                if (!self->stream->send(chunk)) {
+                    return;
+                }
+                if (last) {
+                    self->stream->close();
+                } else {
+                    self->next(self->source.cursor(items.back()));
+                }
+            },
+            [self](const std::exception& e) {
+                // Статус уже ушел: оборванный массив без ] клиент не примет за полный список
+                LOG_ERROR << "List stream aborted: " << e.what();
+                self->stream->close();
+            });
+    }
+
+    ListSource<Item> source;
+    drogon::ResponseStreamPtr stream;
+};
+
+template <typename Item>
+void respondList(const ListRequest& request, ListSource<Item> source, Callback callback) {
+    auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+    auto sourcePtr = std::make_shared<ListSource<Item>>(std::move(source));
+    auto onError = [callbackPtr](const std::exception& e) { (*callbackPtr)(errorResponse(e.what())); };
+    auto requestPtr = std::make_shared<ListRequest>(request);
+
+    if (request.paged) {
+        // Лишняя строка говорит, есть ли следующая страница, без отдельного COUNT
+        size_t limit = request.limit;
+        sourcePtr->fetch(
+            request.after, limit + 1,
+            [callbackPtr, sourcePtr, requestPtr, limit](std::vector<Item> items) {
+                bool more = items.size() > limit;
+                if (more) {
+                    items.resize(limit);
+                }
+                std::string body = "{\"items\":[";
+                for (size_t i = 0; i < items.size(); ++i) {
+                    if (i > 0) {
+                        body += ',';
+                    }
+                    sourcePtr->write(items[i], body);
+                }
+                body += "],\"next_cursor\":";
+                body += more ? "\"" + sourcePtr->cursor(items.back()).encode() + "\"" : "null";
+                body += '}';
+                (*callbackPtr)(conditionalBody(*requestPtr, std::move(body)));
+            },
+            std::move(onError));
+        return;
+    }
+
+    // Первая страница до ответа: ошибка базы - обычный 500, короткий список - обычное тело
+    sourcePtr->fetch(
+        std::nullopt, STREAM_PAGE_ROWS,
+        [callbackPtr, sourcePtr, requestPtr](std::vector<Item> items) {
+            std::string head = "[";
+            for (size_t i = 0; i < items.size(); ++i) {
+                if (i > 0) {
+                    head += ',';
+                }
+                sourcePtr->write(items[i], head);
+            }
+            if (items.size() < STREAM_PAGE_ROWS) {
+                head += ']';
+                if (sourcePtr->whole) {
+                    sourcePtr->whole(head);
+                }
+                (*callbackPtr)(conditionalBody(*requestPtr, std::move(head)));
+                return;
+            }
+            auto list = std::make_shared<ListStream<Item>>(*sourcePtr);
+            models::PageCursor after = sourcePtr->cursor(items.back());
+            auto resp = drogon::HttpResponse::newAsyncStreamResponse(
+                [list, head = std::move(head), after](drogon::ResponseStreamPtr stream) {
+                    list->start(std::move(stream), head, after);
+                });
+            resp->setContentTypeCode(drogon::CT_APPLICATION_JSON);
+            (*callbackPtr)(resp);
+        },
+        std::move(onError));
+}
+
+} // namespace listing
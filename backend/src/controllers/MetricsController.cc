@@ -0,0 +1,21 @@
+#include "MetricsController.h"
+#include "../filters/JwtAuthFilter.h"
+#include "../models/Database.h"
+#include "../models/ModelCache.h"
+#include "../services/DeploymentJobs.h"
+#include "../services/PasswordHasher.h"
+#include "../services/SshSessionPool.h"
+
+void MetricsController::getMetrics(const HttpRequestPtr& req,
+                                   std::function<void(const HttpResponsePtr&)>&& callback) {
+    Json::Value result;
+    result["db"] = models::Database::metrics();
+    result["jwt_cache"] = JwtAuthFilter::cacheMetrics();
+    result["model_cache"] = models::ModelCache::metrics();
+    result["bcrypt"] = services::PasswordHasher::metrics();
+    result["deploy"] = services::DeploymentJobs::metrics();
+    result["ssh_pool"] = services::SshSessionPool::metrics();
+
+    auto resp = HttpResponse::newHttpJsonResponse(result);
+    callback(resp);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <drogon/HttpController.h>
+#include <json/json.h>
+
+using namespace drogon;
+
+// Метрики сервиса для мониторинга насыщения пулов
+class MetricsController : public drogon::HttpController<MetricsController> {
+public:
+    METHOD_LIST_BEGIN
+        ADD_METHOD_TO(MetricsController::getMetrics, "/api/protected/metrics", Get, "JwtAuthFilter");
+    METHOD_LIST_END
+
+    void getMetrics(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback);
+};
@@ -1,4 +1,125 @@
 #include "SchemaController.h"
+#include "ETag.h"
+#include "ListResponse.h"
+#include "../models/Benchmark.h"
+#include "../services/BenchmarkRunner.h"
+#include "../services/DataSeeder.h"
+#include "../services/DeploymentJobs.h"
+#include "../utils/JsonPatch.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+using Callback = std::function<void(const HttpResponsePtr&)>;
+
+void respondError(const std::shared_ptr<Callback>& callback,
+                  const std::string& message, HttpStatusCode code) {
+  drogon::HttpResponsePtr resp =
+      HttpResponse::newHttpJsonResponse(Json::Value(message));
+  resp->setStatusCode(code);
+  (*callback)(resp);
+}
+
+// 412: схема изменилась после того, как клиент ее прочитал
+void respondPreconditionFailed(const std::shared_ptr<Callback>& callback,
+                               const std::string& currentTag) {
+  drogon::HttpResponsePtr resp = HttpResponse::newHttpJsonResponse(
+      Json::Value("Schema was modified by another request"));
+  resp->setStatusCode(k412PreconditionFailed);
+  if (!currentTag.empty()) {
+    resp->addHeader("ETag", currentTag);
+  }
+  (*callback)(resp);
+}
+
+// Диалект для проверки типов: поле dialect (или type) в теле, по умолчанию PostgreSQL
+sql::Dialect requestDialect(const Json::Value& json) {
+  std::string name = json.isMember("dialect") ? json["dialect"].asString()
+                                              : json["type"].asString();
+  return sql::parseDialect(name).value_or(sql::Dialect::PostgreSQL);
+}
+
+Json::Value validationResult(const std::vector<sql::ValidationError>& errors) {
+  Json::Value result;
+  result["valid"] = errors.empty();
+  result["errors"] = Json::Value(Json::arrayValue);
+  for (const auto& error : errors) {
+    result["errors"].append(error.toJson());
+  }
+  return result;
+}
+
+// Сервер и база из тела запроса заполнения или замера
+services::SshCredentials requestTarget(const Json::Value& json) {
+  services::SshCredentials target;
+  target.host = json["host"].asString();
+  target.port = json.get("port", 22).asInt();
+  target.username = json["username"].asString();
+  target.password = json["password"].asString();
+  return target;
+}
+
+// rows - строк в каждой таблице, table_rows - переопределения по имени таблицы.
+// Пустая строка - параметры в порядке, иначе текст ошибки
+std::string generatorOptions(const Json::Value& json, uint64_t maxRows,
+                             sql::DataGenerator::Options& options) {
+  options.rows = json.get("rows", 1000).asUInt64();
+  options.seed = json.get("seed", 1).asUInt64();
+  bool tooMany = options.rows > maxRows;
+  const Json::Value& tableRows = json["table_rows"];
+  for (const auto& name : tableRows.getMemberNames()) {
+    std::string key = name;
+    std::transform(key.begin(), key.end(), key.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    options.tableRows[key] = tableRows[name].asUInt64();
+    tooMany = tooMany || options.tableRows[key] > maxRows;
+  }
+  if (tooMany) {
+    return "rows must not exceed " + std::to_string(maxRows) + " per table";
+  }
+  return "";
+}
+
+// Номер версии из строки запроса; nullopt - параметра нет или это не номер
+std::optional<int> versionParameter(const std::string& text) {
+  if (text.empty() || text.size() > 9 ||
+      text.find_first_not_of("0123456789") != std::string::npos) {
+    return std::nullopt;
+  }
+  int version = std::stoi(text);
+  return version > 0 ? std::optional<int>(version) : std::nullopt;
+}
+
+// Продолжает с next, если схема есть и принадлежит пользователю. Документ не
+// читается: истории хватает владельца и текущей версии
+void withOwnSchema(const std::shared_ptr<Callback>& callback, int schemaId,
+                   int userId,
+                   std::function<void(const models::Schema::Stamp&)> next) {
+  models::Schema::findStampAsync(
+      schemaId,
+      [callback, userId,
+       next = std::move(next)](std::optional<models::Schema::Stamp> stamp) {
+        if (!stamp) {
+          respondError(callback, "Schema not found", k404NotFound);
+          return;
+        }
+        if (stamp->userId != userId) {
+          respondError(callback, "Schema doesn't belong to user",
+                       k403Forbidden);
+          return;
+        }
+        next(*stamp);
+      },
+      [callback](const std::exception& e) {
+        respondError(callback, e.what(), k500InternalServerError);
+      });
+}
+
+}  // namespace
 
 void SchemaController::createSchema(
     const HttpRequestPtr& req,
@@ -13,25 +134,26 @@ void SchemaController::createSchema(
 
   int userId = req->getAttributes()->get<int>("user_id");
 
-  try {
-    models::Schema schema =
-        models::Schema::create(userId, (*json)["name"].asString(),
-                               (*json)["tables"], (*json)["relations"]);
-
-    if (!schema.validate()) {
-      drogon::HttpResponsePtr resp =
-          HttpResponse::newHttpJsonResponse(Json::Value("Invalid schema"));
-      resp->setStatusCode(k400BadRequest);
-      callback(resp);
-      return;
-    }
-    callback(HttpResponse::newHttpJsonResponse(schema.toJson()));
-  } catch (const std::exception& e) {
+  models::Schema draft = models::Schema::fromJson(*json);
+  std::vector<sql::ValidationError> errors =
+      draft.validationErrors(requestDialect(*json));
+  if (!errors.empty()) {
     drogon::HttpResponsePtr resp =
-        HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
-    resp->setStatusCode(k500InternalServerError);
+        HttpResponse::newHttpJsonResponse(validationResult(errors));
+    resp->setStatusCode(k400BadRequest);
     callback(resp);
+    return;
   }
+
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+  models::Schema::createAsync(
+      userId, draft.name, draft.description, draft.tables, draft.relations,
+      [callbackPtr](models::Schema schema) {
+        (*callbackPtr)(HttpResponse::newHttpJsonResponse(schema.toJson()));
+      },
+      [callbackPtr](const std::exception& e) {
+        respondError(callbackPtr, e.what(), k500InternalServerError);
+      });
 }
 
 void SchemaController::getSchemas(
@@ -39,43 +161,85 @@ void SchemaController::getSchemas(
     std::function<void(const HttpResponsePtr&)>&& callback) {
   int userId = req->getAttributes()->get<int>("user_id");
 
-  try {
-    std::vector<models::Schema> schemas = models::Schema::findByUserId(userId);
-    Json::Value result(Json::arrayValue);
-    for (const auto& schema : schemas) {
-      result.append(schema.toJson());
-    }
-    callback(HttpResponse::newHttpJsonResponse(result));
-  } catch (const std::exception& e) {
-    drogon::HttpResponsePtr resp =
-        HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
-    resp->setStatusCode(k500InternalServerError);
-    callback(resp);
+  listing::ListRequest request;
+  std::string error = listing::parseListRequest(req, request);
+  if (!error.empty()) {
+    respondError(std::make_shared<Callback>(std::move(callback)), error,
+                 k400BadRequest);
+    return;
   }
+
+  listing::ListSource<models::Schema> source;
+  source.fetch = [userId](
+                     const std::optional<models::PageCursor>& after,
+                     size_t limit,
+                     std::function<void(std::vector<models::Schema>)>&& onPage,
+                     models::DbErrorCallback&& onError) {
+    models::Schema::findPageByUserIdAsync(userId, after, limit,
+                                          std::move(onPage),
+                                          std::move(onError));
+  };
+  source.cursor = [](const models::Schema& schema) { return schema.cursor(); };
+  source.write = [](const models::Schema& schema, std::string& out) {
+    listing::appendJson(schema.toJson(), out);
+  };
+  listing::respondList(request, std::move(source), std::move(callback));
 }
 
 void SchemaController::getSchema(
     const HttpRequestPtr& req,
-    std::function<void(const HttpResponsePtr&)>&& callback) {
-  int schemaId = req->getAttributes()->get<int>("id");
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId) {
   int userId = req->getAttributes()->get<int>("user_id");
-  try {
-    models::Schema schema = models::Schema::findById(schemaId);
-    if (schema.userId != userId) {
-      throw(std::exception("Schema doesn't belong to user"));
+
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+  auto sendSchema = [callbackPtr, userId](std::shared_ptr<const models::Schema> schema) {
+    if (!schema) {
+      respondError(callbackPtr, "Schema not found", k404NotFound);
+      return;
+    }
+    if (schema->userId != userId) {
+      respondError(callbackPtr, "Schema doesn't belong to user",
+                   k403Forbidden);
+      return;
     }
-    callback(HttpResponse::newHttpJsonResponse(schema.toJson()));
-  } catch (const std::exception& e) {
     drogon::HttpResponsePtr resp =
-        HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
-    resp->setStatusCode(k500InternalServerError);
-    callback(resp);
+        HttpResponse::newHttpJsonResponse(schema->toJson());
+    resp->addHeader("ETag", schema->etag());
+    (*callbackPtr)(resp);
+  };
+  auto onError = [callbackPtr](const std::exception& e) {
+    respondError(callbackPtr, e.what(), k500InternalServerError);
+  };
+
+  std::string ifNoneMatch = req->getHeader("If-None-Match");
+  if (ifNoneMatch.empty()) {
+    models::Schema::findByIdAsync(schemaId, std::move(sendSchema),
+                                  std::move(onError));
+    return;
   }
+  // Сначала только владелец и версия: совпавший ETag - 304 без документа
+  models::Schema::findStampAsync(
+      schemaId,
+      [callbackPtr, userId, schemaId, ifNoneMatch, sendSchema,
+       onError](std::optional<models::Schema::Stamp> stamp) mutable {
+        if (stamp && stamp->userId == userId) {
+          std::string tag = models::Schema::etagFor(schemaId, stamp->version);
+          if (etag::matches(ifNoneMatch, tag, true)) {
+            (*callbackPtr)(etag::notModified(tag));
+            return;
+          }
+        }
+        models::Schema::findByIdAsync(schemaId, std::move(sendSchema),
+                                      std::move(onError));
+      },
+      [callbackPtr](const std::exception& e) {
+        respondError(callbackPtr, e.what(), k500InternalServerError);
+      });
 }
 
 void SchemaController::updateSchema(
     const HttpRequestPtr& req,
-    std::function<void(const HttpResponsePtr&)>&& callback) {
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId) {
   std::shared_ptr<Json::Value> json = req->getJsonObject();
   if (!json) {
     drogon::HttpResponsePtr resp = HttpResponse::newHttpJsonResponse(Json::Value("Invalid JSON"));
@@ -83,64 +247,712 @@ void SchemaController::updateSchema(
     callback(resp);
     return;
   }
-  int schemaId = req->getAttributes()->get<int>("id");
+  // Без If-Match два редактора молча затирали бы изменения друг друга
+  std::string ifMatch = req->getHeader("If-Match");
+  if (ifMatch.empty()) {
+    drogon::HttpResponsePtr resp = HttpResponse::newHttpJsonResponse(
+        Json::Value("If-Match header with the schema ETag is required"));
+    resp->setStatusCode(k428PreconditionRequired);
+    callback(resp);
+    return;
+  }
   int userId = req->getAttributes()->get<int>("user_id");
+
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+  models::Schema::findByIdAsync(
+      schemaId,
+      [callbackPtr, userId, json, ifMatch](std::shared_ptr<const models::Schema> schema) {
+        if (!schema) {
+          respondError(callbackPtr, "Schema not found", k404NotFound);
+          return;
+        }
+        if (schema->userId != userId) {
+          respondError(callbackPtr, "Schema doesn't belong to user",
+                       k403Forbidden);
+          return;
+        }
+        if (!etag::matches(ifMatch, schema->etag(), false)) {
+          respondPreconditionFailed(callbackPtr, schema->etag());
+          return;
+        }
+        // Проверяется итоговый документ, как при создании
+        std::vector<sql::ValidationError> errors =
+            schema->merged(*json).validationErrors(requestDialect(*json));
+        if (!errors.empty()) {
+          drogon::HttpResponsePtr resp =
+              HttpResponse::newHttpJsonResponse(validationResult(errors));
+          resp->setStatusCode(k400BadRequest);
+          (*callbackPtr)(resp);
+          return;
+        }
+        schema->updateAsync(
+            *json,
+            [callbackPtr](std::optional<models::Schema> updated) {
+              // Версия сменилась между чтением и UPDATE; актуальный ETag клиент получит GET-ом
+              if (!updated) {
+                respondPreconditionFailed(callbackPtr, "");
+                return;
+              }
+              drogon::HttpResponsePtr resp =
+                  HttpResponse::newHttpJsonResponse(updated->toJson());
+              resp->addHeader("ETag", updated->etag());
+              (*callbackPtr)(resp);
+            },
+            [callbackPtr](const std::exception& e) {
+              respondError(callbackPtr, e.what(), k500InternalServerError);
+            });
+      },
+      [callbackPtr](const std::exception& e) {
+        respondError(callbackPtr, e.what(), k500InternalServerError);
+      });
+}
+
+void SchemaController::patchSchema(
+    const HttpRequestPtr& req,
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId) {
+  // application/json-patch+json Drogon тоже разбирает как JSON
+  std::shared_ptr<Json::Value> json = req->getJsonObject();
+  if (!json) {
+    drogon::HttpResponsePtr resp = HttpResponse::newHttpJsonResponse(Json::Value("Invalid JSON"));
+    resp->setStatusCode(k400BadRequest);
+    callback(resp);
+    return;
+  }
+  std::shared_ptr<utils::JsonPatch> patch;
   try {
-    models::Schema schema = models::Schema::findById(schemaId);
-    if (schema.userId != userId) {
-      throw(std::exception("Schema doesn't belong to user"));
-    }
-    schema.update(*json);
-  } catch(const std::exception& e){
-    drogon::HttpResponsePtr resp =
-        HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
-    resp->setStatusCode(k500InternalServerError);
+    patch = std::make_shared<utils::JsonPatch>(*json);
+  } catch (const utils::JsonPatch::Error& e) {
+    drogon::HttpResponsePtr resp = HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
+    resp->setStatusCode(k400BadRequest);
     callback(resp);
+    return;
   }
+  if (patch->size() > MAX_PATCH_OPERATIONS) {
+    drogon::HttpResponsePtr resp = HttpResponse::newHttpJsonResponse(Json::Value(
+        "Patch must not exceed " + std::to_string(MAX_PATCH_OPERATIONS) + " operations"));
+    resp->setStatusCode(k413RequestEntityTooLarge);
+    callback(resp);
+    return;
+  }
+  std::string ifMatch = req->getHeader("If-Match");
+  if (ifMatch.empty()) {
+    drogon::HttpResponsePtr resp = HttpResponse::newHttpJsonResponse(
+        Json::Value("If-Match header with the schema ETag is required"));
+    resp->setStatusCode(k428PreconditionRequired);
+    callback(resp);
+    return;
+  }
+  // Тело - массив операций, поэтому диалект проверки типов - в ?dialect=
+  sql::Dialect dialect = sql::parseDialect(req->getParameter("dialect"))
+                             .value_or(sql::Dialect::PostgreSQL);
+  int userId = req->getAttributes()->get<int>("user_id");
+
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+  models::Schema::findByIdAsync(
+      schemaId,
+      [callbackPtr, userId, patch, ifMatch,
+       dialect](std::shared_ptr<const models::Schema> schema) {
+        if (!schema) {
+          respondError(callbackPtr, "Schema not found", k404NotFound);
+          return;
+        }
+        if (schema->userId != userId) {
+          respondError(callbackPtr, "Schema doesn't belong to user",
+                       k403Forbidden);
+          return;
+        }
+        if (!etag::matches(ifMatch, schema->etag(), false)) {
+          respondPreconditionFailed(callbackPtr, schema->etag());
+          return;
+        }
+        // Патч применяется к тем же полям, что принимает PUT; документ из кэша
+        // общий, поэтому правится его копия
+        models::Schema patched = *schema;
+        Json::Value document;
+        document["name"] = patched.name;
+        document["description"] = patched.description;
+        document["tables"] = std::move(patched.tables);
+        document["relations"] = std::move(patched.relations);
+        std::vector<utils::JsonPatch::Edit> edits;
+        try {
+          edits = patch->apply(document);
+        } catch (const utils::JsonPatch::Error& e) {
+          // Не прошел test - клиент правил не ту версию документа
+          respondError(callbackPtr, e.what(),
+                       e.conflict ? k409Conflict : k422UnprocessableEntity);
+          return;
+        }
+        if (document.size() != 4 || !document["name"].isString() ||
+            !document["description"].isString() ||
+            !document["tables"].isArray() || !document["relations"].isArray()) {
+          respondError(callbackPtr,
+                       "Patched schema must keep string name and description "
+                       "and array tables and relations",
+                       k422UnprocessableEntity);
+          return;
+        }
+        patched.name = document["name"].asString();
+        patched.description = document["description"].asString();
+        patched.tables = std::move(document["tables"]);
+        patched.relations = std::move(document["relations"]);
+        // PATCH - такой же путь записи, как PUT: итог проверяется целиком
+        std::vector<sql::ValidationError> errors =
+            patched.validationErrors(dialect);
+        if (!errors.empty()) {
+          drogon::HttpResponsePtr resp =
+              HttpResponse::newHttpJsonResponse(validationResult(errors));
+          resp->setStatusCode(k422UnprocessableEntity);
+          (*callbackPtr)(resp);
+          return;
+        }
+        schema->patchAsync(
+            edits, patched,
+            [callbackPtr](std::optional<models::Schema> updated) {
+              if (!updated) {
+                respondPreconditionFailed(callbackPtr, "");
+                return;
+              }
+              Json::Value result;
+              result["id"] = updated->id;
+              result["version"] = updated->version;
+              result["updatedAt"] = updated->updatedAt;
+              drogon::HttpResponsePtr resp = HttpResponse::newHttpJsonResponse(result);
+              resp->addHeader("ETag", updated->etag());
+              (*callbackPtr)(resp);
+            },
+            [callbackPtr](const std::exception& e) {
+              respondError(callbackPtr, e.what(), k500InternalServerError);
+            });
+      },
+      [callbackPtr](const std::exception& e) {
+        respondError(callbackPtr, e.what(), k500InternalServerError);
+      });
 }
 
 void SchemaController::deleteSchema(
+    const HttpRequestPtr& req,
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId) {
+  int userId = req->getAttributes()->get<int>("user_id");
+
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+  models::Schema::findByIdAsync(
+      schemaId,
+      [callbackPtr, userId](std::shared_ptr<const models::Schema> schema) {
+        if (!schema) {
+          respondError(callbackPtr, "Schema not found", k404NotFound);
+          return;
+        }
+        if (schema->userId != userId) {
+          respondError(callbackPtr, "Schema doesn't belong to user",
+                       k403Forbidden);
+          return;
+        }
+        Json::Value removed = schema->toJson();
+        schema->removeAsync(
+            [callbackPtr, removed](bool) {
+              (*callbackPtr)(HttpResponse::newHttpJsonResponse(removed));
+            },
+            [callbackPtr](const std::exception& e) {
+              respondError(callbackPtr, e.what(), k500InternalServerError);
+            });
+      },
+      [callbackPtr](const std::exception& e) {
+        respondError(callbackPtr, e.what(), k500InternalServerError);
+      });
+}
+
+void SchemaController::validateSchema(
     const HttpRequestPtr& req,
     std::function<void(const HttpResponsePtr&)>&& callback) {
-  int schemaId = req->getAttributes()->get<int>("id");
+  auto json = req->getJsonObject();
+  if (!json) {
+    auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Invalid JSON"));
+    resp->setStatusCode(k400BadRequest);
+    callback(resp);
+    return;
+  }
+
+  // Проверка идёт в памяти без обращения к БД, поэтому выполняется прямо в IO-потоке
+  std::vector<sql::ValidationError> errors =
+      sql::SchemaValidator(requestDialect(*json))
+          .validate((*json)["tables"], (*json)["relations"]);
+  callback(HttpResponse::newHttpJsonResponse(validationResult(errors)));
+}
+
+void SchemaController::generateSql(
+    const HttpRequestPtr& req,
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId) {
   int userId = req->getAttributes()->get<int>("user_id");
-  try {
-    models::Schema schema = models::Schema::findById(schemaId);
-    if (schema.userId != userId) {
-      throw(std::exception("Schema doesn't belong to user"));
-    }
-    schema.remove();
-    callback(HttpResponse::newHttpJsonResponse(schema.toJson()));
-  } catch (const std::exception& e) {
-    drogon::HttpResponsePtr resp =
-        HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
-    resp->setStatusCode(k500InternalServerError);
+  std::string dbType = req->getParameter("type");
+
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+  if (!sql::parseDialect(dbType)) {
+    respondError(callbackPtr, "Unknown type: expected postgresql or mysql",
+                 k400BadRequest);
+    return;
+  }
+  models::Schema::findByIdAsync(
+      schemaId,
+      [callbackPtr, userId, dbType](std::shared_ptr<const models::Schema> schema) {
+        if (!schema) {
+          respondError(callbackPtr, "Schema not found", k404NotFound);
+          return;
+        }
+        if (schema->userId != userId) {
+          respondError(callbackPtr, "Schema doesn't belong to user",
+                       k403Forbidden);
+          return;
+        }
+        try {
+          Json::Value result;
+          result["sql"] = schema->generateSql(dbType);
+          (*callbackPtr)(HttpResponse::newHttpJsonResponse(result));
+        } catch (const std::exception& e) {
+          respondError(callbackPtr, e.what(), k500InternalServerError);
+        }
+      },
+      [callbackPtr](const std::exception& e) {
+        respondError(callbackPtr, e.what(), k500InternalServerError);
+      });
+}
+
+void SchemaController::seedSchema(
+    const HttpRequestPtr& req,
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId) {
+  auto json = req->getJsonObject();
+  if (!json) {
+    auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Invalid JSON"));
+    resp->setStatusCode(k400BadRequest);
     callback(resp);
+    return;
   }
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+
+  std::optional<sql::Dialect> dialect =
+      sql::parseDialect(json->get("type", "postgresql").asString());
+  services::SshCredentials target = requestTarget(*json);
+  std::string database = (*json)["database"].asString();
+  if (!dialect) {
+    respondError(callbackPtr, "Unknown type: expected postgresql or mysql",
+                 k400BadRequest);
+    return;
+  }
+  if (target.host.empty() || database.empty()) {
+    respondError(callbackPtr, "host and database are required", k400BadRequest);
+    return;
+  }
+
+  sql::DataGenerator::Options options;
+  std::string optionsError = generatorOptions(*json, MAX_SEED_ROWS, options);
+  if (!optionsError.empty()) {
+    respondError(callbackPtr, optionsError, k400BadRequest);
+    return;
+  }
+  size_t parallelism = json->get("parallelism", 4).asUInt();
+
+  int userId = req->getAttributes()->get<int>("user_id");
+  models::Schema::findByIdAsync(
+      schemaId,
+      [callbackPtr, userId, dialect = *dialect, target, database, options,
+       parallelism](std::shared_ptr<const models::Schema> schema) {
+        if (!schema) {
+          respondError(callbackPtr, "Schema not found", k404NotFound);
+          return;
+        }
+        if (schema->userId != userId) {
+          respondError(callbackPtr, "Schema doesn't belong to user",
+                       k403Forbidden);
+          return;
+        }
+        std::vector<sql::ValidationError> errors = schema->validationErrors(dialect);
+        if (!errors.empty()) {
+          drogon::HttpResponsePtr resp =
+              HttpResponse::newHttpJsonResponse(validationResult(errors));
+          resp->setStatusCode(k400BadRequest);
+          (*callbackPtr)(resp);
+          return;
+        }
+
+        // План генерации строится сразу: неподдерживаемые NOT NULL колонки - ошибка запроса
+        std::shared_ptr<const sql::DataGenerator> generator;
+        try {
+          generator = std::make_shared<const sql::DataGenerator>(dialect, schema->tables, options);
+        } catch (const std::invalid_argument& e) {
+          respondError(callbackPtr, e.what(), k400BadRequest);
+          return;
+        }
+
+        auto job = services::DeploymentJobs::create(userId, 0, {target});
+        Json::Value accepted;
+        accepted["job_id"] = job->getId();
+        accepted["status"] = "queued";
+        accepted["schema_id"] = schema->id;
+        accepted["tables"] = Json::Value(Json::arrayValue);
+        for (Json::ArrayIndex i = 0; i < generator->tableCount(); ++i) {
+          Json::Value table;
+          table["name"] = generator->tableName(i);
+          table["rows"] = static_cast<Json::UInt64>(generator->rowCount(i));
+          accepted["tables"].append(std::move(table));
+        }
+        auto resp = HttpResponse::newHttpJsonResponse(accepted);
+        resp->setStatusCode(k202Accepted);
+        (*callbackPtr)(resp);
+
+        // Повтор после частичной загрузки упрется в дубликаты ключей, поэтому без повторов
+        services::DeploymentJobs::submit(
+            job, {target}, 0,
+            [generator, dialect, database, parallelism](
+                services::DeploymentJob& job, const services::SshCredentials& target) {
+              Json::Value result;
+              result["tables"] = services::DataSeeder::run(job, target, dialect, database,
+                                                           *generator, parallelism);
+              Json::UInt64 rows = 0;
+              for (const auto& table : result["tables"]) {
+                rows += table["rows"].asUInt64();
+              }
+              result["rows"] = rows;
+              result["message"] = "Database seeded successfully";
+              return result;
+            });
+      },
+      [callbackPtr](const std::exception& e) {
+        respondError(callbackPtr, e.what(), k500InternalServerError);
+      });
 }
 
-void SchemaController::validateSchema(
+void SchemaController::benchmarkSchema(
     const HttpRequestPtr& req,
-    std::function<void(const HttpResponsePtr&)>&& callback) {}
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId) {
+  auto json = req->getJsonObject();
+  if (!json) {
+    auto resp = HttpResponse::newHttpJsonResponse(Json::Value("Invalid JSON"));
+    resp->setStatusCode(k400BadRequest);
+    callback(resp);
+    return;
+  }
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
 
-void SchemaController::generateSql(
+  std::optional<sql::Dialect> dialect =
+      sql::parseDialect(json->get("type", "postgresql").asString());
+  services::SshCredentials target = requestTarget(*json);
+  std::string database = (*json)["database"].asString();
+  if (!dialect) {
+    respondError(callbackPtr, "Unknown type: expected postgresql or mysql",
+                 k400BadRequest);
+    return;
+  }
+  if (target.host.empty() || database.empty()) {
+    respondError(callbackPtr, "host and database are required", k400BadRequest);
+    return;
+  }
+
+  // rows, seed и table_rows - те же, что при заполнении: запросы ищут загруженные строки
+  sql::DataGenerator::Options options;
+  std::string optionsError = generatorOptions(*json, MAX_SEED_ROWS, options);
+  if (!optionsError.empty()) {
+    respondError(callbackPtr, optionsError, k400BadRequest);
+    return;
+  }
+  services::BenchmarkRunner::Options runOptions;
+  runOptions.clients = json->get("clients", 4).asUInt();
+  runOptions.queriesPerClient = json->get("queries", 1000).asUInt64();
+  if (runOptions.clients == 0 || runOptions.clients > MAX_BENCHMARK_CLIENTS ||
+      runOptions.queriesPerClient == 0 || runOptions.queriesPerClient > MAX_BENCHMARK_QUERIES ||
+      runOptions.clients * runOptions.queriesPerClient > MAX_BENCHMARK_QUERIES) {
+    respondError(callbackPtr,
+                 "clients must be 1.." + std::to_string(MAX_BENCHMARK_CLIENTS) +
+                     " and clients * queries at most " + std::to_string(MAX_BENCHMARK_QUERIES),
+                 k400BadRequest);
+    return;
+  }
+  sql::Workload::Options workloadOptions;
+  workloadOptions.maxShapes = json->get("max_shapes", 24).asUInt();
+  workloadOptions.inserts = runOptions.clients * runOptions.queriesPerClient;
+  workloadOptions.seed = options.seed;
+
+  int userId = req->getAttributes()->get<int>("user_id");
+  models::Schema::findByIdAsync(
+      schemaId,
+      [callbackPtr, userId, dialect = *dialect, target, database, options, runOptions,
+       workloadOptions](std::shared_ptr<const models::Schema> schema) {
+        if (!schema) {
+          respondError(callbackPtr, "Schema not found", k404NotFound);
+          return;
+        }
+        if (schema->userId != userId) {
+          respondError(callbackPtr, "Schema doesn't belong to user",
+                       k403Forbidden);
+          return;
+        }
+        std::vector<sql::ValidationError> errors = schema->validationErrors(dialect);
+        if (!errors.empty()) {
+          drogon::HttpResponsePtr resp =
+              HttpResponse::newHttpJsonResponse(validationResult(errors));
+          resp->setStatusCode(k400BadRequest);
+          (*callbackPtr)(resp);
+          return;
+        }
+
+        // Workload держит ссылку на генератор: оба живут до конца задачи
+        std::shared_ptr<const sql::DataGenerator> generator;
+        try {
+          generator = std::make_shared<const sql::DataGenerator>(dialect, schema->tables, options);
+        } catch (const std::invalid_argument& e) {
+          respondError(callbackPtr, e.what(), k400BadRequest);
+          return;
+        }
+        auto workload = std::make_shared<const sql::Workload>(*generator, schema->tables,
+                                                              workloadOptions);
+        if (workload->shapes().empty()) {
+          respondError(callbackPtr, "Schema has no tables with rows to benchmark",
+                       k400BadRequest);
+          return;
+        }
+
+        auto job = services::DeploymentJobs::create(userId, 0, {target});
+        Json::Value accepted;
+        accepted["job_id"] = job->getId();
+        accepted["status"] = "queued";
+        accepted["schema_id"] = schema->id;
+        accepted["schema_version"] = std::atoi(schema->version.c_str());
+        accepted["shapes"] = Json::Value(Json::arrayValue);
+        for (const auto& shape : workload->shapes()) {
+          accepted["shapes"].append(shape.name);
+        }
+        auto resp = HttpResponse::newHttpJsonResponse(accepted);
+        resp->setStatusCode(k202Accepted);
+        (*callbackPtr)(resp);
+
+        // Повтор после вставок упрется в дубликаты ключей, поэтому без повторов
+        int schemaVersion = std::atoi(schema->version.c_str());
+        services::DeploymentJobs::submit(
+            job, {target}, 0,
+            [generator, workload, dialect, database, runOptions, userId, schemaId = schema->id,
+             schemaVersion, rows = options.rows](
+                services::DeploymentJob& job, const services::SshCredentials& target) {
+              Json::Value result = services::BenchmarkRunner::run(job, target, dialect, database,
+                                                                  *workload, runOptions);
+              models::Benchmark benchmark = models::Benchmark::record(
+                  userId, schemaId, schemaVersion, sql::dialectName(dialect), target.host,
+                  static_cast<int>(runOptions.clients), rows, result);
+              result["benchmark_id"] = benchmark.getId();
+              result["message"] = "Benchmark completed successfully";
+              return result;
+            });
+      },
+      [callbackPtr](const std::exception& e) {
+        respondError(callbackPtr, e.what(), k500InternalServerError);
+      });
+}
+
+void SchemaController::getBenchmarks(
     const HttpRequestPtr& req,
-    std::function<void(const HttpResponsePtr&)>&& callback) {
-  try {
-    auto id = std::stoi(req->getParameter("id"));
-    auto dbType = req->getParameter("type");
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId) {
+  int userId = req->getAttributes()->get<int>("user_id");
 
-    auto schema = models::Schema::findById(id);
-    auto sql = schema.generateSql(dbType);
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+  models::Schema::findByIdAsync(
+      schemaId,
+      [callbackPtr, userId, schemaId](std::shared_ptr<const models::Schema> schema) {
+        if (!schema) {
+          respondError(callbackPtr, "Schema not found", k404NotFound);
+          return;
+        }
+        if (schema->userId != userId) {
+          respondError(callbackPtr, "Schema doesn't belong to user",
+                       k403Forbidden);
+          return;
+        }
+        models::Benchmark::findBySchemaIdAsync(
+            schemaId,
+            [callbackPtr](std::vector<models::Benchmark> benchmarks) {
+              // Прогоны идут от новых версий к старым: база сравнения - ближайший
+              // сравнимый прогон более ранней версии
+              Json::Value result(Json::arrayValue);
+              for (size_t i = 0; i < benchmarks.size(); ++i) {
+                Json::Value item = benchmarks[i].toJson();
+                for (size_t j = i + 1; j < benchmarks.size(); ++j) {
+                  if (benchmarks[j].getSchemaVersion() < benchmarks[i].getSchemaVersion() &&
+                      benchmarks[i].comparableWith(benchmarks[j])) {
+                    item["baseline"] = benchmarks[i].compareWith(benchmarks[j]);
+                    break;
+                  }
+                }
+                result.append(std::move(item));
+              }
+              (*callbackPtr)(HttpResponse::newHttpJsonResponse(result));
+            },
+            [callbackPtr](const std::exception& e) {
+              respondError(callbackPtr, e.what(), k500InternalServerError);
+            });
+      },
+      [callbackPtr](const std::exception& e) {
+        respondError(callbackPtr, e.what(), k500InternalServerError);
+      });
+}
 
-    Json::Value result;
-    result["sql"] = sql;
+void SchemaController::getVersions(
+    const HttpRequestPtr& req,
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId) {
+  int userId = req->getAttributes()->get<int>("user_id");
+  size_t limit = listing::DEFAULT_PAGE_ROWS;
+  std::string limitParam = req->getParameter("limit");
+  if (!limitParam.empty()) {
+    std::optional<int> parsed = versionParameter(limitParam);
+    if (!parsed || static_cast<size_t>(*parsed) > listing::MAX_PAGE_ROWS) {
+      drogon::HttpResponsePtr resp = HttpResponse::newHttpJsonResponse(Json::Value(
+          "limit must be from 1 to " + std::to_string(listing::MAX_PAGE_ROWS)));
+      resp->setStatusCode(k400BadRequest);
+      callback(resp);
+      return;
+    }
+    limit = static_cast<size_t>(*parsed);
+  }
+  std::string beforeParam = req->getParameter("before");
+  std::optional<int> before = versionParameter(beforeParam);
+  if (!beforeParam.empty() && !before) {
+    drogon::HttpResponsePtr resp =
+        HttpResponse::newHttpJsonResponse(Json::Value("Invalid before parameter"));
+    resp->setStatusCode(k400BadRequest);
+    callback(resp);
+    return;
+  }
+
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+  withOwnSchema(
+      callbackPtr, schemaId, userId,
+      [callbackPtr, schemaId, before, limit](const models::Schema::Stamp&) {
+        models::SchemaVersion::findBySchemaIdAsync(
+            schemaId, before, limit,
+            [callbackPtr](std::vector<models::SchemaVersion> versions) {
+              Json::Value result(Json::arrayValue);
+              for (const auto& version : versions) {
+                result.append(version.toJson());
+              }
+              (*callbackPtr)(HttpResponse::newHttpJsonResponse(result));
+            },
+            [callbackPtr](const std::exception& e) {
+              respondError(callbackPtr, e.what(), k500InternalServerError);
+            });
+      });
+}
 
-    auto resp = HttpResponse::newHttpJsonResponse(result);
+void SchemaController::getVersion(
+    const HttpRequestPtr& req,
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId,
+    int version) {
+  int userId = req->getAttributes()->get<int>("user_id");
+
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+  withOwnSchema(
+      callbackPtr, schemaId, userId,
+      [callbackPtr, schemaId, version](const models::Schema::Stamp&) {
+        models::SchemaVersion::loadAsync(
+            schemaId, version,
+            [callbackPtr](std::optional<Json::Value> document) {
+              if (!document) {
+                respondError(callbackPtr, "Schema version not found",
+                             k404NotFound);
+                return;
+              }
+              (*callbackPtr)(HttpResponse::newHttpJsonResponse(*document));
+            },
+            [callbackPtr](const std::exception& e) {
+              respondError(callbackPtr, e.what(), k500InternalServerError);
+            });
+      });
+}
+
+void SchemaController::restoreVersion(
+    const HttpRequestPtr& req,
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId,
+    int version) {
+  std::string ifMatch = req->getHeader("If-Match");
+  if (ifMatch.empty()) {
+    drogon::HttpResponsePtr resp = HttpResponse::newHttpJsonResponse(
+        Json::Value("If-Match header with the schema ETag is required"));
+    resp->setStatusCode(k428PreconditionRequired);
     callback(resp);
-  } catch (const std::exception& e) {
-    auto resp = HttpResponse::newHttpJsonResponse(Json::Value(e.what()));
-    resp->setStatusCode(k500InternalServerError);
+    return;
+  }
+  int userId = req->getAttributes()->get<int>("user_id");
+
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+  withOwnSchema(
+      callbackPtr, schemaId, userId,
+      [callbackPtr, schemaId, userId, version,
+       ifMatch](const models::Schema::Stamp& stamp) {
+        std::string currentTag = models::Schema::etagFor(schemaId, stamp.version);
+        if (!etag::matches(ifMatch, currentTag, false)) {
+          respondPreconditionFailed(callbackPtr, currentTag);
+          return;
+        }
+        models::Schema current;
+        current.id = schemaId;
+        current.userId = userId;
+        current.version = stamp.version;
+        models::SchemaVersion::existsAsync(
+            schemaId, version,
+            [callbackPtr, current, version](bool exists) {
+              if (!exists) {
+                respondError(callbackPtr, "Schema version not found",
+                             k404NotFound);
+                return;
+              }
+              current.restoreAsync(
+                  version,
+                  [callbackPtr](std::optional<models::Schema> restored) {
+                    // Версии не удаляются: пустой результат - схему сохранили после проверки
+                    if (!restored) {
+                      respondPreconditionFailed(callbackPtr, "");
+                      return;
+                    }
+                    drogon::HttpResponsePtr resp =
+                        HttpResponse::newHttpJsonResponse(restored->toJson());
+                    resp->addHeader("ETag", restored->etag());
+                    (*callbackPtr)(resp);
+                  },
+                  [callbackPtr](const std::exception& e) {
+                    respondError(callbackPtr, e.what(),
+                                 k500InternalServerError);
+                  });
+            },
+            [callbackPtr](const std::exception& e) {
+              respondError(callbackPtr, e.what(), k500InternalServerError);
+            });
+      });
+}
+
+void SchemaController::diffVersions(
+    const HttpRequestPtr& req,
+    std::function<void(const HttpResponsePtr&)>&& callback, int schemaId) {
+  std::optional<int> from = versionParameter(req->getParameter("from"));
+  std::optional<int> to = versionParameter(req->getParameter("to"));
+  if (!from || !to) {
+    drogon::HttpResponsePtr resp = HttpResponse::newHttpJsonResponse(
+        Json::Value("from and to must be schema version numbers"));
+    resp->setStatusCode(k400BadRequest);
     callback(resp);
+    return;
   }
-}
\ No newline at end of file
+  int userId = req->getAttributes()->get<int>("user_id");
+
+  auto callbackPtr = std::make_shared<Callback>(std::move(callback));
+  withOwnSchema(
+      callbackPtr, schemaId, userId,
+      [callbackPtr, schemaId, from = *from, to = *to](const models::Schema::Stamp&) {
+        models::SchemaVersion::diffAsync(
+            schemaId, from, to,
+            [callbackPtr](std::optional<Json::Value> diff) {
+              if (!diff) {
+                respondError(callbackPtr, "Schema version not found",
+                             k404NotFound);
+                return;
+              }
+              (*callbackPtr)(HttpResponse::newHttpJsonResponse(*diff));
+            },
+            [callbackPtr](const std::exception& e) {
+              respondError(callbackPtr, e.what(), k500InternalServerError);
+            });
+      });
+}
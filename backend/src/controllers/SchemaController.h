@@ -1,6 +1,9 @@
 #pragma once
 #include <drogon/HttpController.h>
 #include "../models/Schema.h"
+#include "../models/SchemaVersion.h"
+#include "../sql/DataGenerator.h"
+#include "../sql/Workload.h"
 #include <json/json.h>
 
 using namespace drogon;
@@ -8,20 +11,54 @@ using namespace drogon;
 class SchemaController : public drogon::HttpController<SchemaController> {
 public:
     METHOD_LIST_BEGIN
-        ADD_METHOD_TO(SchemaController::createSchema, "/api/protected/schemas", Post);
-        ADD_METHOD_TO(SchemaController::getSchemas, "/api/protected/schemas", Get);
-        ADD_METHOD_TO(SchemaController::getSchema, "/api/protected/schemas/{id}", Get);
-        ADD_METHOD_TO(SchemaController::updateSchema, "/api/protected/schemas/{id}", Put);
-        ADD_METHOD_TO(SchemaController::deleteSchema, "/api/protected/schemas/{id}", Delete);
-        ADD_METHOD_TO(SchemaController::validateSchema, "/api/protected/schemas/validate", Post);
-        ADD_METHOD_TO(SchemaController::generateSql, "/api/protected/schemas/{id}/sql", Get);
+        ADD_METHOD_TO(SchemaController::createSchema, "/api/protected/schemas", Post, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::getSchemas, "/api/protected/schemas", Get, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::getSchema, "/api/protected/schemas/{id}", Get, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::updateSchema, "/api/protected/schemas/{id}", Put, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::patchSchema, "/api/protected/schemas/{id}", Patch, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::deleteSchema, "/api/protected/schemas/{id}", Delete, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::validateSchema, "/api/protected/schemas/validate", Post, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::generateSql, "/api/protected/schemas/{id}/sql", Get, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::seedSchema, "/api/protected/schemas/{id}/seed", Post, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::benchmarkSchema, "/api/protected/schemas/{id}/benchmark", Post, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::getBenchmarks, "/api/protected/schemas/{id}/benchmarks", Get, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::getVersions, "/api/protected/schemas/{id}/versions", Get, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::getVersion, "/api/protected/schemas/{id}/versions/{version}", Get, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::restoreVersion, "/api/protected/schemas/{id}/versions/{version}/restore", Post, "JwtAuthFilter");
+        ADD_METHOD_TO(SchemaController::diffVersions, "/api/protected/schemas/{id}/diff", Get, "JwtAuthFilter");
     METHOD_LIST_END
 
     void createSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback);
     void getSchemas(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback);
-    void getSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback);
-    void updateSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback);
-    void deleteSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback);
-    void validateSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback); // TODO #1
-    void generateSql(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback);
+    void getSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId);
+    void updateSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId);
+    // JSON Patch (RFC 6902) над {name, description, tables, relations}: в базу
+    // уходят только правки, ответ - id и новая версия без документа
+    void patchSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId);
+    void deleteSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId);
+    void validateSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback);
+    void generateSql(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId);
+    // Заполняет развернутую по схеме базу синтетическими данными: фоновая задача
+    // DeploymentJobs, ответ 202 с job_id, ход - через GET /api/protected/deploy/{id}
+    void seedSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId);
+    // Замер выведенной из схемы нагрузки на заполненной базе: фоновая задача
+    // DeploymentJobs, результат сохраняется под текущей версией схемы
+    void benchmarkSchema(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId);
+    // Замеры схемы по версиям со сравнением с предыдущей версией на том же сервере
+    void getBenchmarks(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId);
+    // История сохранений от новых версий к старым (limit, before) со сводкой
+    // изменений относительно предыдущей версии
+    void getVersions(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId);
+    void getVersion(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId, int version);
+    // Сохраняет содержимое старой версии как новую; If-Match как у PUT
+    void restoreVersion(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId, int version);
+    // Добавленные, удаленные и измененные таблицы между версиями from и to
+    void diffVersions(const HttpRequestPtr& req, std::function<void(const HttpResponsePtr&)>&& callback, int schemaId);
+
+private:
+    static constexpr size_t MAX_PATCH_OPERATIONS = 1000;
+    static constexpr uint64_t MAX_SEED_ROWS = 100000000;
+    static constexpr size_t MAX_BENCHMARK_CLIENTS = 64;
+    // Запросов одной формы за прогон: задержки PostgreSQL возвращаются построчно
+    static constexpr uint64_t MAX_BENCHMARK_QUERIES = 200000;
 };
\ No newline at end of file
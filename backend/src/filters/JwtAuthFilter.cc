@@ -1,15 +1,60 @@
 #include "JwtAuthFilter.h"
-#include <json/json.h>
+#include <openssl/sha.h>
 
 const std::string JwtAuthFilter::JWT_SECRET = "your-secret-key"; // Должен совпадать с секретом в AuthController
 
+namespace {
+
+constexpr size_t TOKEN_CACHE_CAPACITY = 10000;
+constexpr size_t TOKEN_CACHE_SHARDS = 16;
+
+} // namespace
+
+utils::ShardedLruCache<std::string, JwtAuthFilter::VerifiedToken>& JwtAuthFilter::tokenCache() {
+    static utils::ShardedLruCache<std::string, VerifiedToken> cache(TOKEN_CACHE_CAPACITY, TOKEN_CACHE_SHARDS);
+    return cache;
+}
+
+std::string JwtAuthFilter::tokenDigest(const std::string& token) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(token.data()), token.size(), digest);
+    return std::string(reinterpret_cast<const char*>(digest), SHA256_DIGEST_LENGTH);
+}
+
+JwtAuthFilter::VerifiedToken JwtAuthFilter::verifyToken(const std::string& token) {
+    // Верификатор собирается один раз; verify() константный и потокобезопасный
+    static const auto verifier = jwt::verify()
+        .allow_algorithm(jwt::algorithm::hs256{JWT_SECRET})
+        .with_issuer("auth0");
+
+    auto decoded = jwt::decode(token);
+    verifier.verify(decoded);
+
+    VerifiedToken verified;
+    verified.userId = decoded.get_payload_claim("user_id").as_string();
+    verified.username = decoded.get_payload_claim("username").as_string();
+    verified.expiresAt = decoded.get_expires_at();
+    return verified;
+}
+
 void JwtAuthFilter::doFilter(const drogon::HttpRequestPtr& req,
                            drogon::FilterCallback&& fcb,
                            drogon::FilterChainCallback&& fccb) {
+    // Токен только из заголовка: в URL он попал бы в журналы и Referer
+    std::string token;
+    auto auth = req->getHeader("Authorization");
+    if (auth.find("Bearer ") == 0) {
+        token = auth.substr(7); // Пропускаем "Bearer "
+    }
+    authenticate(req, token, std::move(fcb), std::move(fccb));
+}
+
+void JwtAuthFilter::authenticate(const drogon::HttpRequestPtr& req,
+                                 const std::string& token,
+                                 drogon::FilterCallback&& fcb,
+                                 drogon::FilterChainCallback&& fccb) {
     try {
-        // Получаем токен из заголовка
-        auto auth = req->getHeader("Authorization");
-        if (auth.empty() || auth.find("Bearer ") != 0) {
+        if (token.empty()) {
             Json::Value result;
             result["message"] = "No token provided";
             auto resp = drogon::HttpResponse::newHttpJsonResponse(result);
@@ -18,22 +63,23 @@ void JwtAuthFilter::doFilter(const drogon::HttpRequestPtr& req,
             return;
         }
 
-        std::string token = auth.substr(7); // Пропускаем "Bearer "
-        
-        // Проверяем токен
-        auto verifier = jwt::verify()
-            .allow_algorithm(jwt::algorithm::hs256{JWT_SECRET})
-            .with_issuer("auth0");
-            
-        auto decoded = jwt::decode(token);
-        verifier.verify(decoded);
+        // Проверяем токен: сначала в кэше уже проверенных, иначе полная проверка подписи
+        std::string digest = tokenDigest(token);
+        auto now = std::chrono::system_clock::now();
+        std::optional<VerifiedToken> verified = tokenCache().get(digest);
+        if (verified && verified->expiresAt <= now) {
+            tokenCache().erase(digest);
+            verified.reset();
+        }
+        if (!verified) {
+            verified = verifyToken(token);
+            tokenCache().put(digest, *verified);
+        }
         
         // Добавляем данные пользователя в запрос для дальнейшего использования
-        auto userId = decoded.get_payload_claim("user_id").as_string();
-        auto username = decoded.get_payload_claim("username").as_string();
-        
-        req->setParameter("userId", userId);
-        req->setParameter("username", username);
+        req->setParameter("userId", verified->userId);
+        req->setParameter("username", verified->username);
+        req->getAttributes()->insert("user_id", std::stoi(verified->userId));
         
         // Продолжаем цепочку фильтров
         fccb();
@@ -47,3 +93,16 @@ void JwtAuthFilter::doFilter(const drogon::HttpRequestPtr& req,
         fcb(resp);
     }
 }
+
+Json::Value JwtAuthFilter::cacheMetrics() {
+    auto& cache = tokenCache();
+    uint64_t hits = cache.hits();
+    uint64_t misses = cache.misses();
+    Json::Value json;
+    json["size"] = static_cast<Json::UInt64>(cache.size());
+    json["capacity"] = static_cast<Json::UInt64>(TOKEN_CACHE_CAPACITY);
+    json["hits"] = static_cast<Json::UInt64>(hits);
+    json["misses"] = static_cast<Json::UInt64>(misses);
+    json["hit_ratio"] = hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+    return json;
+}
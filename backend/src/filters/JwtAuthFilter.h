@@ -1,12 +1,38 @@
 #pragma once
 #include <drogon/HttpFilter.h>
 #include <jwt-cpp/jwt.h>
+#include <json/json.h>
+#include <chrono>
+#include <string>
+#include "../utils/ShardedLruCache.h"
 
 class JwtAuthFilter : public drogon::HttpFilter<JwtAuthFilter> {
 private:
     static const std::string JWT_SECRET;
+
+    // Уже проверенный токен: данные пользователя и момент истечения (claim exp)
+    struct VerifiedToken {
+        std::string userId;
+        std::string username;
+        std::chrono::system_clock::time_point expiresAt;
+    };
+
+    // Ключ - SHA-256 токена, чтобы не хранить сами токены в памяти
+    static utils::ShardedLruCache<std::string, VerifiedToken>& tokenCache();
+    static std::string tokenDigest(const std::string& token);
+    static VerifiedToken verifyToken(const std::string& token);
+
 public:
     virtual void doFilter(const drogon::HttpRequestPtr& req,
                          drogon::FilterCallback&& fcb,
                          drogon::FilterChainCallback&& fccb) override;
+
+    // Проверка уже извлеченного токена (пустой - 401); общая с WsJwtAuthFilter
+    static void authenticate(const drogon::HttpRequestPtr& req,
+                             const std::string& token,
+                             drogon::FilterCallback&& fcb,
+                             drogon::FilterChainCallback&& fccb);
+
+    // Размер кэша и доля попаданий
+    static Json::Value cacheMetrics();
 };
@@ -0,0 +1,15 @@
+#include "WsJwtAuthFilter.h"
+#include "JwtAuthFilter.h"
+
+void WsJwtAuthFilter::doFilter(const drogon::HttpRequestPtr& req,
+                               drogon::FilterCallback&& fcb,
+                               drogon::FilterChainCallback&& fccb) {
+    std::string token;
+    auto auth = req->getHeader("Authorization");
+    if (auth.find("Bearer ") == 0) {
+        token = auth.substr(7);
+    } else {
+        token = req->getParameter("access_token");
+    }
+    JwtAuthFilter::authenticate(req, token, std::move(fcb), std::move(fccb));
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <drogon/HttpFilter.h>
+
+// JwtAuthFilter для WebSocket-маршрутов: браузерный WebSocket не ставит
+// заголовки, поэтому здесь токен допускается и в параметре access_token.
+// Для обычных HTTP-маршрутов не подключать.
+class WsJwtAuthFilter : public drogon::HttpFilter<WsJwtAuthFilter> {
+public:
+    virtual void doFilter(const drogon::HttpRequestPtr& req,
+                         drogon::FilterCallback&& fcb,
+                         drogon::FilterChainCallback&& fccb) override;
+};
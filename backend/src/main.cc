@@ -1,8 +1,208 @@
 #include <drogon/drogon.h>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include "bench/Bench.h"
 #include "controllers/AuthController.h"
-#include "filters/JwtAuthFilter.h"
+#include "models/Database.h"
+#include "models/ModelCache.h"
+#include "services/DeploymentJobs.h"
+#include "services/PasswordHasher.h"
+#include "services/SshSessionPool.h"
+#include "sql/DataGenerator.h"
+#include "sql/DdlCompiler.h"
+#include "sql/SchemaValidator.h"
+
+namespace {
+
+// Загружаем config.json один раз: его читают и Drogon, и наши модели.
+// Так же читается файл схемы для команды seed
+Json::Value loadJsonFile(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Cannot open file " + path);
+    }
+    Json::Value json;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    if (!Json::parseFromStream(builder, file, &json, &errors)) {
+        throw std::runtime_error("Invalid JSON in " + path + ": " + errors);
+    }
+    return json;
+}
+
+const char* SEED_USAGE =
+    "usage: webdatabase_backend seed <schema.json> [--type postgresql|mysql] [--rows N]\n"
+    "           [--table-rows name=N,...] [--seed N] [--ddl] [--out DIR]\n"
+    "PostgreSQL: psql-скрипт с COPY FROM STDIN в stdout, например\n"
+    "    webdatabase_backend seed schema.json --ddl --rows 1000000 | psql -v ON_ERROR_STOP=1 -d test\n"
+    "MySQL: CSV таблиц в DIR и load.sql с LOAD DATA LOCAL INFILE в stdout, например\n"
+    "    webdatabase_backend seed schema.json --type mysql --out /tmp/seed | mysql --local-infile=1 test\n";
+
+// Синтетические данные по схеме из файла (объект схемы или массив tables) без сервера и БД
+int runSeedCommand(int argc, char* argv[]) {
+    if (argc < 1) {
+        std::cerr << SEED_USAGE;
+        return 2;
+    }
+    sql::Dialect dialect = sql::Dialect::PostgreSQL;
+    sql::DataGenerator::Options options;
+    bool withDdl = false;
+    std::string outDir;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--ddl") {
+            withDdl = true;
+        } else if (arg == "--type" && hasValue) {
+            auto parsed = sql::parseDialect(argv[++i]);
+            if (!parsed) {
+                std::cerr << "Unknown type " << argv[i] << "\n";
+                return 2;
+            }
+            dialect = *parsed;
+        } else if (arg == "--rows" && hasValue) {
+            options.rows = std::stoull(argv[++i]);
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+        } else if (arg == "--out" && hasValue) {
+            outDir = argv[++i];
+        } else if (arg == "--table-rows" && hasValue) {
+            std::string list = argv[++i];
+            for (size_t start = 0; start < list.size();) {
+                size_t end = std::min(list.find(',', start), list.size());
+                std::string item = list.substr(start, end - start);
+                size_t eq = item.find('=');
+                if (eq == std::string::npos) {
+                    std::cerr << "Expected name=rows in --table-rows\n";
+                    return 2;
+                }
+                std::string name = item.substr(0, eq);
+                std::transform(name.begin(), name.end(), name.begin(),
+                               [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                options.tableRows[name] = std::stoull(item.substr(eq + 1));
+                start = end + 1;
+            }
+        } else {
+            std::cerr << SEED_USAGE;
+            return 2;
+        }
+    }
+    if (dialect == sql::Dialect::MySQL && outDir.empty()) {
+        std::cerr << "--out is required for MySQL: LOAD DATA LOCAL INFILE reads files\n";
+        return 2;
+    }
+
+    Json::Value schema = loadJsonFile(argv[0]);
+    const Json::Value& tables = schema.isArray() ? schema : schema["tables"];
+    sql::DataGenerator generator(dialect, tables, options);
+
+    std::ostream& out = std::cout;
+    if (withDdl) {
+        out << sql::DdlCompiler(dialect).compile(tables);
+    }
+    std::string chunk;
+    if (dialect == sql::Dialect::PostgreSQL) {
+        // Данные COPY идут в том же потоке сразу за командой и заканчиваются строкой \.
+        for (const auto& layer : generator.layers()) {
+            for (Json::ArrayIndex table : layer) {
+                out << generator.loadStatement(table) << ";\n";
+                auto stream = generator.stream(table);
+                while (stream.next(chunk)) {
+                    out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+                }
+                out << "\\.\n";
+            }
+        }
+        out << generator.finishStatements();
+        return out ? 0 : 1;
+    }
+
+    // Имя таблицы становится именем файла в outDir
+    for (Json::ArrayIndex table = 0; table < generator.tableCount(); ++table) {
+        if (!sql::SchemaValidator::isValidIdentifier(dialect, generator.tableName(table))) {
+            std::cerr << "Invalid table name " << generator.tableName(table) << "\n";
+            return 2;
+        }
+    }
+
+    // Файлы таблиц независимы и пишутся параллельно фиксированным числом потоков; load.sql грузит их по слоям
+    std::atomic<Json::ArrayIndex> next{0};
+    std::atomic<bool> failed{false};
+    auto writer = [&generator, &outDir, &failed, &next]() {
+        for (Json::ArrayIndex table = next++; table < generator.tableCount(); table = next++) {
+            std::ofstream file(outDir + "/" + generator.tableName(table) + ".csv", std::ios::binary);
+            auto stream = generator.stream(table);
+            std::string buffer;
+            while (file && stream.next(buffer)) {
+                file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            }
+            if (!file) {
+                failed = true;
+            }
+        }
+    };
+    size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), generator.tableCount());
+    std::vector<std::thread> writers;
+    for (size_t t = 1; t < threadCount; ++t) {
+        writers.emplace_back(writer);
+    }
+    writer();
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    if (failed) {
+        std::cerr << "Failed to write CSV files to " << outDir << "\n";
+        return 1;
+    }
+    for (const auto& layer : generator.layers()) {
+        for (Json::ArrayIndex table : layer) {
+            out << generator.loadStatement(table, outDir + "/" + generator.tableName(table) + ".csv") << ";\n";
+        }
+    }
+    return out ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "seed") {
+        try {
+            return runSeedCommand(argc - 2, argv + 2);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+    if (argc > 1 && std::string(argv[1]) == "bench") {
+        try {
+            return bench::runBenchCommand(argc - 2, argv + 2);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    std::string configPath = argc > 1 ? argv[1] : "config.json";
+    Json::Value config;
+    try {
+        config = loadJsonFile(configPath);
+        models::Database::initDb(config);
+        models::ModelCache::init(config["custom_config"]["model_cache"]);
+        services::PasswordHasher::init(config["custom_config"]["bcrypt"]);
+        services::DeploymentJobs::init(config["custom_config"]["deploy"]);
+        services::SshSessionPool::init(config["custom_config"]["ssh_pool"]);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // Слушатели, число потоков и клиенты БД (размер пула, is_fast, timeout) берутся из конфига
+    drogon::app().loadConfigJson(config);
 
-int main() {
     // Настройка CORS
     drogon::app().registerHandler(
         "/api/{*}",
@@ -10,19 +210,15 @@ int main() {
            std::function<void(const drogon::HttpResponsePtr&)>&& callback) {
             auto resp = drogon::HttpResponse::newHttpResponse();
             resp->addHeader("Access-Control-Allow-Origin", "*");
-            resp->addHeader("Access-Control-Allow-Methods", "GET,POST,PUT,DELETE,OPTIONS");
-            resp->addHeader("Access-Control-Allow-Headers", "Content-Type,Authorization");
+            resp->addHeader("Access-Control-Allow-Methods", "GET,POST,PUT,PATCH,DELETE,OPTIONS");
+            resp->addHeader("Access-Control-Allow-Headers", "Content-Type,Authorization,If-Match,If-None-Match");
             callback(resp);
         },
         {drogon::Options}
     );
 
-    // Применяем JWT фильтр ко всем защищенным маршрутам
-    drogon::app().registerFilter(std::make_shared<JwtAuthFilter>("/api/protected/*"));
-
     // Настройка сервера
-    drogon::app().addListener("0.0.0.0", 8080)
-        .setThreadNum(16)
+    drogon::app()
         .enableRunAsDaemon()
         .run();
     
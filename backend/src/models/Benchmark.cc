@@ -0,0 +1,121 @@
+#include "Benchmark.h"
+#include <drogon/drogon.h>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace models {
+
+Benchmark::Benchmark(const drogon::orm::Row& row) {
+    id = row["id"].as<int>();
+    userId = row["user_id"].as<int>();
+    schemaId = row["schema_id"].as<int>();
+    schemaVersion = row["schema_version"].as<int>();
+    dbType = row["db_type"].as<std::string>();
+    host = row["host"].as<std::string>();
+    clients = row["clients"].as<int>();
+    rowCount = static_cast<uint64_t>(row["row_count"].as<int64_t>());
+    std::string resultsText = row["results"].as<std::string>();
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    if (!reader->parse(resultsText.data(), resultsText.data() + resultsText.size(), &results, &errors)) {
+        throw std::runtime_error("Invalid benchmark results: " + errors);
+    }
+    createdAt = row["created_at"].as<std::string>();
+}
+
+void Benchmark::findBySchemaIdAsync(int schemaId,
+                                    std::function<void(std::vector<Benchmark>)>&& callback,
+                                    DbErrorCallback&& errorCallback) {
+    Database::execSqlAsync(
+        "SELECT * FROM schema_benchmarks WHERE schema_id = $1 "
+        "ORDER BY schema_version DESC, created_at DESC, id DESC LIMIT 200",
+        [callback = std::move(callback), errorCallback](const drogon::orm::Result& result) {
+            std::vector<Benchmark> benchmarks;
+            try {
+                benchmarks.reserve(result.size());
+                for (const auto& row : result) {
+                    benchmarks.emplace_back(row);
+                }
+            } catch (const std::exception& e) {
+                errorCallback(e);
+                return;
+            }
+            callback(std::move(benchmarks));
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error finding benchmarks: " << e.base().what();
+            errorCallback(e.base());
+        },
+        schemaId
+    );
+}
+
+Benchmark Benchmark::record(int userId, int schemaId, int schemaVersion, const std::string& dbType,
+                            const std::string& host, int clients, uint64_t rowCount, const Json::Value& results) {
+    Json::FastWriter writer;
+    std::string resultsStr = writer.write(results);
+    drogon::orm::DbClientPtr db = Database::getDbClient();
+    drogon::orm::Result result = db->execSqlSync(
+        "INSERT INTO schema_benchmarks (user_id, schema_id, schema_version, db_type, host, clients, "
+        "row_count, results) VALUES ($1, $2, $3, $4, $5, $6, $7, $8::jsonb) RETURNING *",
+        userId, schemaId, schemaVersion, dbType, host, clients, static_cast<int64_t>(rowCount), resultsStr);
+    return Benchmark(result[0]);
+}
+
+bool Benchmark::comparableWith(const Benchmark& other) const {
+    return dbType == other.dbType && host == other.host && clients == other.clients &&
+           rowCount == other.rowCount &&
+           results["queries_per_client"].asUInt64() == other.results["queries_per_client"].asUInt64();
+}
+
+Json::Value Benchmark::compareWith(const Benchmark& baseline) const {
+    std::unordered_map<std::string, const Json::Value*> previous;
+    for (const auto& shape : baseline.results["shapes"]) {
+        previous[shape["shape"].asString()] = &shape;
+    }
+
+    Json::Value comparison;
+    comparison["benchmark_id"] = baseline.id;
+    comparison["schema_version"] = baseline.schemaVersion;
+    comparison["shapes"] = Json::Value(Json::objectValue);
+    comparison["regressions"] = Json::Value(Json::arrayValue);
+    for (const auto& shape : results["shapes"]) {
+        std::string name = shape["shape"].asString();
+        auto it = previous.find(name);
+        if (it == previous.end()) {
+            continue;
+        }
+        const Json::Value& before = *it->second;
+        double throughputBefore = before["throughput_qps"].asDouble();
+        double p95Before = before["p95_ms"].asDouble();
+        Json::Value change;
+        change["throughput_ratio"] = throughputBefore > 0 ? shape["throughput_qps"].asDouble() / throughputBefore : 0.0;
+        change["p95_ratio"] = p95Before > 0 ? shape["p95_ms"].asDouble() / p95Before : 0.0;
+        bool regression = (throughputBefore > 0 && change["throughput_ratio"].asDouble() < 1 - REGRESSION_TOLERANCE) ||
+                          (p95Before > 0 && change["p95_ratio"].asDouble() > 1 + REGRESSION_TOLERANCE);
+        change["regression"] = regression;
+        if (regression) {
+            comparison["regressions"].append(name);
+        }
+        comparison["shapes"][name] = std::move(change);
+    }
+    return comparison;
+}
+
+Json::Value Benchmark::toJson() const {
+    Json::Value json;
+    json["id"] = id;
+    json["schema_id"] = schemaId;
+    json["schema_version"] = schemaVersion;
+    json["db_type"] = dbType;
+    json["host"] = host;
+    json["clients"] = clients;
+    json["rows"] = static_cast<Json::UInt64>(rowCount);
+    json["results"] = results;
+    json["created_at"] = createdAt;
+    return json;
+}
+
+} // namespace models
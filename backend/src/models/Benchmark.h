@@ -0,0 +1,54 @@
+#pragma once
+#include <string>
+#include <json/json.h>
+#include <drogon/orm/Result.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "Database.h"
+
+namespace models {
+
+// Результат замера нагрузки на базе, развернутой по версии схемы. Прогоны
+// хранятся по версиям, чтобы сравнивать версию с предыдущей на том же сервере.
+class Benchmark {
+public:
+    Benchmark() = default;
+    Benchmark(const drogon::orm::Row& row);
+
+    int getId() const { return id; }
+    int getSchemaVersion() const { return schemaVersion; }
+    const Json::Value& getResults() const { return results; }
+
+    // Прогоны схемы от новых версий к старым
+    static void findBySchemaIdAsync(int schemaId,
+                                    std::function<void(std::vector<Benchmark>)>&& callback,
+                                    DbErrorCallback&& errorCallback);
+    // Синхронно: вызывается из рабочих потоков задач, не из IO-потоков
+    static Benchmark record(int userId, int schemaId, int schemaVersion, const std::string& dbType,
+                            const std::string& host, int clients, uint64_t rowCount, const Json::Value& results);
+
+    // Прогон сравним с этим: тот же сервер, СУБД, число клиентов и строк
+    bool comparableWith(const Benchmark& other) const;
+    // Отношения пропускной способности и p95 к baseline по общим формам;
+    // regressions - формы, просевшие больше чем на REGRESSION_TOLERANCE
+    Json::Value compareWith(const Benchmark& baseline) const;
+
+    Json::Value toJson() const;
+
+    static constexpr double REGRESSION_TOLERANCE = 0.1;
+
+private:
+    int id;
+    int userId;
+    int schemaId;
+    int schemaVersion;
+    std::string dbType;
+    std::string host;
+    int clients;
+    uint64_t rowCount;
+    Json::Value results;
+    std::string createdAt;
+};
+
+} // namespace models
@@ -1,20 +1,163 @@
 #include "Database.h"
+#include "SchemaVersion.h"
 #include <drogon/drogon.h>
+#include <cctype>
+#include <stdexcept>
 
 namespace models {
 
-std::shared_ptr<drogon::orm::DbClient> Database::dbClient;
+std::string Database::clientName = "default";
+std::string Database::connInfo;
+bool Database::fastMode = false;
+size_t Database::connectionNumber = 1;
+double Database::timeout = -1.0;
 
-void Database::initDb(const std::string& connStr) {
-    dbClient = drogon::orm::DbClient::newPgClient(connStr, 1);
-    createTables();
+std::atomic<int64_t> Database::pendingQueries{0};
+std::atomic<int64_t> Database::peakPendingQueries{0};
+std::atomic<uint64_t> Database::failedQueries{0};
+utils::LatencyStats Database::queryWait;
+
+namespace {
+
+// ГГГГММДДЧЧММСС и шесть цифр микросекунд
+constexpr size_t CURSOR_DIGITS = 20;
+
+} // namespace
+
+std::string PageCursor::encode() const {
+    // PostgreSQL печатает "2024-05-01 10:20:30.1234" без хвостовых нулей дробной части
+    std::string digits;
+    size_t fraction = std::string::npos;
+    for (char c : createdAt) {
+        if (c == '.') {
+            fraction = digits.size();
+        } else if (std::isdigit(static_cast<unsigned char>(c))) {
+            digits += c;
+        }
+    }
+    if (fraction == std::string::npos) {
+        fraction = digits.size();
+    }
+    digits.resize(fraction + 6, '0');
+    return digits + "-" + std::to_string(id);
+}
+
+std::optional<PageCursor> PageCursor::decode(const std::string& text) {
+    size_t dash = text.find('-');
+    if (dash != CURSOR_DIGITS || dash + 1 >= text.size() || text.size() - dash - 1 > 9) {
+        return std::nullopt;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (i != dash && !std::isdigit(static_cast<unsigned char>(text[i]))) {
+            return std::nullopt;
+        }
+    }
+    PageCursor cursor;
+    cursor.createdAt = text.substr(0, 4) + "-" + text.substr(4, 2) + "-" + text.substr(6, 2) + " " +
+                       text.substr(8, 2) + ":" + text.substr(10, 2) + ":" + text.substr(12, 2) + "." +
+                       text.substr(14, 6);
+    cursor.id = std::stoi(text.substr(dash + 1));
+    return cursor;
+}
+
+void Database::initDb(const Json::Value& config) {
+    const Json::Value& clients = config["db_clients"];
+    if (!clients.isArray() || clients.empty()) {
+        throw std::runtime_error("config.json: db_clients is empty");
+    }
+
+    // Первый клиент задаёт имя и параметры подключения. Клиент с тем же именем
+    // и is_fast=true используется на IO-потоках, обычный - для остальных потоков.
+    const Json::Value& primary = clients[0];
+    clientName = primary.get("name", "default").asString();
+    connectionNumber = 0;
+    for (const auto& client : clients) {
+        if (client.get("name", "default").asString() != clientName) {
+            continue;
+        }
+        if (client.get("is_fast", false).asBool()) {
+            fastMode = true;
+        } else {
+            connectionNumber = client.get("connection_number", 1).asUInt();
+            timeout = client.get("timeout", -1.0).asDouble();
+        }
+    }
+    if (connectionNumber == 0) {
+        throw std::runtime_error("config.json: db client '" + clientName +
+                                 "' needs a non-fast entry for use outside IO loops");
+    }
+
+    connInfo = "host=" + primary["host"].asString() +
+               " port=" + std::to_string(primary.get("port", 5432).asInt()) +
+               " dbname=" + primary["dbname"].asString() +
+               " user=" + primary["user"].asString() +
+               " password=" + primary["passwd"].asString();
+    if (timeout > 0) {
+        connInfo += " connect_timeout=" + std::to_string(static_cast<int>(timeout));
+    }
+
+    // Клиенты БД создаются внутри app().run(), поэтому таблицы создаём после старта
+    drogon::app().registerBeginningAdvice([]() {
+        try {
+            createTables();
+        } catch (const std::exception& e) {
+            LOG_FATAL << "Failed to create tables: " << e.what();
+            drogon::app().quit();
+        }
+    });
 }
 
 std::shared_ptr<drogon::orm::DbClient> Database::getDbClient() {
-    return dbClient;
+    return drogon::app().getDbClient(clientName);
+}
+
+std::shared_ptr<drogon::orm::DbClient> Database::getLoopDbClient() {
+    if (fastMode) {
+        auto* loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+        if (loop != nullptr && loop != drogon::app().getLoop()) {
+            return drogon::app().getFastDbClient(clientName);
+        }
+    }
+    return getDbClient();
+}
+
+std::chrono::steady_clock::time_point Database::beginQuery() {
+    int64_t pending = ++pendingQueries;
+    int64_t peak = peakPendingQueries.load(std::memory_order_relaxed);
+    while (pending > peak &&
+           !peakPendingQueries.compare_exchange_weak(peak, pending, std::memory_order_relaxed)) {
+    }
+    return std::chrono::steady_clock::now();
+}
+
+void Database::endQuery(std::chrono::steady_clock::time_point start, bool failed) {
+    --pendingQueries;
+    if (failed) {
+        ++failedQueries;
+    }
+    queryWait.record(std::chrono::steady_clock::now() - start);
+}
+
+Json::Value Database::metrics() {
+    Json::Value json;
+    int64_t pending = pendingQueries.load();
+    // Запросы сверх числа соединений пула ждут свободного соединения
+    int64_t queued = pending - static_cast<int64_t>(connectionNumber);
+    json["client"] = clientName;
+    json["fast_mode"] = fastMode;
+    json["connection_number"] = static_cast<Json::UInt64>(connectionNumber);
+    json["timeout"] = timeout;
+    json["pending_queries"] = static_cast<Json::Int64>(pending);
+    json["peak_pending_queries"] = static_cast<Json::Int64>(peakPendingQueries.load());
+    json["queue_depth"] = static_cast<Json::Int64>(queued > 0 ? queued : 0);
+    json["failed_queries"] = static_cast<Json::UInt64>(failedQueries.load());
+    json["wait"] = queryWait.toJson();
+    return json;
 }
 
 void Database::createTables() {
+    auto dbClient = getDbClient();
+
     // Создание таблицы пользователей
     dbClient->execSqlSync(
         "CREATE TABLE IF NOT EXISTS users ("
@@ -37,6 +180,11 @@ void Database::createTables() {
         "updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
         ");"
     );
+    // Списки пользователя листаются по ключу (created_at, id) от новых к старым
+    dbClient->execSqlSync(
+        "CREATE INDEX IF NOT EXISTS database_configs_user_page_idx "
+        "ON database_configs (user_id, created_at DESC, id DESC)"
+    );
 
     // Создание таблицы для хранения учетных данных серверов
     dbClient->execSqlSync(
@@ -52,6 +200,88 @@ void Database::createTables() {
         "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
         ");"
     );
+
+    // Создание таблицы схем из конструктора
+    dbClient->execSqlSync(
+        "CREATE TABLE IF NOT EXISTS schemas ("
+        "id SERIAL PRIMARY KEY,"
+        "user_id INTEGER REFERENCES users(id),"
+        "name VARCHAR(100) NOT NULL,"
+        "description TEXT NOT NULL DEFAULT '',"
+        "tables JSONB NOT NULL DEFAULT '[]',"
+        "relations JSONB NOT NULL DEFAULT '[]',"
+        "version INTEGER NOT NULL DEFAULT 1,"
+        "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+        "updated_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
+        ");"
+    );
+    dbClient->execSqlSync(
+        "CREATE INDEX IF NOT EXISTS schemas_user_page_idx "
+        "ON schemas (user_id, created_at DESC, id DESC)"
+    );
+
+    // История версий схем: определения таблиц и relations хранятся по sha256
+    // один раз на схему, версия - манифест хэшей (см. SchemaVersion)
+    dbClient->execSqlSync(
+        "CREATE TABLE IF NOT EXISTS schema_blobs ("
+        "schema_id INTEGER REFERENCES schemas(id) ON DELETE CASCADE,"
+        "hash BYTEA NOT NULL,"
+        "body JSONB NOT NULL,"
+        "PRIMARY KEY (schema_id, hash)"
+        ");"
+    );
+    dbClient->execSqlSync(
+        "CREATE TABLE IF NOT EXISTS schema_versions ("
+        "schema_id INTEGER REFERENCES schemas(id) ON DELETE CASCADE,"
+        "version INTEGER NOT NULL,"
+        "name VARCHAR(100) NOT NULL,"
+        "description TEXT NOT NULL DEFAULT '',"
+        "tables BYTEA[] NOT NULL,"
+        "relations BYTEA NOT NULL,"
+        "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,"
+        "PRIMARY KEY (schema_id, version)"
+        ");"
+    );
+    // Схемы, сохраненные до появления истории, начинают ее с текущей версии
+    dbClient->execSqlSync(SchemaVersion::backfillSql());
+
+    // История развертываний: что и какой версии развернуто на сервере
+    dbClient->execSqlSync(
+        "CREATE TABLE IF NOT EXISTS deployments ("
+        "id SERIAL PRIMARY KEY,"
+        "user_id INTEGER REFERENCES users(id),"
+        "config_id INTEGER REFERENCES database_configs(id) ON DELETE CASCADE,"
+        "host VARCHAR(255) NOT NULL,"
+        "port INTEGER NOT NULL,"
+        "version VARCHAR(64) NOT NULL,"
+        "config JSONB NOT NULL,"
+        "deployed_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
+        ");"
+    );
+    dbClient->execSqlSync(
+        "CREATE INDEX IF NOT EXISTS deployments_target_idx "
+        "ON deployments (config_id, host, port, deployed_at DESC)"
+    );
+
+    // Замеры нагрузки по версиям схемы: видно, какая версия просела
+    dbClient->execSqlSync(
+        "CREATE TABLE IF NOT EXISTS schema_benchmarks ("
+        "id SERIAL PRIMARY KEY,"
+        "user_id INTEGER REFERENCES users(id),"
+        "schema_id INTEGER REFERENCES schemas(id) ON DELETE CASCADE,"
+        "schema_version INTEGER NOT NULL,"
+        "db_type VARCHAR(20) NOT NULL,"
+        "host VARCHAR(255) NOT NULL,"
+        "clients INTEGER NOT NULL,"
+        "row_count BIGINT NOT NULL,"
+        "results JSONB NOT NULL,"
+        "created_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP"
+        ");"
+    );
+    dbClient->execSqlSync(
+        "CREATE INDEX IF NOT EXISTS schema_benchmarks_version_idx "
+        "ON schema_benchmarks (schema_id, schema_version DESC, created_at DESC)"
+    );
 }
 
 } // namespace models
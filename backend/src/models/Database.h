@@ -1,18 +1,87 @@
 #pragma once
 #include <drogon/orm/DbClient.h>
+#include <json/json.h>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include "../utils/LatencyStats.h"
 
 namespace models {
 
+// Колбэк ошибки для асинхронных методов моделей
+using DbErrorCallback = std::function<void(const std::exception&)>;
+
+// Позиция keyset-пагинации списков: (created_at, id) последней отданной строки.
+// Списки идут от новых к старым, следующая страница - строки строго меньше ключа
+struct PageCursor {
+    std::string createdAt;
+    int id = 0;
+
+    // Строка для клиента: цифры created_at с микросекундами, дефис, id
+    std::string encode() const;
+    // nullopt - строка не похожа на результат encode()
+    static std::optional<PageCursor> decode(const std::string& text);
+};
+
 class Database {
 public:
-    static void initDb(const std::string& connStr); // TODO: #18 initialization database on PostgreSQL
-    static std::shared_ptr<drogon::orm::DbClient> getDbClient(); // TODO: #19 ??? Разобраться надо
+    // Читает секцию db_clients из config.json: имя клиента, размер пула,
+    // fast-режим (клиент на каждый IO-поток) и таймаут. Сами клиенты создаёт Drogon
+    // из того же конфига, таблицы создаются после старта event loop.
+    static void initDb(const Json::Value& config);
+    // Общий пул соединений, безопасен для вызова из любого потока (в том числе execSqlSync)
+    static std::shared_ptr<drogon::orm::DbClient> getDbClient();
+    // Fast-клиент текущего IO-потока, если он настроен, иначе общий пул
+    static std::shared_ptr<drogon::orm::DbClient> getLoopDbClient();
+    // Строка подключения libpq, собранная из конфига
+    static const std::string& getConnectionInfo() { return connInfo; }
+
+    // execSqlAsync с учётом метрик насыщения пула
+    template <typename ResultCallback, typename ExceptionCallback, typename... Arguments>
+    static void execSqlAsync(const std::string& sql,
+                             ResultCallback&& resultCallback,
+                             ExceptionCallback&& exceptionCallback,
+                             Arguments&&... args) {
+        auto start = beginQuery();
+        getLoopDbClient()->execSqlAsync(
+            sql,
+            [start, resultCallback = std::forward<ResultCallback>(resultCallback)](
+                const drogon::orm::Result& result) {
+                endQuery(start, false);
+                resultCallback(result);
+            },
+            [start, exceptionCallback = std::forward<ExceptionCallback>(exceptionCallback)](
+                const drogon::orm::DrogonDbException& e) {
+                endQuery(start, true);
+                exceptionCallback(e);
+            },
+            std::forward<Arguments>(args)...);
+    }
+
+    // Метрики пула: число запросов в работе, оценка очереди и время ожидания ответа
+    static Json::Value metrics();
 
 private:
-    static std::shared_ptr<drogon::orm::DbClient> dbClient;
-    static void createTables(); // TODO: #20 create Tables, static function...
+    static std::string clientName;
+    static std::string connInfo;
+    static bool fastMode;
+    static size_t connectionNumber;
+    static double timeout;
+
+    static std::atomic<int64_t> pendingQueries;
+    static std::atomic<int64_t> peakPendingQueries;
+    static std::atomic<uint64_t> failedQueries;
+    static utils::LatencyStats queryWait;
+
+    static std::chrono::steady_clock::time_point beginQuery();
+    static void endQuery(std::chrono::steady_clock::time_point start, bool failed);
+    // CREATE TABLE IF NOT EXISTS для таблиц моделей; вызывается один раз после старта event loop
+    static void createTables();
 };
 
 } // namespace models
@@ -1,103 +1,202 @@
 #include "DatabaseConfig.h"
 #include "Database.h"
+#include "ModelCache.h"
+#include <stdexcept>
 
 namespace models {
 
 DatabaseConfig::DatabaseConfig(const drogon::orm::Row& row) {
-    Json::Reader parser;
     id = row["id"].as<int>();
     userId = row["user_id"].as<int>();
     name = row["name"].as<std::string>();
-    if(!parser.parse(row["config"].as<std::string>(), config)){
-        throw std::exception(parser.getFormatedErrorMessages().c_str());
-    }
+    config->text = row["config"].as<std::string>();
     createdAt = row["created_at"].as<std::string>();
     updatedAt = row["updated_at"].as<std::string>();
 }
 
-std::optional<DatabaseConfig> DatabaseConfig::findById(int id) {
-    drogon::orm::DbClientPtr db = Database::getDbClient();
-    try {
-        drogon::orm::Result result = db->execSqlSync(
-            "SELECT * FROM database_configs WHERE id = $1",
-            id
-        );
-        if (result.size() > 0) {
-            return DatabaseConfig(result[0]);
-        }
-    } catch (const std::exception& e) {
-        LOG_ERROR << "Error finding database config by id: " << e.what();
+void DatabaseConfig::findByIdAsync(int id,
+                                   std::function<void(std::optional<DatabaseConfig>)>&& callback,
+                                   DbErrorCallback&& errorCallback) {
+    if (std::optional<DatabaseConfig> cached = ModelCache::config(id)) {
+        callback(std::move(cached));
+        return;
     }
-    return std::nullopt;
+    uint64_t generation = ModelCache::configGeneration(id);
+    Database::execSqlAsync(
+        "SELECT * FROM database_configs WHERE id = $1",
+        [callback = std::move(callback), errorCallback, generation](const drogon::orm::Result& result) {
+            std::optional<DatabaseConfig> config;
+            try {
+                if (result.size() > 0) {
+                    config = DatabaseConfig(result[0]);
+                }
+            } catch (const std::exception& e) {
+                errorCallback(e);
+                return;
+            }
+            if (config) {
+                ModelCache::putConfig(*config, generation);
+            }
+            callback(std::move(config));
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error finding database config by id: " << e.base().what();
+            errorCallback(e.base());
+        },
+        id
+    );
 }
 
-std::vector<DatabaseConfig> DatabaseConfig::findByUserId(int userId) {
-    drogon::orm::DbClientPtr db = Database::getDbClient();
-    std::vector<DatabaseConfig> configs;
-    try {
-        drogon::orm::Result result = db->execSqlSync(
-            "SELECT * FROM database_configs WHERE user_id = $1 ORDER BY created_at DESC",
-            userId
-        );
-        for (const auto& row : result) {
-            configs.emplace_back(row);
+void DatabaseConfig::findByUserIdAsync(int userId,
+                                       std::function<void(std::vector<DatabaseConfig>)>&& callback,
+                                       DbErrorCallback&& errorCallback) {
+    Database::execSqlAsync(
+        "SELECT * FROM database_configs WHERE user_id = $1 ORDER BY created_at DESC",
+        [callback = std::move(callback), errorCallback](const drogon::orm::Result& result) {
+            std::vector<DatabaseConfig> configs;
+            configs.reserve(result.size());
+            try {
+                for (const auto& row : result) {
+                    configs.emplace_back(row);
+                }
+            } catch (const std::exception& e) {
+                errorCallback(e);
+                return;
+            }
+            callback(std::move(configs));
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error finding database configs by user id: " << e.base().what();
+            errorCallback(e.base());
+        },
+        userId
+    );
+}
+
+void DatabaseConfig::findPageByUserIdAsync(int userId, const std::optional<PageCursor>& after, size_t limit,
+                                           std::function<void(std::vector<DatabaseConfig>)>&& callback,
+                                           DbErrorCallback&& errorCallback) {
+    auto onResult = [callback = std::move(callback), errorCallback](const drogon::orm::Result& result) {
+        std::vector<DatabaseConfig> configs;
+        configs.reserve(result.size());
+        try {
+            for (const auto& row : result) {
+                configs.emplace_back(row);
+            }
+        } catch (const std::exception& e) {
+            errorCallback(e);
+            return;
         }
-    } catch (const std::exception& e) {
-        LOG_ERROR << "Error finding database configs by user id: " << e.what();
+        callback(std::move(configs));
+    };
+    auto onError = [errorCallback](const drogon::orm::DrogonDbException& e) {
+        LOG_ERROR << "Error finding database configs page: " << e.base().what();
+        errorCallback(e.base());
+    };
+    if (!after) {
+        Database::execSqlAsync(
+            "SELECT * FROM database_configs WHERE user_id = $1 "
+            "ORDER BY created_at DESC, id DESC LIMIT $2",
+            std::move(onResult), std::move(onError),
+            userId,
+            static_cast<int64_t>(limit)
+        );
+        return;
     }
-    return configs;
+    Database::execSqlAsync(
+        "SELECT * FROM database_configs WHERE user_id = $1 AND (created_at, id) < ($2::timestamp, $3) "
+        "ORDER BY created_at DESC, id DESC LIMIT $4",
+        std::move(onResult), std::move(onError),
+        userId,
+        after->createdAt,
+        after->id,
+        static_cast<int64_t>(limit)
+    );
 }
 
-DatabaseConfig DatabaseConfig::create(int userId, const std::string& name, const Json::Value& config) {
-    drogon::orm::DbClientPtr db = Database::getDbClient();
+void DatabaseConfig::createAsync(int userId, const std::string& name, const Json::Value& config,
+                                 std::function<void(DatabaseConfig)>&& callback,
+                                 DbErrorCallback&& errorCallback) {
     Json::FastWriter writer;
     std::string configStr = writer.write(config);
-    try {
-        drogon::orm::Result result = db->execSqlSync(
+    Database::execSqlAsync(
         "INSERT INTO database_configs (user_id, name, config) VALUES ($1, $2, $3::jsonb) RETURNING *",
+        [callback = std::move(callback), errorCallback](const drogon::orm::Result& result) {
+            DatabaseConfig created;
+            try {
+                created = DatabaseConfig(result[0]);
+            } catch (const std::exception& e) {
+                errorCallback(e);
+                return;
+            }
+            ModelCache::invalidateConfig(created.getId(), created.getUserId());
+            callback(std::move(created));
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error creating database config: " << e.base().what();
+            errorCallback(e.base());
+        },
         userId,
         name,
         configStr
-        );
-        return DatabaseConfig(result[0]);
-    } catch (const std::exception& e) {
-        LOG_ERROR << "Error finding database configs by user id: " << e.what();
-    }
-    return DatabaseConfig();
+    );
 }
 
-bool DatabaseConfig::update(int id, const std::string& name, const Json::Value& config) {
-    drogon::orm::DbClientPtr db = Database::getDbClient();
-    try {
-        Json::FastWriter writer;
-        std::string configStr = writer.write(config);
-        
-        drogon::orm::Result result = db->execSqlSync(
-            "UPDATE database_configs SET name = $1, config = $2::jsonb, updated_at = CURRENT_TIMESTAMP "
-            "WHERE id = $3",
-            name,
-            configStr,
-            id
-        );
-        return result.affectedRows() > 0;
-    } catch (const std::exception& e) {
-        LOG_ERROR << "Error updating database config: " << e.what();
-        return false;
-    }
+void DatabaseConfig::updateAsync(int id, const std::string& name, const Json::Value& config,
+                                 std::function<void(bool)>&& callback,
+                                 DbErrorCallback&& errorCallback) {
+    Json::FastWriter writer;
+    std::string configStr = writer.write(config);
+    Database::execSqlAsync(
+        "UPDATE database_configs SET name = $1, config = $2::jsonb, updated_at = CURRENT_TIMESTAMP "
+        "WHERE id = $3 RETURNING user_id",
+        [callback = std::move(callback), id](const drogon::orm::Result& result) {
+            if (result.size() > 0) {
+                ModelCache::invalidateConfig(id, result[0]["user_id"].as<int>());
+            }
+            callback(result.affectedRows() > 0);
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error updating database config: " << e.base().what();
+            errorCallback(e.base());
+        },
+        name,
+        configStr,
+        id
+    );
 }
 
-bool DatabaseConfig::remove(int id) {
-    drogon::orm::DbClientPtr db = Database::getDbClient();
-    try {
-        drogon::orm::Result result = db->execSqlSync(
-            "DELETE FROM database_configs WHERE id = $1",
-            id
-        );
-        return result.affectedRows() > 0;
-    } catch (const std::exception& e) {
-        LOG_ERROR << "Error removing database config: " << e.what();
-        return false;
-    }
+void DatabaseConfig::removeAsync(int id,
+                                 std::function<void(bool)>&& callback,
+                                 DbErrorCallback&& errorCallback) {
+    Database::execSqlAsync(
+        "DELETE FROM database_configs WHERE id = $1 RETURNING user_id",
+        [callback = std::move(callback), id](const drogon::orm::Result& result) {
+            if (result.size() > 0) {
+                ModelCache::invalidateConfig(id, result[0]["user_id"].as<int>());
+            }
+            callback(result.affectedRows() > 0);
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error removing database config: " << e.base().what();
+            errorCallback(e.base());
+        },
+        id
+    );
+}
+
+const Json::Value& DatabaseConfig::getConfig() const {
+    // Одну конфигурацию читают конвейеры всех серверов деплоя сразу
+    std::call_once(config->parsed, [this]() {
+        Json::CharReaderBuilder builder;
+        std::string errors;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        const std::string& text = config->text;
+        if (!reader->parse(text.data(), text.data() + text.size(), &config->value, &errors)) {
+            throw std::runtime_error("Invalid database config: " + errors);
+        }
+    });
+    return config->value;
 }
 
 Json::Value DatabaseConfig::toJson() const {
@@ -105,10 +204,26 @@ Json::Value DatabaseConfig::toJson() const {
     json["id"] = id;
     json["user_id"] = userId;
     json["name"] = name;
-    json["config"] = config;
+    json["config"] = getConfig();
     json["created_at"] = createdAt;
     json["updated_at"] = updatedAt;
     return json;
 }
 
+void DatabaseConfig::writeJson(std::string& out) const {
+    out += "{\"id\":";
+    out += std::to_string(id);
+    out += ",\"user_id\":";
+    out += std::to_string(userId);
+    out += ",\"name\":";
+    out += Json::valueToQuotedString(name.c_str());
+    out += ",\"config\":";
+    out += config->text;
+    out += ",\"created_at\":";
+    out += Json::valueToQuotedString(createdAt.c_str());
+    out += ",\"updated_at\":";
+    out += Json::valueToQuotedString(updatedAt.c_str());
+    out += '}';
+}
+
 } // namespace models
@@ -3,6 +3,11 @@
 #include <json/json.h>
 #include <drogon/orm/Result.h>
 #include <optional>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Database.h"
 
 namespace models {
 
@@ -14,21 +19,52 @@ public:
     int getId() const { return id; }
     int getUserId() const { return userId; }
     const std::string& getName() const { return name; }
-    const Json::Value& getConfig() const { return config; }
+    // Разбирает JSONB при первом обращении; копии модели делят разобранное дерево.
+    // Бросает runtime_error, если в базе оказался не JSON
+    const Json::Value& getConfig() const;
+    // Текст JSONB как его отдала база
+    const std::string& getConfigText() const { return config->text; }
+    const std::string& getCreatedAt() const { return createdAt; }
+    const std::string& getUpdatedAt() const { return updatedAt; }
+    PageCursor getCursor() const { return {createdAt, id}; }
 
-    static std::optional<DatabaseConfig> findById(int id);
-    static std::vector<DatabaseConfig> findByUserId(int userId);
-    static DatabaseConfig create(int userId, const std::string& name, const Json::Value& config);
-    static bool update(int id, const std::string& name, const Json::Value& config);
-    static bool remove(int id);
+    // Запросы к БД асинхронные: не блокируют IO-поток Drogon
+    static void findByIdAsync(int id,
+                              std::function<void(std::optional<DatabaseConfig>)>&& callback,
+                              DbErrorCallback&& errorCallback);
+    static void findByUserIdAsync(int userId,
+                                  std::function<void(std::vector<DatabaseConfig>)>&& callback,
+                                  DbErrorCallback&& errorCallback);
+    // До limit конфигураций пользователя после after (nullopt - с самой новой)
+    static void findPageByUserIdAsync(int userId, const std::optional<PageCursor>& after, size_t limit,
+                                      std::function<void(std::vector<DatabaseConfig>)>&& callback,
+                                      DbErrorCallback&& errorCallback);
+    static void createAsync(int userId, const std::string& name, const Json::Value& config,
+                            std::function<void(DatabaseConfig)>&& callback,
+                            DbErrorCallback&& errorCallback);
+    static void updateAsync(int id, const std::string& name, const Json::Value& config,
+                            std::function<void(bool)>&& callback,
+                            DbErrorCallback&& errorCallback);
+    static void removeAsync(int id,
+                            std::function<void(bool)>&& callback,
+                            DbErrorCallback&& errorCallback);
 
     Json::Value toJson() const;
+    // Тот же объект, что toJson, сразу текстом в out: config вставляется как есть, без разбора
+    void writeJson(std::string& out) const;
 
 private:
+    // Списки и ответы с конфигурацией ее не читают: дерево строится только для деплоя
+    struct LazyConfig {
+        std::string text = "{}";
+        std::once_flag parsed;
+        Json::Value value;
+    };
+
     int id;
     int userId;
     std::string name;
-    Json::Value config;
+    std::shared_ptr<LazyConfig> config = std::make_shared<LazyConfig>();
     std::string createdAt;
     std::string updatedAt;
 };
@@ -0,0 +1,75 @@
+#include "Deployment.h"
+#include <drogon/drogon.h>
+#include <memory>
+#include <stdexcept>
+
+namespace models {
+
+Deployment::Deployment(const drogon::orm::Row& row) {
+    id = row["id"].as<int>();
+    userId = row["user_id"].as<int>();
+    configId = row["config_id"].as<int>();
+    host = row["host"].as<std::string>();
+    port = row["port"].as<int>();
+    version = row["version"].as<std::string>();
+    std::string configText = row["config"].as<std::string>();
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    if (!reader->parse(configText.data(), configText.data() + configText.size(), &config, &errors)) {
+        throw std::runtime_error("Invalid deployment config: " + errors);
+    }
+    deployedAt = row["deployed_at"].as<std::string>();
+}
+
+void Deployment::findLatestPerTargetAsync(int configId,
+                                          std::function<void(std::vector<Deployment>)>&& callback,
+                                          DbErrorCallback&& errorCallback) {
+    Database::execSqlAsync(
+        "SELECT DISTINCT ON (host, port) * FROM deployments WHERE config_id = $1 "
+        "ORDER BY host, port, deployed_at DESC, id DESC",
+        [callback = std::move(callback), errorCallback](const drogon::orm::Result& result) {
+            std::vector<Deployment> deployments;
+            try {
+                deployments.reserve(result.size());
+                for (const auto& row : result) {
+                    deployments.emplace_back(row);
+                }
+            } catch (const std::exception& e) {
+                errorCallback(e);
+                return;
+            }
+            callback(std::move(deployments));
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error finding deployments: " << e.base().what();
+            errorCallback(e.base());
+        },
+        configId
+    );
+}
+
+Deployment Deployment::record(int userId, int configId, const std::string& host, int port,
+                              const std::string& version, const Json::Value& config) {
+    Json::FastWriter writer;
+    std::string configStr = writer.write(config);
+    drogon::orm::DbClientPtr db = Database::getDbClient();
+    drogon::orm::Result result = db->execSqlSync(
+        "INSERT INTO deployments (user_id, config_id, host, port, version, config) "
+        "VALUES ($1, $2, $3, $4, $5, $6::jsonb) RETURNING *",
+        userId, configId, host, port, version, configStr);
+    return Deployment(result[0]);
+}
+
+Json::Value Deployment::toJson() const {
+    Json::Value json;
+    json["id"] = id;
+    json["config_id"] = configId;
+    json["host"] = host;
+    json["port"] = port;
+    json["version"] = version;
+    json["deployed_at"] = deployedAt;
+    return json;
+}
+
+} // namespace models
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <json/json.h>
+#include <drogon/orm/Result.h>
+#include <optional>
+#include <functional>
+#include <vector>
+#include "Database.h"
+
+namespace models {
+
+// Запись об успешном развертывании конфигурации на сервер.
+// Хранит развернутую версию, чтобы следующий деплой применял только разницу.
+class Deployment {
+public:
+    Deployment() = default;
+    Deployment(const drogon::orm::Row& row);
+
+    int getId() const { return id; }
+    int getConfigId() const { return configId; }
+    const std::string& getHost() const { return host; }
+    int getPort() const { return port; }
+    const std::string& getVersion() const { return version; }
+    const Json::Value& getConfig() const { return config; }
+
+    // Последнее развертывание конфигурации на каждый host:port - одним запросом
+    static void findLatestPerTargetAsync(int configId,
+                                         std::function<void(std::vector<Deployment>)>&& callback,
+                                         DbErrorCallback&& errorCallback);
+    // Синхронно: вызывается из рабочих потоков деплоя, не из IO-потоков
+    static Deployment record(int userId, int configId, const std::string& host, int port,
+                             const std::string& version, const Json::Value& config);
+
+    Json::Value toJson() const;
+
+private:
+    int id;
+    int userId;
+    int configId;
+    std::string host;
+    int port;
+    std::string version;
+    Json::Value config;
+    std::string deployedAt;
+};
+
+} // namespace models
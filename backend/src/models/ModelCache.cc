@@ -0,0 +1,206 @@
+#include "ModelCache.h"
+#include <drogon/drogon.h>
+#include <algorithm>
+#include <sstream>
+
+namespace models {
+
+namespace {
+
+constexpr const char* CHANNEL = "model_cache";
+// Поля модели кроме JSON: id, имя, даты
+constexpr size_t ENTRY_OVERHEAD = 128;
+
+} // namespace
+
+std::unique_ptr<utils::ShardedLruCache<int64_t, ModelCache::Entry>> ModelCache::cache;
+size_t ModelCache::maxBytes = 0;
+std::chrono::seconds ModelCache::ttl{300};
+bool ModelCache::notifyEnabled = false;
+std::shared_ptr<drogon::orm::DbListener> ModelCache::listener;
+
+std::array<std::atomic<uint64_t>, ModelCache::GENERATION_SLOTS> ModelCache::generations{};
+std::atomic<uint64_t> ModelCache::hitCount{0};
+std::atomic<uint64_t> ModelCache::missCount{0};
+std::atomic<uint64_t> ModelCache::invalidations{0};
+std::atomic<uint64_t> ModelCache::notifications{0};
+
+void ModelCache::init(const Json::Value& config) {
+    maxBytes = config.get("max_bytes", 64 * 1024 * 1024).asUInt64();
+    size_t shards = config.get("shards", 16).asUInt();
+    ttl = std::chrono::seconds(config.get("ttl_sec", 300).asUInt());
+    notifyEnabled = config.get("notify", false).asBool();
+    if (maxBytes == 0) {
+        return;
+    }
+    cache = std::make_unique<utils::ShardedLruCache<int64_t, Entry>>(
+        maxBytes, std::max<size_t>(1, shards), [](const Entry& entry) { return entry.bytes; });
+
+    if (notifyEnabled) {
+        // Отдельное соединение: LISTEN живет, пока живет сессия, пул для этого не годится.
+        // DbListener переподключается сам; сброс, пришедший во время обрыва, теряется,
+        // поэтому записи в любом случае живут не дольше ttl_sec
+        drogon::app().registerBeginningAdvice([]() {
+            listener = drogon::orm::DbListener::newPgListener(Database::getConnectionInfo(),
+                                                              drogon::app().getLoop());
+            if (!listener) {
+                LOG_ERROR << "Model cache: LISTEN is unavailable, invalidation stays local";
+                return;
+            }
+            listener->listen(CHANNEL, [](const std::string&, const std::string& payload) {
+                onNotification(payload);
+            });
+        });
+    }
+}
+
+std::atomic<uint64_t>& ModelCache::generationSlot(Kind kind, int id) {
+    // Перемешиваем биты: id подряд и разные виды ключей расходятся по ячейкам
+    uint64_t hash = static_cast<uint64_t>(key(kind, id)) * 0x9E3779B97F4A7C15ULL;
+    return generations[(hash >> 32) % GENERATION_SLOTS];
+}
+
+std::optional<ModelCache::Entry> ModelCache::find(Kind kind, int id) {
+    if (!cache) {
+        return std::nullopt;
+    }
+    std::optional<Entry> entry = cache->get(key(kind, id));
+    if (entry && entry->expires <= std::chrono::steady_clock::now()) {
+        cache->erase(key(kind, id));
+        entry.reset();
+    }
+    ++(entry ? hitCount : missCount);
+    return entry;
+}
+
+void ModelCache::put(Kind kind, int id, Entry entry, uint64_t generation) {
+    // Между чтением из базы и этой вставкой ключ сбрасывали: значение могло устареть
+    if (!cache || generation != generationSlot(kind, id).load()) {
+        return;
+    }
+    entry.bytes += ENTRY_OVERHEAD;
+    entry.expires = std::chrono::steady_clock::now() + ttl;
+    cache->put(key(kind, id), std::move(entry));
+}
+
+std::optional<DatabaseConfig> ModelCache::config(int id) {
+    std::optional<Entry> entry = find(Kind::Config, id);
+    if (!entry) {
+        return std::nullopt;
+    }
+    return *entry->config;
+}
+
+void ModelCache::putConfig(const DatabaseConfig& config, uint64_t generation) {
+    Entry entry;
+    entry.bytes = config.getConfigText().size() + config.getName().size();
+    entry.config = std::make_shared<const DatabaseConfig>(config);
+    put(Kind::Config, config.getId(), std::move(entry), generation);
+}
+
+std::shared_ptr<const std::string> ModelCache::configList(int userId) {
+    std::optional<Entry> entry = find(Kind::ConfigList, userId);
+    return entry ? entry->list : nullptr;
+}
+
+void ModelCache::putConfigList(int userId, std::string body, uint64_t generation) {
+    Entry entry;
+    entry.bytes = body.size();
+    entry.list = std::make_shared<const std::string>(std::move(body));
+    put(Kind::ConfigList, userId, std::move(entry), generation);
+}
+
+std::shared_ptr<const Schema> ModelCache::schema(int id) {
+    std::optional<Entry> entry = find(Kind::Schema, id);
+    return entry ? entry->schema : nullptr;
+}
+
+std::optional<Schema::Stamp> ModelCache::schemaStamp(int id) {
+    std::optional<Entry> entry = find(Kind::Schema, id);
+    if (!entry) {
+        return std::nullopt;
+    }
+    return Schema::Stamp{entry->schema->userId, entry->schema->version};
+}
+
+void ModelCache::putSchema(std::shared_ptr<const Schema> schema, size_t jsonBytes, uint64_t generation) {
+    int id = schema->id;
+    Entry entry;
+    entry.bytes = jsonBytes;
+    entry.schema = std::move(schema);
+    put(Kind::Schema, id, std::move(entry), generation);
+}
+
+void ModelCache::drop(Kind kind, int id) {
+    // Поколение растет до удаления: чтение, начатое раньше, уже не вставит старое
+    ++generationSlot(kind, id);
+    ++invalidations;
+    if (cache) {
+        cache->erase(key(kind, id));
+    }
+}
+
+void ModelCache::invalidateConfig(int id, int userId) {
+    drop(Kind::Config, id);
+    drop(Kind::ConfigList, userId);
+    notify("config " + std::to_string(id) + " " + std::to_string(userId));
+}
+
+void ModelCache::invalidateSchema(int id) {
+    drop(Kind::Schema, id);
+    notify("schema " + std::to_string(id));
+}
+
+void ModelCache::notify(const std::string& payload) {
+    if (!cache || !notifyEnabled) {
+        return;
+    }
+    Database::execSqlAsync(
+        "SELECT pg_notify($1, $2)",
+        [](const drogon::orm::Result&) {},
+        [](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Model cache: failed to notify other instances: " << e.base().what();
+        },
+        std::string(CHANNEL),
+        payload);
+}
+
+void ModelCache::onNotification(const std::string& payload) {
+    // Свои уведомления тоже приходят сюда; повторный сброс безвреден
+    ++notifications;
+    std::istringstream in(payload);
+    std::string kind;
+    int id = 0;
+    if (!(in >> kind >> id)) {
+        LOG_ERROR << "Model cache: unexpected notification '" << payload << "'";
+        return;
+    }
+    if (kind == "config") {
+        int userId = 0;
+        drop(Kind::Config, id);
+        if (in >> userId) {
+            drop(Kind::ConfigList, userId);
+        }
+    } else if (kind == "schema") {
+        drop(Kind::Schema, id);
+    }
+}
+
+Json::Value ModelCache::metrics() {
+    uint64_t hits = hitCount.load();
+    uint64_t misses = missCount.load();
+    Json::Value json;
+    json["enabled"] = cache != nullptr;
+    json["notify"] = notifyEnabled && listener != nullptr;
+    json["size"] = static_cast<Json::UInt64>(cache ? cache->size() : 0);
+    json["bytes"] = static_cast<Json::UInt64>(cache ? cache->weight() : 0);
+    json["max_bytes"] = static_cast<Json::UInt64>(maxBytes);
+    json["hits"] = static_cast<Json::UInt64>(hits);
+    json["misses"] = static_cast<Json::UInt64>(misses);
+    json["hit_ratio"] = hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+    json["invalidations"] = static_cast<Json::UInt64>(invalidations.load());
+    json["notifications"] = static_cast<Json::UInt64>(notifications.load());
+    return json;
+}
+
+} // namespace models
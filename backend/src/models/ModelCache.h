@@ -0,0 +1,89 @@
+#pragma once
+#include <drogon/orm/DbListener.h>
+#include <json/json.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include "DatabaseConfig.h"
+#include "Schema.h"
+#include "../utils/ShardedLruCache.h"
+
+namespace models {
+
+// Read-through кэш редко меняющихся моделей: конфигурации и схемы по id и тело
+// списка конфигураций по user_id. Размер ограничен суммарной длиной их JSON.
+// Записи моделей сбрасывают свои ключи сразу; с notify сброс уходит в канал
+// NOTIFY model_cache, и другие экземпляры, слушающие его через DbListener,
+// сбрасывают те же ключи у себя.
+class ModelCache {
+public:
+    // Секция custom_config.model_cache: max_bytes, shards, ttl_sec, notify
+    static void init(const Json::Value& config);
+
+    // Поколение ключа до запроса в базу: прочитанное до сброса этого ключа в кэш
+    // уже не попадет. Сброс других ключей заполнению не мешает
+    static uint64_t configGeneration(int id) { return generation(Kind::Config, id); }
+    static uint64_t configListGeneration(int userId) { return generation(Kind::ConfigList, userId); }
+    static uint64_t schemaGeneration(int id) { return generation(Kind::Schema, id); }
+
+    static std::optional<DatabaseConfig> config(int id);
+    static void putConfig(const DatabaseConfig& config, uint64_t generation);
+    // Тело GET /configs без параметров; кэшируется, только если список пользователя короткий
+    static std::shared_ptr<const std::string> configList(int userId);
+    static void putConfigList(int userId, std::string body, uint64_t generation);
+    // Общий с кэшем документ, без копирования; nullptr - записи нет
+    static std::shared_ptr<const Schema> schema(int id);
+    // Владелец и версия схемы без копирования документа
+    static std::optional<Schema::Stamp> schemaStamp(int id);
+    // jsonBytes - длина JSON схемы в базе: по ней считается занятое место
+    static void putSchema(std::shared_ptr<const Schema> schema, size_t jsonBytes, uint64_t generation);
+
+    // После записи в базу: сброс здесь и, с notify, во всех экземплярах
+    static void invalidateConfig(int id, int userId);
+    static void invalidateSchema(int id);
+
+    // Попадания, промахи, число записей и их объем в байтах JSON, сбросы
+    static Json::Value metrics();
+
+private:
+    enum class Kind : int64_t { Config = 1, ConfigList = 2, Schema = 3 };
+
+    struct Entry {
+        std::shared_ptr<const DatabaseConfig> config;
+        std::shared_ptr<const std::string> list;
+        std::shared_ptr<const Schema> schema;
+        size_t bytes = 0;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    // Поколения хранятся в ячейках по хэшу ключа: сброс задевает только ключи своей ячейки
+    static constexpr size_t GENERATION_SLOTS = 4096;
+
+    static int64_t key(Kind kind, int id) { return (static_cast<int64_t>(kind) << 32) | static_cast<uint32_t>(id); }
+    static std::atomic<uint64_t>& generationSlot(Kind kind, int id);
+    static uint64_t generation(Kind kind, int id) { return generationSlot(kind, id).load(); }
+    static std::optional<Entry> find(Kind kind, int id);
+    static void put(Kind kind, int id, Entry entry, uint64_t generation);
+    // Сброс без рассылки: так применяются и свои записи, и уведомления других экземпляров
+    static void drop(Kind kind, int id);
+    static void notify(const std::string& payload);
+    static void onNotification(const std::string& payload);
+
+    static std::unique_ptr<utils::ShardedLruCache<int64_t, Entry>> cache;
+    static size_t maxBytes;
+    static std::chrono::seconds ttl;
+    static bool notifyEnabled;
+    static std::shared_ptr<drogon::orm::DbListener> listener;
+
+    static std::array<std::atomic<uint64_t>, GENERATION_SLOTS> generations;
+    static std::atomic<uint64_t> hitCount;
+    static std::atomic<uint64_t> missCount;
+    static std::atomic<uint64_t> invalidations;
+    static std::atomic<uint64_t> notifications;
+};
+
+} // namespace models
@@ -0,0 +1,467 @@
+#include "Schema.h"
+#include "ModelCache.h"
+#include "SchemaVersion.h"
+#include <drogon/drogon.h>
+#include <memory>
+#include <stdexcept>
+#include "../sql/DdlCompiler.h"
+
+Json::Value models::Schema::toJson() const {
+  Json::Value result;
+  result["name"] = name;
+  result["id"] = id;
+  result["userId"] = userId;
+  result["description"] = description;
+  result["tables"] = tables;
+  result["relations"] = relations;
+  result["version"] = version;
+  result["createdAt"] = createdAt;
+  result["updatedAt"] = updatedAt;
+  return result;
+}
+
+models::Schema models::Schema::fromJson(const Json::Value& json) {
+  models::Schema result;
+  result.name = json["name"].asString();
+  result.id = json["id"].asInt();
+  result.userId = json["userId"].asInt();
+  result.description = json["description"].asString();
+  result.tables = json["tables"];
+  result.relations = json["relations"];
+  result.version = json["version"].asString();
+  result.createdAt = json["createdAt"].asString();
+  result.updatedAt = json["updatedAt"].asString();
+  return result;
+}
+
+namespace {
+
+Json::Value parseJsonColumn(const std::string& text) {
+  Json::Value value;
+  Json::CharReaderBuilder builder;
+  std::string errors;
+  std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+  if (!reader->parse(text.data(), text.data() + text.size(), &value,
+                     &errors)) {
+    throw std::runtime_error("Invalid JSON in schema row: " + errors);
+  }
+  return value;
+}
+
+std::string writeJsonColumn(const Json::Value& value) {
+  Json::FastWriter writer;
+  return writer.write(value);
+}
+
+// Место схемы в кэше - длина ее JSON-столбцов
+size_t rowJsonBytes(const drogon::orm::Row& row) {
+  return row["tables"].as<std::string>().size() +
+         row["relations"].as<std::string>().size() +
+         row["description"].as<std::string>().size() +
+         row["name"].as<std::string>().size();
+}
+
+}  // namespace
+
+models::Schema models::Schema::fromRow(const drogon::orm::Row& row) {
+  models::Schema result;
+  result.id = row["id"].as<int>();
+  result.userId = row["user_id"].as<int>();
+  result.name = row["name"].as<std::string>();
+  result.description = row["description"].as<std::string>();
+  result.tables = parseJsonColumn(row["tables"].as<std::string>());
+  result.relations = parseJsonColumn(row["relations"].as<std::string>());
+  result.version = row["version"].as<std::string>();
+  result.createdAt = row["created_at"].as<std::string>();
+  result.updatedAt = row["updated_at"].as<std::string>();
+  return result;
+}
+
+void models::Schema::applyJson(const Json::Value& json) {
+  if (json.isMember("name")) {
+    name = json["name"].asString();
+  }
+  if (json.isMember("description")) {
+    description = json["description"].asString();
+  }
+  if (json.isMember("tables")) {
+    tables = json["tables"];
+  }
+  if (json.isMember("relations")) {
+    relations = json["relations"];
+  }
+}
+
+void models::Schema::createAsync(int userId, const std::string& name,
+                                 const std::string& description,
+                                 const Json::Value& tables,
+                                 const Json::Value& relations,
+                                 std::function<void(Schema)>&& callback,
+                                 DbErrorCallback&& errorCallback) {
+  Database::execSqlAsync(
+      SchemaVersion::recordingSql(
+          "INSERT INTO schemas (user_id, name, description, tables, relations) "
+          "VALUES ($1, $2, $3, $4::jsonb, $5::jsonb) RETURNING *",
+          "*"),
+      [callback = std::move(callback),
+       errorCallback](const drogon::orm::Result& result) {
+        models::Schema schema;
+        try {
+          schema = fromRow(result[0]);
+        } catch (const std::exception& e) {
+          errorCallback(e);
+          return;
+        }
+        callback(std::move(schema));
+      },
+      [errorCallback](const drogon::orm::DrogonDbException& e) {
+        LOG_ERROR << "Error creating schema: " << e.base().what();
+        errorCallback(e.base());
+      },
+      userId, name, description, writeJsonColumn(tables),
+      writeJsonColumn(relations));
+}
+
+void models::Schema::findByIdAsync(
+    int id, std::function<void(std::shared_ptr<const Schema>)>&& callback,
+    DbErrorCallback&& errorCallback) {
+  if (std::shared_ptr<const Schema> cached = ModelCache::schema(id)) {
+    callback(std::move(cached));
+    return;
+  }
+  uint64_t generation = ModelCache::schemaGeneration(id);
+  Database::execSqlAsync(
+      "SELECT * FROM schemas WHERE id = $1",
+      [callback = std::move(callback), errorCallback,
+       generation](const drogon::orm::Result& result) {
+        std::shared_ptr<const models::Schema> schema;
+        try {
+          if (result.size() > 0) {
+            schema = std::make_shared<const models::Schema>(fromRow(result[0]));
+            ModelCache::putSchema(schema, rowJsonBytes(result[0]), generation);
+          }
+        } catch (const std::exception& e) {
+          errorCallback(e);
+          return;
+        }
+        callback(std::move(schema));
+      },
+      [errorCallback](const drogon::orm::DrogonDbException& e) {
+        LOG_ERROR << "Error finding schema by id: " << e.base().what();
+        errorCallback(e.base());
+      },
+      id);
+}
+
+void models::Schema::findByUserIdAsync(
+    int userId, std::function<void(std::vector<Schema>)>&& callback,
+    DbErrorCallback&& errorCallback) {
+  Database::execSqlAsync(
+      "SELECT * FROM schemas WHERE user_id = $1 ORDER BY created_at DESC",
+      [callback = std::move(callback),
+       errorCallback](const drogon::orm::Result& result) {
+        std::vector<models::Schema> schemas;
+        schemas.reserve(result.size());
+        try {
+          for (const auto& row : result) {
+            schemas.push_back(fromRow(row));
+          }
+        } catch (const std::exception& e) {
+          errorCallback(e);
+          return;
+        }
+        callback(std::move(schemas));
+      },
+      [errorCallback](const drogon::orm::DrogonDbException& e) {
+        LOG_ERROR << "Error finding schemas by user id: " << e.base().what();
+        errorCallback(e.base());
+      },
+      userId);
+}
+
+void models::Schema::findPageByUserIdAsync(
+    int userId, const std::optional<PageCursor>& after, size_t limit,
+    std::function<void(std::vector<Schema>)>&& callback,
+    DbErrorCallback&& errorCallback) {
+  auto onResult = [callback = std::move(callback),
+                   errorCallback](const drogon::orm::Result& result) {
+    std::vector<models::Schema> schemas;
+    schemas.reserve(result.size());
+    try {
+      for (const auto& row : result) {
+        schemas.push_back(fromRow(row));
+      }
+    } catch (const std::exception& e) {
+      errorCallback(e);
+      return;
+    }
+    callback(std::move(schemas));
+  };
+  auto onError = [errorCallback](const drogon::orm::DrogonDbException& e) {
+    LOG_ERROR << "Error finding schemas page: " << e.base().what();
+    errorCallback(e.base());
+  };
+  if (!after) {
+    Database::execSqlAsync(
+        "SELECT * FROM schemas WHERE user_id = $1 "
+        "ORDER BY created_at DESC, id DESC LIMIT $2",
+        std::move(onResult), std::move(onError), userId,
+        static_cast<int64_t>(limit));
+    return;
+  }
+  Database::execSqlAsync(
+      "SELECT * FROM schemas WHERE user_id = $1 AND "
+      "(created_at, id) < ($2::timestamp, $3) "
+      "ORDER BY created_at DESC, id DESC LIMIT $4",
+      std::move(onResult), std::move(onError), userId, after->createdAt,
+      after->id, static_cast<int64_t>(limit));
+}
+
+void models::Schema::findStampAsync(
+    int id, std::function<void(std::optional<Stamp>)>&& callback,
+    DbErrorCallback&& errorCallback) {
+  if (std::optional<Stamp> cached = ModelCache::schemaStamp(id)) {
+    callback(std::move(cached));
+    return;
+  }
+  Database::execSqlAsync(
+      "SELECT user_id, version FROM schemas WHERE id = $1",
+      [callback = std::move(callback),
+       errorCallback](const drogon::orm::Result& result) {
+        std::optional<Stamp> stamp;
+        try {
+          if (result.size() > 0) {
+            stamp = Stamp{result[0]["user_id"].as<int>(),
+                          result[0]["version"].as<std::string>()};
+          }
+        } catch (const std::exception& e) {
+          errorCallback(e);
+          return;
+        }
+        callback(std::move(stamp));
+      },
+      [errorCallback](const drogon::orm::DrogonDbException& e) {
+        LOG_ERROR << "Error finding schema version: " << e.base().what();
+        errorCallback(e.base());
+      },
+      id);
+}
+
+models::Schema models::Schema::merged(const Json::Value& json) const {
+  models::Schema result = *this;
+  result.applyJson(json);
+  return result;
+}
+
+void models::Schema::updateAsync(
+    const Json::Value& json,
+    std::function<void(std::optional<Schema>)>&& callback,
+    DbErrorCallback&& errorCallback) const {
+  models::Schema updated = merged(json);
+  // Условие на версию: поля, которых нет в json, взяты из этой копии и не
+  // должны затереть чужое сохранение, сделанное после её чтения
+  Database::execSqlAsync(
+      SchemaVersion::recordingSql(
+          "UPDATE schemas SET name = $1, description = $2, tables = $3::jsonb, "
+          "relations = $4::jsonb, version = version + 1, "
+          "updated_at = CURRENT_TIMESTAMP WHERE id = $5 AND version = $6::integer "
+          "RETURNING *",
+          "*"),
+      [callback = std::move(callback), errorCallback,
+       id = id](const drogon::orm::Result& result) {
+        // Сброс и при конфликте: копия могла прийти из устаревшего кэша
+        ModelCache::invalidateSchema(id);
+        std::optional<models::Schema> schema;
+        try {
+          if (result.size() > 0) {
+            schema = fromRow(result[0]);
+          }
+        } catch (const std::exception& e) {
+          errorCallback(e);
+          return;
+        }
+        callback(std::move(schema));
+      },
+      [errorCallback](const drogon::orm::DrogonDbException& e) {
+        LOG_ERROR << "Error updating schema: " << e.base().what();
+        errorCallback(e.base());
+      },
+      updated.name, updated.description, writeJsonColumn(updated.tables),
+      writeJsonColumn(updated.relations), id, version);
+}
+
+void models::Schema::patchAsync(
+    const std::vector<utils::JsonPatch::Edit>& edits, const Schema& patched,
+    std::function<void(std::optional<Schema>)>&& callback,
+    DbErrorCallback&& errorCallback) const {
+  // Правки уходят одним параметром jsonb: [{"p": путь внутри столбца, "v": значение}];
+  // в SQL попадают только номера правок, пользовательские строки - нет
+  Json::Value params(Json::arrayValue);
+  std::string tablesExpr = "tables";
+  std::string relationsExpr = "relations";
+  bool tablesChanged = false;
+  bool relationsChanged = false;
+  auto addEdit = [&](utils::JsonPatch::Edit::Kind kind,
+                     const std::string& column,
+                     std::vector<std::string>::const_iterator first,
+                     std::vector<std::string>::const_iterator last,
+                     const Json::Value& value) {
+    std::string& expr = column == "tables" ? tablesExpr : relationsExpr;
+    (column == "tables" ? tablesChanged : relationsChanged) = true;
+    Json::Value param;
+    param["p"] = Json::Value(Json::arrayValue);
+    for (auto it = first; it != last; ++it) {
+      param["p"].append(*it);
+    }
+    param["v"] = value;
+    std::string index = std::to_string(params.size());
+    params.append(std::move(param));
+    std::string path = "ARRAY(SELECT jsonb_array_elements_text($3::jsonb #> '{" +
+                       index + ",p}'))";
+    std::string newValue = "($3::jsonb #> '{" + index + ",v}')";
+    if (first == last) {
+      expr = newValue;
+    } else if (kind == utils::JsonPatch::Edit::Kind::Set) {
+      expr = "jsonb_set(" + expr + ", " + path + ", " + newValue + ", true)";
+    } else if (kind == utils::JsonPatch::Edit::Kind::Insert) {
+      expr = "jsonb_insert(" + expr + ", " + path + ", " + newValue + ")";
+    } else {
+      expr = "(" + expr + " #- " + path + ")";
+    }
+  };
+  for (const auto& edit : edits) {
+    if (edit.path.empty()) {
+      // Замена документа целиком: значения из самой правки, а не итог патча,
+      // иначе следующие правки применятся в базе второй раз
+      bool object = edit.value.isObject();
+      addEdit(utils::JsonPatch::Edit::Kind::Set, "tables", edit.path.end(),
+              edit.path.end(), object ? edit.value["tables"] : Json::Value());
+      addEdit(utils::JsonPatch::Edit::Kind::Set, "relations", edit.path.end(),
+              edit.path.end(), object ? edit.value["relations"] : Json::Value());
+    } else if (edit.path[0] == "tables" || edit.path[0] == "relations") {
+      addEdit(edit.kind, edit.path[0], edit.path.begin() + 1, edit.path.end(),
+              edit.value);
+    }
+  }
+
+  auto onResult = [callback = std::move(callback), errorCallback, patched,
+                   id = id](const drogon::orm::Result& result) {
+    ModelCache::invalidateSchema(id);
+    std::optional<models::Schema> schema;
+    try {
+      if (result.size() > 0) {
+        schema = patched;
+        schema->version = result[0]["version"].as<std::string>();
+        schema->updatedAt = result[0]["updated_at"].as<std::string>();
+      }
+    } catch (const std::exception& e) {
+      errorCallback(e);
+      return;
+    }
+    callback(std::move(schema));
+  };
+  auto onError = [errorCallback](const drogon::orm::DrogonDbException& e) {
+    LOG_ERROR << "Error patching schema: " << e.base().what();
+    errorCallback(e.base());
+  };
+  if (!tablesChanged && !relationsChanged) {
+    Database::execSqlAsync(
+        SchemaVersion::recordingSql(
+            "UPDATE schemas SET name = $1, description = $2, "
+            "version = version + 1, updated_at = CURRENT_TIMESTAMP "
+            "WHERE id = $3 AND version = $4::integer RETURNING *",
+            "version, updated_at"),
+        std::move(onResult), std::move(onError), patched.name,
+        patched.description, id, version);
+    return;
+  }
+  // Несмененный столбец не упоминается в SET: его TOAST-значение не переписывается
+  std::string assignments;
+  if (tablesChanged) {
+    assignments += "tables = " + tablesExpr + ", ";
+  }
+  if (relationsChanged) {
+    assignments += "relations = " + relationsExpr + ", ";
+  }
+  Database::execSqlAsync(
+      SchemaVersion::recordingSql(
+          "UPDATE schemas SET name = $1, description = $2, " + assignments +
+              "version = version + 1, updated_at = CURRENT_TIMESTAMP "
+              "WHERE id = $4 AND version = $5::integer RETURNING *",
+          "version, updated_at"),
+      std::move(onResult), std::move(onError), patched.name,
+      patched.description, writeJsonColumn(params), id, version);
+}
+
+void models::Schema::restoreAsync(
+    int restored, std::function<void(std::optional<Schema>)>&& callback,
+    DbErrorCallback&& errorCallback) const {
+  Database::execSqlAsync(
+      SchemaVersion::recordingSql(SchemaVersion::restoreSql(), "*"),
+      [callback = std::move(callback), errorCallback,
+       id = id](const drogon::orm::Result& result) {
+        ModelCache::invalidateSchema(id);
+        std::optional<models::Schema> schema;
+        try {
+          if (result.size() > 0) {
+            schema = fromRow(result[0]);
+          }
+        } catch (const std::exception& e) {
+          errorCallback(e);
+          return;
+        }
+        callback(std::move(schema));
+      },
+      [errorCallback](const drogon::orm::DrogonDbException& e) {
+        LOG_ERROR << "Error restoring schema version: " << e.base().what();
+        errorCallback(e.base());
+      },
+      id, version, restored);
+}
+
+void models::Schema::removeAsync(std::function<void(bool)>&& callback,
+                                 DbErrorCallback&& errorCallback) const {
+  Database::execSqlAsync(
+      "DELETE FROM schemas WHERE id = $1",
+      [callback = std::move(callback), id = id](const drogon::orm::Result& result) {
+        ModelCache::invalidateSchema(id);
+        callback(result.affectedRows() > 0);
+      },
+      [errorCallback](const drogon::orm::DrogonDbException& e) {
+        LOG_ERROR << "Error removing schema: " << e.base().what();
+        errorCallback(e.base());
+      },
+      id);
+}
+
+std::string models::Schema::generateSql(const std::string& dbType) const {
+  std::optional<sql::Dialect> dialect = sql::parseDialect(dbType);
+  if (!dialect) {
+    throw std::invalid_argument("Unsupported database type: " + dbType);
+  }
+  return *dialect == sql::Dialect::MySQL ? generateMySqlSql()
+                                         : generatePostgresSql();
+}
+
+std::string models::Schema::generatePostgresSql() const {
+  return sql::DdlCompiler(sql::Dialect::PostgreSQL).compile(tables);
+}
+
+std::string models::Schema::generateMySqlSql() const {
+  return sql::DdlCompiler(sql::Dialect::MySQL).compile(tables);
+}
+
+std::vector<std::string> models::Schema::migrationFrom(
+    const Schema& previous, sql::Dialect dialect) const {
+  if (previous.id == id && previous.version == version) {
+    return {};
+  }
+  return sql::SchemaDiff(dialect).diff(previous.tables, tables);
+}
+
+bool models::Schema::validate() const { return validationErrors().empty(); }
+
+std::vector<sql::ValidationError> models::Schema::validationErrors(
+    sql::Dialect dialect) const {
+  return sql::SchemaValidator(dialect).validate(tables, relations);
+}
@@ -2,13 +2,26 @@
 #include <drogon/orm/Result.h>
 #include <drogon/orm/Row.h>
 #include <json/json.h>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
+#include "Database.h"
+#include "../sql/SchemaValidator.h"
+#include "../sql/SchemaDiff.h"
+#include "../utils/JsonPatch.h"
 
 namespace models {
 
 class Schema {
 public:
+    // Владелец и версия без документа: для условных запросов
+    struct Stamp {
+        int userId = 0;
+        std::string version;
+    };
+
     int id;
     int userId;
     std::string name;
@@ -20,27 +33,74 @@ public:
     std::string updatedAt;
     
     static Schema fromJson(const Json::Value& json);
+    static Schema fromRow(const drogon::orm::Row& row);
     
     Json::Value toJson() const;
     
-    static Schema create(int userId, const std::string& name, 
-                        const Json::Value& tables, 
-                        const Json::Value& relations); // TODO #4
-    static Schema findById(int id); // TODO #5
-    static std::vector<Schema> findByUserId(int userId); // TODO #6
-    void update(const Json::Value& json); // TODO: #7 Обновление повходящему JSON
-    void remove(); // TODO: #8 Удаление из таблицы, а не объекта.
-    bool validate() const; // TODO #9:
-    std::string generateSql(const std::string& dbType) const; // TODO #10
+    // Запросы к БД асинхронные: не блокируют IO-поток Drogon
+    static void createAsync(int userId, const std::string& name,
+                            const std::string& description,
+                            const Json::Value& tables,
+                            const Json::Value& relations,
+                            std::function<void(Schema)>&& callback,
+                            DbErrorCallback&& errorCallback);
+    // nullptr - схемы нет. Документ общий с кэшем моделей и не копируется
+    static void findByIdAsync(int id,
+                              std::function<void(std::shared_ptr<const Schema>)>&& callback,
+                              DbErrorCallback&& errorCallback);
+    static void findByUserIdAsync(int userId,
+                                  std::function<void(std::vector<Schema>)>&& callback,
+                                  DbErrorCallback&& errorCallback);
+    // До limit схем пользователя после after (nullopt - с самой новой)
+    static void findPageByUserIdAsync(int userId,
+                                      const std::optional<PageCursor>& after,
+                                      size_t limit,
+                                      std::function<void(std::vector<Schema>)>&& callback,
+                                      DbErrorCallback&& errorCallback);
+    PageCursor cursor() const { return {createdAt, id}; }
+    // Из кэша, иначе одним узким запросом по первичному ключу
+    static void findStampAsync(int id,
+                               std::function<void(std::optional<Stamp>)>&& callback,
+                               DbErrorCallback&& errorCallback);
+    // Сильный ETag: id и версия, версия растет при каждом сохранении
+    static std::string etagFor(int id, const std::string& version) {
+        return "\"" + std::to_string(id) + "-" + version + "\"";
+    }
+    std::string etag() const { return etagFor(id, version); }
+    // Копия схемы с полями из json - то, что сохранит updateAsync
+    Schema merged(const Json::Value& json) const;
+    // Применяет поля из json к копии схемы и сохраняет её, если версия в базе
+    // всё ещё та же, что у этой копии. nullopt - схему успели изменить или удалить
+    void updateAsync(const Json::Value& json,
+                     std::function<void(std::optional<Schema>)>&& callback,
+                     DbErrorCallback&& errorCallback) const;
+    // Сохраняет результат JSON Patch: tables и relations меняются правками edits
+    // прямо в базе (jsonb_set / jsonb_insert / #-), без пересылки документа;
+    // name и description берутся из patched. Условие на версию - как в updateAsync
+    void patchAsync(const std::vector<utils::JsonPatch::Edit>& edits,
+                    const Schema& patched,
+                    std::function<void(std::optional<Schema>)>&& callback,
+                    DbErrorCallback&& errorCallback) const;
+    // Новая версия с содержимым сохраненной версии restored (см. SchemaVersion);
+    // nullopt - схему успели изменить или такой версии нет
+    void restoreAsync(int restored,
+                      std::function<void(std::optional<Schema>)>&& callback,
+                      DbErrorCallback&& errorCallback) const;
+    void removeAsync(std::function<void(bool)>&& callback,
+                     DbErrorCallback&& errorCallback) const;
+
+    bool validate() const;
+    // Все ошибки схемы с путями до полей; пустой вектор - схема корректна
+    std::vector<sql::ValidationError> validationErrors(sql::Dialect dialect = sql::Dialect::PostgreSQL) const;
+    // DDL схемы для postgresql или mysql; invalid_argument для другого типа
+    std::string generateSql(const std::string& dbType) const;
+    // ALTER/CREATE/DROP для перехода от версии previous к этой; пусто при равных версиях
+    std::vector<std::string> migrationFrom(const Schema& previous, sql::Dialect dialect) const;
     
 private:
-    // <TODO #11
     std::string generatePostgresSql() const;
     std::string generateMySqlSql() const;
-    bool validateTable(const Json::Value& table) const;
-    bool validateColumn(const Json::Value& column) const;
-    bool validateRelation(const Json::Value& relation) const;
-    // !TODO>
+    void applyJson(const Json::Value& json);
 };
 
-} // namespace models
\ No newline at end of file
+} // namespace models
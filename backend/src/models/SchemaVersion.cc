@@ -0,0 +1,289 @@
+#include "SchemaVersion.h"
+#include <drogon/drogon.h>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include "../sql/SchemaJson.h"
+
+namespace models {
+
+namespace {
+
+// Адрес блоба: jsonb приводит ключи и пробелы к одному виду, так что одинаковые
+// определения дают один хэш независимо от того, как их прислал клиент
+std::string digest(const std::string& value) {
+    return "sha256(convert_to((" + value + ")::text, 'UTF8'))";
+}
+
+// Запись saved (строки schemas со всеми столбцами) плюс ее блобы и манифест.
+// Таблицы и relations, уже лежащие в schema_blobs, пропускает ON CONFLICT
+std::string historySql(const std::string& saved, const std::string& returning) {
+    return "WITH saved AS (" + saved + "), "
+           "hashed AS (SELECT saved.id AS schema_id, e.n, e.t, " + digest("e.t") + " AS hash "
+           "FROM saved, jsonb_array_elements(CASE jsonb_typeof(saved.tables) "
+           "WHEN 'array' THEN saved.tables ELSE '[]'::jsonb END) WITH ORDINALITY AS e(t, n)), "
+           "blobs AS (INSERT INTO schema_blobs (schema_id, hash, body) "
+           "SELECT schema_id, hash, t FROM hashed "
+           "UNION ALL SELECT id, " + digest("relations") + ", relations FROM saved "
+           "ON CONFLICT DO NOTHING), "
+           "history AS (INSERT INTO schema_versions "
+           "(schema_id, version, name, description, tables, relations, created_at) "
+           "SELECT saved.id, saved.version, saved.name, saved.description, "
+           "ARRAY(SELECT hash FROM hashed WHERE hashed.schema_id = saved.id ORDER BY n), " +
+           digest("saved.relations") + ", saved.updated_at FROM saved "
+           "ON CONFLICT DO NOTHING) "
+           "SELECT " + returning + " FROM saved";
+}
+
+// Таблицы версии alias в порядке манифеста
+std::string tablesSql(const std::string& alias) {
+    return "COALESCE((SELECT jsonb_agg(b.body ORDER BY m.n) "
+           "FROM unnest(" + alias + ".tables) WITH ORDINALITY AS m(hash, n) "
+           "JOIN schema_blobs b ON b.schema_id = " + alias + ".schema_id AND b.hash = m.hash), '[]'::jsonb)";
+}
+
+std::string relationsSql(const std::string& alias) {
+    return "(SELECT body FROM schema_blobs WHERE schema_id = " + alias + ".schema_id AND hash = " + alias +
+           ".relations)";
+}
+
+Json::Value parseBody(const std::string& text) {
+    Json::Value value;
+    Json::CharReaderBuilder builder;
+    std::string errors;
+    std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+    if (!reader->parse(text.data(), text.data() + text.size(), &value, &errors)) {
+        throw std::runtime_error("Invalid JSON in schema version: " + errors);
+    }
+    return value;
+}
+
+} // namespace
+
+SchemaVersion::SchemaVersion(const drogon::orm::Row& row) {
+    version = row["version"].as<int>();
+    name = row["name"].as<std::string>();
+    description = row["description"].as<std::string>();
+    tableCount = row["table_count"].as<int>();
+    tablesWritten = static_cast<int>(row["tables_written"].as<int64_t>());
+    tablesReplaced = static_cast<int>(row["tables_replaced"].as<int64_t>());
+    relationsChanged = row["relations_changed"].as<bool>();
+    createdAt = row["created_at"].as<std::string>();
+}
+
+std::string SchemaVersion::recordingSql(const std::string& write, const std::string& returning) {
+    return historySql(write, returning);
+}
+
+std::string SchemaVersion::backfillSql() {
+    return historySql("SELECT s.* FROM schemas s WHERE NOT EXISTS (SELECT 1 FROM schema_versions v "
+                      "WHERE v.schema_id = s.id AND v.version = s.version)",
+                      "count(*)");
+}
+
+std::string SchemaVersion::restoreSql() {
+    return "UPDATE schemas SET name = v.name, description = v.description, "
+           "tables = " + tablesSql("v") + ", relations = " + relationsSql("v") + ", "
+           "version = schemas.version + 1, updated_at = CURRENT_TIMESTAMP "
+           "FROM schema_versions v WHERE schemas.id = $1 AND schemas.version = $2::integer "
+           "AND v.schema_id = schemas.id AND v.version = $3 RETURNING schemas.*";
+}
+
+void SchemaVersion::findBySchemaIdAsync(int schemaId, std::optional<int> before, size_t limit,
+                                        std::function<void(std::vector<SchemaVersion>)>&& callback,
+                                        DbErrorCallback&& errorCallback) {
+    // Сводка по манифестам: хэши сравниваются в базе, блобы не читаются
+    Database::execSqlAsync(
+        "SELECT v.version, v.name, v.description, v.created_at, "
+        "cardinality(v.tables) AS table_count, "
+        "(SELECT count(*) FROM (SELECT unnest(v.tables) EXCEPT ALL SELECT unnest(p.tables)) w) "
+        "AS tables_written, "
+        "(SELECT count(*) FROM (SELECT unnest(p.tables) EXCEPT ALL SELECT unnest(v.tables)) r) "
+        "AS tables_replaced, "
+        "p.relations IS DISTINCT FROM v.relations AS relations_changed "
+        "FROM schema_versions v LEFT JOIN LATERAL (SELECT tables, relations FROM schema_versions "
+        "WHERE schema_id = v.schema_id AND version < v.version ORDER BY version DESC LIMIT 1) p ON true "
+        "WHERE v.schema_id = $1 AND v.version < $2 ORDER BY v.version DESC LIMIT $3",
+        [callback = std::move(callback), errorCallback](const drogon::orm::Result& result) {
+            std::vector<SchemaVersion> versions;
+            try {
+                versions.reserve(result.size());
+                for (const auto& row : result) {
+                    versions.emplace_back(row);
+                }
+            } catch (const std::exception& e) {
+                errorCallback(e);
+                return;
+            }
+            callback(std::move(versions));
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error finding schema versions: " << e.base().what();
+            errorCallback(e.base());
+        },
+        schemaId,
+        before.value_or(std::numeric_limits<int>::max()),
+        static_cast<int64_t>(limit)
+    );
+}
+
+void SchemaVersion::existsAsync(int schemaId, int version, std::function<void(bool)>&& callback,
+                                DbErrorCallback&& errorCallback) {
+    Database::execSqlAsync(
+        "SELECT 1 FROM schema_versions WHERE schema_id = $1 AND version = $2",
+        [callback = std::move(callback)](const drogon::orm::Result& result) {
+            callback(result.size() > 0);
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error finding schema version: " << e.base().what();
+            errorCallback(e.base());
+        },
+        schemaId,
+        version
+    );
+}
+
+void SchemaVersion::loadAsync(int schemaId, int version,
+                              std::function<void(std::optional<Json::Value>)>&& callback,
+                              DbErrorCallback&& errorCallback) {
+    Database::execSqlAsync(
+        "SELECT v.version, v.name, v.description, v.created_at, " + tablesSql("v") + " AS tables, " +
+            relationsSql("v") + " AS relations "
+            "FROM schema_versions v WHERE v.schema_id = $1 AND v.version = $2",
+        [callback = std::move(callback), errorCallback](const drogon::orm::Result& result) {
+            std::optional<Json::Value> document;
+            try {
+                if (result.size() > 0) {
+                    const drogon::orm::Row& row = result[0];
+                    Json::Value json;
+                    json["version"] = row["version"].as<int>();
+                    json["name"] = row["name"].as<std::string>();
+                    json["description"] = row["description"].as<std::string>();
+                    json["tables"] = parseBody(row["tables"].as<std::string>());
+                    json["relations"] = parseBody(row["relations"].as<std::string>());
+                    json["created_at"] = row["created_at"].as<std::string>();
+                    document = std::move(json);
+                }
+            } catch (const std::exception& e) {
+                errorCallback(e);
+                return;
+            }
+            callback(std::move(document));
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error loading schema version: " << e.base().what();
+            errorCallback(e.base());
+        },
+        schemaId,
+        version
+    );
+}
+
+void SchemaVersion::diffAsync(int schemaId, int from, int to,
+                              std::function<void(std::optional<Json::Value>)>&& callback,
+                              DbErrorCallback&& errorCallback) {
+    // Хэши сравниваются в базе; читаются только определения, которых нет в другой версии.
+    // Первая строка - сколько из двух версий нашлось
+    Database::execSqlAsync(
+        "WITH a AS (SELECT tables, relations FROM schema_versions WHERE schema_id = $1 AND version = $2), "
+        "b AS (SELECT tables, relations FROM schema_versions WHERE schema_id = $1 AND version = $3), "
+        "removed AS (SELECT unnest(tables) AS hash FROM a EXCEPT SELECT unnest(tables) FROM b), "
+        "added AS (SELECT unnest(tables) AS hash FROM b EXCEPT SELECT unnest(tables) FROM a) "
+        "SELECT 'found' AS side, to_jsonb((SELECT count(*) FROM a) + (SELECT count(*) FROM b)) AS body "
+        "UNION ALL SELECT 'from', s.body FROM removed "
+        "JOIN schema_blobs s ON s.schema_id = $1 AND s.hash = removed.hash "
+        "UNION ALL SELECT 'to', s.body FROM added "
+        "JOIN schema_blobs s ON s.schema_id = $1 AND s.hash = added.hash "
+        "UNION ALL SELECT 'relations_from', s.body FROM a, b, schema_blobs s "
+        "WHERE a.relations <> b.relations AND s.schema_id = $1 AND s.hash = a.relations "
+        "UNION ALL SELECT 'relations_to', s.body FROM a, b, schema_blobs s "
+        "WHERE a.relations <> b.relations AND s.schema_id = $1 AND s.hash = b.relations",
+        [callback = std::move(callback), errorCallback, from, to](const drogon::orm::Result& result) {
+            std::optional<Json::Value> diff;
+            try {
+                Json::Value before(Json::arrayValue);
+                Json::Value after(Json::arrayValue);
+                Json::Value relations;
+                int found = 0;
+                for (const auto& row : result) {
+                    std::string side = row["side"].as<std::string>();
+                    Json::Value body = parseBody(row["body"].as<std::string>());
+                    if (side == "found") {
+                        found = body.asInt();
+                    } else if (side == "from") {
+                        before.append(std::move(body));
+                    } else if (side == "to") {
+                        after.append(std::move(body));
+                    } else if (side == "relations_from") {
+                        relations["before"] = std::move(body);
+                    } else {
+                        relations["after"] = std::move(body);
+                    }
+                }
+                if (found == 2) {
+                    // Таблица, измененная между версиями, есть с обеих сторон под одним
+                    // ключом (id из конструктора, иначе имя); остальные - добавлены или удалены
+                    std::unordered_map<std::string, Json::ArrayIndex> removedByKey;
+                    for (Json::ArrayIndex i = 0; i < before.size(); ++i) {
+                        removedByKey.emplace(sql::matchKey(before[i]), i);
+                    }
+                    Json::Value json;
+                    json["from"] = from;
+                    json["to"] = to;
+                    json["added"] = Json::Value(Json::arrayValue);
+                    json["removed"] = Json::Value(Json::arrayValue);
+                    json["changed"] = Json::Value(Json::arrayValue);
+                    std::vector<bool> matched(before.size(), false);
+                    for (auto& table : after) {
+                        auto it = removedByKey.find(sql::matchKey(table));
+                        if (it == removedByKey.end() || matched[it->second]) {
+                            json["added"].append(std::move(table));
+                            continue;
+                        }
+                        matched[it->second] = true;
+                        Json::Value change;
+                        change["before"] = std::move(before[it->second]);
+                        change["after"] = std::move(table);
+                        json["changed"].append(std::move(change));
+                    }
+                    for (Json::ArrayIndex i = 0; i < before.size(); ++i) {
+                        if (!matched[i]) {
+                            json["removed"].append(std::move(before[i]));
+                        }
+                    }
+                    if (!relations.isNull()) {
+                        json["relations"] = std::move(relations);
+                    }
+                    diff = std::move(json);
+                }
+            } catch (const std::exception& e) {
+                errorCallback(e);
+                return;
+            }
+            callback(std::move(diff));
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error comparing schema versions: " << e.base().what();
+            errorCallback(e.base());
+        },
+        schemaId,
+        from,
+        to
+    );
+}
+
+Json::Value SchemaVersion::toJson() const {
+    Json::Value json;
+    json["version"] = version;
+    json["name"] = name;
+    json["description"] = description;
+    json["tables"] = tableCount;
+    json["tables_written"] = tablesWritten;
+    json["tables_replaced"] = tablesReplaced;
+    json["relations_changed"] = relationsChanged;
+    json["created_at"] = createdAt;
+    return json;
+}
+
+} // namespace models
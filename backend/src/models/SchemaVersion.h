@@ -0,0 +1,65 @@
+#pragma once
+#include <drogon/orm/Row.h>
+#include <json/json.h>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+#include "Database.h"
+
+namespace models {
+
+// Сохраненная версия схемы. Определение каждой таблицы и массив relations лежат
+// в schema_blobs один раз на схему под sha256 своего jsonb-текста; версия в
+// schema_versions - манифест: хэши таблиц по порядку и хэш relations. Таблица,
+// не менявшаяся между версиями, стоит в новой версии 32 байта хэша, поэтому
+// история растет с объемом правок, а не с размером схемы.
+class SchemaVersion {
+public:
+    SchemaVersion() = default;
+    SchemaVersion(const drogon::orm::Row& row);
+
+    // Оборачивает запись строки schemas (INSERT или UPDATE с RETURNING всех ее
+    // столбцов) так, что тем же запросом сохраняются новые блобы и манифест
+    // записанной версии. Запрос возвращает столбцы returning записанной строки
+    static std::string recordingSql(const std::string& write, const std::string& returning);
+    // Добавляет в историю текущие версии схем, сохраненных до ее появления
+    static std::string backfillSql();
+    // UPDATE схемы $1 версии $2::integer до содержимого сохраненной версии $3;
+    // блобы собираются в документ в базе, без пересылки в приложение
+    static std::string restoreSql();
+
+    static void existsAsync(int schemaId, int version, std::function<void(bool)>&& callback,
+                            DbErrorCallback&& errorCallback);
+
+    // Версии схемы от новых к старым, до limit штук с номером меньше before
+    static void findBySchemaIdAsync(int schemaId, std::optional<int> before, size_t limit,
+                                    std::function<void(std::vector<SchemaVersion>)>&& callback,
+                                    DbErrorCallback&& errorCallback);
+    // Документ версии {name, description, tables, relations}; nullopt - версии нет
+    static void loadAsync(int schemaId, int version,
+                          std::function<void(std::optional<Json::Value>)>&& callback,
+                          DbErrorCallback&& errorCallback);
+    // Разница версий по таблицам: из базы читаются только блобы, которых нет
+    // в другой версии. nullopt - одной из версий нет
+    static void diffAsync(int schemaId, int from, int to,
+                          std::function<void(std::optional<Json::Value>)>&& callback,
+                          DbErrorCallback&& errorCallback);
+
+    int getVersion() const { return version; }
+    Json::Value toJson() const;
+
+private:
+    int version = 0;
+    std::string name;
+    std::string description;
+    int tableCount = 0;
+    // Определения таблиц, которых не было в предыдущей версии (новые и измененные),
+    // и определения предыдущей версии, которых больше нет (удаленные и измененные)
+    int tablesWritten = 0;
+    int tablesReplaced = 0;
+    bool relationsChanged = false;
+    std::string createdAt;
+};
+
+} // namespace models
@@ -12,47 +12,79 @@ User::User(const drogon::orm::Row& row) {
     createdAt = row["created_at"].as<std::string>();
 }
 
-std::optional<User> User::findByUsername(const std::string& username) {
-    auto db = Database::getDbClient();
-    try {
-        auto result = db->execSqlSync(
-            "SELECT * FROM users WHERE username = $1",
-            username
-        );
-        if (result.size() > 0) {
-            return User(result[0]);
-        }
-    } catch (const std::exception& e) {
-        LOG_ERROR << "Error finding user by username: " << e.what();
-    }
-    return std::nullopt;
+void User::findByUsernameAsync(const std::string& username,
+                               std::function<void(std::optional<User>)>&& callback,
+                               DbErrorCallback&& errorCallback) {
+    Database::execSqlAsync(
+        "SELECT * FROM users WHERE username = $1",
+        [callback = std::move(callback), errorCallback](const drogon::orm::Result& result) {
+            std::optional<User> user;
+            try {
+                if (result.size() > 0) {
+                    user = User(result[0]);
+                }
+            } catch (const std::exception& e) {
+                errorCallback(e);
+                return;
+            }
+            callback(std::move(user));
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error finding user by username: " << e.base().what();
+            errorCallback(e.base());
+        },
+        username
+    );
 }
 
-std::optional<User> User::findById(int id) {
-    auto db = Database::getDbClient();
-    try {
-        auto result = db->execSqlSync(
-            "SELECT * FROM users WHERE id = $1",
-            id
-        );
-        if (result.size() > 0) {
-            return User(result[0]);
-        }
-    } catch (const std::exception& e) {
-        LOG_ERROR << "Error finding user by id: " << e.what();
-    }
-    return std::nullopt;
+void User::findByIdAsync(int id,
+                         std::function<void(std::optional<User>)>&& callback,
+                         DbErrorCallback&& errorCallback) {
+    Database::execSqlAsync(
+        "SELECT * FROM users WHERE id = $1",
+        [callback = std::move(callback), errorCallback](const drogon::orm::Result& result) {
+            std::optional<User> user;
+            try {
+                if (result.size() > 0) {
+                    user = User(result[0]);
+                }
+            } catch (const std::exception& e) {
+                errorCallback(e);
+                return;
+            }
+            callback(std::move(user));
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error finding user by id: " << e.base().what();
+            errorCallback(e.base());
+        },
+        id
+    );
 }
 
-User User::create(const std::string& username, const std::string& email, const std::string& passwordHash) {
-    auto db = Database::getDbClient();
-    auto result = db->execSqlSync(
+void User::createAsync(const std::string& username, const std::string& email, const std::string& passwordHash,
+                       std::function<void(User)>&& callback,
+                       DbErrorCallback&& errorCallback) {
+    Database::execSqlAsync(
         "INSERT INTO users (username, email, password_hash) VALUES ($1, $2, $3) RETURNING *",
+        [callback = std::move(callback), errorCallback](const drogon::orm::Result& result) {
+            User user;
+            try {
+                user = User(result[0]);
+            } catch (const std::exception& e) {
+                errorCallback(e);
+                return;
+            }
+            callback(std::move(user));
+        },
+        [errorCallback](const drogon::orm::DrogonDbException& e) {
+            LOG_ERROR << "Error creating user: " << e.base().what();
+            errorCallback(e.base());
+        },
         username,
         email,
         passwordHash
     );
-    return User(result[0]);
 }
 
 bool User::validatePassword(const std::string& password, const std::string& hash) {
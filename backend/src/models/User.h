@@ -3,6 +3,8 @@
 #include <json/json.h>
 #include <drogon/orm/Result.h>
 #include <optional>
+#include <functional>
+#include "Database.h"
 
 namespace models {
 
@@ -16,12 +18,19 @@ public:
     const std::string& getEmail() const { return email; }
     const std::string& getPasswordHash() const { return passwordHash; }
 
-    static std::optional<User> findByUsername(const std::string& username); // TODO #12
-    static std::optional<User> findById(int id); // TODO #13
-    static User create(const std::string& username, const std::string& email, const std::string& passwordHash); // TODO: #14 Create user in table
-    static bool validatePassword(const std::string& password, const std::string& hash); // TODO: #15 validation of password in table
+    // Запросы к БД асинхронные: не блокируют IO-поток Drogon
+    static void findByUsernameAsync(const std::string& username,
+                                    std::function<void(std::optional<User>)>&& callback,
+                                    DbErrorCallback&& errorCallback);
+    static void findByIdAsync(int id,
+                              std::function<void(std::optional<User>)>&& callback,
+                              DbErrorCallback&& errorCallback);
+    static void createAsync(const std::string& username, const std::string& email, const std::string& passwordHash,
+                            std::function<void(User)>&& callback,
+                            DbErrorCallback&& errorCallback);
+    static bool validatePassword(const std::string& password, const std::string& hash);
 
-    Json::Value toJson() const; // TODO: #16 Convert user to JSON
+    Json::Value toJson() const;
 
 private:
     int id;
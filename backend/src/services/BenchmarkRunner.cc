@@ -0,0 +1,268 @@
+#include "BenchmarkRunner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+
+namespace services {
+
+namespace {
+
+// Порция файла запросов на одну запись в канал
+constexpr size_t CHUNK_BYTES = 64 * 1024;
+// Строк ошибок клиентов в журнал задачи на форму
+constexpr int ERROR_LINES = 5;
+
+// Строковый литерал MySQL: экранируются кавычка и обратная косая черта
+std::string mysqlString(const std::string& value) {
+    std::string quoted = "'";
+    for (char c : value) {
+        if (c == '\'' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "'";
+}
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::string clientCommand(sql::Dialect dialect, const std::string& database) {
+    // \timing печатает "Time: N ms" в stdout, результаты запросов уходят в \o /dev/null
+    if (dialect == sql::Dialect::PostgreSQL) {
+        return "sudo -u postgres psql -X -q -d " + DeployScript::shellQuote(database);
+    }
+    // --force: ошибка запроса (дубликат ключа) не прерывает клиента
+    return "sudo mysql --force " + DeployScript::shellQuote(database);
+}
+
+// Выполняет команду и возвращает ее stdout; stderr и ненулевой код - исключение
+std::string capture(RemoteExecutor& executor, const std::string& command, std::string_view input = {}) {
+    std::string out;
+    std::string err;
+    int code = executor.run(command, [&out, &err](bool isStderr, std::string_view data) {
+        (isStderr ? err : out).append(data);
+    }, input);
+    if (code != 0) {
+        throw std::runtime_error("Command failed with exit code " + std::to_string(code) + ": " + err);
+    }
+    return out;
+}
+
+} // namespace
+
+double BenchmarkRunner::percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    auto rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+Json::Value BenchmarkRunner::run(DeploymentJob& job, const SshCredentials& target, sql::Dialect dialect,
+                                 const std::string& database, const sql::Workload& workload, Options options) {
+    auto start = std::chrono::steady_clock::now();
+    std::string key = DeploymentJobs::targetKey(target);
+    RemoteExecutor executor(target);
+    executor.connect();
+
+    std::string directory = capture(executor, "mktemp -d");
+    directory.erase(directory.find_last_not_of(" \r\n") + 1);
+    if (directory.empty()) {
+        throw std::runtime_error("Failed to create a temporary directory on the server");
+    }
+
+    Json::Value shapes(Json::arrayValue);
+    try {
+        for (size_t s = 0; s < workload.shapes().size(); ++s) {
+            shapes.append(runShape(job, executor, key, dialect, database, workload, s, options, directory));
+        }
+    } catch (...) {
+        executor.run("rm -rf " + DeployScript::shellQuote(directory), [](bool, std::string_view) {});
+        throw;
+    }
+    executor.run("rm -rf " + DeployScript::shellQuote(directory), [](bool, std::string_view) {});
+
+    Json::Value result;
+    result["clients"] = static_cast<Json::UInt64>(options.clients);
+    result["queries_per_client"] = static_cast<Json::UInt64>(options.queriesPerClient);
+    result["shapes"] = std::move(shapes);
+    result["duration_ms"] = millisSince(start);
+    return result;
+}
+
+Json::Value BenchmarkRunner::runShape(DeploymentJob& job, RemoteExecutor& executor, const std::string& key,
+                                      sql::Dialect dialect, const std::string& database,
+                                      const sql::Workload& workload, size_t shape, const Options& options,
+                                      const std::string& directory) {
+    const sql::Workload::Shape& definition = workload.shapes()[shape];
+    auto onOutput = [&job, &key, shape](bool isStderr, std::string_view data) {
+        if (!isStderr) {
+            return;
+        }
+        Json::Value output;
+        output["type"] = "output";
+        output["target"] = key;
+        output["step"] = static_cast<Json::UInt64>(shape + 1);
+        output["stream"] = "stderr";
+        output["data"] = std::string(data);
+        job.emit(std::move(output));
+    };
+
+    Json::Value event;
+    event["type"] = "step";
+    event["target"] = key;
+    event["step"] = static_cast<Json::UInt64>(shape + 1);
+    event["total"] = static_cast<Json::UInt64>(workload.shapes().size());
+    event["name"] = "bench_" + definition.name;
+    job.emit(std::move(event));
+
+    // Файлы запросов: у клиента свой диапазон номеров, вставки не пересекаются
+    for (size_t client = 0; client < options.clients; ++client) {
+        uint64_t sequence = client * options.queriesPerClient;
+        uint64_t last = sequence + options.queriesPerClient;
+        std::string chunk;
+        bool header = dialect == sql::Dialect::PostgreSQL;
+        int code = executor.run(
+            "cat > " + DeployScript::shellQuote(directory + "/" + std::to_string(client) + ".sql"), onOutput,
+            [&]() {
+                chunk.clear();
+                if (header) {
+                    chunk += "\\timing on\n\\o /dev/null\n";
+                    header = false;
+                }
+                while (sequence < last && chunk.size() < CHUNK_BYTES) {
+                    workload.writeQuery(shape, sequence++, chunk);
+                }
+                return std::string_view(chunk);
+            });
+        if (code != 0) {
+            throw std::runtime_error("Failed to upload queries, exit code " + std::to_string(code));
+        }
+    }
+
+    // Только этот прогон в гистограммах MySQL: сброс счетчиков digest перед формой
+    std::string sample;
+    if (dialect == sql::Dialect::MySQL) {
+        workload.writeQuery(shape, 0, sample);
+        sample.erase(sample.find_last_not_of(";\n") + 1);
+        capture(executor, "sudo mysql -e " + DeployScript::shellQuote(
+            "TRUNCATE TABLE performance_schema.events_statements_summary_by_digest; "
+            "TRUNCATE TABLE performance_schema.events_statements_histogram_by_digest"));
+    }
+
+    // Клиенты стартуют вместе; время стены - от запуска первого до выхода последнего
+    std::string script = "cd " + DeployScript::shellQuote(directory) + " || exit 1\n"
+        "start=$(date +%s%N)\n"
+        "i=0\n"
+        "while [ $i -lt " + std::to_string(options.clients) + " ]; do\n"
+        "  " + clientCommand(dialect, database) + " < $i.sql > $i.out 2> $i.err &\n"
+        "  i=$((i + 1))\n"
+        "done\n"
+        "wait\n"
+        "end=$(date +%s%N)\n"
+        "echo \"wall $((end - start))\"\n"
+        "echo \"errors $(cat *.err | grep -c ERROR)\"\n"
+        "grep -h ERROR *.err | head -n " + std::to_string(ERROR_LINES) + " >&2\n";
+    if (dialect == sql::Dialect::PostgreSQL) {
+        script += "awk '/^Time:/ { print \"latency\", $2 }' *.out\n";
+    }
+    std::string report;
+    int code = executor.run("sh -s", [&report, &onOutput](bool isStderr, std::string_view data) {
+        if (isStderr) {
+            onOutput(isStderr, data);
+        } else {
+            report.append(data);
+        }
+    }, script);
+    if (code != 0) {
+        throw std::runtime_error("Benchmark clients failed, exit code " + std::to_string(code));
+    }
+
+    // PostgreSQL: задержка каждого запроса; MySQL: корзины гистограммы с верхней границей в пикосекундах
+    std::vector<double> latencies;
+    std::vector<std::pair<double, uint64_t>> buckets;
+    uint64_t wallNanos = 0;
+    uint64_t errors = 0;
+    std::istringstream lines(report);
+    std::string kind;
+    while (lines >> kind) {
+        if (kind == "wall") {
+            lines >> wallNanos;
+        } else if (kind == "errors") {
+            lines >> errors;
+        } else if (kind == "latency") {
+            double millis = 0;
+            lines >> millis;
+            latencies.push_back(millis);
+        }
+    }
+    if (dialect == sql::Dialect::MySQL) {
+        std::istringstream rows(capture(executor, "sudo mysql -N -B -e " + DeployScript::shellQuote(
+            "SELECT BUCKET_TIMER_HIGH, SUM(COUNT_BUCKET) "
+            "FROM performance_schema.events_statements_histogram_by_digest "
+            "WHERE SCHEMA_NAME = " + mysqlString(database) + " AND DIGEST = STATEMENT_DIGEST(" +
+            mysqlString(sample) + ") GROUP BY BUCKET_TIMER_HIGH HAVING SUM(COUNT_BUCKET) > 0 "
+            "ORDER BY BUCKET_TIMER_HIGH")));
+        double high = 0;
+        uint64_t count = 0;
+        while (rows >> high >> count) {
+            buckets.emplace_back(high / 1e9, count);
+        }
+    }
+
+    uint64_t queries = options.clients * options.queriesPerClient;
+    double durationMs = static_cast<double>(wallNanos) / 1e6;
+    Json::Value result;
+    result["shape"] = definition.name;
+    result["kind"] = sql::Workload::kindName(definition.kind);
+    result["queries"] = static_cast<Json::UInt64>(queries);
+    result["errors"] = static_cast<Json::UInt64>(errors);
+    result["duration_ms"] = durationMs;
+    result["throughput_qps"] = durationMs > 0 ? static_cast<double>(queries) * 1000.0 / durationMs : 0.0;
+    if (dialect == sql::Dialect::PostgreSQL) {
+        std::sort(latencies.begin(), latencies.end());
+        result["timed"] = static_cast<Json::UInt64>(latencies.size());
+        result["p50_ms"] = percentile(latencies, 50);
+        result["p95_ms"] = percentile(latencies, 95);
+        result["p99_ms"] = percentile(latencies, 99);
+        result["max_ms"] = latencies.empty() ? 0.0 : latencies.back();
+    } else {
+        // Перцентиль - верхняя граница корзины, в которую он попал
+        uint64_t total = 0;
+        for (const auto& bucket : buckets) {
+            total += bucket.second;
+        }
+        auto bucketPercentile = [&buckets, total](double p) {
+            auto rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+            uint64_t seen = 0;
+            for (const auto& bucket : buckets) {
+                seen += bucket.second;
+                if (seen >= std::max<uint64_t>(rank, 1)) {
+                    return bucket.first;
+                }
+            }
+            return 0.0;
+        };
+        result["timed"] = static_cast<Json::UInt64>(total);
+        result["p50_ms"] = bucketPercentile(50);
+        result["p95_ms"] = bucketPercentile(95);
+        result["p99_ms"] = bucketPercentile(99);
+        result["max_ms"] = buckets.empty() ? 0.0 : buckets.back().first;
+    }
+
+    Json::Value exit;
+    exit["type"] = "exit";
+    exit["target"] = key;
+    exit["step"] = static_cast<Json::UInt64>(shape + 1);
+    exit["name"] = "bench_" + definition.name;
+    exit["code"] = 0;
+    exit["duration_ms"] = durationMs;
+    job.emit(std::move(exit));
+    return result;
+}
+
+} // namespace services
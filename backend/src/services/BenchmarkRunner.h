@@ -0,0 +1,39 @@
+#pragma once
+#include <json/json.h>
+#include <string>
+#include <vector>
+#include "DeploymentJobs.h"
+#include "RemoteExecutor.h"
+#include "SshSessionPool.h"
+#include "../sql/Workload.h"
+
+namespace services {
+
+// Замер нагрузки sql::Workload на развернутой базе. Порты СУБД наружу не
+// открыты, поэтому клиенты запускаются на самом сервере: по файлу запросов на
+// клиента выгружается по SSH, затем clients процессов psql/mysql работают
+// одновременно. Формы прогоняются по очереди, у каждой своя пропускная
+// способность и перцентили задержки: PostgreSQL - по \timing каждого запроса,
+// MySQL - по гистограмме performance_schema (8.0.19+) для digest формы.
+class BenchmarkRunner {
+public:
+    struct Options {
+        size_t clients = 4;
+        uint64_t queriesPerClient = 1000;
+    };
+
+    // {"clients", "queries_per_client", "duration_ms", "shapes": [{"shape", "kind",
+    //  "queries", "timed", "errors", "duration_ms", "throughput_qps", "p50_ms", "p95_ms", "p99_ms", "max_ms"}]}
+    static Json::Value run(DeploymentJob& job, const SshCredentials& target, sql::Dialect dialect,
+                           const std::string& database, const sql::Workload& workload, Options options);
+
+    // Перцентиль p (0..100) по возрастающим значениям, метод ближайшего ранга
+    static double percentile(const std::vector<double>& sorted, double p);
+
+private:
+    static Json::Value runShape(DeploymentJob& job, RemoteExecutor& executor, const std::string& key,
+                                sql::Dialect dialect, const std::string& database, const sql::Workload& workload,
+                                size_t shape, const Options& options, const std::string& directory);
+};
+
+} // namespace services
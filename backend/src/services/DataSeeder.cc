@@ -0,0 +1,213 @@
+#include "DataSeeder.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace services {
+
+namespace {
+
+// Порция CSV на одну запись в канал
+constexpr size_t CHUNK_BYTES = 256 * 1024;
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+std::string DataSeeder::clientCommand(sql::Dialect dialect, const std::string& database,
+                                      const std::string& statement) {
+    if (dialect == sql::Dialect::PostgreSQL) {
+        return "sudo -u postgres psql -v ON_ERROR_STOP=1 -d " + DeployScript::shellQuote(database) + " -c " + DeployScript::shellQuote(statement);
+    }
+    return "sudo mysql --local-infile=1 " + DeployScript::shellQuote(database) + " -e " + DeployScript::shellQuote(statement);
+}
+
+Json::Value DataSeeder::run(DeploymentJob& job, const SshCredentials& target, sql::Dialect dialect,
+                            const std::string& database, const sql::DataGenerator& generator,
+                            size_t parallelism) {
+    parallelism = std::clamp<size_t>(parallelism, 1, SshSessionPool::maxSessionsPerHost());
+
+    // LOAD DATA LOCAL выключен на сервере MySQL по умолчанию, а local_infile бывает только
+    // глобальной: включаем на время загрузки и возвращаем прежнее значение, в том числе при ошибке
+    bool restoreLocalInfile = dialect == sql::Dialect::MySQL && !localInfileEnabled(target);
+    if (restoreLocalInfile) {
+        setLocalInfile(target, true);
+    }
+    try {
+        Json::Value tables = loadLayers(job, target, dialect, database, generator, parallelism);
+        if (restoreLocalInfile) {
+            restoreLocalInfile = false;
+            setLocalInfile(target, false);
+        }
+        return tables;
+    } catch (...) {
+        if (restoreLocalInfile) {
+            try {
+                setLocalInfile(target, false);
+            } catch (const std::exception&) {
+                // Исходная ошибка загрузки важнее
+            }
+        }
+        throw;
+    }
+}
+
+bool DataSeeder::localInfileEnabled(const SshCredentials& target) {
+    RemoteExecutor executor(target);
+    executor.connect();
+    std::string value;
+    int code = executor.run("sudo mysql -N -B -e " + DeployScript::shellQuote("SELECT @@GLOBAL.local_infile"),
+                            [&value](bool isStderr, std::string_view data) {
+                                if (!isStderr) {
+                                    value += data;
+                                }
+                            });
+    if (code != 0) {
+        throw std::runtime_error("Failed to read local_infile, exit code " + std::to_string(code));
+    }
+    return value.compare(0, 1, "1") == 0;
+}
+
+void DataSeeder::setLocalInfile(const SshCredentials& target, bool enabled) {
+    RemoteExecutor executor(target);
+    executor.connect();
+    std::string statement = std::string("SET GLOBAL local_infile = ") + (enabled ? "1" : "0");
+    int code = executor.run("sudo mysql -e " + DeployScript::shellQuote(statement), [](bool, std::string_view) {});
+    if (code != 0) {
+        throw std::runtime_error(std::string("Failed to ") + (enabled ? "enable" : "restore") +
+                                 " local_infile, exit code " + std::to_string(code));
+    }
+}
+
+Json::Value DataSeeder::loadLayers(DeploymentJob& job, const SshCredentials& target, sql::Dialect dialect,
+                                   const std::string& database, const sql::DataGenerator& generator,
+                                   size_t parallelism) {
+    Json::Value tables(Json::arrayValue);
+    size_t step = 0;
+    for (const auto& layer : generator.layers()) {
+        std::vector<Json::Value> results(layer.size());
+        std::atomic<size_t> next{0};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+
+        // Таблицы слоя друг на друга не ссылаются: каждую грузит свой поток по своему каналу
+        auto worker = [&]() {
+            for (size_t i = next++; i < layer.size(); i = next++) {
+                {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (error) {
+                        return;
+                    }
+                }
+                try {
+                    results[i] = loadTable(job, target, dialect, database, generator, layer[i], step + i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(errorMutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < std::min(parallelism, layer.size()); ++t) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        for (auto& result : results) {
+            tables.append(std::move(result));
+        }
+        step += layer.size();
+    }
+
+    // Счетчики serial есть только в PostgreSQL: SQL идет через stdin psql
+    std::string finish = generator.finishStatements();
+    if (!finish.empty()) {
+        RemoteExecutor executor(target);
+        executor.connect();
+        int code = executor.run("sudo -u postgres psql -v ON_ERROR_STOP=1 -q -d " + DeployScript::shellQuote(database),
+                                [](bool, std::string_view) {}, finish);
+        if (code != 0) {
+            throw std::runtime_error("Failed to reset sequences, exit code " + std::to_string(code));
+        }
+    }
+    return tables;
+}
+
+Json::Value DataSeeder::loadTable(DeploymentJob& job, const SshCredentials& target, sql::Dialect dialect,
+                                  const std::string& database, const sql::DataGenerator& generator,
+                                  Json::ArrayIndex table, size_t step) {
+    std::string key = DeploymentJobs::targetKey(target);
+    const std::string& name = generator.tableName(table);
+    auto start = std::chrono::steady_clock::now();
+
+    Json::Value event;
+    event["type"] = "step";
+    event["target"] = key;
+    event["step"] = static_cast<Json::UInt64>(step + 1);
+    event["total"] = static_cast<Json::UInt64>(generator.tableCount());
+    event["name"] = "seed_" + name;
+    job.emit(std::move(event));
+
+    uint64_t bytes = 0;
+    int code = 0;
+    if (generator.rowCount(table) > 0) {
+        RemoteExecutor executor(target);
+        executor.connect();
+        sql::DataGenerator::TableStream stream = generator.stream(table);
+        std::string chunk;
+        code = executor.run(
+            clientCommand(dialect, database, generator.loadStatement(table)),
+            [&job, &key, step](bool isStderr, std::string_view data) {
+                Json::Value output;
+                output["type"] = "output";
+                output["target"] = key;
+                output["step"] = static_cast<Json::UInt64>(step + 1);
+                output["stream"] = isStderr ? "stderr" : "stdout";
+                output["data"] = std::string(data);
+                job.emit(std::move(output));
+            },
+            [&stream, &chunk, &bytes]() {
+                if (!stream.next(chunk, CHUNK_BYTES)) {
+                    return std::string_view();
+                }
+                bytes += chunk.size();
+                return std::string_view(chunk);
+            });
+    }
+
+    Json::Value result;
+    result["table"] = name;
+    result["rows"] = static_cast<Json::UInt64>(generator.rowCount(table));
+    result["bytes"] = static_cast<Json::UInt64>(bytes);
+    result["code"] = code;
+    result["duration_ms"] = millisSince(start);
+
+    Json::Value exit;
+    exit["type"] = "exit";
+    exit["target"] = key;
+    exit["step"] = static_cast<Json::UInt64>(step + 1);
+    exit["name"] = "seed_" + name;
+    exit["code"] = code;
+    exit["duration_ms"] = result["duration_ms"];
+    job.emit(std::move(exit));
+
+    if (code != 0) {
+        throw std::runtime_error("Loading table " + name + " failed with exit code " + std::to_string(code));
+    }
+    return result;
+}
+
+} // namespace services
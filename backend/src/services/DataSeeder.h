@@ -0,0 +1,38 @@
+#pragma once
+#include <json/json.h>
+#include <string>
+#include "DeploymentJobs.h"
+#include "SshSessionPool.h"
+#include "../sql/DataGenerator.h"
+
+namespace services {
+
+// Загрузка синтетических данных DataGenerator в развернутую базу по SSH.
+// Слои DataGenerator::layers() идут по порядку, таблицы слоя - параллельно,
+// каждая по своей сессии из SshSessionPool: COPY FROM STDIN в PostgreSQL,
+// LOAD DATA LOCAL INFILE '/dev/stdin' в MySQL. CSV генерируется порциями по
+// мере отправки, таблица целиком в памяти не собирается.
+class DataSeeder {
+public:
+    // Возвращает по каждой таблице строки, байты и время; бросает на первой
+    // неудачной загрузке. parallelism ограничивается max_per_host пула сессий
+    static Json::Value run(DeploymentJob& job, const SshCredentials& target, sql::Dialect dialect,
+                           const std::string& database, const sql::DataGenerator& generator,
+                           size_t parallelism);
+
+    // Команда клиента СУБД на сервере, выполняющая statement в базе database
+    static std::string clientCommand(sql::Dialect dialect, const std::string& database,
+                                     const std::string& statement);
+
+private:
+    static Json::Value loadLayers(DeploymentJob& job, const SshCredentials& target, sql::Dialect dialect,
+                                  const std::string& database, const sql::DataGenerator& generator,
+                                  size_t parallelism);
+    static bool localInfileEnabled(const SshCredentials& target);
+    static void setLocalInfile(const SshCredentials& target, bool enabled);
+    static Json::Value loadTable(DeploymentJob& job, const SshCredentials& target, sql::Dialect dialect,
+                                 const std::string& database, const sql::DataGenerator& generator,
+                                 Json::ArrayIndex table, size_t step);
+};
+
+} // namespace services
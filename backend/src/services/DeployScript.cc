@@ -0,0 +1,169 @@
+#include "DeployScript.h"
+#include <charconv>
+
+namespace services {
+
+namespace {
+
+constexpr char MARKER = '\x1e';
+
+// Миллисекунды: EPOCHREALTIME есть в bash 5, иначе GNU date
+const char* SCRIPT_PROLOGUE =
+    "__deploy_now() {\n"
+    "  if [ -n \"$EPOCHREALTIME\" ]; then local t=${EPOCHREALTIME/[.,]/}; echo $((t / 1000));\n"
+    "  else date +%s%3N; fi\n"
+    "}\n";
+
+// Разделитель heredoc не должен встречаться в данных шага
+std::string heredocDelimiter(size_t step, const std::string& input) {
+    std::string delimiter = "__DEPLOY_INPUT_" + std::to_string(step) + "__";
+    while (input.find(delimiter) != std::string::npos) {
+        delimiter.insert(0, "_");
+    }
+    return delimiter;
+}
+
+} // namespace
+
+DeployScript::DeployScript(const std::vector<DeployStep>& steps) {
+    size_t size = 0;
+    for (const auto& step : steps) {
+        size += step.command.size() + step.input.size() + 256;
+    }
+    script.reserve(size + 256);
+    script += SCRIPT_PROLOGUE;
+
+    stepResults.reserve(steps.size());
+    for (size_t i = 0; i < steps.size(); ++i) {
+        const DeployStep& step = steps[i];
+        StepResult result;
+        result.name = step.name;
+        stepResults.push_back(std::move(result));
+
+        std::string index = std::to_string(i);
+        script += "printf '\\036step-begin " + index + "\\n'\n";
+        script += "__deploy_start=$(__deploy_now)\n";
+        // Подоболочка - чтобы exit в команде завершал шаг, а не скрипт.
+        // У каждого шага свой stdin: иначе команда дочитала бы сам скрипт
+        script += "( " + step.command + "\n) ";
+        if (step.input.empty()) {
+            script += "</dev/null\n";
+        } else {
+            std::string delimiter = heredocDelimiter(i, step.input);
+            script += "<<'" + delimiter + "'\n";
+            script += step.input;
+            if (step.input.back() != '\n') {
+                script += '\n';
+            }
+            script += delimiter + "\n";
+        }
+        script += "__deploy_rc=$?\n";
+        script += "printf '\\036step-end " + index +
+                  " %d %d\\n' \"$__deploy_rc\" \"$(( $(__deploy_now) - __deploy_start ))\"\n";
+        script += "[ \"$__deploy_rc\" -eq 0 ] || exit \"$__deploy_rc\"\n";
+    }
+}
+
+std::string DeployScript::shellQuote(const std::string& value) {
+    std::string quoted = "'";
+    for (char c : value) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+
+void DeployScript::consume(bool isStderr, std::string_view data) {
+    if (isStderr) {
+        emitOutput(true, data);
+        return;
+    }
+
+    pending.append(data.data(), data.size());
+    size_t pos = 0;
+    while (pos < pending.size()) {
+        size_t marker = pending.find(MARKER, pos);
+        if (marker == std::string::npos) {
+            emitOutput(false, std::string_view(pending).substr(pos));
+            pos = pending.size();
+            break;
+        }
+        if (marker > pos) {
+            emitOutput(false, std::string_view(pending).substr(pos, marker - pos));
+        }
+        size_t end = pending.find('\n', marker);
+        if (end == std::string::npos) {
+            // Служебная строка пришла не целиком - ждем остаток
+            pos = marker;
+            break;
+        }
+        handleMarker(std::string_view(pending).substr(marker + 1, end - marker - 1));
+        pos = end + 1;
+    }
+    pending.erase(0, pos);
+}
+
+void DeployScript::finish() {
+    if (!pending.empty()) {
+        emitOutput(false, pending);
+        pending.clear();
+    }
+}
+
+size_t DeployScript::firstFailed() const {
+    for (size_t i = 0; i < stepResults.size(); ++i) {
+        if (!stepResults[i].finished || stepResults[i].exitCode != 0) {
+            return i;
+        }
+    }
+    return stepResults.size();
+}
+
+void DeployScript::handleMarker(std::string_view marker) {
+    // step-begin <i> | step-end <i> <code> <ms>
+    std::vector<long long> numbers;
+    size_t space = marker.find(' ');
+    std::string_view kind = marker.substr(0, space);
+    while (space != std::string_view::npos) {
+        size_t start = space + 1;
+        space = marker.find(' ', start);
+        std::string_view token = marker.substr(start, space == std::string_view::npos ? space : space - start);
+        long long value = 0;
+        auto [ptr, ec] = std::from_chars(token.data(), token.data() + token.size(), value);
+        if (ec != std::errc()) {
+            return;
+        }
+        numbers.push_back(value);
+    }
+    if (numbers.empty() || numbers[0] < 0 || static_cast<size_t>(numbers[0]) >= stepResults.size()) {
+        return;
+    }
+
+    size_t step = static_cast<size_t>(numbers[0]);
+    StepResult& result = stepResults[step];
+    if (kind == "step-begin") {
+        currentStep = step;
+        result.started = true;
+        if (handlers.stepStarted) {
+            handlers.stepStarted(step);
+        }
+    } else if (kind == "step-end" && numbers.size() == 3) {
+        result.finished = true;
+        result.exitCode = static_cast<int>(numbers[1]);
+        result.durationMs = static_cast<double>(numbers[2]);
+        if (handlers.stepFinished) {
+            handlers.stepFinished(step, result);
+        }
+    }
+}
+
+void DeployScript::emitOutput(bool isStderr, std::string_view data) {
+    if (!data.empty() && handlers.output) {
+        handlers.output(currentStep, isStderr, data);
+    }
+}
+
+} // namespace services
@@ -0,0 +1,74 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace services {
+
+// Шаг деплоя: имя (попадает в журнал вместо текста команды), команда и
+// необязательные данные для ее stdin (SQL не нужно экранировать в кавычках).
+struct DeployStep {
+    std::string name;
+    std::string command;
+    std::string input;
+};
+
+struct StepResult {
+    std::string name;
+    bool started = false;
+    bool finished = false;
+    int exitCode = -1;
+    double durationMs = 0;
+};
+
+// Все шаги одного сервера собираются в один bash-скрипт, который уходит
+// через stdin одного канала. Скрипт печатает в stdout служебные
+// строки с префиксом \x1e о начале и конце шага (код возврата, время) и
+// останавливается на первом ненулевом коде. consume разбирает вывод канала
+// и отделяет служебные строки от вывода самих команд.
+class DeployScript {
+public:
+    struct Handlers {
+        std::function<void(size_t step)> stepStarted;
+        std::function<void(size_t step, bool isStderr, std::string_view data)> output;
+        std::function<void(size_t step, const StepResult& result)> stepFinished;
+    };
+
+    explicit DeployScript(const std::vector<DeployStep>& steps);
+
+    // Команда на сервере: сначала дочитывает скрипт из stdin во временный файл,
+    // потом выполняет его. Так запись скрипта не упирается в вывод шагов.
+    static const char* interpreter() {
+        return "__deploy_script=$(mktemp) || exit 1; cat > \"$__deploy_script\" && "
+               "bash \"$__deploy_script\" </dev/null; __deploy_rc=$?; "
+               "rm -f \"$__deploy_script\"; exit $__deploy_rc";
+    }
+
+    // Аргумент командной строки в одинарных кавычках
+    static std::string shellQuote(const std::string& value);
+
+    const std::string& text() const { return script; }
+
+    void setHandlers(Handlers handlers) { this->handlers = std::move(handlers); }
+
+    void consume(bool isStderr, std::string_view data);
+    // Остаток stdout без перевода строки
+    void finish();
+
+    const std::vector<StepResult>& results() const { return stepResults; }
+    // Номер первого шага с ненулевым кодом или незавершенного; size() - все успешны
+    size_t firstFailed() const;
+
+private:
+    void handleMarker(std::string_view marker);
+    void emitOutput(bool isStderr, std::string_view data);
+
+    std::string script;
+    std::vector<StepResult> stepResults;
+    Handlers handlers;
+    std::string pending;
+    size_t currentStep = 0;
+};
+
+} // namespace services
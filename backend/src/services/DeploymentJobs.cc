@@ -0,0 +1,532 @@
+#include "DeploymentJobs.h"
+#include <drogon/drogon.h>
+#include <drogon/utils/Utilities.h>
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+namespace services {
+
+namespace {
+
+const char* statusName(DeploymentJob::Status status) {
+    switch (status) {
+        case DeploymentJob::Status::Queued: return "queued";
+        case DeploymentJob::Status::Running: return "running";
+        case DeploymentJob::Status::Succeeded: return "succeeded";
+        case DeploymentJob::Status::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+// Пауза перед повтором растет вдвое с каждой попыткой, но не дольше этого
+constexpr std::chrono::milliseconds MAX_RETRY_DELAY{60000};
+constexpr int MAX_CONFIG_RETRIES = 5;
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+DeploymentJob::DeploymentJob(std::string id, int userId, int configId, const std::vector<std::string>& targets)
+    : id(std::move(id)),
+      userId(userId),
+      configId(configId),
+      createdAt(std::chrono::steady_clock::now()),
+      targetOrder(targets) {
+    for (const auto& target : targets) {
+        this->targets.emplace(target, TargetState());
+    }
+}
+
+bool DeploymentJob::isFinished() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return status == Status::Succeeded || status == Status::Failed;
+}
+
+std::chrono::steady_clock::time_point DeploymentJob::finishedAt() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return finishedTime;
+}
+
+void DeploymentJob::start() {
+    setStatus(Status::Running, Json::Value(Json::objectValue));
+}
+
+void DeploymentJob::succeed(const Json::Value& details) {
+    Json::Value event;
+    event["result"] = details;
+    setStatus(Status::Succeeded, std::move(event));
+}
+
+void DeploymentJob::fail(const std::string& message) {
+    Json::Value event;
+    event["message"] = message;
+    setStatus(Status::Failed, std::move(event));
+}
+
+void DeploymentJob::setStatus(Status next, Json::Value event) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (status == Status::Succeeded || status == Status::Failed || status == next) {
+        return;
+    }
+    status = next;
+    event["type"] = "status";
+    event["status"] = statusName(next);
+    if (next == Status::Succeeded || next == Status::Failed) {
+        finishedTime = std::chrono::steady_clock::now();
+        result = event;
+    }
+    append(std::move(event));
+    deliver(lock);
+}
+
+void DeploymentJob::targetStarted(const std::string& target, int attempt) {
+    std::unique_lock<std::mutex> lock(mutex);
+    TargetState& state = targets[target];
+    state.status = "running";
+    state.attempts = attempt;
+    Json::Value event;
+    event["type"] = "target";
+    event["target"] = target;
+    event["status"] = state.status;
+    event["attempt"] = attempt;
+    append(std::move(event));
+    deliver(lock);
+}
+
+void DeploymentJob::targetSucceeded(const std::string& target, const Json::Value& details) {
+    std::unique_lock<std::mutex> lock(mutex);
+    TargetState& state = targets[target];
+    state.status = "succeeded";
+    state.message.clear();
+    state.result = details;
+    Json::Value event;
+    event["type"] = "target";
+    event["target"] = target;
+    event["status"] = state.status;
+    event["result"] = details;
+    append(std::move(event));
+    deliver(lock);
+}
+
+void DeploymentJob::targetFailed(const std::string& target, const std::string& message, bool willRetry) {
+    std::unique_lock<std::mutex> lock(mutex);
+    TargetState& state = targets[target];
+    state.status = willRetry ? "retrying" : "failed";
+    state.message = message;
+    Json::Value event;
+    event["type"] = "target";
+    event["target"] = target;
+    event["status"] = state.status;
+    event["message"] = message;
+    append(std::move(event));
+    deliver(lock);
+}
+
+void DeploymentJob::emit(Json::Value event) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (event["type"].asString() == "output") {
+        // Вывод apt-get может быть большим: журнал в памяти ограничен
+        size_t size = event["data"].asString().size();
+        if (outputBytes + size > DeploymentJobs::maxOutputBytes()) {
+            if (!outputTruncated) {
+                outputTruncated = true;
+                Json::Value notice;
+                notice["type"] = "truncated";
+                notice["step"] = event["step"];
+                append(std::move(notice));
+                deliver(lock);
+            }
+            return;
+        }
+        outputBytes += size;
+    }
+    append(std::move(event));
+    deliver(lock);
+}
+
+void DeploymentJob::append(Json::Value event) {
+    // Число событий тоже ограничено: шагов и повторов на сотнях серверов много.
+    // Смена статуса задачи сохраняется всегда, иначе подписчики не узнают о завершении
+    if (events.size() >= DeploymentJobs::maxEvents() && event["type"].asString() != "status") {
+        if (eventsTruncated) {
+            return;
+        }
+        eventsTruncated = true;
+        event = Json::Value();
+        event["type"] = "truncated";
+    }
+    event["seq"] = static_cast<Json::UInt64>(events.size());
+    event["elapsed_ms"] = millisSince(createdAt);
+    events.push_back(std::move(event));
+}
+
+void DeploymentJob::deliver(std::unique_lock<std::mutex>& lock) {
+    // Раздает события один поток за раз, остальные только дописывают журнал: так
+    // каждый подписчик получает события по порядку, а вызывается без мьютекса задачи
+    // и не задерживает других писателей журнала
+    if (delivering) {
+        return;
+    }
+    delivering = true;
+    for (;;) {
+        std::vector<std::pair<Listener, std::vector<Json::Value>>> batches;
+        for (auto& [subscription, subscriber] : listeners) {
+            if (subscriber.next < events.size()) {
+                batches.emplace_back(subscriber.listener,
+                                     std::vector<Json::Value>(events.begin() + subscriber.next, events.end()));
+                subscriber.next = events.size();
+            }
+        }
+        if (batches.empty()) {
+            break;
+        }
+        lock.unlock();
+        for (const auto& [listener, batch] : batches) {
+            for (const auto& event : batch) {
+                try {
+                    listener(event);
+                } catch (const std::exception& e) {
+                    LOG_ERROR << "Deployment job listener failed: " << e.what();
+                }
+            }
+        }
+        lock.lock();
+    }
+    // Журнал завершенной задачи отдан целиком, подписчики больше ничего не получат
+    if (status == Status::Succeeded || status == Status::Failed) {
+        listeners.clear();
+    }
+    delivering = false;
+}
+
+uint64_t DeploymentJob::subscribe(Listener listener) {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (status == Status::Succeeded || status == Status::Failed) {
+        std::vector<Json::Value> history = events;
+        lock.unlock();
+        for (const auto& event : history) {
+            listener(event);
+        }
+        return 0;
+    }
+    uint64_t subscription = nextSubscription++;
+    listeners.emplace(subscription, Subscriber{std::move(listener)});
+    // Накопленный журнал приходит через deliver, в общем порядке с новыми событиями
+    deliver(lock);
+    return subscription;
+}
+
+void DeploymentJob::unsubscribe(uint64_t subscriptionId) {
+    std::lock_guard<std::mutex> lock(mutex);
+    listeners.erase(subscriptionId);
+}
+
+Json::Value DeploymentJob::toJson(uint64_t since) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Json::Value json;
+    json["id"] = id;
+    json["config_id"] = configId;
+    json["status"] = statusName(status);
+    if (result.isMember("result")) {
+        json["result"] = result["result"];
+    }
+    if (result.isMember("message")) {
+        json["message"] = result["message"];
+    }
+    json["targets"] = Json::Value(Json::arrayValue);
+    for (const auto& target : targetOrder) {
+        const TargetState& state = targets.at(target);
+        Json::Value item;
+        item["target"] = target;
+        item["status"] = state.status;
+        item["attempts"] = state.attempts;
+        if (!state.message.empty()) {
+            item["message"] = state.message;
+        }
+        if (!state.result.isNull()) {
+            item["result"] = state.result;
+        }
+        json["targets"].append(std::move(item));
+    }
+    json["output_truncated"] = outputTruncated;
+    json["events_truncated"] = eventsTruncated;
+    json["events"] = Json::Value(Json::arrayValue);
+    for (size_t i = std::min<uint64_t>(since, events.size()); i < events.size(); ++i) {
+        json["events"].append(events[i]);
+    }
+    json["next_seq"] = static_cast<Json::UInt64>(events.size());
+    return json;
+}
+
+struct DeploymentJobs::FanOut {
+    TargetWork work;
+    int retries = 0;
+    std::chrono::steady_clock::time_point enqueued;
+    std::atomic<size_t> remaining{0};
+    std::atomic<size_t> failed{0};
+    size_t total = 0;
+};
+
+std::unique_ptr<utils::BoundedThreadPool> DeploymentJobs::pool;
+std::mutex DeploymentJobs::registryMutex;
+std::unordered_map<std::string, std::shared_ptr<DeploymentJob>> DeploymentJobs::jobs;
+std::chrono::seconds DeploymentJobs::retention{3600};
+size_t DeploymentJobs::outputLimit = 1024 * 1024;
+size_t DeploymentJobs::eventLimit = 10000;
+int DeploymentJobs::defaultRetries = 2;
+std::chrono::milliseconds DeploymentJobs::retryDelay{1000};
+utils::LatencyStats DeploymentJobs::queueWait;
+utils::LatencyStats DeploymentJobs::targetTime;
+
+void DeploymentJobs::init(const Json::Value& config) {
+    size_t workers = config.get("workers", 4).asUInt();
+    size_t queueSize = config.get("queue_size", 64).asUInt();
+    defaultRetries = std::clamp(config.get("retries", 2).asInt(), 0, MAX_CONFIG_RETRIES);
+    retryDelay = std::clamp(std::chrono::milliseconds(config.get("retry_delay_ms", 1000).asInt64()),
+                            std::chrono::milliseconds(0), MAX_RETRY_DELAY);
+    retention = std::chrono::seconds(config.get("retention_sec", 3600).asInt64());
+    outputLimit = config.get("max_output_bytes", 1024 * 1024).asUInt64();
+    eventLimit = std::max<size_t>(1, config.get("max_events", 10000).asUInt64());
+    RemoteExecutor::setTimeouts(std::chrono::seconds(config.get("command_timeout_sec", 3600).asInt64()),
+                                std::chrono::seconds(config.get("idle_timeout_sec", 600).asInt64()));
+    pool = std::make_unique<utils::BoundedThreadPool>(std::max<size_t>(1, workers), queueSize);
+}
+
+std::string DeploymentJobs::targetKey(const SshCredentials& target) {
+    return target.host + ":" + std::to_string(target.port);
+}
+
+void DeploymentJobs::purgeFinished() {
+    auto threshold = std::chrono::steady_clock::now() - retention;
+    for (auto it = jobs.begin(); it != jobs.end();) {
+        if (it->second->isFinished() && it->second->finishedAt() < threshold) {
+            it = jobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+std::shared_ptr<DeploymentJob> DeploymentJobs::create(int userId, int configId,
+                                                      const std::vector<SshCredentials>& targets) {
+    std::vector<std::string> keys;
+    keys.reserve(targets.size());
+    for (const auto& target : targets) {
+        keys.push_back(targetKey(target));
+    }
+    auto job = std::make_shared<DeploymentJob>(drogon::utils::getUuid(), userId, configId, keys);
+    std::lock_guard<std::mutex> lock(registryMutex);
+    purgeFinished();
+    jobs.emplace(job->getId(), job);
+    return job;
+}
+
+std::shared_ptr<DeploymentJob> DeploymentJobs::find(const std::string& id) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    auto it = jobs.find(id);
+    return it == jobs.end() ? nullptr : it->second;
+}
+
+void DeploymentJobs::submit(const std::shared_ptr<DeploymentJob>& job,
+                            const std::vector<SshCredentials>& targets,
+                            int retries,
+                            TargetWork&& work) {
+    if (!pool) {
+        LOG_ERROR << "DeploymentJobs is not initialized";
+        job->fail("Deployment executor is not available");
+        return;
+    }
+
+    auto fanOut = std::make_shared<FanOut>();
+    fanOut->work = std::move(work);
+    fanOut->retries = retries < 0 ? defaultRetries : retries;
+    fanOut->enqueued = std::chrono::steady_clock::now();
+    fanOut->total = targets.size();
+    fanOut->remaining = targets.size();
+
+    for (const auto& target : targets) {
+        bool accepted = pool->trySubmit([job, fanOut, target]() {
+            runTarget(job, fanOut, target);
+        });
+        if (!accepted) {
+            job->targetFailed(targetKey(target), "Deployment queue is full, try again later", false);
+            finishTarget(job, fanOut, false);
+        }
+    }
+}
+
+void DeploymentJobs::runTarget(const std::shared_ptr<DeploymentJob>& job,
+                               const std::shared_ptr<FanOut>& fanOut,
+                               const SshCredentials& target) {
+    auto start = std::chrono::steady_clock::now();
+    queueWait.record(start - fanOut->enqueued);
+    job->start();
+
+    std::string key = targetKey(target);
+    bool succeeded = false;
+    for (int attempt = 1; attempt <= fanOut->retries + 1 && !succeeded; ++attempt) {
+        job->targetStarted(key, attempt);
+        try {
+            job->targetSucceeded(key, fanOut->work(*job, target));
+            succeeded = true;
+        } catch (const std::exception& e) {
+            // Зависшую команду не повторяем: повтор снова занял бы поток до таймаута
+            bool timedOut = dynamic_cast<const RemoteExecutor::Timeout*>(&e) != nullptr;
+            bool willRetry = attempt <= fanOut->retries && !timedOut;
+            job->targetFailed(key, e.what(), willRetry);
+            if (!willRetry) {
+                break;
+            }
+            // Поток пула занят на время паузы: глобальный предел учитывает и повторы
+            auto delay = retryDelay * (int64_t{1} << std::min(attempt - 1, 16));
+            std::this_thread::sleep_for(std::min<std::chrono::milliseconds>(delay, MAX_RETRY_DELAY));
+        }
+    }
+    targetTime.record(std::chrono::steady_clock::now() - start);
+    finishTarget(job, fanOut, succeeded);
+}
+
+void DeploymentJobs::finishTarget(const std::shared_ptr<DeploymentJob>& job,
+                                  const std::shared_ptr<FanOut>& fanOut,
+                                  bool succeeded) {
+    if (!succeeded) {
+        ++fanOut->failed;
+    }
+    if (--fanOut->remaining != 0) {
+        return;
+    }
+
+    size_t failed = fanOut->failed.load();
+    if (failed == 0) {
+        Json::Value summary;
+        summary["targets"] = static_cast<Json::UInt64>(fanOut->total);
+        summary["succeeded"] = static_cast<Json::UInt64>(fanOut->total);
+        summary["failed"] = 0;
+        job->succeed(summary);
+    } else {
+        job->fail("Deployment failed on " + std::to_string(failed) + " of " +
+                  std::to_string(fanOut->total) + " targets");
+    }
+}
+
+Json::Value DeploymentJobs::runSteps(DeploymentJob& job, const SshCredentials& target,
+                                     const std::vector<DeployStep>& steps) {
+    std::string key = targetKey(target);
+    DeployScript script(steps);
+
+    // Текст команд не публикуем: в них бывают пароли, в журнал идут только имена шагов
+    script.setHandlers({
+        [&job, &key, &steps](size_t step) {
+            Json::Value event;
+            event["type"] = "step";
+            event["target"] = key;
+            event["step"] = static_cast<Json::UInt64>(step + 1);
+            event["total"] = static_cast<Json::UInt64>(steps.size());
+            event["name"] = steps[step].name;
+            job.emit(std::move(event));
+        },
+        [&job, &key](size_t step, bool isStderr, std::string_view data) {
+            Json::Value event;
+            event["type"] = "output";
+            event["target"] = key;
+            event["step"] = static_cast<Json::UInt64>(step + 1);
+            event["stream"] = isStderr ? "stderr" : "stdout";
+            event["data"] = std::string(data);
+            job.emit(std::move(event));
+        },
+        [&job, &key](size_t step, const StepResult& result) {
+            Json::Value event;
+            event["type"] = "exit";
+            event["target"] = key;
+            event["step"] = static_cast<Json::UInt64>(step + 1);
+            event["name"] = result.name;
+            event["code"] = result.exitCode;
+            event["duration_ms"] = result.durationMs;
+            job.emit(std::move(event));
+        }});
+
+    // Одно подключение и один канал на все шаги: скрипт уходит через stdin
+    RemoteExecutor executor(target);
+    executor.connect();
+    int exitCode = executor.run(
+        DeployScript::interpreter(),
+        [&script](bool isStderr, std::string_view data) {
+            script.consume(isStderr, data);
+        },
+        script.text());
+    script.finish();
+
+    Json::Value results(Json::arrayValue);
+    for (const auto& result : script.results()) {
+        if (!result.started) {
+            continue;
+        }
+        Json::Value item;
+        item["name"] = result.name;
+        item["code"] = result.finished ? result.exitCode : exitCode;
+        item["duration_ms"] = result.durationMs;
+        results.append(std::move(item));
+    }
+
+    size_t failed = script.firstFailed();
+    if (failed < steps.size() || exitCode != 0) {
+        if (failed < steps.size()) {
+            const StepResult& result = script.results()[failed];
+            throw std::runtime_error("Step " + std::to_string(failed + 1) + " (" + result.name +
+                                     ") failed with exit code " +
+                                     std::to_string(result.finished ? result.exitCode : exitCode));
+        }
+        throw std::runtime_error("Deploy script failed with exit code " + std::to_string(exitCode));
+    }
+    return results;
+}
+
+std::string DeploymentJobs::runProbe(DeploymentJob& job, const SshCredentials& target,
+                                     const std::string& command) {
+    auto start = std::chrono::steady_clock::now();
+    RemoteExecutor executor(target);
+    executor.connect();
+    std::string output;
+    executor.run(command, [&output](bool isStderr, std::string_view data) {
+        if (!isStderr) {
+            output.append(data.data(), data.size());
+        }
+    });
+
+    Json::Value event;
+    event["type"] = "probe";
+    event["target"] = targetKey(target);
+    event["duration_ms"] = millisSince(start);
+    job.emit(std::move(event));
+    return output;
+}
+
+Json::Value DeploymentJobs::metrics() {
+    Json::Value json;
+    if (pool) {
+        json["workers"] = static_cast<Json::UInt64>(pool->threadCount());
+        json["queue_capacity"] = static_cast<Json::UInt64>(pool->queueCapacity());
+        json["queue_depth"] = static_cast<Json::UInt64>(pool->queueDepth());
+        json["rejected"] = static_cast<Json::UInt64>(pool->rejected());
+    }
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        Json::UInt64 active = 0;
+        for (const auto& [id, job] : jobs) {
+            if (!job->isFinished()) {
+                ++active;
+            }
+        }
+        json["jobs"] = static_cast<Json::UInt64>(jobs.size());
+        json["active_jobs"] = active;
+    }
+    json["queue_wait"] = queueWait.toJson();
+    json["target_time"] = targetTime.toJson();
+    return json;
+}
+
+} // namespace services
@@ -0,0 +1,162 @@
+#pragma once
+#include <json/json.h>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "DeployScript.h"
+#include "RemoteExecutor.h"
+#include "../utils/BoundedThreadPool.h"
+#include "../utils/LatencyStats.h"
+
+namespace services {
+
+// Фоновый деплой одной конфигурации на один или несколько серверов:
+// общий статус, результат по каждому серверу и журнал событий (шаги, вывод,
+// коды возврата, повторы). Подписчики получают сначала накопленный журнал,
+// затем новые события по порядку; вызываются они вне мьютекса задачи.
+class DeploymentJob {
+public:
+    enum class Status { Queued, Running, Succeeded, Failed };
+    using Listener = std::function<void(const Json::Value& event)>;
+
+    DeploymentJob(std::string id, int userId, int configId, const std::vector<std::string>& targets);
+
+    const std::string& getId() const { return id; }
+    int getUserId() const { return userId; }
+    bool isFinished() const;
+
+    void start();
+    void succeed(const Json::Value& details);
+    void fail(const std::string& message);
+
+    // Состояние отдельного сервера; target - "host:port"
+    void targetStarted(const std::string& target, int attempt);
+    void targetSucceeded(const std::string& target, const Json::Value& details);
+    void targetFailed(const std::string& target, const std::string& message, bool willRetry);
+
+    // События step/output/exit; seq и время проставляются здесь
+    void emit(Json::Value event);
+
+    // 0 - задача уже завершена, весь журнал отдан сразу. Подписчик может быть
+    // вызван и после unsubscribe - с событиями, разосланными до него
+    uint64_t subscribe(Listener listener);
+    void unsubscribe(uint64_t subscriptionId);
+
+    // Состояние и события начиная с номера since (для опроса без WebSocket)
+    Json::Value toJson(uint64_t since = 0) const;
+
+    std::chrono::steady_clock::time_point finishedAt() const;
+
+private:
+    struct TargetState {
+        std::string status = "queued";
+        int attempts = 0;
+        std::string message;
+        Json::Value result;
+    };
+
+    struct Subscriber {
+        Listener listener;
+        // Номер первого события, которое подписчик еще не получил
+        size_t next = 0;
+    };
+
+    void setStatus(Status next, Json::Value event);
+    // Дописывает событие в журнал; вызывается под mutex
+    void append(Json::Value event);
+    // Рассылает подписчикам новые события, отпуская lock на время вызовов
+    void deliver(std::unique_lock<std::mutex>& lock);
+
+    std::string id;
+    int userId;
+    int configId;
+    std::chrono::steady_clock::time_point createdAt;
+    std::chrono::steady_clock::time_point finishedTime;
+
+    mutable std::mutex mutex;
+    Status status = Status::Queued;
+    Json::Value result;
+    // Порядок серверов как в запросе
+    std::vector<std::string> targetOrder;
+    std::unordered_map<std::string, TargetState> targets;
+    std::vector<Json::Value> events;
+    size_t outputBytes = 0;
+    bool outputTruncated = false;
+    bool eventsTruncated = false;
+    bool delivering = false;
+    uint64_t nextSubscription = 1;
+    std::map<uint64_t, Subscriber> listeners;
+};
+
+// Реестр задач и планировщик SSH-деплоев. Конвейер каждого сервера - отдельная
+// задача общего пула, поэтому число workers - глобальный предел одновременных
+// деплоев по всем запросам. Завершенные задачи хранятся retention_sec секунд.
+class DeploymentJobs {
+public:
+    // Выполняет деплой на один сервер и возвращает его результат; исключение - неудача
+    using TargetWork = std::function<Json::Value(DeploymentJob& job, const SshCredentials& target)>;
+
+    // Секция custom_config.deploy: workers, queue_size, retries (не больше 5),
+    // retry_delay_ms (пауза перед повтором не длиннее минуты),
+    // retention_sec, max_output_bytes, max_events, command_timeout_sec и idle_timeout_sec
+    // (таймауты команд RemoteExecutor; сервер с зависшей командой не повторяется)
+    static void init(const Json::Value& config);
+
+    static std::string targetKey(const SshCredentials& target);
+
+    static std::shared_ptr<DeploymentJob> create(int userId, int configId,
+                                                 const std::vector<SshCredentials>& targets);
+    static std::shared_ptr<DeploymentJob> find(const std::string& id);
+
+    // Ставит конвейеры всех серверов в пул. Неудачная попытка повторяется до retries раз
+    // с экспоненциальной задержкой; задача завершается, когда отработали все серверы.
+    // retries < 0 - значение из конфига
+    static void submit(const std::shared_ptr<DeploymentJob>& job,
+                       const std::vector<SshCredentials>& targets,
+                       int retries,
+                       TargetWork&& work);
+
+    // Выполняет шаги одним скриптом по одному SSH-каналу с трансляцией вывода.
+    // Возвращает имя, код возврата и время каждого шага; бросает на первом ненулевом коде
+    static Json::Value runSteps(DeploymentJob& job, const SshCredentials& target,
+                                const std::vector<DeployStep>& steps);
+
+    // Одна команда проверки состояния сервера; возвращает ее stdout
+    static std::string runProbe(DeploymentJob& job, const SshCredentials& target,
+                                const std::string& command);
+
+    static size_t maxOutputBytes() { return outputLimit; }
+    static size_t maxEvents() { return eventLimit; }
+
+    static Json::Value metrics();
+
+private:
+    struct FanOut;
+
+    static void runTarget(const std::shared_ptr<DeploymentJob>& job,
+                          const std::shared_ptr<FanOut>& fanOut,
+                          const SshCredentials& target);
+    static void finishTarget(const std::shared_ptr<DeploymentJob>& job,
+                             const std::shared_ptr<FanOut>& fanOut,
+                             bool succeeded);
+    static void purgeFinished();
+
+    static std::unique_ptr<utils::BoundedThreadPool> pool;
+    static std::mutex registryMutex;
+    static std::unordered_map<std::string, std::shared_ptr<DeploymentJob>> jobs;
+    static std::chrono::seconds retention;
+    static size_t outputLimit;
+    static size_t eventLimit;
+    static int defaultRetries;
+    static std::chrono::milliseconds retryDelay;
+    static utils::LatencyStats queueWait;
+    static utils::LatencyStats targetTime;
+};
+
+} // namespace services
@@ -0,0 +1,295 @@
+#include "DirectDeployer.h"
+#include "SshTunnel.h"
+#include <drogon/orm/DbClient.h>
+#include <drogon/orm/Exception.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace services {
+
+namespace {
+
+// Начало оператора в журнале задачи: полный DDL большой таблицы журнал не красит
+constexpr size_t STATEMENT_LOG_CHARS = 200;
+// Первый запрос ждет подключения; неверный пароль не должен ждать таймаута оператора
+constexpr double CONNECT_TIMEOUT_SEC = 15;
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Значение строки подключения в кавычках, ' и обратная косая черта экранируются
+std::string connectionValue(const std::string& value) {
+    std::string quoted = "'";
+    for (char c : value) {
+        if (c == '\'' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "'";
+}
+
+drogon::orm::DbClientPtr connect(const DirectDeployer::Connection& connection, int localPort) {
+    std::string info = "host=127.0.0.1 port=" + std::to_string(localPort) +
+                       " dbname=" + connectionValue(connection.database) +
+                       " user=" + connectionValue(connection.user) +
+                       " password=" + connectionValue(connection.password);
+    drogon::orm::DbClientPtr client = connection.dialect == sql::Dialect::PostgreSQL
+        ? drogon::orm::DbClient::newPgClient(info, connection.connections)
+        : drogon::orm::DbClient::newMysqlClient(info, connection.connections);
+    client->setTimeout(CONNECT_TIMEOUT_SEC);
+    client->execSqlSync("SELECT 1");
+    client->setTimeout(connection.statementTimeoutSec);
+    return client;
+}
+
+// Выполнение одного элемента плана с событиями step/statement/exit в журнале задачи
+class PlanRunner {
+public:
+    PlanRunner(DeploymentJob& job, std::string key, drogon::orm::DbClient& client, sql::Dialect dialect,
+               size_t total)
+        : job(job), key(std::move(key)), client(client), dialect(dialect), total(total) {}
+
+    // created - после выполнения в базе есть таблица элемента (в MySQL - даже если
+    // упал индекс после CREATE TABLE), ее надо удалять при откате плана
+    Json::Value execute(size_t step, const std::string& name, const std::vector<std::string>& statements,
+                        bool& created) {
+        auto start = std::chrono::steady_clock::now();
+        Json::Value event;
+        event["type"] = "step";
+        event["target"] = key;
+        event["step"] = static_cast<Json::UInt64>(step + 1);
+        event["total"] = static_cast<Json::UInt64>(total);
+        event["name"] = name;
+        job.emit(std::move(event));
+
+        Json::Value timings(Json::arrayValue);
+        auto runAll = [&](drogon::orm::DbClient& executor) {
+            for (const auto& statement : statements) {
+                auto statementStart = std::chrono::steady_clock::now();
+                executor.execSqlSync(statement);
+                Json::Value timing;
+                timing["sql"] = statement.substr(0, STATEMENT_LOG_CHARS);
+                timing["duration_ms"] = millisSince(statementStart);
+
+                Json::Value log = timing;
+                log["type"] = "statement";
+                log["target"] = key;
+                log["step"] = static_cast<Json::UInt64>(step + 1);
+                job.emit(std::move(log));
+                timings.append(std::move(timing));
+                if (dialect == sql::Dialect::MySQL) {
+                    created = true;
+                }
+            }
+        };
+
+        try {
+            if (dialect == sql::Dialect::PostgreSQL) {
+                // Коммит асинхронный: его итог ждем до следующего слоя, который ссылается на эту таблицу
+                auto committed = std::make_shared<std::promise<bool>>();
+                std::future<bool> result = committed->get_future();
+                {
+                    auto transaction = client.newTransaction([committed](bool success) {
+                        try {
+                            committed->set_value(success);
+                        } catch (const std::future_error&) {
+                        }
+                    });
+                    try {
+                        runAll(*transaction);
+                    } catch (...) {
+                        transaction->rollback();
+                        throw;
+                    }
+                }
+                if (!result.get()) {
+                    throw std::runtime_error("Commit failed");
+                }
+                created = true;
+            } else {
+                runAll(client);
+            }
+        } catch (const std::exception& e) {
+            finish(step, name, start, 1, e.what());
+            throw std::runtime_error(name + ": " + e.what());
+        }
+        finish(step, name, start, 0, "");
+
+        Json::Value result;
+        result["name"] = name;
+        result["statements"] = std::move(timings);
+        result["duration_ms"] = millisSince(start);
+        return result;
+    }
+
+    // Откат плана: DROP созданных таблиц в обратном порядке. Ошибки отката
+    // только в журнал - наружу идет исходная ошибка
+    void dropTables(size_t step, const std::vector<std::string>& tables) {
+        auto start = std::chrono::steady_clock::now();
+        Json::Value event;
+        event["type"] = "step";
+        event["target"] = key;
+        event["step"] = static_cast<Json::UInt64>(step + 1);
+        event["total"] = static_cast<Json::UInt64>(total);
+        event["name"] = "rollback_tables";
+        job.emit(std::move(event));
+        try {
+            if (dialect == sql::Dialect::PostgreSQL) {
+                for (auto it = tables.rbegin(); it != tables.rend(); ++it) {
+                    client.execSqlSync("DROP TABLE IF EXISTS " + *it + " CASCADE");
+                }
+            } else {
+                // Отложенные FK циклов мешают порядку удаления: проверки выключаются в одном соединении
+                auto pinned = client.newTransaction();
+                pinned->execSqlSync("SET FOREIGN_KEY_CHECKS = 0");
+                for (auto it = tables.rbegin(); it != tables.rend(); ++it) {
+                    pinned->execSqlSync("DROP TABLE IF EXISTS " + *it);
+                }
+                pinned->execSqlSync("SET FOREIGN_KEY_CHECKS = 1");
+            }
+            finish(step, "rollback_tables", start, 0, "");
+        } catch (const std::exception& e) {
+            finish(step, "rollback_tables", start, 1, e.what());
+        }
+    }
+
+private:
+    void finish(size_t step, const std::string& name, std::chrono::steady_clock::time_point start, int code,
+                const std::string& error) {
+        Json::Value exit;
+        exit["type"] = "exit";
+        exit["target"] = key;
+        exit["step"] = static_cast<Json::UInt64>(step + 1);
+        exit["name"] = name;
+        exit["code"] = code;
+        exit["duration_ms"] = millisSince(start);
+        if (!error.empty()) {
+            exit["error"] = error;
+        }
+        job.emit(std::move(exit));
+    }
+
+    DeploymentJob& job;
+    std::string key;
+    drogon::orm::DbClient& client;
+    sql::Dialect dialect;
+    size_t total;
+};
+
+} // namespace
+
+Json::Value DirectDeployer::createTables(DeploymentJob& job, const SshCredentials& target,
+                                         const Connection& connection, const sql::DdlPlan& plan) {
+    auto start = std::chrono::steady_clock::now();
+    size_t total = plan.deferred.empty() ? 0 : 1;
+    for (const auto& layer : plan.layers) {
+        total += layer.size();
+    }
+
+    // Клиент разрушается раньше туннеля: соединения закрываются, пока канал жив
+    SshTunnel tunnel(target, "127.0.0.1", connection.port);
+    drogon::orm::DbClientPtr client = connect(connection, tunnel.localPort());
+    PlanRunner runner(job, DeploymentJobs::targetKey(target), *client, connection.dialect, total);
+
+    std::vector<std::string> created;
+    std::mutex createdMutex;
+    Json::Value layers(Json::arrayValue);
+    size_t step = 0;
+    try {
+        for (const auto& layer : plan.layers) {
+            std::vector<Json::Value> results(layer.size());
+            std::atomic<size_t> next{0};
+            std::mutex errorMutex;
+            std::exception_ptr error;
+
+            // Таблицы слоя друг на друга не ссылаются: каждую создает свой поток в своем соединении
+            auto worker = [&]() {
+                for (size_t i = next++; i < layer.size(); i = next++) {
+                    {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if (error) {
+                            return;
+                        }
+                    }
+                    bool tableCreated = false;
+                    try {
+                        results[i] = runner.execute(step + i, "create_" + layer[i].table, layer[i].statements,
+                                                    tableCreated);
+                        results[i]["table"] = layer[i].table;
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(errorMutex);
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                    if (tableCreated) {
+                        std::lock_guard<std::mutex> lock(createdMutex);
+                        created.push_back(layer[i].table);
+                    }
+                }
+            };
+            std::vector<std::thread> threads;
+            for (size_t t = 1; t < std::min(connection.connections, layer.size()); ++t) {
+                threads.emplace_back(worker);
+            }
+            worker();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+
+            Json::Value layerResult(Json::arrayValue);
+            for (auto& result : results) {
+                layerResult.append(std::move(result));
+            }
+            layers.append(std::move(layerResult));
+            step += layer.size();
+        }
+
+        Json::Value result;
+        if (!plan.deferred.empty()) {
+            bool unused = false;
+            result["deferred"] = runner.execute(step++, "create_foreign_keys", plan.deferred, unused);
+        }
+        result["transport"] = "direct";
+        result["connections"] = static_cast<Json::UInt64>(connection.connections);
+        result["layers"] = std::move(layers);
+        result["duration_ms"] = millisSince(start);
+        return result;
+    } catch (...) {
+        if (!created.empty()) {
+            runner.dropTables(total, created);
+        }
+        throw;
+    }
+}
+
+Json::Value DirectDeployer::runStatements(DeploymentJob& job, const SshCredentials& target,
+                                          const Connection& connection, const std::string& name,
+                                          const std::vector<std::string>& statements) {
+    auto start = std::chrono::steady_clock::now();
+    SshTunnel tunnel(target, "127.0.0.1", connection.port);
+    Connection single = connection;
+    single.connections = 1;
+    drogon::orm::DbClientPtr client = connect(single, tunnel.localPort());
+    PlanRunner runner(job, DeploymentJobs::targetKey(target), *client, connection.dialect, 1);
+
+    bool unused = false;
+    Json::Value result = runner.execute(0, name, statements, unused);
+    result["transport"] = "direct";
+    result["duration_ms"] = millisSince(start);
+    return result;
+}
+
+} // namespace services
@@ -0,0 +1,41 @@
+#pragma once
+#include <json/json.h>
+#include <string>
+#include <vector>
+#include "DeploymentJobs.h"
+#include "SshSessionPool.h"
+#include "../sql/DdlCompiler.h"
+
+namespace services {
+
+// Выполнение DDL напрямую через соединения с СУБД вместо psql/mysql в
+// скрипте: соединения идут через SshTunnel на localhost сервера, время
+// каждого оператора попадает в журнал задачи (событие statement).
+class DirectDeployer {
+public:
+    struct Connection {
+        sql::Dialect dialect = sql::Dialect::PostgreSQL;
+        std::string database;
+        std::string user;
+        std::string password;
+        // Порт СУБД на сервере
+        int port = 5432;
+        // Одновременных соединений, они же потоки создания таблиц слоя
+        size_t connections = 4;
+        double statementTimeoutSec = 600;
+    };
+
+    // Слои DdlPlan по порядку, таблицы слоя - параллельно по connections
+    // соединениям; в PostgreSQL каждая таблица с индексами и разделами - своя
+    // транзакция. deferred - после всех слоев. План выполняется целиком или
+    // никак: при ошибке созданные им таблицы удаляются и ошибка бросается дальше
+    static Json::Value createTables(DeploymentJob& job, const SshCredentials& target,
+                                    const Connection& connection, const sql::DdlPlan& plan);
+
+    // Операторы по порядку в одном соединении; в PostgreSQL - одной транзакцией
+    static Json::Value runStatements(DeploymentJob& job, const SshCredentials& target,
+                                     const Connection& connection, const std::string& name,
+                                     const std::vector<std::string>& statements);
+};
+
+} // namespace services
@@ -0,0 +1,89 @@
+#include "PasswordHasher.h"
+#include <drogon/drogon.h>
+#include <bcrypt/BCrypt.hpp>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace services {
+
+std::unique_ptr<utils::BoundedThreadPool> PasswordHasher::pool;
+int PasswordHasher::cost = 12;
+utils::LatencyStats PasswordHasher::queueWait;
+utils::LatencyStats PasswordHasher::hashTime;
+
+void PasswordHasher::init(const Json::Value& config) {
+    unsigned int defaultWorkers = std::max(1u, std::thread::hardware_concurrency() / 2);
+    size_t workers = config.get("workers", defaultWorkers).asUInt();
+    size_t queueSize = config.get("queue_size", 256).asUInt();
+    int configured = config.get("cost", 12).asInt();
+    cost = std::clamp(configured, MIN_COST, MAX_COST);
+    if (cost != configured) {
+        LOG_WARN << "bcrypt cost " << configured << " is out of range " << MIN_COST << ".." << MAX_COST
+                 << ", using " << cost;
+    }
+    pool = std::make_unique<utils::BoundedThreadPool>(std::max<size_t>(1, workers), queueSize);
+}
+
+bool PasswordHasher::submit(std::function<void()>&& work) {
+    if (!pool) {
+        LOG_ERROR << "PasswordHasher is not initialized";
+        return false;
+    }
+    auto enqueued = std::chrono::steady_clock::now();
+    return pool->trySubmit([work = std::move(work), enqueued]() {
+        queueWait.record(std::chrono::steady_clock::now() - enqueued);
+        work();
+    });
+}
+
+bool PasswordHasher::hashAsync(const std::string& password,
+                               std::function<void(std::string)>&& callback) {
+    // Возвращаемся в тот же IO-поток, чтобы дальше работать с его fast-клиентом БД
+    trantor::EventLoop* loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    return submit([password, callback = std::move(callback), loop]() {
+        auto start = std::chrono::steady_clock::now();
+        std::string hash = BCrypt::generateHash(password, cost);
+        hashTime.record(std::chrono::steady_clock::now() - start);
+        if (loop != nullptr) {
+            loop->queueInLoop([callback = std::move(callback), hash = std::move(hash)]() {
+                callback(hash);
+            });
+        } else {
+            callback(std::move(hash));
+        }
+    });
+}
+
+bool PasswordHasher::validateAsync(const std::string& password, const std::string& hash,
+                                   std::function<void(bool)>&& callback) {
+    trantor::EventLoop* loop = trantor::EventLoop::getEventLoopOfCurrentThread();
+    return submit([password, hash, callback = std::move(callback), loop]() {
+        auto start = std::chrono::steady_clock::now();
+        bool valid = BCrypt::validatePassword(password, hash);
+        hashTime.record(std::chrono::steady_clock::now() - start);
+        if (loop != nullptr) {
+            loop->queueInLoop([callback = std::move(callback), valid]() {
+                callback(valid);
+            });
+        } else {
+            callback(valid);
+        }
+    });
+}
+
+Json::Value PasswordHasher::metrics() {
+    Json::Value json;
+    if (pool) {
+        json["workers"] = static_cast<Json::UInt64>(pool->threadCount());
+        json["queue_capacity"] = static_cast<Json::UInt64>(pool->queueCapacity());
+        json["queue_depth"] = static_cast<Json::UInt64>(pool->queueDepth());
+        json["rejected"] = static_cast<Json::UInt64>(pool->rejected());
+    }
+    json["cost"] = cost;
+    json["queue_wait"] = queueWait.toJson();
+    json["hash_time"] = hashTime.toJson();
+    return json;
+}
+
+} // namespace services
@@ -0,0 +1,40 @@
+#pragma once
+#include <json/json.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include "../utils/BoundedThreadPool.h"
+#include "../utils/LatencyStats.h"
+
+namespace services {
+
+// Выносит bcrypt с IO-потоков Drogon в отдельный пул фиксированного размера.
+// Результат возвращается в event loop, из которого был сделан вызов.
+class PasswordHasher {
+public:
+    // Секция custom_config.bcrypt: workers, queue_size, cost.
+    // cost приводится к [MIN_COST, MAX_COST]: bcrypt допускает 4..31, но ниже 10
+    // хэш слишком дешев для перебора, а выше 14 вход занимает секунды
+    static constexpr int MIN_COST = 10;
+    static constexpr int MAX_COST = 14;
+    static void init(const Json::Value& config);
+
+    // false - очередь переполнена, запрос нужно отклонить (503)
+    static bool hashAsync(const std::string& password,
+                          std::function<void(std::string)>&& callback);
+    static bool validateAsync(const std::string& password, const std::string& hash,
+                              std::function<void(bool)>&& callback);
+
+    // Глубина очереди, отказы, время ожидания в очереди и время хэширования
+    static Json::Value metrics();
+
+private:
+    static bool submit(std::function<void()>&& work);
+
+    static std::unique_ptr<utils::BoundedThreadPool> pool;
+    static int cost;
+    static utils::LatencyStats queueWait;
+    static utils::LatencyStats hashTime;
+};
+
+} // namespace services
@@ -0,0 +1,209 @@
+#include "PerformanceTuner.h"
+#include <algorithm>
+#include "RemoteState.h"
+
+namespace services {
+
+namespace {
+
+constexpr uint64_t MB_PER_GB = 1024;
+
+std::string megabytes(uint64_t mb) {
+    if (mb >= MB_PER_GB && mb % MB_PER_GB == 0) {
+        return std::to_string(mb / MB_PER_GB) + "GB";
+    }
+    return std::to_string(mb) + "MB";
+}
+
+uint64_t parseUnsigned(const std::string& value) {
+    try {
+        return value.empty() ? 0 : std::stoull(value);
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+} // namespace
+
+std::optional<WorkloadProfile> parseWorkloadProfile(const std::string& name) {
+    if (name == "oltp") {
+        return WorkloadProfile::Oltp;
+    }
+    if (name == "analytics") {
+        return WorkloadProfile::Analytics;
+    }
+    if (name == "cache") {
+        return WorkloadProfile::Cache;
+    }
+    return std::nullopt;
+}
+
+const char* workloadProfileName(WorkloadProfile profile) {
+    switch (profile) {
+        case WorkloadProfile::Oltp: return "oltp";
+        case WorkloadProfile::Analytics: return "analytics";
+        case WorkloadProfile::Cache: return "cache";
+    }
+    return "unknown";
+}
+
+HardwareInfo HardwareInfo::fromState(const RemoteState& state) {
+    HardwareInfo hardware;
+    hardware.cpus = static_cast<int>(parseUnsigned(state.hardware("cpus")));
+    hardware.memoryBytes = parseUnsigned(state.hardware("mem_kb")) * 1024;
+    const std::string& rotational = state.hardware("rotational");
+    if (rotational == "0") {
+        hardware.storage = Storage::Ssd;
+    } else if (rotational == "1") {
+        hardware.storage = Storage::Hdd;
+    }
+    return hardware;
+}
+
+Json::Value HardwareInfo::toJson() const {
+    Json::Value json;
+    json["cpus"] = cpus;
+    json["memory_mb"] = static_cast<Json::UInt64>(memoryBytes / (1024 * 1024));
+    json["storage"] = storage == Storage::Ssd ? "ssd" : storage == Storage::Hdd ? "hdd" : "unknown";
+    return json;
+}
+
+PerformanceTuner::PerformanceTuner(const HardwareInfo& hardware, WorkloadProfile profile)
+    : hardware(hardware), profile(profile) {}
+
+PerformanceTuner::Settings PerformanceTuner::postgres() const {
+    uint64_t memory = memoryMb();
+    int cpus = std::max(1, hardware.cpus);
+    bool analytics = profile == WorkloadProfile::Analytics;
+
+    uint64_t maxConnections = analytics ? 40 : profile == WorkloadProfile::Cache ? 300 : 200;
+    uint64_t sharedBuffers = memory / 4;
+    uint64_t effectiveCache = memory * 3 / 4;
+    uint64_t maintenanceWorkMem = std::min<uint64_t>(analytics ? memory / 8 : memory / 16, 2 * MB_PER_GB);
+    int workersPerGather = analytics ? std::max(1, cpus / 2) : profile == WorkloadProfile::Oltp ? std::min(2, cpus / 2) : 0;
+    int maintenanceWorkers = std::min(4, std::max(1, cpus / 2));
+
+    // work_mem выделяется на каждую сортировку/хэш каждого процесса
+    uint64_t workMemKb = (memory - sharedBuffers) * 1024 / (maxConnections * (analytics ? 2 : 3)) /
+                         std::max(1, workersPerGather);
+    workMemKb = std::max<uint64_t>(workMemKb, 4 * 1024);
+
+    uint64_t minWal = analytics ? 4 * MB_PER_GB : profile == WorkloadProfile::Cache ? 512 : MB_PER_GB;
+    uint64_t maxWal = analytics ? 16 * MB_PER_GB : profile == WorkloadProfile::Cache ? 2 * MB_PER_GB : 4 * MB_PER_GB;
+
+    return {
+        {"max_connections", std::to_string(maxConnections)},
+        {"shared_buffers", megabytes(sharedBuffers)},
+        {"effective_cache_size", megabytes(effectiveCache)},
+        {"maintenance_work_mem", megabytes(maintenanceWorkMem)},
+        {"work_mem", std::to_string(workMemKb) + "kB"},
+        {"checkpoint_completion_target", "0.9"},
+        {"min_wal_size", megabytes(minWal)},
+        {"max_wal_size", megabytes(maxWal)},
+        {"wal_buffers", "16MB"},
+        {"random_page_cost", isSsd() ? "1.1" : "4"},
+        {"effective_io_concurrency", isSsd() ? "200" : "2"},
+        {"max_worker_processes", std::to_string(cpus)},
+        {"max_parallel_workers", std::to_string(cpus)},
+        {"max_parallel_workers_per_gather", std::to_string(workersPerGather)},
+        {"max_parallel_maintenance_workers", std::to_string(maintenanceWorkers)},
+    };
+}
+
+PerformanceTuner::Settings PerformanceTuner::mysql() const {
+    uint64_t memory = memoryMb();
+    int cpus = std::max(1, hardware.cpus);
+
+    // На маленьких машинах оставляем место ОС и соединениям
+    uint64_t percent = memory < 2 * MB_PER_GB ? 50
+                     : profile == WorkloadProfile::Analytics ? 75
+                     : profile == WorkloadProfile::Cache ? 60 : 70;
+    uint64_t bufferPool = std::max<uint64_t>(memory * percent / 100, 128);
+    uint64_t instances = std::clamp<uint64_t>(bufferPool / MB_PER_GB, 1, 8);
+
+    // Redo-лог около четверти буферного пула, в пределах профиля
+    uint64_t logFile = profile == WorkloadProfile::Analytics ? std::clamp<uint64_t>(bufferPool / 4, 512, 4 * MB_PER_GB)
+                     : profile == WorkloadProfile::Cache ? std::clamp<uint64_t>(bufferPool / 8, 64, 512)
+                     : std::clamp<uint64_t>(bufferPool / 4, 128, 2 * MB_PER_GB);
+    int ioThreads = profile == WorkloadProfile::Analytics ? std::clamp(cpus, 4, 16) : 4;
+
+    return {
+        {"innodb_buffer_pool_size", std::to_string(bufferPool) + "M"},
+        {"innodb_buffer_pool_instances", std::to_string(instances)},
+        {"innodb_log_file_size", std::to_string(logFile) + "M"},
+        {"innodb_flush_log_at_trx_commit", profile == WorkloadProfile::Oltp ? "1" : "2"},
+        {"innodb_io_capacity", isSsd() ? "2000" : "200"},
+        {"innodb_flush_neighbors", isSsd() ? "0" : "1"},
+        {"innodb_read_io_threads", std::to_string(ioThreads)},
+        {"innodb_write_io_threads", std::to_string(ioThreads)},
+        {"max_connections", profile == WorkloadProfile::Analytics ? "100"
+                            : profile == WorkloadProfile::Cache ? "1000" : "500"},
+    };
+}
+
+PerformanceTuner::Settings PerformanceTuner::redis(uint64_t maxMemoryMb) const {
+    int cpus = std::max(1, hardware.cpus);
+    // Потоки ввода-вывода окупаются от 4 ядер; одно ядро остается основному потоку
+    int ioThreads = cpus < 4 ? 1 : std::min(8, cpus / 2);
+
+    Settings settings;
+    if (maxMemoryMb == 0) {
+        maxMemoryMb = memoryMb() * (profile == WorkloadProfile::Cache ? 75 : 50) / 100;
+        settings.emplace_back("maxmemory", std::to_string(maxMemoryMb) + "mb");
+    }
+    settings.emplace_back("maxmemory-policy", profile == WorkloadProfile::Cache ? "allkeys-lru" : "noeviction");
+    settings.emplace_back("io-threads", std::to_string(ioThreads));
+    settings.emplace_back("io-threads-do-reads", ioThreads > 1 ? "yes" : "no");
+
+    // Кэш без персистентности, OLTP - AOF раз в секунду, аналитика - только снимки RDB
+    switch (profile) {
+        case WorkloadProfile::Cache:
+            settings.emplace_back("save", "\"\"");
+            settings.emplace_back("appendonly", "no");
+            break;
+        case WorkloadProfile::Oltp:
+            settings.emplace_back("save", "3600 1 300 100 60 10000");
+            settings.emplace_back("appendonly", "yes");
+            settings.emplace_back("appendfsync", "everysec");
+            break;
+        case WorkloadProfile::Analytics:
+            settings.emplace_back("save", "900 1 300 10 60 10000");
+            settings.emplace_back("appendonly", "no");
+            break;
+    }
+    return settings;
+}
+
+std::string PerformanceTuner::renderPostgres(const Settings& settings) {
+    std::string text = "# Generated by webdatabase deploy\n";
+    for (const auto& [name, value] : settings) {
+        text += name + " = '" + value + "'\n";
+    }
+    return text;
+}
+
+std::string PerformanceTuner::renderMysql(const Settings& settings) {
+    std::string text = "# Generated by webdatabase deploy\n[mysqld]\n";
+    for (const auto& [name, value] : settings) {
+        text += name + " = " + value + "\n";
+    }
+    return text;
+}
+
+std::string PerformanceTuner::renderRedis(const Settings& settings) {
+    std::string text = "# Generated by webdatabase deploy\n";
+    for (const auto& [name, value] : settings) {
+        text += name + " " + value + "\n";
+    }
+    return text;
+}
+
+Json::Value PerformanceTuner::toJson(const Settings& settings) {
+    Json::Value json(Json::objectValue);
+    for (const auto& [name, value] : settings) {
+        json[name] = value;
+    }
+    return json;
+}
+
+} // namespace services
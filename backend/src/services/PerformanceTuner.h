@@ -0,0 +1,60 @@
+#pragma once
+#include <json/json.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace services {
+
+class RemoteState;
+
+enum class WorkloadProfile { Oltp, Analytics, Cache };
+
+// oltp, analytics, cache; nullopt - неизвестный профиль
+std::optional<WorkloadProfile> parseWorkloadProfile(const std::string& name);
+const char* workloadProfileName(WorkloadProfile profile);
+
+// Железо сервера из пробы деплоя
+struct HardwareInfo {
+    enum class Storage { Unknown, Ssd, Hdd };
+
+    int cpus = 0;
+    uint64_t memoryBytes = 0;
+    Storage storage = Storage::Unknown;
+
+    static HardwareInfo fromState(const RemoteState& state);
+    bool isKnown() const { return cpus > 0 && memoryBytes > 0; }
+    Json::Value toJson() const;
+};
+
+// Настройки СУБД под железо и профиль нагрузки. Формулы - в духе PGTune и
+// рекомендаций MySQL/Redis; неизвестный тип диска считается SSD.
+class PerformanceTuner {
+public:
+    using Settings = std::vector<std::pair<std::string, std::string>>;
+
+    PerformanceTuner(const HardwareInfo& hardware, WorkloadProfile profile);
+
+    Settings postgres() const;
+    Settings mysql() const;
+    // maxMemoryMb == 0 - maxmemory рассчитывается от RAM по профилю
+    Settings redis(uint64_t maxMemoryMb) const;
+
+    // Файлы конфигурации: conf.d PostgreSQL, секция [mysqld], директивы redis.conf
+    static std::string renderPostgres(const Settings& settings);
+    static std::string renderMysql(const Settings& settings);
+    static std::string renderRedis(const Settings& settings);
+
+    static Json::Value toJson(const Settings& settings);
+
+private:
+    bool isSsd() const { return hardware.storage != HardwareInfo::Storage::Hdd; }
+    uint64_t memoryMb() const { return hardware.memoryBytes / (1024 * 1024); }
+
+    HardwareInfo hardware;
+    WorkloadProfile profile;
+};
+
+} // namespace services
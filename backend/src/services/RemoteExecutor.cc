@@ -0,0 +1,168 @@
+#include "RemoteExecutor.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace services {
+
+namespace {
+
+// Сколько ждать stdout перед тем, как заглянуть в stderr
+constexpr int READ_TIMEOUT_MS = 50;
+constexpr size_t READ_BUFFER_SIZE = 16 * 1024;
+constexpr size_t WRITE_CHUNK_SIZE = 64 * 1024;
+
+struct ChannelDeleter {
+    void operator()(ssh_channel channel) const {
+        if (ssh_channel_is_open(channel)) {
+            ssh_channel_close(channel);
+        }
+        ssh_channel_free(channel);
+    }
+};
+
+} // namespace
+
+std::chrono::seconds RemoteExecutor::commandTimeout{0};
+std::chrono::seconds RemoteExecutor::idleTimeout{0};
+
+void RemoteExecutor::setTimeouts(std::chrono::seconds command, std::chrono::seconds idle) {
+    commandTimeout = command;
+    idleTimeout = idle;
+}
+
+RemoteExecutor::RemoteExecutor(SshCredentials credentials)
+    : credentials(std::move(credentials)) {}
+
+void RemoteExecutor::connect() {
+    lease = SshSessionPool::acquire(credentials);
+}
+
+ssh_channel RemoteExecutor::openChannel() {
+    ssh_channel channel = ssh_channel_new(lease.get());
+    if (channel != nullptr && ssh_channel_open_session(channel) == SSH_OK) {
+        return channel;
+    }
+    if (channel != nullptr) {
+        ssh_channel_free(channel);
+    }
+    // Сессия из пула могла умереть после проверки: один раз подключаемся заново
+    lease.invalidate();
+    if (!lease.isReused()) {
+        throw std::runtime_error("Failed to open SSH channel");
+    }
+    // Старую сессию отдаем до ожидания новой, иначе упремся в лимит на сервер
+    lease = SshSessionPool::Lease();
+    lease = SshSessionPool::acquire(credentials);
+    return openChannel();
+}
+
+int RemoteExecutor::run(const std::string& command, const OutputHandler& onOutput,
+                        std::string_view input) {
+    return run(command, onOutput, [&input]() {
+        std::string_view chunk = input;
+        input = std::string_view();
+        return chunk;
+    });
+}
+
+bool RemoteExecutor::drain(ssh_channel channel, int timeoutMs, const OutputHandler& onOutput) {
+    char buffer[READ_BUFFER_SIZE];
+    int out = timeoutMs > 0 ? ssh_channel_read_timeout(channel, buffer, sizeof(buffer), 0, timeoutMs)
+                            : ssh_channel_read_nonblocking(channel, buffer, sizeof(buffer), 0);
+    if (out > 0) {
+        onOutput(false, std::string_view(buffer, out));
+    }
+    int err = ssh_channel_read_nonblocking(channel, buffer, sizeof(buffer), 1);
+    if (err > 0) {
+        onOutput(true, std::string_view(buffer, err));
+    }
+    if (out == SSH_ERROR || err == SSH_ERROR) {
+        lease.invalidate();
+        throw std::runtime_error("Failed to read command output");
+    }
+    if (out > 0 || err > 0) {
+        lastActivity = std::chrono::steady_clock::now();
+        return true;
+    }
+    return false;
+}
+
+void RemoteExecutor::checkTimeout() {
+    auto now = std::chrono::steady_clock::now();
+    bool expired = commandTimeout.count() > 0 && now - started > commandTimeout;
+    bool idle = idleTimeout.count() > 0 && now - lastActivity > idleTimeout;
+    if (!expired && !idle) {
+        return;
+    }
+    // Команда могла остаться на сервере: сессия закрывается вместе с ней
+    lease.invalidate();
+    throw Timeout(expired ? "Remote command timed out after " + std::to_string(commandTimeout.count()) + " s"
+                          : "Remote command produced no output for " + std::to_string(idleTimeout.count()) +
+                                " s");
+}
+
+bool RemoteExecutor::write(ssh_channel channel, std::string_view data, const OutputHandler& onOutput) {
+    while (!data.empty()) {
+        // Пока команда не читает stdin, окно закрыто и блокирующая запись
+        // ждала бы без таймаута: ждем окно здесь, забирая вывод
+        uint32_t window = ssh_channel_window_size(channel);
+        if (window == 0) {
+            if (ssh_channel_is_eof(channel) || ssh_channel_is_closed(channel)) {
+                // Команда завершилась, не дочитав ввод: код возврата скажет остальное
+                return false;
+            }
+            drain(channel, READ_TIMEOUT_MS, onOutput);
+            checkTimeout();
+            continue;
+        }
+
+        size_t size = std::min({data.size(), WRITE_CHUNK_SIZE, static_cast<size_t>(window)});
+        int written = ssh_channel_write(channel, data.data(), static_cast<uint32_t>(size));
+        if (written == SSH_ERROR) {
+            lease.invalidate();
+            throw std::runtime_error("Failed to write command input");
+        }
+        data.remove_prefix(written);
+        lastActivity = std::chrono::steady_clock::now();
+
+        // Вывод забираем и во время записи: иначе команда с длинным вводом
+        // может встать на переполненном окне stdout/stderr
+        drain(channel, 0, onOutput);
+        checkTimeout();
+    }
+    return true;
+}
+
+int RemoteExecutor::run(const std::string& command, const OutputHandler& onOutput,
+                        const InputSource& source) {
+    std::unique_ptr<ssh_channel_struct, ChannelDeleter> channel(openChannel());
+    started = std::chrono::steady_clock::now();
+    lastActivity = started;
+
+    if (ssh_channel_request_exec(channel.get(), command.c_str()) != SSH_OK) {
+        lease.invalidate();
+        throw std::runtime_error("Failed to execute command");
+    }
+
+    for (std::string_view chunk = source(); !chunk.empty(); chunk = source()) {
+        if (!write(channel.get(), chunk, onOutput)) {
+            break;
+        }
+    }
+    ssh_channel_send_eof(channel.get());
+
+    // Читаем оба потока, пока сервер не закроет канал или не истечет таймаут
+    while (true) {
+        bool read = drain(channel.get(), READ_TIMEOUT_MS, onOutput);
+        if (!read && ssh_channel_is_eof(channel.get())) {
+            break;
+        }
+        checkTimeout();
+    }
+
+    return ssh_channel_get_exit_status(channel.get());
+}
+
+} // namespace services
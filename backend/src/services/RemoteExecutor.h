@@ -0,0 +1,70 @@
+#pragma once
+#include <libssh/libssh.h>
+#include "SshSessionPool.h"
+#include <chrono>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace services {
+
+// Выполнение команд на сервере через сессию из SshSessionPool: команды
+// выполняются по очереди, вывод отдается по мере поступления, код возврата
+// ждется до конца команды. Все вызовы блокирующие - только для рабочих
+// потоков, не для IO-потоков Drogon. Команда, превысившая общий таймаут или
+// молчащая дольше таймаута простоя, прерывается: канал закрывается, сессия
+// в пул не возвращается.
+class RemoteExecutor {
+public:
+    // Команда прервана по таймауту; повторять ее бессмысленно
+    class Timeout : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    using OutputHandler = std::function<void(bool isStderr, std::string_view data)>;
+    // Следующая порция stdin; пустая - данных больше нет. Порция должна
+    // оставаться действительной до следующего вызова
+    using InputSource = std::function<std::string_view()>;
+
+    explicit RemoteExecutor(SshCredentials credentials);
+
+    RemoteExecutor(const RemoteExecutor&) = delete;
+    RemoteExecutor& operator=(const RemoteExecutor&) = delete;
+
+    // Общий таймаут команды и таймаут без вывода и записи в stdin
+    // (custom_config.deploy: command_timeout_sec, idle_timeout_sec); 0 - без ограничения
+    static void setTimeouts(std::chrono::seconds command, std::chrono::seconds idle);
+
+    // Берет сессию из пула (подключается, если свободной нет); бросает runtime_error
+    void connect();
+
+    // Код возврата команды (-1, если сервер его не сообщил).
+    // input целиком передается в stdin команды, затем stdin закрывается.
+    // При таймауте бросает Timeout
+    int run(const std::string& command, const OutputHandler& onOutput,
+            std::string_view input = {});
+    // stdin берется из source по мере записи: большой ввод (выгрузка данных)
+    // не собирается в памяти целиком
+    int run(const std::string& command, const OutputHandler& onOutput,
+            const InputSource& source);
+
+private:
+    ssh_channel openChannel();
+    // false - команда завершилась, не дочитав ввод
+    bool write(ssh_channel channel, std::string_view data, const OutputHandler& onOutput);
+    // Забирает доступный вывод обоих потоков; true - что-то прочитано
+    bool drain(ssh_channel channel, int timeoutMs, const OutputHandler& onOutput);
+    void checkTimeout();
+
+    static std::chrono::seconds commandTimeout;
+    static std::chrono::seconds idleTimeout;
+
+    SshCredentials credentials;
+    SshSessionPool::Lease lease;
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point lastActivity;
+};
+
+} // namespace services
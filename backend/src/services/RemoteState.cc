@@ -0,0 +1,194 @@
+#include "RemoteState.h"
+#include <algorithm>
+#include <cctype>
+#include "../sql/SchemaValidator.h"
+
+namespace services {
+
+namespace {
+
+const std::string EMPTY;
+
+std::string toLower(std::string_view value) {
+    std::string lower(value);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return lower;
+}
+
+// Версия и статус из dpkg; "ii" - пакет установлен полностью
+std::string packageProbe(const std::string& packages) {
+    return "dpkg-query -W -f='pkg ${Package} ${db:Status-Abbrev} ${Version}\\n' " + packages + " 2>/dev/null; ";
+}
+
+// Ядра, память и тип корневого диска: ROTA=1 - HDD, 0 - SSD
+std::string hardwareProbe() {
+    return "echo \"hw cpus $(nproc 2>/dev/null)\"; "
+           "awk '/^MemTotal:/ {print \"hw mem_kb \" $2}' /proc/meminfo 2>/dev/null; "
+           "echo \"hw rotational $(lsblk -ndo ROTA \"$(findmnt -n -o SOURCE / 2>/dev/null)\" 2>/dev/null "
+           "| head -n1 | tr -d ' ')\"; ";
+}
+
+std::string tuningProbe(const std::string& path) {
+    return "sudo -n cat " + path + " 2>/dev/null | sed 's/^/tuning /'; ";
+}
+
+} // namespace
+
+std::string RemoteState::probeCommand(const std::string& dbType, const std::string& dbName) {
+    // Имя базы подставляется в SQL только если это обычный идентификатор
+    if (dbType == "postgresql") {
+        std::string command = packageProbe("postgresql postgresql-contrib") + hardwareProbe() +
+                              tuningProbe(POSTGRES_TUNING_FILE);
+        command += "if command -v psql >/dev/null 2>&1; then "
+                   "sudo -n -u postgres psql -Atc \"SELECT 'db ' || datname FROM pg_database "
+                   "UNION ALL SELECT 'role ' || rolname FROM pg_roles\" 2>/dev/null; ";
+        if (sql::SchemaValidator::isValidIdentifier(sql::Dialect::PostgreSQL, dbName)) {
+            // Разделы - по имени без префикса "<таблица>_", как их называет DdlCompiler
+            command += "sudo -n -u postgres psql -d " + dbName +
+                       " -Atc \"SELECT 'table ' || tablename FROM pg_tables WHERE schemaname = 'public'\""
+                       " -c \"SELECT 'partition ' || p.relname || ' ' || substr(c.relname, length(p.relname) + 2) "
+                       "FROM pg_inherits i JOIN pg_class p ON p.oid = i.inhparent JOIN pg_class c ON c.oid = i.inhrelid "
+                       "WHERE p.relkind = 'p' AND c.relkind IN ('r', 'p') "
+                       "AND left(c.relname, length(p.relname) + 1) = p.relname || '_'\""
+                       " 2>/dev/null; ";
+        }
+        command += "fi; true";
+        return command;
+    }
+    if (dbType == "mysql") {
+        std::string command = packageProbe("mysql-server") + hardwareProbe() + tuningProbe(MYSQL_TUNING_FILE);
+        command += "if command -v mysql >/dev/null 2>&1; then "
+                   "sudo -n mysql -N -B -e \"SELECT CONCAT('db ', schema_name) FROM information_schema.schemata; "
+                   "SELECT CONCAT('role ', user) FROM mysql.user WHERE host = 'localhost';";
+        if (sql::SchemaValidator::isValidIdentifier(sql::Dialect::MySQL, dbName)) {
+            command += " SELECT CONCAT('table ', table_name) FROM information_schema.tables "
+                       "WHERE table_schema = '" + dbName + "';"
+                       " SELECT CONCAT('partition ', table_name, ' ', partition_name) FROM information_schema.partitions "
+                       "WHERE table_schema = '" + dbName + "' AND partition_name IS NOT NULL;";
+        }
+        command += "\" 2>/dev/null; fi; true";
+        return command;
+    }
+    if (dbType == "redis") {
+        std::string command = packageProbe("redis-server") + hardwareProbe() + tuningProbe(REDIS_TUNING_FILE);
+        command += std::string("sudo -n grep -E '^(requirepass|port|maxmemory) ' ") + REDIS_SETTINGS_FILE +
+                   " 2>/dev/null "
+                   "| sed 's/^/conf /'; "
+                   "systemctl is-active --quiet redis-server 2>/dev/null && echo 'service redis-server'; "
+                   "true";
+        return command;
+    }
+    return "";
+}
+
+RemoteState RemoteState::parse(std::string_view output) {
+    RemoteState state;
+    while (!output.empty()) {
+        size_t end = output.find('\n');
+        std::string_view line = output.substr(0, end);
+        output.remove_prefix(end == std::string_view::npos ? output.size() : end + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        size_t space = line.find(' ');
+        if (space == std::string_view::npos) {
+            continue;
+        }
+        std::string_view kind = line.substr(0, space);
+        std::string_view value = line.substr(space + 1);
+
+        if (kind == "pkg") {
+            // pkg <name> <status> <version>
+            size_t nameEnd = value.find(' ');
+            if (nameEnd == std::string_view::npos) {
+                continue;
+            }
+            std::string_view rest = value.substr(nameEnd + 1);
+            size_t statusEnd = rest.find(' ');
+            std::string_view status = rest.substr(0, statusEnd);
+            if (status.substr(0, 2) == "ii") {
+                std::string_view version =
+                    statusEnd == std::string_view::npos ? std::string_view() : rest.substr(statusEnd + 1);
+                while (!version.empty() && version.front() == ' ') {
+                    version.remove_prefix(1);
+                }
+                while (!version.empty() && version.back() == ' ') {
+                    version.remove_suffix(1);
+                }
+                state.packages.emplace(std::string(value.substr(0, nameEnd)), std::string(version));
+            }
+        } else if (kind == "db") {
+            state.databases.insert(toLower(value));
+        } else if (kind == "role") {
+            state.roles.insert(toLower(value));
+        } else if (kind == "table") {
+            state.tables.insert(toLower(value));
+        } else if (kind == "conf") {
+            size_t nameEnd = value.find(' ');
+            if (nameEnd != std::string_view::npos) {
+                state.settings[std::string(value.substr(0, nameEnd))] = std::string(value.substr(nameEnd + 1));
+            }
+        } else if (kind == "service") {
+            state.activeServices.emplace(value);
+        } else if (kind == "hw") {
+            size_t nameEnd = value.find(' ');
+            if (nameEnd != std::string_view::npos) {
+                state.hardwareInfo[std::string(value.substr(0, nameEnd))] = std::string(value.substr(nameEnd + 1));
+            }
+        } else if (kind == "partition") {
+            size_t nameEnd = value.find(' ');
+            if (nameEnd != std::string_view::npos) {
+                state.partitionsByTable[toLower(value.substr(0, nameEnd))].emplace_back(value.substr(nameEnd + 1));
+            }
+        } else if (kind == "tuning") {
+            state.tuningFile.append(value).append("\n");
+        }
+    }
+    return state;
+}
+
+bool RemoteState::hasPackage(const std::string& name) const {
+    return packages.count(name) > 0;
+}
+
+const std::string& RemoteState::packageVersion(const std::string& name) const {
+    auto it = packages.find(name);
+    return it == packages.end() ? EMPTY : it->second;
+}
+
+bool RemoteState::hasDatabase(const std::string& name) const {
+    return databases.count(toLower(name)) > 0;
+}
+
+bool RemoteState::hasRole(const std::string& name) const {
+    return roles.count(toLower(name)) > 0;
+}
+
+bool RemoteState::hasTable(std::string_view name) const {
+    return tables.count(toLower(name)) > 0;
+}
+
+const std::string& RemoteState::setting(const std::string& name) const {
+    auto it = settings.find(name);
+    return it == settings.end() ? EMPTY : it->second;
+}
+
+bool RemoteState::isServiceActive(const std::string& name) const {
+    return activeServices.count(name) > 0;
+}
+
+const std::vector<std::string>& RemoteState::partitions(std::string_view table) const {
+    static const std::vector<std::string> none;
+    auto it = partitionsByTable.find(toLower(table));
+    return it == partitionsByTable.end() ? none : it->second;
+}
+
+const std::string& RemoteState::hardware(const std::string& name) const {
+    auto it = hardwareInfo.find(name);
+    return it == hardwareInfo.end() ? EMPTY : it->second;
+}
+
+} // namespace services
@@ -0,0 +1,60 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace services {
+
+// Состояние сервера перед деплоем, собранное одной командой: установленные
+// пакеты, базы данных, роли, таблицы целевой базы, настройки Redis, состояние
+// службы и железо сервера. По нему план деплоя выбрасывает уже выполненные шаги.
+class RemoteState {
+public:
+    // Файлы настроек производительности, которые пишет деплой
+    static constexpr const char* POSTGRES_TUNING_FILE = "/etc/postgresql/*/main/conf.d/90-webdatabase-tuning.conf";
+    static constexpr const char* MYSQL_TUNING_FILE = "/etc/mysql/mysql.conf.d/90-webdatabase-tuning.cnf";
+    static constexpr const char* REDIS_TUNING_FILE = "/etc/redis/webdatabase-tuning.conf";
+    // Пароль, порт и maxmemory Redis из конфигурации деплоя
+    static constexpr const char* REDIS_SETTINGS_FILE = "/etc/redis/webdatabase.conf";
+
+    // Команда проверки для postgresql/mysql/redis. Ошибки внутри гасятся:
+    // неустановленная СУБД просто не попадает в вывод. Пустая строка - тип не поддерживается
+    static std::string probeCommand(const std::string& dbType, const std::string& dbName);
+
+    // Разбор вывода probeCommand: строки "<вид> <значение...>"
+    static RemoteState parse(std::string_view output);
+
+    bool hasPackage(const std::string& name) const;
+    const std::string& packageVersion(const std::string& name) const;
+    bool hasDatabase(const std::string& name) const;
+    bool hasRole(const std::string& name) const;
+    // Имена сравниваются без учета регистра: PostgreSQL приводит имена без кавычек к нижнему
+    bool hasTable(std::string_view name) const;
+    // Значение директивы из REDIS_SETTINGS_FILE как оно записано; пустая строка - не задана
+    const std::string& setting(const std::string& name) const;
+    bool isServiceActive(const std::string& name) const;
+    // cpus, mem_kb, rotational (0/1 для корневого диска); пустая строка - не определено
+    const std::string& hardware(const std::string& name) const;
+    // Содержимое файла настроек производительности, записанного прошлым деплоем
+    const std::string& tuning() const { return tuningFile; }
+
+    // Разделы секционированной таблицы (p202405, p0...)
+    const std::vector<std::string>& partitions(std::string_view table) const;
+
+    size_t tableCount() const { return tables.size(); }
+
+private:
+    std::unordered_map<std::string, std::string> packages;
+    std::unordered_set<std::string> databases;
+    std::unordered_set<std::string> roles;
+    std::unordered_set<std::string> tables;
+    std::unordered_map<std::string, std::vector<std::string>> partitionsByTable;
+    std::unordered_map<std::string, std::string> settings;
+    std::unordered_set<std::string> activeServices;
+    std::unordered_map<std::string, std::string> hardwareInfo;
+    std::string tuningFile;
+};
+
+} // namespace services
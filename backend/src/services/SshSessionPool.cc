@@ -0,0 +1,244 @@
+#include "SshSessionPool.h"
+#include <drogon/drogon.h>
+#include <trantor/net/EventLoopThread.h>
+#include <openssl/sha.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace services {
+
+std::mutex SshSessionPool::mutex;
+std::condition_variable SshSessionPool::available;
+std::unordered_map<std::string, SshSessionPool::HostSlot> SshSessionPool::hosts;
+
+size_t SshSessionPool::maxPerHost = 4;
+std::chrono::seconds SshSessionPool::idleTimeout{300};
+std::chrono::seconds SshSessionPool::healthCheckAfter{30};
+std::chrono::seconds SshSessionPool::acquireTimeout{60};
+long SshSessionPool::connectTimeout = 10;
+std::unique_ptr<trantor::EventLoopThread> SshSessionPool::evictionLoop;
+
+std::atomic<uint64_t> SshSessionPool::hits{0};
+std::atomic<uint64_t> SshSessionPool::misses{0};
+std::atomic<uint64_t> SshSessionPool::evicted{0};
+std::atomic<uint64_t> SshSessionPool::healthCheckFailures{0};
+utils::LatencyStats SshSessionPool::handshakeTime;
+utils::LatencyStats SshSessionPool::acquireWait;
+
+SshSessionPool::Lease::Lease(std::string key, ssh_session session, bool reused)
+    : key(std::move(key)), session(session), reused(reused) {}
+
+SshSessionPool::Lease::Lease(Lease&& other) noexcept
+    : key(std::move(other.key)), session(other.session), reused(other.reused), valid(other.valid) {
+    other.session = nullptr;
+}
+
+SshSessionPool::Lease& SshSessionPool::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        key = std::move(other.key);
+        session = other.session;
+        reused = other.reused;
+        valid = other.valid;
+        other.session = nullptr;
+    }
+    return *this;
+}
+
+SshSessionPool::Lease::~Lease() {
+    release();
+}
+
+void SshSessionPool::Lease::release() {
+    if (session != nullptr) {
+        SshSessionPool::release(key, session, valid);
+        session = nullptr;
+    }
+}
+
+void SshSessionPool::init(const Json::Value& config) {
+    maxPerHost = std::max<size_t>(1, config.get("max_per_host", 4).asUInt());
+    idleTimeout = std::chrono::seconds(config.get("idle_timeout_sec", 300).asInt64());
+    healthCheckAfter = std::chrono::seconds(config.get("health_check_after_sec", 30).asInt64());
+    acquireTimeout = std::chrono::seconds(config.get("acquire_timeout_sec", 60).asInt64());
+    connectTimeout = config.get("connect_timeout_sec", 10).asInt();
+
+    // Простаивающие сессии закрываются и без новых запросов к серверу. Таймер живет
+    // в своем потоке: ssh_disconnect до зависшего сервера не держит IO-потоки Drogon
+    double interval = std::max<double>(1.0, idleTimeout.count() / 2.0);
+    evictionLoop = std::make_unique<trantor::EventLoopThread>("SshPoolEviction");
+    evictionLoop->run();
+    evictionLoop->getLoop()->runEvery(interval, []() {
+        evictIdle();
+    });
+}
+
+std::string SshSessionPool::poolKey(const SshCredentials& credentials) {
+    unsigned char digest[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(credentials.password.data()),
+           credentials.password.size(), digest);
+    return credentials.username + "@" + credentials.host + ":" + std::to_string(credentials.port) + "#" +
+           std::string(reinterpret_cast<const char*>(digest), SHA256_DIGEST_LENGTH);
+}
+
+ssh_session SshSessionPool::handshake(const SshCredentials& credentials) {
+    auto start = std::chrono::steady_clock::now();
+    ssh_session session = ssh_new();
+    if (session == nullptr) {
+        throw std::runtime_error("Failed to create SSH session");
+    }
+
+    ssh_options_set(session, SSH_OPTIONS_HOST, credentials.host.c_str());
+    ssh_options_set(session, SSH_OPTIONS_PORT, &credentials.port);
+    ssh_options_set(session, SSH_OPTIONS_USER, credentials.username.c_str());
+    ssh_options_set(session, SSH_OPTIONS_TIMEOUT, &connectTimeout);
+
+    if (ssh_connect(session) != SSH_OK) {
+        ssh_free(session);
+        throw std::runtime_error("Failed to connect to server");
+    }
+
+    if (ssh_userauth_password(session, nullptr, credentials.password.c_str()) != SSH_AUTH_SUCCESS) {
+        close(session);
+        throw std::runtime_error("Failed to authenticate");
+    }
+    handshakeTime.record(std::chrono::steady_clock::now() - start);
+    return session;
+}
+
+bool SshSessionPool::isHealthy(const IdleSession& idle) {
+    if (!ssh_is_connected(idle.session)) {
+        return false;
+    }
+    // Недавно использованную сессию не проверяем лишним обменом
+    if (std::chrono::steady_clock::now() - idle.lastUsed < healthCheckAfter) {
+        return true;
+    }
+    return ssh_send_ignore(idle.session, "") == SSH_OK && ssh_is_connected(idle.session);
+}
+
+void SshSessionPool::close(ssh_session session) {
+    ssh_disconnect(session);
+    ssh_free(session);
+}
+
+SshSessionPool::Lease SshSessionPool::acquire(const SshCredentials& credentials) {
+    std::string key = poolKey(credentials);
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + acquireTimeout;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        HostSlot& slot = hosts[key];
+
+        // Сначала самая свежая простаивающая сессия
+        while (!slot.idle.empty()) {
+            IdleSession idle = slot.idle.back();
+            slot.idle.pop_back();
+            ++slot.leased;
+            lock.unlock();
+            if (isHealthy(idle)) {
+                ++hits;
+                acquireWait.record(std::chrono::steady_clock::now() - start);
+                return Lease(key, idle.session, true);
+            }
+            ++healthCheckFailures;
+            close(idle.session);
+            lock.lock();
+            --slot.leased;
+        }
+
+        if (slot.leased < maxPerHost) {
+            ++slot.leased;
+            lock.unlock();
+            ++misses;
+            try {
+                ssh_session session = handshake(credentials);
+                acquireWait.record(std::chrono::steady_clock::now() - start);
+                return Lease(key, session, false);
+            } catch (...) {
+                lock.lock();
+                --slot.leased;
+                available.notify_all();
+                throw;
+            }
+        }
+
+        if (available.wait_until(lock, deadline) == std::cv_status::timeout) {
+            throw std::runtime_error("Too many concurrent SSH sessions to " + credentials.host);
+        }
+    }
+}
+
+void SshSessionPool::release(const std::string& key, ssh_session session, bool valid) {
+    bool keep = valid && ssh_is_connected(session);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        HostSlot& slot = hosts[key];
+        --slot.leased;
+        if (keep) {
+            slot.idle.push_back({session, std::chrono::steady_clock::now()});
+        }
+    }
+    available.notify_all();
+    if (!keep) {
+        close(session);
+    }
+}
+
+void SshSessionPool::evictIdle() {
+    auto threshold = std::chrono::steady_clock::now() - idleTimeout;
+    std::vector<ssh_session> expired;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = hosts.begin(); it != hosts.end();) {
+            auto& idle = it->second.idle;
+            auto stale = std::partition(idle.begin(), idle.end(), [&threshold](const IdleSession& session) {
+                return session.lastUsed >= threshold;
+            });
+            for (auto session = stale; session != idle.end(); ++session) {
+                expired.push_back(session->session);
+            }
+            idle.erase(stale, idle.end());
+            if (idle.empty() && it->second.leased == 0) {
+                it = hosts.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    // Закрываем вне блокировки: disconnect ходит в сеть
+    evicted += expired.size();
+    for (ssh_session session : expired) {
+        close(session);
+    }
+}
+
+Json::Value SshSessionPool::metrics() {
+    Json::Value json;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Json::UInt64 idle = 0;
+        Json::UInt64 leased = 0;
+        for (const auto& [key, slot] : hosts) {
+            idle += slot.idle.size();
+            leased += slot.leased;
+        }
+        json["hosts"] = static_cast<Json::UInt64>(hosts.size());
+        json["idle"] = idle;
+        json["leased"] = leased;
+    }
+    uint64_t hitCount = hits.load();
+    uint64_t missCount = misses.load();
+    json["max_per_host"] = static_cast<Json::UInt64>(maxPerHost);
+    json["hits"] = static_cast<Json::UInt64>(hitCount);
+    json["misses"] = static_cast<Json::UInt64>(missCount);
+    json["hit_ratio"] = hitCount + missCount == 0 ? 0.0 : static_cast<double>(hitCount) / (hitCount + missCount);
+    json["evicted"] = static_cast<Json::UInt64>(evicted.load());
+    json["health_check_failures"] = static_cast<Json::UInt64>(healthCheckFailures.load());
+    json["handshake"] = handshakeTime.toJson();
+    json["acquire_wait"] = acquireWait.toJson();
+    return json;
+}
+
+} // namespace services
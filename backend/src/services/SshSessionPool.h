@@ -0,0 +1,116 @@
+#pragma once
+#include <libssh/libssh.h>
+#include <json/json.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../utils/LatencyStats.h"
+
+namespace trantor {
+class EventLoopThread;
+}
+
+namespace services {
+
+struct SshCredentials {
+    std::string host;
+    int port = 22;
+    std::string username;
+    std::string password;
+};
+
+// Пул аутентифицированных SSH-сессий по (host, port, user): повторные деплои
+// и проверки одного сервера не платят заново за обмен ключами и вход.
+// В ключ входит и хэш пароля, чтобы сессию не получил запрос с другим паролем.
+// Сессия выдается одному потоку за раз; простаивающие дольше idle_timeout_sec
+// закрываются, перед повторной выдачей давно простаивавшая сессия проверяется.
+class SshSessionPool {
+public:
+    // Сессия, взятая из пула. При разрушении возвращается в пул,
+    // после invalidate() - закрывается.
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        ~Lease();
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        ssh_session get() const { return session; }
+        // Сессия взята из простаивающих, а не создана заново
+        bool isReused() const { return reused; }
+        void invalidate() { valid = false; }
+
+    private:
+        friend class SshSessionPool;
+        Lease(std::string key, ssh_session session, bool reused);
+        void release();
+
+        std::string key;
+        ssh_session session = nullptr;
+        bool reused = false;
+        bool valid = true;
+    };
+
+    // Секция custom_config.ssh_pool: max_per_host, idle_timeout_sec,
+    // health_check_after_sec, acquire_timeout_sec, connect_timeout_sec
+    static void init(const Json::Value& config);
+
+    // Блокирует, пока у сервера занято max_per_host сессий; бросает runtime_error
+    // при ошибке подключения или истечении acquire_timeout_sec
+    static Lease acquire(const SshCredentials& credentials);
+
+    // Сколько сессий одного сервера можно держать одновременно
+    static size_t maxSessionsPerHost() { return maxPerHost; }
+
+    // Закрывает сессии, простаивающие дольше idle_timeout_sec
+    static void evictIdle();
+
+    static Json::Value metrics();
+
+private:
+    struct IdleSession {
+        ssh_session session;
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    struct HostSlot {
+        std::vector<IdleSession> idle;
+        size_t leased = 0;
+    };
+
+    static std::string poolKey(const SshCredentials& credentials);
+    static ssh_session handshake(const SshCredentials& credentials);
+    static bool isHealthy(const IdleSession& idle);
+    static void close(ssh_session session);
+    static void release(const std::string& key, ssh_session session, bool valid);
+
+    static std::mutex mutex;
+    static std::condition_variable available;
+    static std::unordered_map<std::string, HostSlot> hosts;
+
+    static size_t maxPerHost;
+    static std::chrono::seconds idleTimeout;
+    static std::chrono::seconds healthCheckAfter;
+    static std::chrono::seconds acquireTimeout;
+    static long connectTimeout;
+    // Поток таймера evictIdle
+    static std::unique_ptr<trantor::EventLoopThread> evictionLoop;
+
+    static std::atomic<uint64_t> hits;
+    static std::atomic<uint64_t> misses;
+    static std::atomic<uint64_t> evicted;
+    static std::atomic<uint64_t> healthCheckFailures;
+    static utils::LatencyStats handshakeTime;
+    static utils::LatencyStats acquireWait;
+};
+
+} // namespace services
@@ -0,0 +1,170 @@
+#include "SshTunnel.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <stdexcept>
+#include <vector>
+
+namespace services {
+
+namespace {
+
+constexpr size_t BUFFER_SIZE = 16 * 1024;
+// libssh может держать прочитанные данные у себя, не в сокете: poll не ждет дольше
+constexpr int POLL_TIMEOUT_MS = 10;
+
+// Проброшенное соединение: локальный сокет клиента и канал direct-tcpip
+struct Forward {
+    int socket = -1;
+    ssh_channel channel = nullptr;
+    bool clientClosed = false;
+};
+
+void closeForward(Forward& forward) {
+    if (forward.channel != nullptr) {
+        if (ssh_channel_is_open(forward.channel)) {
+            ssh_channel_close(forward.channel);
+        }
+        ssh_channel_free(forward.channel);
+        forward.channel = nullptr;
+    }
+    if (forward.socket >= 0) {
+        ::close(forward.socket);
+        forward.socket = -1;
+    }
+}
+
+bool sendAll(int socket, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = ::send(socket, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+} // namespace
+
+SshTunnel::SshTunnel(const SshCredentials& credentials, std::string remoteHost, int remotePort)
+    : lease(SshSessionPool::acquire(credentials)), remoteHost(std::move(remoteHost)), remotePort(remotePort) {
+    listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw std::runtime_error("Failed to create tunnel socket");
+    }
+    // Порт выбирает система, слушаем только loopback
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t length = sizeof(address);
+    if (::bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listener, SOMAXCONN) != 0 ||
+        ::getsockname(listener, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        ::close(listener);
+        throw std::runtime_error("Failed to open tunnel port");
+    }
+    port = ntohs(address.sin_port);
+    worker = std::thread([this]() { loop(); });
+}
+
+SshTunnel::~SshTunnel() {
+    stopping = true;
+    if (worker.joinable()) {
+        worker.join();
+    }
+    ::close(listener);
+}
+
+void SshTunnel::loop() {
+    std::vector<Forward> forwards;
+    std::vector<pollfd> fds;
+    char buffer[BUFFER_SIZE];
+
+    while (!stopping) {
+        fds.clear();
+        fds.push_back({listener, POLLIN, 0});
+        fds.push_back({ssh_get_fd(lease.get()), POLLIN, 0});
+        for (const auto& forward : forwards) {
+            fds.push_back({forward.socket, static_cast<short>(forward.clientClosed ? 0 : POLLIN), 0});
+        }
+        if (::poll(fds.data(), fds.size(), POLL_TIMEOUT_MS) < 0 && errno != EINTR) {
+            break;
+        }
+
+        // Новое подключение клиента - новый канал до СУБД
+        if (fds[0].revents & POLLIN) {
+            int client = ::accept(listener, nullptr, nullptr);
+            if (client >= 0) {
+                Forward forward;
+                forward.socket = client;
+                forward.channel = ssh_channel_new(lease.get());
+                if (forward.channel == nullptr ||
+                    ssh_channel_open_forward(forward.channel, remoteHost.c_str(), remotePort, "127.0.0.1", port) !=
+                        SSH_OK) {
+                    closeForward(forward);
+                } else {
+                    forwards.push_back(forward);
+                    fds.push_back({client, 0, 0});
+                }
+            }
+        }
+
+        for (size_t i = 0; i < forwards.size(); ++i) {
+            Forward& forward = forwards[i];
+            bool failed = false;
+            bool sshError = false;
+
+            // Клиент -> СУБД
+            if (!forward.clientClosed && (fds[i + 2].revents & (POLLIN | POLLHUP | POLLERR))) {
+                ssize_t received = ::recv(forward.socket, buffer, sizeof(buffer), 0);
+                if (received > 0) {
+                    sshError = ssh_channel_write(forward.channel, buffer, static_cast<uint32_t>(received)) == SSH_ERROR;
+                    failed = sshError;
+                } else if (received == 0 || errno != EINTR) {
+                    forward.clientClosed = true;
+                    ssh_channel_send_eof(forward.channel);
+                }
+            }
+
+            // СУБД -> клиент: забираем все, что уже пришло по каналу
+            while (!failed) {
+                int read = ssh_channel_read_nonblocking(forward.channel, buffer, sizeof(buffer), 0);
+                if (read > 0) {
+                    failed = !sendAll(forward.socket, buffer, static_cast<size_t>(read));
+                    continue;
+                }
+                sshError = read == SSH_ERROR;
+                failed = sshError;
+                break;
+            }
+
+            bool finished = ssh_channel_is_eof(forward.channel) ||
+                            (forward.clientClosed && !ssh_channel_is_open(forward.channel));
+            if (failed || finished) {
+                // Ошибка SSH - сессия больше не годится для пула; закрытый клиентом сокет - нет
+                if (sshError) {
+                    lease.invalidate();
+                }
+                closeForward(forward);
+                forwards.erase(forwards.begin() + static_cast<std::ptrdiff_t>(i));
+                fds.erase(fds.begin() + static_cast<std::ptrdiff_t>(i + 2));
+                --i;
+            }
+        }
+    }
+
+    for (auto& forward : forwards) {
+        closeForward(forward);
+    }
+}
+
+} // namespace services
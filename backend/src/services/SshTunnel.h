@@ -0,0 +1,38 @@
+#pragma once
+#include <libssh/libssh.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "SshSessionPool.h"
+
+namespace services {
+
+// Локальный порт, проброшенный через SSH на remoteHost:remotePort со стороны
+// сервера (как ssh -L): клиенты СУБД подключаются к 127.0.0.1:localPort(), а
+// сама СУБД по-прежнему слушает только localhost сервера. Сессия берется из
+// SshSessionPool на все время жизни туннеля; libssh не потокобезопасна, поэтому
+// все вызовы по сессии делает один поток туннеля.
+class SshTunnel {
+public:
+    // Бросает runtime_error, если не удалось подключиться или открыть порт
+    SshTunnel(const SshCredentials& credentials, std::string remoteHost, int remotePort);
+    ~SshTunnel();
+
+    SshTunnel(const SshTunnel&) = delete;
+    SshTunnel& operator=(const SshTunnel&) = delete;
+
+    int localPort() const { return port; }
+
+private:
+    void loop();
+
+    SshSessionPool::Lease lease;
+    std::string remoteHost;
+    int remotePort;
+    int listener = -1;
+    int port = 0;
+    std::atomic<bool> stopping{false};
+    std::thread worker;
+};
+
+} // namespace services
@@ -0,0 +1,433 @@
+#include "CompactSchema.h"
+#include "SchemaJson.h"
+#include <algorithm>
+#include <cctype>
+
+namespace sql {
+
+namespace {
+
+// FNV-1a
+size_t hashText(std::string_view text) {
+    size_t hash = 14695981039346656037ULL;
+    for (char c : text) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::string lower(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+std::string_view stringMember(const Json::Value& object, std::string_view key) {
+    const Json::Value* value = findMember(object, key);
+    return value != nullptr ? jsonString(*value) : std::string_view();
+}
+
+} // namespace
+
+CompactSchema::CompactSchema(const Json::Value& tables, const Json::Value& relations)
+    : offsets{0, 0}, lowercase{0}, typeNames{0} {
+    typesByName.emplace(0, 0);
+
+    tablesArray = tables.isArray();
+    if (tablesArray) {
+        tableList.reserve(tables.size());
+        tablesById.reserve(tables.size());
+        tablesByName.reserve(tables.size());
+        for (const auto& table : tables) {
+            addTable(table);
+        }
+        resolveReferences();
+    }
+
+    if (relations.isArray()) {
+        relationsKind = RelationsShape::Array;
+        relationList.reserve(relations.size());
+        for (const auto& json : relations) {
+            Relation relation;
+            relation.object = json.isObject();
+            if (relation.object) {
+                relation.source = intern(stringMember(json, "sourceId"));
+                relation.target = intern(stringMember(json, "targetId"));
+                relation.type = intern(stringMember(json, "type"));
+            }
+            relationList.push_back(relation);
+        }
+    } else if (!relations.isNull()) {
+        relationsKind = RelationsShape::Invalid;
+    }
+}
+
+CompactSchema::Slice<CompactSchema::Column> CompactSchema::columns(uint32_t table) const {
+    const Table& item = tableList[table];
+    return Slice<Column>(columnList.data() + item.firstColumn, item.columnCount);
+}
+
+CompactSchema::Slice<CompactSchema::Index> CompactSchema::indexes(uint32_t table) const {
+    const Table& item = tableList[table];
+    return Slice<Index>(indexList.data() + item.firstIndex, item.indexCount);
+}
+
+CompactSchema::Slice<CompactSchema::IndexKey> CompactSchema::keys(const Index& index) const {
+    return Slice<IndexKey>(indexKeys.data() + index.firstKey, index.keyCount);
+}
+
+std::string_view CompactSchema::text(Name name) const {
+    return std::string_view(chars.data() + offsets[name], offsets[name + 1] - offsets[name]);
+}
+
+CompactSchema::Name CompactSchema::find(std::string_view value) const {
+    return value.empty() ? 0 : lookup(value, hashText(value));
+}
+
+CompactSchema::Name CompactSchema::lookup(std::string_view value, size_t hash) const {
+    if (slots.empty()) {
+        return 0;
+    }
+    size_t mask = slots.size() - 1;
+    for (size_t i = hash & mask; slots[i] != 0; i = (i + 1) & mask) {
+        if (text(slots[i]) == value) {
+            return slots[i];
+        }
+    }
+    return 0;
+}
+
+void CompactSchema::growSlots() {
+    // Заполнение не больше половины: короткие цепочки проб
+    std::vector<Name> grown(std::max<size_t>(64, slots.size() * 2), 0);
+    size_t mask = grown.size() - 1;
+    for (Name name = 1; name + 1 < offsets.size(); ++name) {
+        size_t i = hashText(text(name)) & mask;
+        while (grown[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        grown[i] = name;
+    }
+    slots.swap(grown);
+}
+
+CompactSchema::Name CompactSchema::intern(std::string_view value) {
+    if (value.empty()) {
+        return 0;
+    }
+    size_t hash = hashText(value);
+    if (Name found = lookup(value, hash)) {
+        return found;
+    }
+
+    Name name = static_cast<Name>(offsets.size() - 1);
+    chars.append(value.data(), value.size());
+    offsets.push_back(static_cast<uint32_t>(chars.size()));
+    lowercase.push_back(name);
+    if (offsets.size() * 2 > slots.size()) {
+        growSlots();
+    } else {
+        size_t mask = slots.size() - 1;
+        size_t i = hash & mask;
+        while (slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = name;
+    }
+
+    if (std::any_of(value.begin(), value.end(), [](unsigned char c) { return std::isupper(c); })) {
+        Name folded = intern(lower(value));
+        lowercase[name] = folded;
+    }
+    return name;
+}
+
+uint32_t CompactSchema::internType(Name name) {
+    auto [it, inserted] = typesByName.emplace(name, static_cast<uint32_t>(typeNames.size()));
+    if (inserted) {
+        typeNames.push_back(name);
+    }
+    return it->second;
+}
+
+void CompactSchema::addTable(const Json::Value& json) {
+    auto index = static_cast<uint32_t>(tableList.size());
+    tableList.emplace_back();
+    Table& table = tableList.back();
+    table.firstColumn = static_cast<uint32_t>(columnList.size());
+    table.firstIndex = static_cast<uint32_t>(indexList.size());
+    if (!json.isObject()) {
+        return;
+    }
+
+    table.flags |= TableObject;
+    table.name = intern(stringMember(json, "name"));
+    table.id = intern(stringMember(json, "id"));
+    if (table.id != 0) {
+        tablesById.emplace(table.id, index);
+    }
+    if (table.name != 0) {
+        tablesByName.emplace(lowered(table.name), index);
+    }
+
+    const Json::Value* columns = findMember(json, "columns");
+    if (columns != nullptr && columns->isArray()) {
+        table.flags |= ColumnsArray;
+        for (const auto& column : *columns) {
+            addColumn(column);
+        }
+        table.columnCount = static_cast<uint32_t>(columnList.size()) - table.firstColumn;
+    }
+
+    const Json::Value* partitioning = findMember(json, "partitioning");
+    if (partitioning != nullptr && !partitioning->isNull()) {
+        table.partitioning = static_cast<uint32_t>(partitionings.size());
+        partitionings.push_back(*partitioning);
+    }
+
+    const Json::Value* indexes = findMember(json, "indexes");
+    if (indexes != nullptr && !indexes->isNull()) {
+        table.flags |= IndexesPresent;
+        if (indexes->isArray()) {
+            table.flags |= IndexesArray;
+            addIndexes(*indexes, index);
+        }
+    }
+}
+
+void CompactSchema::addColumn(const Json::Value& json) {
+    Column column;
+    if (json.isObject()) {
+        column.flags |= ColumnObject;
+        column.name = intern(stringMember(json, "name"));
+        column.id = intern(stringMember(json, "id"));
+        column.type = internType(intern(stringMember(json, "type")));
+        if (isPrimaryKey(json)) {
+            column.flags |= PrimaryKey;
+        }
+        if (isNotNull(json)) {
+            column.flags |= NotNull;
+        }
+        // Число или флаг по умолчанию пишется в DDL своим текстом, как asString
+        if (const Json::Value* value = sql::defaultValue(json)) {
+            if (value->isString()) {
+                column.defaultValue = intern(jsonString(*value));
+            } else if (value->isConvertibleTo(Json::stringValue)) {
+                column.defaultValue = intern(value->asString());
+            }
+        }
+        const Json::Value* reference = findMember(json, "references");
+        if (reference != nullptr && !reference->isNull()) {
+            column.flags |= HasReference;
+            if (reference->isObject()) {
+                column.flags |= ReferenceObject;
+            }
+            column.referenceTable = intern(referenceKey(*reference, "tableId", "table"));
+            column.referenceColumn = intern(referenceKey(*reference, "columnId", "column"));
+        }
+    }
+    columnList.push_back(column);
+}
+
+void CompactSchema::addIndexes(const Json::Value& json, uint32_t table) {
+    for (const auto& item : json) {
+        Index index;
+        index.firstKey = static_cast<uint32_t>(indexKeys.size());
+        if (item.isObject()) {
+            index.flags |= IndexObject;
+            index.name = intern(stringMember(item, "name"));
+            index.method = intern(stringMember(item, "method"));
+            index.where = intern(stringMember(item, "where"));
+            const Json::Value* unique = findMember(item, "unique");
+            if (unique != nullptr && unique->isConvertibleTo(Json::booleanValue) && unique->asBool()) {
+                index.flags |= Unique;
+            }
+            const Json::Value* columns = findMember(item, "columns");
+            if (columns != nullptr && columns->isArray()) {
+                index.flags |= IndexColumnsArray;
+                for (const auto& key : *columns) {
+                    Name name = intern(jsonString(key));
+                    indexKeys.push_back({name, findColumn(table, name)});
+                }
+            }
+        }
+        index.keyCount = static_cast<uint32_t>(indexKeys.size()) - index.firstKey;
+        indexList.push_back(index);
+    }
+    tableList[table].indexCount = static_cast<uint32_t>(json.size());
+}
+
+void CompactSchema::resolveReferences() {
+    for (uint32_t t = 0; t < tableList.size(); ++t) {
+        const Table& table = tableList[t];
+        for (uint32_t c = table.firstColumn; c < table.firstColumn + table.columnCount; ++c) {
+            Column& column = columnList[c];
+            if (!column.has(ReferenceObject)) {
+                continue;
+            }
+            std::optional<uint32_t> target = tableByKey(column.referenceTable);
+            if (!target) {
+                continue;
+            }
+            uint32_t targetColumn = findColumn(*target, column.referenceColumn);
+            if (targetColumn != NONE) {
+                column.targetTable = *target;
+                column.targetColumn = targetColumn;
+            }
+        }
+    }
+}
+
+std::optional<uint32_t> CompactSchema::tableByKey(Name key) const {
+    if (key == 0) {
+        return std::nullopt;
+    }
+    auto it = tablesById.find(key);
+    if (it != tablesById.end()) {
+        return it->second;
+    }
+    it = tablesByName.find(lowered(key));
+    if (it != tablesByName.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+std::optional<uint32_t> CompactSchema::findTable(std::string_view key) const {
+    if (key.empty()) {
+        return std::nullopt;
+    }
+    // Строки, которой нет в пуле, нет ни среди id, ни среди имен
+    auto it = tablesById.find(find(key));
+    if (it != tablesById.end()) {
+        return it->second;
+    }
+    it = tablesByName.find(find(lower(key)));
+    if (it != tablesByName.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+uint32_t CompactSchema::findColumn(uint32_t table, Name exact, Name lower) const {
+    const Table& item = tableList[table];
+    uint32_t end = item.firstColumn + item.columnCount;
+    if (exact != 0) {
+        for (uint32_t c = item.firstColumn; c < end; ++c) {
+            if (columnList[c].id == exact) {
+                return c;
+            }
+        }
+    }
+    if (lower != 0) {
+        for (uint32_t c = item.firstColumn; c < end; ++c) {
+            if (lowercase[columnList[c].name] == lower) {
+                return c;
+            }
+        }
+    }
+    return NONE;
+}
+
+uint32_t CompactSchema::findColumn(uint32_t table, Name key) const {
+    return key == 0 ? NONE : findColumn(table, key, lowered(key));
+}
+
+uint32_t CompactSchema::findColumn(uint32_t table, std::string_view key) const {
+    return key.empty() ? NONE : findColumn(table, find(key), find(lower(key)));
+}
+
+std::string CompactSchema::key(const Table& table) const {
+    return table.id != 0 ? "#" + std::string(text(table.id)) : std::string(text(lowered(table.name)));
+}
+
+std::string CompactSchema::key(const Column& column) const {
+    return column.id != 0 ? "#" + std::string(text(column.id)) : std::string(text(lowered(column.name)));
+}
+
+const Json::Value* CompactSchema::partitioning(uint32_t table) const {
+    uint32_t index = tableList[table].partitioning;
+    return index != NONE ? &partitionings[index] : nullptr;
+}
+
+std::optional<PartitionSpec> CompactSchema::partitionSpec(uint32_t table) const {
+    const Json::Value* json = partitioning(table);
+    if (json == nullptr) {
+        return std::nullopt;
+    }
+    return PartitionSpec::fromJson(*json, [this, table](std::string_view key, std::string& name,
+                                                        std::string& columnKey) {
+        uint32_t column = findColumn(table, key);
+        if (column == NONE) {
+            return false;
+        }
+        name = std::string(text(columnList[column].name));
+        columnKey = this->key(columnList[column]);
+        return true;
+    });
+}
+
+std::vector<IndexDefinition> CompactSchema::indexDefinitions(uint32_t table) const {
+    std::string_view tableName = text(tableList[table].name);
+    Slice<Column> tableColumns = columns(table);
+    std::vector<IndexDefinition> definitions;
+
+    // Ведущие колонки первичного ключа и индексов: по ним уже есть поиск
+    std::vector<std::string> leading;
+    for (const auto& column : tableColumns) {
+        if (column.has(PrimaryKey)) {
+            leading.push_back(key(column));
+            break;
+        }
+    }
+
+    for (const auto& index : indexes(table)) {
+        IndexDefinition definition;
+        for (const auto& indexKey : keys(index)) {
+            if (indexKey.column == NONE) {
+                continue;
+            }
+            const Column& column = columnList[indexKey.column];
+            definition.columns.emplace_back(text(column.name));
+            definition.columnKeys.push_back(key(column));
+        }
+        if (definition.columns.empty()) {
+            continue;
+        }
+        definition.unique = index.has(Unique);
+        if (index.method != 0) {
+            definition.method = std::string(text(lowered(index.method)));
+        }
+        definition.where = std::string(text(index.where));
+        definition.name = index.name == 0 ? generatedIndexName(tableName, definition.columns, definition.unique)
+                                          : std::string(text(index.name));
+        // Частичный индекс покрывает не все строки и для FK не годится
+        if (definition.where.empty()) {
+            leading.push_back(definition.columnKeys.front());
+        }
+        definitions.push_back(std::move(definition));
+    }
+
+    // Колонкам FK без покрывающего индекса - индекс автоматически
+    for (const auto& column : tableColumns) {
+        if (!column.has(ReferenceObject)) {
+            continue;
+        }
+        std::string columnKey = key(column);
+        if (std::find(leading.begin(), leading.end(), columnKey) != leading.end()) {
+            continue;
+        }
+        IndexDefinition definition;
+        definition.columns.emplace_back(text(column.name));
+        definition.columnKeys.push_back(columnKey);
+        definition.name = generatedIndexName(tableName, definition.columns, false);
+        definition.automatic = true;
+        leading.push_back(std::move(columnKey));
+        definitions.push_back(std::move(definition));
+    }
+    return definitions;
+}
+
+} // namespace sql
@@ -0,0 +1,197 @@
+#pragma once
+#include <json/json.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "IndexDefinition.h"
+#include "Partitioning.h"
+
+namespace sql {
+
+// Массив tables (и relations) схемы в плоском виде: таблицы, колонки, индексы
+// лежат подряд в своих векторах, строки - один раз в общем пуле и сравниваются
+// как номера, тип колонки - номер в списке различных типов, ссылка FK -
+// номера целевой таблицы и колонки. Строится один раз из Json; проверка,
+// генерация DDL и diff дальше не ищут поля по строковым ключам и не выделяют
+// память на каждый узел. Номера таблиц совпадают с индексами в массиве tables.
+// Сборка не бросает исключений: поля неверного типа считаются отсутствующими,
+// об этом сообщает SchemaValidator по флагам структуры.
+class CompactSchema {
+public:
+    // Номер строки в пуле; 0 - пустая строка (поля нет или оно не строка)
+    using Name = uint32_t;
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    // Непрерывный участок одного из векторов
+    template <typename T>
+    class Slice {
+    public:
+        Slice(const T* begin, size_t size) : first(begin), count(size) {}
+        const T* begin() const { return first; }
+        const T* end() const { return first + count; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        const T& operator[](size_t i) const { return first[i]; }
+
+    private:
+        const T* first;
+        size_t count;
+    };
+
+    enum TableFlag : uint8_t {
+        TableObject = 1 << 0,
+        ColumnsArray = 1 << 1,
+        // indexes задан и не null / задан массивом
+        IndexesPresent = 1 << 2,
+        IndexesArray = 1 << 3
+    };
+
+    enum ColumnFlag : uint8_t {
+        ColumnObject = 1 << 0,
+        PrimaryKey = 1 << 1,
+        NotNull = 1 << 2,
+        // references задан и не null / задан объектом
+        HasReference = 1 << 3,
+        ReferenceObject = 1 << 4
+    };
+
+    enum IndexFlag : uint8_t {
+        IndexObject = 1 << 0,
+        IndexColumnsArray = 1 << 1,
+        Unique = 1 << 2
+    };
+
+    struct Table {
+        Name name = 0;
+        Name id = 0;
+        uint32_t firstColumn = 0;
+        uint32_t columnCount = 0;
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        // Номер в partitionings или NONE, если partitioning нет или он null
+        uint32_t partitioning = NONE;
+        uint8_t flags = 0;
+
+        bool has(TableFlag flag) const { return (flags & flag) != 0; }
+    };
+
+    struct Column {
+        Name name = 0;
+        Name id = 0;
+        // Номер в types(); 0 - тип не задан
+        uint32_t type = 0;
+        // Текст значения по умолчанию; 0 - его нет
+        Name defaultValue = 0;
+        // Ключи ссылки как в JSON (tableId/table, columnId/column) и куда они разрешились
+        Name referenceTable = 0;
+        Name referenceColumn = 0;
+        uint32_t targetTable = NONE;
+        // Номер колонки в columns() всей схемы
+        uint32_t targetColumn = NONE;
+        uint8_t flags = 0;
+
+        bool has(ColumnFlag flag) const { return (flags & flag) != 0; }
+    };
+
+    // Колонка индекса: ключ из JSON и разрешенная колонка (NONE - не нашлась)
+    struct IndexKey {
+        Name key = 0;
+        uint32_t column = NONE;
+    };
+
+    struct Index {
+        Name name = 0;
+        Name method = 0;
+        Name where = 0;
+        uint32_t firstKey = 0;
+        uint32_t keyCount = 0;
+        uint8_t flags = 0;
+
+        bool has(IndexFlag flag) const { return (flags & flag) != 0; }
+    };
+
+    struct Relation {
+        bool object = false;
+        Name source = 0;
+        Name target = 0;
+        Name type = 0;
+    };
+
+    // relations: null (или не передан), массив или что-то другое
+    enum class RelationsShape { Null, Array, Invalid };
+
+    explicit CompactSchema(const Json::Value& tables, const Json::Value& relations = Json::Value());
+
+    bool tablesIsArray() const { return tablesArray; }
+    const std::vector<Table>& tables() const { return tableList; }
+    const std::vector<Column>& columns() const { return columnList; }
+    Slice<Column> columns(uint32_t table) const;
+    Slice<Index> indexes(uint32_t table) const;
+    Slice<IndexKey> keys(const Index& index) const;
+    RelationsShape relationsShape() const { return relationsKind; }
+    const std::vector<Relation>& relations() const { return relationList; }
+
+    std::string_view text(Name name) const;
+    // Та же строка в нижнем регистре
+    Name lowered(Name name) const { return lowercase[name]; }
+    // Номер строки, если она есть в пуле, иначе 0
+    Name find(std::string_view text) const;
+    // Различные типы колонок схемы, types()[0] - пустой
+    const std::vector<Name>& types() const { return typeNames; }
+    std::string_view type(const Column& column) const { return text(typeNames[column.type]); }
+
+    // Таблица по id или имени без учета регистра
+    std::optional<uint32_t> findTable(std::string_view key) const;
+    // Колонка таблицы по id или имени без учета регистра (номер в columns()); NONE - нет
+    uint32_t findColumn(uint32_t table, Name key) const;
+    uint32_t findColumn(uint32_t table, std::string_view key) const;
+
+    // Ключи сопоставления как matchKey: "#id" или имя в нижнем регистре
+    std::string key(const Table& table) const;
+    std::string key(const Column& column) const;
+
+    // Исходный объект partitioning таблицы или nullptr
+    const Json::Value* partitioning(uint32_t table) const;
+    // То же, что PartitionSpec::fromTable и tableIndexes для исходной таблицы
+    std::optional<PartitionSpec> partitionSpec(uint32_t table) const;
+    std::vector<IndexDefinition> indexDefinitions(uint32_t table) const;
+
+private:
+    Name intern(std::string_view text);
+    Name lookup(std::string_view text, size_t hash) const;
+    void growSlots();
+    uint32_t internType(Name name);
+    void addTable(const Json::Value& json);
+    void addColumn(const Json::Value& json);
+    void addIndexes(const Json::Value& json, uint32_t table);
+    void resolveReferences();
+    std::optional<uint32_t> tableByKey(Name key) const;
+    uint32_t findColumn(uint32_t table, Name exact, Name lower) const;
+
+    // Пул строк: строка n - chars[offsets[n], offsets[n + 1])
+    std::string chars;
+    std::vector<uint32_t> offsets;
+    std::vector<Name> lowercase;
+    // Открытая адресация по хэшу строки; 0 - свободная ячейка
+    std::vector<Name> slots;
+
+    bool tablesArray = false;
+    std::vector<Table> tableList;
+    std::vector<Column> columnList;
+    std::vector<Index> indexList;
+    std::vector<IndexKey> indexKeys;
+    std::vector<Json::Value> partitionings;
+    RelationsShape relationsKind = RelationsShape::Null;
+    std::vector<Relation> relationList;
+    std::vector<Name> typeNames;
+    // Номер типа по имени: меньше сравнений строк при сборке
+    std::unordered_map<Name, uint32_t> typesByName;
+    // Таблицы по id и по имени в нижнем регистре, первая встреченная
+    std::unordered_map<Name, uint32_t> tablesById;
+    std::unordered_map<Name, uint32_t> tablesByName;
+};
+
+} // namespace sql
@@ -0,0 +1,1117 @@
+#include "DataGenerator.h"
+#include "IndexDefinition.h"
+#include "SchemaGraph.h"
+#include "SchemaJson.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+
+namespace sql {
+
+namespace {
+
+constexpr uint64_t UNLIMITED = std::numeric_limits<uint64_t>::max();
+// Случайные целые без уникальности - из [1, RANDOM_INT_LIMIT]
+constexpr int64_t RANDOM_INT_LIMIT = 1000000;
+// Случайные даты - за последние три года
+constexpr int64_t RANDOM_DAYS = 3 * 365;
+constexpr int64_t SECONDS_PER_DAY = 86400;
+// Уникальные даты и время отсчитываются от 2000-01-01
+constexpr int64_t UNIQUE_EPOCH_DAYS = 10957;
+constexpr int64_t MAX_DAYS = 2932896;
+
+const char* const WORDS[] = {
+    "alpha", "amber", "anchor", "apex", "arrow", "aspen", "atlas", "aurora",
+    "basil", "beacon", "birch", "blaze", "bloom", "breeze", "brook", "cedar",
+    "cinder", "cliff", "clover", "comet", "coral", "crest", "dawn", "delta",
+    "drift", "dune", "echo", "ember", "fern", "field", "flint", "forest",
+    "frost", "garnet", "glade", "granite", "harbor", "hazel", "horizon", "iris",
+    "ivory", "jade", "juniper", "lagoon", "lark", "lotus", "maple", "meadow",
+    "mesa", "mist", "nectar", "oak", "onyx", "orbit", "pearl", "pine",
+    "prairie", "quartz", "raven", "reef", "ridge", "river", "sage", "summit"};
+constexpr size_t WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+// splitmix64: дешевый хэш с хорошим перемешиванием битов
+uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t saturatingMultiply(uint64_t lhs, uint64_t rhs) {
+    if (lhs != 0 && rhs > UNLIMITED / lhs) {
+        return UNLIMITED;
+    }
+    return lhs * rhs;
+}
+
+uint64_t power(uint64_t base, size_t exponent) {
+    uint64_t result = 1;
+    for (size_t i = 0; i < exponent && result != UNLIMITED; ++i) {
+        result = saturatingMultiply(result, base);
+    }
+    return result;
+}
+
+std::string lowerString(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+// SQL-литерал из PartitionBound или списка enum без кавычек: 'a''b' -> a'b
+std::string unquote(std::string_view literal) {
+    while (!literal.empty() && std::isspace(static_cast<unsigned char>(literal.front()))) {
+        literal.remove_prefix(1);
+    }
+    while (!literal.empty() && std::isspace(static_cast<unsigned char>(literal.back()))) {
+        literal.remove_suffix(1);
+    }
+    if (literal.size() < 2 || literal.front() != '\'' || literal.back() != '\'') {
+        return std::string(literal);
+    }
+    std::string result;
+    literal = literal.substr(1, literal.size() - 2);
+    for (size_t i = 0; i < literal.size(); ++i) {
+        result += literal[i];
+        if (literal[i] == '\'' && i + 1 < literal.size() && literal[i + 1] == '\'') {
+            ++i;
+        }
+    }
+    return result;
+}
+
+// Аргументы в скобках: "enum('a','b')" -> {"'a'", "'b'"}, "numeric(10, 2)" -> {"10", "2"}
+std::vector<std::string> typeArguments(std::string_view type) {
+    std::vector<std::string> arguments;
+    size_t open = type.find('(');
+    size_t close = type.rfind(')');
+    if (open == std::string_view::npos || close == std::string_view::npos || close < open) {
+        return arguments;
+    }
+    std::string current;
+    bool quoted = false;
+    for (size_t i = open + 1; i < close; ++i) {
+        char c = type[i];
+        if (c == '\'') {
+            quoted = !quoted;
+        }
+        if (c == ',' && !quoted) {
+            arguments.push_back(current);
+            current.clear();
+            continue;
+        }
+        current += c;
+    }
+    arguments.push_back(current);
+    return arguments;
+}
+
+// Имя типа без аргументов, массивов и модификаторов знака, в нижнем регистре
+std::string baseType(std::string_view type) {
+    std::string result;
+    int depth = 0;
+    bool pendingSpace = false;
+    for (char c : type) {
+        if (c == '(' || c == ')') {
+            depth += c == '(' ? 1 : -1;
+            continue;
+        }
+        if (depth > 0 || c == '[' || c == ']') {
+            continue;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = !result.empty();
+            continue;
+        }
+        if (pendingSpace) {
+            result += ' ';
+            pendingSpace = false;
+        }
+        result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    for (std::string_view suffix : {" unsigned", " signed", " zerofill"}) {
+        while (result.size() > suffix.size() &&
+               result.compare(result.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            result.erase(result.size() - suffix.size());
+        }
+    }
+    return result;
+}
+
+long parseNumber(std::string_view text, long fallback) {
+    try {
+        return std::stol(std::string(text));
+    } catch (const std::exception&) {
+        return fallback;
+    }
+}
+
+// 'YYYY-MM-DD...' в дни от 1970-01-01
+bool parseDays(std::string_view text, int64_t& days) {
+    int year = 0;
+    unsigned month = 0;
+    unsigned day = 0;
+    if (std::sscanf(std::string(text).c_str(), "%d-%u-%u", &year, &month, &day) != 3 ||
+        month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    days = CalendarDate{year, month, day}.toDays();
+    return true;
+}
+
+void appendBase36(uint64_t value, std::string& out) {
+    char digits[16];
+    size_t count = 0;
+    do {
+        uint64_t digit = value % 36;
+        digits[count++] = static_cast<char>(digit < 10 ? '0' + digit : 'a' + digit - 10);
+        value /= 36;
+    } while (value != 0);
+    while (count > 0) {
+        out += digits[--count];
+    }
+}
+
+void appendHex(uint64_t value, size_t digits, std::string& out) {
+    static const char HEX[] = "0123456789abcdef";
+    for (size_t i = digits; i-- > 0;) {
+        out += HEX[(value >> (i * 4)) & 0xf];
+    }
+}
+
+size_t base36Digits(uint64_t value) {
+    size_t digits = 1;
+    while (value >= 36) {
+        value /= 36;
+        ++digits;
+    }
+    return digits;
+}
+
+void appendTime(int64_t seconds, std::string& out) {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", static_cast<int>(seconds / 3600),
+                  static_cast<int>(seconds / 60 % 60), static_cast<int>(seconds % 60));
+    out += buffer;
+}
+
+void appendTimestamp(int64_t seconds, std::string& out) {
+    int64_t days = seconds >= 0 ? seconds / SECONDS_PER_DAY : (seconds - SECONDS_PER_DAY + 1) / SECONDS_PER_DAY;
+    out += CalendarDate::fromDays(static_cast<long>(days)).toString();
+    out += ' ';
+    appendTime(seconds - days * SECONDS_PER_DAY, out);
+}
+
+void appendUuid(uint64_t high, uint64_t low, std::string& out) {
+    appendHex(high >> 32, 8, out);
+    out += '-';
+    appendHex(high >> 16, 4, out);
+    out += '-';
+    appendHex(high, 4, out);
+    out += '-';
+    appendHex(low >> 48, 4, out);
+    out += '-';
+    appendHex(low, 12, out);
+}
+
+} // namespace
+
+DataGenerator::DataGenerator(Dialect dialect, const Json::Value& tables, Options options)
+    : dialect(dialect), options(std::move(options)) {
+    if (!tables.isArray() || tables.empty()) {
+        return;
+    }
+    SchemaGraph graph(tables);
+    plans.resize(tables.size());
+    std::vector<std::vector<size_t>> partitionColumns(tables.size());
+    for (Json::ArrayIndex i = 0; i < tables.size(); ++i) {
+        TablePlan& plan = plans[i];
+        plan.name = std::string(jsonString(tables[i]["name"]));
+        for (const auto& column : tables[i]["columns"]) {
+            ColumnPlan columnPlan;
+            columnPlan.name = std::string(jsonString(column["name"]));
+            columnPlan.type = std::string(jsonString(column["type"]));
+            columnPlan.nullable = !isNotNull(column) && !isPrimaryKey(column);
+            columnPlan.hasDefault = defaultValue(column) != nullptr;
+            columnPlan.salt = mix(this->options.seed ^ mix((static_cast<uint64_t>(i) << 24) + plan.columns.size()));
+            parseType(dialect, columnPlan);
+            plan.columns.push_back(std::move(columnPlan));
+        }
+        planPartitions(tables[i], plan, partitionColumns[i]);
+    }
+
+    // Ссылки FK и колонки, на которые ссылаются: они обязаны быть уникальными
+    auto columnIndex = [this](Json::ArrayIndex table, std::string_view name) {
+        const auto& columns = plans[table].columns;
+        for (size_t c = 0; c < columns.size(); ++c) {
+            if (equalsIgnoreCase(columns[c].name, name)) {
+                return c;
+            }
+        }
+        return columns.size();
+    };
+    std::vector<std::vector<bool>> referenced(tables.size());
+    for (Json::ArrayIndex i = 0; i < tables.size(); ++i) {
+        referenced[i].resize(plans[i].columns.size(), false);
+    }
+    for (Json::ArrayIndex i = 0; i < tables.size(); ++i) {
+        for (const auto& key : graph.foreignKeys(i)) {
+            size_t column = columnIndex(i, key.column);
+            size_t target = columnIndex(key.targetTable, key.targetColumn);
+            if (column == plans[i].columns.size() || target == plans[key.targetTable].columns.size()) {
+                continue;
+            }
+            ColumnPlan& plan = plans[i].columns[column];
+            plan.reference = true;
+            plan.parentTable = key.targetTable;
+            plan.parentColumn = target;
+            referenced[key.targetTable][target] = true;
+        }
+    }
+
+    // Родители планируются раньше детей: от их числа строк зависят ключи детей
+    const auto& order = graph.creationOrder();
+    std::vector<size_t> position(tables.size());
+    for (size_t p = 0; p < order.size(); ++p) {
+        position[order[p]] = p;
+    }
+    size_t layerCount = 0;
+    for (Json::ArrayIndex table : order) {
+        TablePlan& plan = plans[table];
+        for (auto& column : plan.columns) {
+            if (!column.reference) {
+                continue;
+            }
+            const ColumnPlan& parent = plans[column.parentTable].columns[column.parentColumn];
+            // Ссылка назад по циклу FK или на колонку без генератора: оставляем NULL или DEFAULT
+            if ((column.parentTable != table && position[column.parentTable] > position[table]) ||
+                !parent.loaded()) {
+                column.reference = false;
+                column.kind = ValueKind::Unsupported;
+                continue;
+            }
+            column.kind = parent.kind;
+            if (column.parentTable != table) {
+                plan.layer = std::max(plan.layer, plans[column.parentTable].layer + 1);
+            }
+        }
+        planKeys(tables[table], table, referenced[table], partitionColumns[table]);
+
+        auto rowsIt = this->options.tableRows.find(lowerString(plan.name));
+        plan.rows = rowsIt != this->options.tableRows.end() ? rowsIt->second : this->options.rows;
+        for (const auto& column : plan.columns) {
+            if (!column.loaded()) {
+                if (!column.nullable && !column.hasDefault) {
+                    throw std::invalid_argument("Cannot generate values for " + plan.name + "." + column.name +
+                                                " of type '" + column.type + "'");
+                }
+                continue;
+            }
+            if (column.capacity != 0) {
+                plan.capacity = std::min(plan.capacity, column.capacity);
+            }
+            // Обязательная ссылка на пустую таблицу: ни одной строки вставить нельзя
+            if (column.reference && column.parentTable != table && !column.nullable &&
+                plans[column.parentTable].rows == 0) {
+                plan.rows = 0;
+            }
+        }
+        plan.rows = std::min(plan.rows, plan.capacity);
+        layerCount = std::max(layerCount, plan.layer + 1);
+    }
+
+    loadLayers.resize(layerCount);
+    for (Json::ArrayIndex table : order) {
+        loadLayers[plans[table].layer].push_back(table);
+    }
+}
+
+void DataGenerator::parseType(Dialect dialect, ColumnPlan& column) {
+    std::string base = baseType(column.type);
+    std::vector<std::string> arguments = typeArguments(column.type);
+    column.array = dialect == Dialect::PostgreSQL && column.type.find('[') != std::string::npos;
+    long firstArgument = arguments.empty() ? 0 : parseNumber(arguments[0], 0);
+
+    auto integer = [&column](int64_t maxValue) {
+        column.kind = ValueKind::Integer;
+        column.maxValue = maxValue;
+    };
+    auto text = [&column](size_t length) {
+        column.kind = ValueKind::Text;
+        column.length = length;
+    };
+
+    if (base == "smallint" || base == "int2" || base == "smallserial" || base == "serial2") {
+        integer(32767);
+    } else if (base == "tinyint") {
+        integer(127);
+    } else if (base == "mediumint") {
+        integer(8388607);
+    } else if (base == "integer" || base == "int" || base == "int4" || base == "serial" ||
+               base == "serial4" || base == "oid") {
+        // serial в MySQL - псевдоним bigint unsigned
+        integer(dialect == Dialect::MySQL && base == "serial" ? std::numeric_limits<int64_t>::max() : 2147483647);
+    } else if (base == "bigint" || base == "int8" || base == "bigserial" || base == "serial8") {
+        integer(std::numeric_limits<int64_t>::max());
+    } else if (base == "decimal" || base == "numeric" || base == "dec" || base == "fixed" || base == "money") {
+        column.kind = ValueKind::Decimal;
+        long precision = base == "money" ? 12 : firstArgument;
+        column.scale = base == "money" ? 2 : arguments.size() > 1 ? static_cast<int>(parseNumber(arguments[1], 0)) : 0;
+        if (precision <= 0) {
+            // numeric без точности в PostgreSQL не ограничен, decimal в MySQL - это decimal(10, 0)
+            precision = dialect == Dialect::MySQL ? 10 : 12;
+            column.scale = dialect == Dialect::MySQL ? 0 : 2;
+        }
+        column.scale = std::clamp(column.scale, 0, static_cast<int>(precision));
+        column.maxValue = static_cast<int64_t>(std::min<uint64_t>(power(10, precision - column.scale),
+                                                                  std::numeric_limits<int64_t>::max()));
+    } else if (base == "real" || base == "float4" || base == "float" || base == "double" ||
+               base == "double precision" || base == "float8") {
+        column.kind = ValueKind::Float;
+    } else if (base == "bool" || base == "boolean") {
+        column.kind = ValueKind::Boolean;
+    } else if (base == "varchar" || base == "character varying" || base == "varbinary") {
+        text(firstArgument > 0 ? static_cast<size_t>(firstArgument) : 0);
+    } else if (base == "char" || base == "character" || base == "bpchar" || base == "binary") {
+        text(firstArgument > 0 ? static_cast<size_t>(firstArgument) : 1);
+    } else if (base == "tinytext" || base == "tinyblob") {
+        text(255);
+    } else if (base == "text" || base == "citext" || base == "mediumtext" || base == "longtext" ||
+               base == "xml" || base == "tsvector" || base == "blob" || base == "mediumblob" ||
+               base == "longblob") {
+        text(0);
+    } else if (base == "enum" || base == "set") {
+        column.kind = ValueKind::Text;
+        for (const auto& argument : arguments) {
+            column.choices.push_back(unquote(argument));
+        }
+    } else if (base == "date") {
+        column.kind = ValueKind::Date;
+    } else if (base.compare(0, 9, "timestamp") == 0 || base == "datetime") {
+        column.kind = ValueKind::Timestamp;
+    } else if (base.compare(0, 4, "time") == 0) {
+        column.kind = ValueKind::Time;
+    } else if (base == "year") {
+        column.kind = ValueKind::Year;
+    } else if (base == "uuid") {
+        column.kind = ValueKind::Uuid;
+    } else if (base == "json" || base == "jsonb") {
+        column.kind = ValueKind::Json;
+    } else if (base == "bytea") {
+        column.kind = ValueKind::Binary;
+    } else if (base == "inet") {
+        column.kind = ValueKind::Inet;
+    } else if (base == "cidr") {
+        column.kind = ValueKind::Cidr;
+    } else if (base == "macaddr" || base == "macaddr8") {
+        column.kind = ValueKind::MacAddress;
+    } else if (base == "interval") {
+        column.kind = ValueKind::Interval;
+    } else if (dialect == Dialect::PostgreSQL && (base == "bit" || base == "varbit" || base == "bit varying")) {
+        // bit без длины - bit(1); у varbit без длины берем байт
+        column.kind = ValueKind::Bits;
+        column.length = firstArgument > 0 ? static_cast<size_t>(firstArgument) : base == "bit" ? 1 : 8;
+    }
+}
+
+void DataGenerator::planPartitions(const Json::Value& table, TablePlan& plan, std::vector<size_t>& keyColumns) const {
+    std::optional<PartitionSpec> spec = PartitionSpec::fromTable(table);
+    if (!spec) {
+        return;
+    }
+    for (const auto& name : spec->columns) {
+        for (size_t c = 0; c < plan.columns.size(); ++c) {
+            if (equalsIgnoreCase(plan.columns[c].name, name)) {
+                keyColumns.push_back(c);
+            }
+        }
+    }
+    // Границы по нескольким колонкам сравниваются как кортежи - их не соблюдаем
+    if (keyColumns.size() != 1 || spec->strategy == PartitionStrategy::Hash) {
+        return;
+    }
+    ColumnPlan& column = plan.columns[keyColumns.front()];
+
+    for (const auto& bound : spec->initialPartitions(options.today)) {
+        if (bound.isDefault) {
+            continue;
+        }
+        if (spec->strategy == PartitionStrategy::List) {
+            for (const auto& value : bound.values) {
+                column.choices.push_back(unquote(value));
+            }
+            continue;
+        }
+
+        // MINVALUE и MAXVALUE заменяем на разумную ширину раздела
+        auto parse = [&column](const std::string& literal, int64_t& value) {
+            std::string text = unquote(literal);
+            if (text == "MINVALUE" || text == "MAXVALUE") {
+                return false;
+            }
+            if (column.kind == ValueKind::Date || column.kind == ValueKind::Timestamp) {
+                if (!parseDays(text, value)) {
+                    return false;
+                }
+                if (column.kind == ValueKind::Timestamp) {
+                    value *= SECONDS_PER_DAY;
+                }
+                return true;
+            }
+            try {
+                value = std::stoll(text);
+                return true;
+            } catch (const std::exception&) {
+                return false;
+            }
+        };
+        int64_t width = column.kind == ValueKind::Timestamp ? RANDOM_DAYS * SECONDS_PER_DAY
+                        : column.kind == ValueKind::Date   ? RANDOM_DAYS
+                                                           : RANDOM_INT_LIMIT;
+        int64_t from = 0;
+        int64_t to = 0;
+        bool hasFrom = parse(bound.from, from);
+        bool hasTo = parse(bound.to, to);
+        if (!hasFrom && !hasTo) {
+            continue;
+        }
+        if (!hasFrom) {
+            from = to - width;
+        } else if (!hasTo) {
+            to = from + width;
+        }
+        if (from < to) {
+            column.ranges.emplace_back(from, to);
+        }
+    }
+}
+
+void DataGenerator::planKeys(const Json::Value& table, Json::ArrayIndex index, const std::vector<bool>& referenced,
+                             const std::vector<size_t>& partitionColumns) {
+    TablePlan& plan = plans[index];
+    auto findColumn = [&plan](std::string_view name) {
+        for (size_t c = 0; c < plan.columns.size(); ++c) {
+            if (equalsIgnoreCase(plan.columns[c].name, name)) {
+                return c;
+            }
+        }
+        return plan.columns.size();
+    };
+
+    // Наборы колонок, значения которых не должны повторяться
+    std::vector<std::vector<size_t>> keys;
+    std::vector<size_t> primaryKey;
+    for (const auto& column : table["columns"]) {
+        if (isPrimaryKey(column)) {
+            primaryKey.push_back(findColumn(jsonString(column["name"])));
+        }
+    }
+    if (!primaryKey.empty()) {
+        keys.push_back(std::move(primaryKey));
+    }
+    for (const auto& definition : tableIndexes(table)) {
+        if (!definition.unique) {
+            continue;
+        }
+        std::vector<size_t> key;
+        for (const auto& name : definition.columns) {
+            key.push_back(findColumn(name));
+        }
+        keys.push_back(std::move(key));
+    }
+    for (size_t c = 0; c < referenced.size(); ++c) {
+        if (referenced[c]) {
+            keys.push_back({c});
+        }
+    }
+
+    auto makeUnique = [this, index](ColumnPlan& column) {
+        column.nullable = false;
+        if (!column.reference) {
+            column.unique = true;
+            switch (column.kind) {
+            case ValueKind::Integer:
+                column.capacity = static_cast<uint64_t>(column.maxValue);
+                break;
+            case ValueKind::Decimal:
+                // Целая часть decimal(p, s) - не больше p - s знаков
+                column.capacity = std::max<uint64_t>(static_cast<uint64_t>(column.maxValue) - 1, 1);
+                break;
+            case ValueKind::Float:
+                column.capacity = uint64_t(1) << 53;
+                break;
+            case ValueKind::Boolean:
+                column.capacity = 2;
+                break;
+            case ValueKind::Text:
+            case ValueKind::Binary:
+                column.capacity = column.length == 0 ? 0 : power(36, column.length);
+                break;
+            case ValueKind::Date:
+                column.capacity = MAX_DAYS - UNIQUE_EPOCH_DAYS;
+                break;
+            case ValueKind::Time:
+                column.capacity = SECONDS_PER_DAY;
+                break;
+            case ValueKind::Year:
+                column.capacity = 255;
+                break;
+            case ValueKind::Inet:
+                column.capacity = uint64_t(1) << 24;
+                break;
+            case ValueKind::Cidr:
+                column.capacity = uint64_t(1) << 16;
+                break;
+            case ValueKind::MacAddress:
+                column.capacity = uint64_t(1) << 40;
+                break;
+            case ValueKind::Bits:
+                column.capacity = column.length >= 64 ? 0 : uint64_t(1) << column.length;
+                break;
+            default:
+                break;
+            }
+            if (!column.choices.empty()) {
+                column.capacity = column.choices.size();
+            }
+        } else if (column.parentTable == index) {
+            // Уникальная ссылка на себя: каждая строка ссылается на саму себя
+            column.sameRow = true;
+        } else {
+            // Связь 1:1 - строка i ссылается на строку i родителя
+            column.sameRow = true;
+            column.capacity = plans[column.parentTable].rows;
+        }
+    };
+
+    for (const auto& key : keys) {
+        if (std::find(key.begin(), key.end(), plan.columns.size()) != key.end()) {
+            continue;
+        }
+        bool satisfied = std::any_of(key.begin(), key.end(), [&plan](size_t c) {
+            const ColumnPlan& column = plan.columns[c];
+            return column.unique || column.sameRow;
+        });
+        for (size_t c : key) {
+            plan.columns[c].nullable = false;
+        }
+        if (satisfied) {
+            continue;
+        }
+        if (key.size() == 1) {
+            makeUnique(plan.columns[key.front()]);
+            continue;
+        }
+
+        // Уникальной делаем одну колонку составного ключа, лучше не ссылку и не ключ раздела:
+        // ключ раздела должен попадать в границы разделов
+        auto pick = [&](bool allowPartitionKey) {
+            for (size_t c : key) {
+                bool partitionKey =
+                    std::find(partitionColumns.begin(), partitionColumns.end(), c) != partitionColumns.end();
+                if (!plan.columns[c].reference && (allowPartitionKey || !partitionKey)) {
+                    return c;
+                }
+            }
+            return plan.columns.size();
+        };
+        size_t chosen = pick(false);
+        if (chosen == plan.columns.size()) {
+            chosen = pick(true);
+        }
+        if (chosen != plan.columns.size()) {
+            makeUnique(plan.columns[chosen]);
+            continue;
+        }
+
+        // Ключ только из ссылок (таблица связи многие-ко-многим): номер строки раскладываем
+        // по разрядам с основаниями - числами строк родителей
+        uint64_t divisor = 1;
+        for (size_t c : key) {
+            ColumnPlan& column = plan.columns[c];
+            if (column.radixDivisor != 0) {
+                continue;
+            }
+            column.radixDivisor = divisor;
+            divisor = saturatingMultiply(divisor, plans[column.parentTable].rows);
+        }
+        for (size_t c : key) {
+            plan.columns[c].capacity = divisor;
+        }
+    }
+}
+
+uint64_t DataGenerator::hash(const ColumnPlan& column, uint64_t row, uint64_t stream) const {
+    return mix(column.salt ^ mix(row * 8 + stream));
+}
+
+bool DataGenerator::value(Json::ArrayIndex table, size_t index, uint64_t row, std::string& out) const {
+    const TablePlan& plan = plans[table];
+    const ColumnPlan& column = plan.columns[index];
+    if (!column.loaded()) {
+        return false;
+    }
+    uint64_t random = hash(column, row, 0);
+    bool nullable = column.nullable && !column.unique && !column.sameRow && column.radixDivisor == 0;
+    if (nullable && static_cast<double>(random % 10000) < options.nullRatio * 10000) {
+        return false;
+    }
+
+    if (column.reference) {
+        uint64_t parentRows = plans[column.parentTable].rows;
+        uint64_t parentRow = 0;
+        if (column.sameRow) {
+            parentRow = row;
+        } else if (column.radixDivisor != 0) {
+            parentRow = (row / column.radixDivisor) % parentRows;
+        } else {
+            // Ссылка на себя - только на уже вставленные строки, первая строка без родителя;
+            // строки после загрузки ссылаются на загруженные
+            uint64_t limit = column.parentTable == table ? std::min(row + (column.nullable ? 0 : 1), parentRows)
+                                                         : parentRows;
+            if (limit == 0) {
+                return false;
+            }
+            parentRow = hash(column, row, 1) % limit;
+        }
+        return value(column.parentTable, column.parentColumn, parentRow, out);
+    }
+
+    if (column.unique) {
+        uniqueScalar(column, row, out);
+    } else if (column.array) {
+        // Литерал массива PostgreSQL: элементы в кавычках, внутри экранируются " и обратная косая черта
+        out += '{';
+        uint64_t count = 1 + random % 3;
+        std::string element;
+        for (uint64_t i = 0; i < count; ++i) {
+            element.clear();
+            scalar(column, hash(column, row, 2 + i), element);
+            out += i > 0 ? ",\"" : "\"";
+            for (char c : element) {
+                if (c == '"' || c == '\\') {
+                    out += '\\';
+                }
+                out += c;
+            }
+            out += '"';
+        }
+        out += '}';
+    } else {
+        scalar(column, hash(column, row, 1), out);
+    }
+    return true;
+}
+
+void DataGenerator::scalar(const ColumnPlan& column, uint64_t random, std::string& out) const {
+    if (!column.choices.empty()) {
+        out += column.choices[random % column.choices.size()];
+        return;
+    }
+    if (!column.ranges.empty()) {
+        const auto& range = column.ranges[random % column.ranges.size()];
+        int64_t value = range.first + static_cast<int64_t>((random >> 16) % static_cast<uint64_t>(range.second - range.first));
+        if (column.kind == ValueKind::Date) {
+            out += CalendarDate::fromDays(static_cast<long>(value)).toString();
+        } else if (column.kind == ValueKind::Timestamp) {
+            appendTimestamp(value, out);
+        } else {
+            out += std::to_string(value);
+        }
+        return;
+    }
+
+    int64_t todayDays = options.today.toDays();
+    switch (column.kind) {
+    case ValueKind::Integer:
+        out += std::to_string(1 + random % static_cast<uint64_t>(std::min(column.maxValue, RANDOM_INT_LIMIT)));
+        break;
+    case ValueKind::Decimal: {
+        out += std::to_string(random % static_cast<uint64_t>(std::min(column.maxValue, RANDOM_INT_LIMIT)));
+        if (column.scale > 0) {
+            out += '.';
+            uint64_t fraction = random >> 32;
+            for (int i = 0; i < column.scale; ++i) {
+                out += static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+        }
+        break;
+    }
+    case ValueKind::Float: {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.2f", static_cast<double>(random % 100000000) / 100.0);
+        out += buffer;
+        break;
+    }
+    case ValueKind::Boolean:
+        if (dialect == Dialect::MySQL) {
+            out += (random & 1) ? '1' : '0';
+        } else {
+            out += (random & 1) ? "true" : "false";
+        }
+        break;
+    case ValueKind::Text: {
+        // Слова через пробел; строки ограниченной длины обрезаются
+        size_t start = out.size();
+        uint64_t words = column.length == 0 ? 1 + random % 6 : 1 + random % 3;
+        for (uint64_t i = 0; i < words; ++i) {
+            if (i > 0) {
+                out += ' ';
+            }
+            out += WORDS[(random >> (8 + i * 6)) % WORD_COUNT];
+        }
+        if (column.length != 0 && out.size() - start > column.length) {
+            out.resize(start + column.length);
+        }
+        break;
+    }
+    case ValueKind::Date:
+        out += CalendarDate::fromDays(static_cast<long>(todayDays - static_cast<int64_t>(random % RANDOM_DAYS))).toString();
+        break;
+    case ValueKind::Timestamp:
+        appendTimestamp(todayDays * SECONDS_PER_DAY -
+                            static_cast<int64_t>(random % static_cast<uint64_t>(RANDOM_DAYS * SECONDS_PER_DAY)),
+                        out);
+        break;
+    case ValueKind::Time:
+        appendTime(static_cast<int64_t>(random % SECONDS_PER_DAY), out);
+        break;
+    case ValueKind::Year:
+        out += std::to_string(1970 + random % 60);
+        break;
+    case ValueKind::Uuid: {
+        // Версия 4, вариант RFC 4122
+        uint64_t high = (random & 0xffffffffffff0fffULL) | 0x4000;
+        uint64_t low = (mix(random) & 0x3fffffffffffffffULL) | 0x8000000000000000ULL;
+        appendUuid(high, low, out);
+        break;
+    }
+    case ValueKind::Json:
+        out += "{\"n\": " + std::to_string(random % 1000) + ", \"tag\": \"" + WORDS[(random >> 16) % WORD_COUNT] + "\"}";
+        break;
+    case ValueKind::Binary:
+        out += "\\x";
+        appendHex(random, 16, out);
+        break;
+    case ValueKind::Inet:
+    case ValueKind::Cidr:
+        out += "10." + std::to_string((random >> 16) & 0xff) + "." + std::to_string((random >> 8) & 0xff) + ".";
+        out += column.kind == ValueKind::Cidr ? "0/24" : std::to_string(1 + random % 254);
+        break;
+    case ValueKind::MacAddress:
+        for (int i = 5; i >= 0; --i) {
+            appendHex(random >> (i * 8), 2, out);
+            if (i > 0) {
+                out += ':';
+            }
+        }
+        break;
+    case ValueKind::Interval:
+        out += std::to_string(random % 10000) + " minutes";
+        break;
+    case ValueKind::Bits:
+        for (size_t i = 0; i < column.length; ++i) {
+            out += ((random >> (i % 64)) & 1) ? '1' : '0';
+        }
+        break;
+    case ValueKind::Unsupported:
+        break;
+    }
+}
+
+void DataGenerator::uniqueScalar(const ColumnPlan& column, uint64_t row, std::string& out) const {
+    if (!column.choices.empty()) {
+        out += column.choices[row];
+        return;
+    }
+    switch (column.kind) {
+    case ValueKind::Integer:
+    case ValueKind::Decimal:
+    case ValueKind::Float:
+        out += std::to_string(row + 1);
+        break;
+    case ValueKind::Boolean:
+        out += dialect == Dialect::MySQL ? (row == 0 ? "0" : "1") : (row == 0 ? "false" : "true");
+        break;
+    case ValueKind::Text: {
+        // <колонка>_<номер в base36>, если помещается; '_' не дает префиксу совпасть с голым номером
+        if (column.length == 0 || column.name.size() + 1 + base36Digits(row) <= column.length) {
+            out += column.name;
+            out += '_';
+        }
+        appendBase36(row, out);
+        break;
+    }
+    case ValueKind::Binary:
+        if (dialect == Dialect::MySQL) {
+            appendBase36(row, out);
+        } else {
+            out += "\\x";
+            appendHex(row, 16, out);
+        }
+        break;
+    case ValueKind::Date:
+        out += CalendarDate::fromDays(static_cast<long>(UNIQUE_EPOCH_DAYS + row)).toString();
+        break;
+    case ValueKind::Timestamp:
+        appendTimestamp(UNIQUE_EPOCH_DAYS * SECONDS_PER_DAY + static_cast<int64_t>(row), out);
+        break;
+    case ValueKind::Time:
+        appendTime(static_cast<int64_t>(row), out);
+        break;
+    case ValueKind::Year:
+        out += std::to_string(1901 + row);
+        break;
+    case ValueKind::Uuid:
+        appendUuid(column.salt, row, out);
+        break;
+    case ValueKind::Json:
+        out += "{\"id\": " + std::to_string(row + 1) + "}";
+        break;
+    case ValueKind::Inet:
+        out += "10." + std::to_string((row >> 16) & 0xff) + "." + std::to_string((row >> 8) & 0xff) + "." +
+               std::to_string(row & 0xff);
+        break;
+    case ValueKind::Cidr:
+        out += "10." + std::to_string((row >> 8) & 0xff) + "." + std::to_string(row & 0xff) + ".0/24";
+        break;
+    case ValueKind::MacAddress:
+        for (int i = 5; i >= 0; --i) {
+            appendHex(row >> (i * 8), 2, out);
+            if (i > 0) {
+                out += ':';
+            }
+        }
+        break;
+    case ValueKind::Interval:
+        out += std::to_string(row) + " seconds";
+        break;
+    case ValueKind::Bits:
+        for (size_t i = column.length; i-- > 0;) {
+            out += (i < 64 && ((row >> i) & 1)) ? '1' : '0';
+        }
+        break;
+    case ValueKind::Unsupported:
+        break;
+    }
+}
+
+void DataGenerator::appendField(std::string_view text, std::string& out) const {
+    if (dialect == Dialect::MySQL) {
+        // ESCAPED BY '\\': спецсимволы экранируются, запятая требует кавычек
+        bool enclose = text.find(',') != std::string_view::npos;
+        if (enclose) {
+            out += '"';
+        }
+        for (char c : text) {
+            switch (c) {
+            case '\\':
+                out += "\\\\";
+                break;
+            case '"':
+                out += "\\\"";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            default:
+                out += c;
+            }
+        }
+        if (enclose) {
+            out += '"';
+        }
+        return;
+    }
+
+    // CSV PostgreSQL: NULL - пустое поле без кавычек, поэтому пустая строка всегда в кавычках
+    bool quote = text.empty() || text == "\\." || text.find_first_of(",\"\n\r") != std::string_view::npos;
+    if (!quote) {
+        out.append(text);
+        return;
+    }
+    out += '"';
+    for (char c : text) {
+        if (c == '"') {
+            out += '"';
+        }
+        out += c;
+    }
+    out += '"';
+}
+
+void DataGenerator::writeRows(Json::ArrayIndex table, uint64_t from, uint64_t to, std::string& out) const {
+    const TablePlan& plan = plans[table];
+    std::string field;
+    for (uint64_t row = from; row < to; ++row) {
+        bool first = true;
+        for (size_t c = 0; c < plan.columns.size(); ++c) {
+            if (!plan.columns[c].loaded()) {
+                continue;
+            }
+            if (!first) {
+                out += ',';
+            }
+            first = false;
+            field.clear();
+            if (value(table, c, row, field)) {
+                appendField(field, out);
+            } else if (dialect == Dialect::MySQL) {
+                out += "\\N";
+            }
+        }
+        out += '\n';
+    }
+}
+
+size_t DataGenerator::columnIndex(Json::ArrayIndex table, std::string_view name) const {
+    const auto& columns = plans[table].columns;
+    for (size_t c = 0; c < columns.size(); ++c) {
+        if (equalsIgnoreCase(columns[c].name, name)) {
+            return c;
+        }
+    }
+    return columns.size();
+}
+
+bool DataGenerator::ordered(Json::ArrayIndex table, size_t column) const {
+    const ColumnPlan& plan = plans[table].columns[column];
+    if (plan.array) {
+        return false;
+    }
+    switch (plan.kind) {
+    case ValueKind::Integer:
+    case ValueKind::Decimal:
+    case ValueKind::Float:
+    case ValueKind::Text:
+    case ValueKind::Date:
+    case ValueKind::Timestamp:
+    case ValueKind::Time:
+    case ValueKind::Year:
+    case ValueKind::Uuid:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void DataGenerator::writeLiteral(Json::ArrayIndex table, size_t index, uint64_t row, std::string& out) const {
+    const ColumnPlan& column = plans[table].columns[index];
+    std::string text;
+    if (!value(table, index, row, text)) {
+        out += "NULL";
+        return;
+    }
+    bool number = column.kind == ValueKind::Integer || column.kind == ValueKind::Decimal ||
+                  column.kind == ValueKind::Float || column.kind == ValueKind::Boolean;
+    if (number && !column.array && column.choices.empty()) {
+        out += text;
+        return;
+    }
+    // Строка в кавычках; в MySQL обратная косая черта тоже экранирует
+    out += column.kind == ValueKind::Bits && !column.array ? "B'" : "'";
+    for (char c : text) {
+        if (c == '\'' || (c == '\\' && dialect == Dialect::MySQL)) {
+            out += c;
+        }
+        out += c;
+    }
+    out += '\'';
+}
+
+std::string DataGenerator::insertStatement(Json::ArrayIndex table, uint64_t row) const {
+    const TablePlan& plan = plans[table];
+    std::string sql = "INSERT INTO " + plan.name + " (" + columnList(plan) + ") VALUES (";
+    bool first = true;
+    for (size_t c = 0; c < plan.columns.size(); ++c) {
+        if (!plan.columns[c].loaded()) {
+            continue;
+        }
+        if (!first) {
+            sql += ", ";
+        }
+        first = false;
+        writeLiteral(table, c, row, sql);
+    }
+    sql += ')';
+    return sql;
+}
+
+std::string DataGenerator::columnList(const TablePlan& plan) const {
+    std::string list;
+    for (const auto& column : plan.columns) {
+        if (!column.loaded()) {
+            continue;
+        }
+        if (!list.empty()) {
+            list += ", ";
+        }
+        list += column.name;
+    }
+    return list;
+}
+
+std::string DataGenerator::loadStatement(Json::ArrayIndex table, std::string_view file) const {
+    const TablePlan& plan = plans[table];
+    if (dialect == Dialect::PostgreSQL) {
+        return "COPY " + plan.name + " (" + columnList(plan) + ") FROM STDIN WITH (FORMAT csv)";
+    }
+    std::string path = "'";
+    for (char c : file) {
+        if (c == '\'' || c == '\\') {
+            path += c;
+        }
+        path += c;
+    }
+    path += '\'';
+    return "LOAD DATA LOCAL INFILE " + path + " INTO TABLE " + plan.name +
+           " CHARACTER SET utf8mb4 FIELDS TERMINATED BY ',' OPTIONALLY ENCLOSED BY '\"' ESCAPED BY '\\\\'"
+           " LINES TERMINATED BY '\\n' (" + columnList(plan) + ")";
+}
+
+std::string DataGenerator::finishStatements() const {
+    // AUTO_INCREMENT в MySQL сам сдвигается за явно вставленные значения
+    std::string sql;
+    if (dialect != Dialect::PostgreSQL) {
+        return sql;
+    }
+    for (const auto& plan : plans) {
+        for (const auto& column : plan.columns) {
+            if (column.kind != ValueKind::Integer || !column.unique || plan.rows == 0) {
+                continue;
+            }
+            // Колонка в pg_get_serial_sequence не приводится к нижнему регистру, в отличие от таблицы
+            sql += "SELECT setval(pg_get_serial_sequence('" + plan.name + "', '" + lowerString(column.name) +
+                   "'), max(" + column.name + ")) FROM " + plan.name + ";\n";
+        }
+    }
+    return sql;
+}
+
+DataGenerator::TableStream::TableStream(const DataGenerator& generator, Json::ArrayIndex table, uint64_t first,
+                                        uint64_t last)
+    : generator(generator), table(table), first(first), row(first), last(last) {}
+
+bool DataGenerator::TableStream::next(std::string& chunk, size_t maxBytes) {
+    chunk.clear();
+    while (row < last && chunk.size() < maxBytes) {
+        generator.writeRows(table, row, row + 1, chunk);
+        ++row;
+    }
+    return !chunk.empty();
+}
+
+DataGenerator::TableStream DataGenerator::stream(Json::ArrayIndex table) const {
+    return TableStream(*this, table, 0, plans[table].rows);
+}
+
+} // namespace sql
@@ -0,0 +1,162 @@
+#pragma once
+#include <json/json.h>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Dialect.h"
+#include "Partitioning.h"
+
+namespace sql {
+
+// Синтетические данные по описанию таблиц в CSV для COPY FROM STDIN (PostgreSQL)
+// и LOAD DATA LOCAL INFILE (MySQL). Значение колонки - чистая функция от
+// (seed, таблица, строка, колонка), поэтому таблицы и куски таблиц генерируются
+// независимо и в любом порядке, а ссылка FK вычисляет значение ключа родителя,
+// не читая его из базы. Соблюдаются типы и длины, NOT NULL, уникальность
+// первичных ключей и уникальных индексов, целостность FK и границы разделов.
+// Таблицы без места под уникальные значения (smallint, varchar(2)) обрезаются
+// до числа различных значений.
+class DataGenerator {
+public:
+    struct Options {
+        // Строк в таблице, если для нее не задано иное
+        uint64_t rows = 1000;
+        // Строк по имени таблицы в нижнем регистре
+        std::unordered_map<std::string, uint64_t> tableRows;
+        uint64_t seed = 1;
+        // Доля NULL в необязательных колонках
+        double nullRatio = 0.05;
+        // Относительно нее строятся даты и разделы по периодам
+        CalendarDate today = CalendarDate::today();
+    };
+
+    // Бросает invalid_argument, если для NOT NULL колонки нельзя сгенерировать
+    // значение (неподдерживаемый тип, обязательная ссылка внутри цикла FK)
+    DataGenerator(Dialect dialect, const Json::Value& tables, Options options);
+
+    // Слои загрузки: таблица ссылается только на таблицы прежних слоев и на себя,
+    // таблицы одного слоя можно загружать параллельно
+    const std::vector<std::vector<Json::ArrayIndex>>& layers() const { return loadLayers; }
+    const std::string& tableName(Json::ArrayIndex table) const { return plans[table].name; }
+    uint64_t rowCount(Json::ArrayIndex table) const { return plans[table].rows; }
+    size_t tableCount() const { return plans.size(); }
+
+    // "COPY t (a, b) FROM STDIN WITH (FORMAT csv)" или
+    // "LOAD DATA LOCAL INFILE '<file>' INTO TABLE t ... (a, b)"
+    std::string loadStatement(Json::ArrayIndex table, std::string_view file = "/dev/stdin") const;
+    // После загрузки: счетчики serial-колонок PostgreSQL на максимум загруженных значений
+    std::string finishStatements() const;
+
+    // Дописывает в out строки CSV с номерами [from, to)
+    void writeRows(Json::ArrayIndex table, uint64_t from, uint64_t to, std::string& out) const;
+
+    // Номер колонки по имени без учета регистра; columnCount(table), если ее нет
+    size_t columnIndex(Json::ArrayIndex table, std::string_view name) const;
+    size_t columnCount(Json::ArrayIndex table) const { return plans[table].columns.size(); }
+    const std::string& columnName(Json::ArrayIndex table, size_t column) const {
+        return plans[table].columns[column].name;
+    }
+    // Для колонки есть генератор, иначе в ней NULL или DEFAULT
+    bool generated(Json::ArrayIndex table, size_t column) const { return plans[table].columns[column].loaded(); }
+    // Значения колонки сравнимы по порядку: числа, строки, даты и время
+    bool ordered(Json::ArrayIndex table, size_t column) const;
+    // Строк без повторов уникальных значений. Номера строк от rowCount до rowCapacity
+    // не совпадают по ключам с загруженными и годятся для вставок после загрузки
+    uint64_t rowCapacity(Json::ArrayIndex table) const { return plans[table].capacity; }
+
+    // Литерал SQL значения колонки в строке row: 42, 'text', NULL
+    void writeLiteral(Json::ArrayIndex table, size_t column, uint64_t row, std::string& out) const;
+    // "INSERT INTO t (a, b) VALUES (...)" для строки row, без точки с запятой
+    std::string insertStatement(Json::ArrayIndex table, uint64_t row) const;
+
+    // CSV таблицы кусками, без сборки всей таблицы в памяти
+    class TableStream {
+    public:
+        // Заменяет chunk следующими строками, пока он не дорастет до maxBytes; false - строки кончились
+        bool next(std::string& chunk, size_t maxBytes = 256 * 1024);
+        uint64_t rowsWritten() const { return row - first; }
+
+    private:
+        friend class DataGenerator;
+        TableStream(const DataGenerator& generator, Json::ArrayIndex table, uint64_t first, uint64_t last);
+
+        const DataGenerator& generator;
+        Json::ArrayIndex table;
+        uint64_t first;
+        uint64_t row;
+        uint64_t last;
+    };
+
+    TableStream stream(Json::ArrayIndex table) const;
+
+private:
+    enum class ValueKind {
+        Integer, Decimal, Float, Boolean, Text, Date, Timestamp, Time, Year,
+        Uuid, Json, Binary, Inet, Cidr, MacAddress, Interval, Bits, Unsupported
+    };
+
+    struct ColumnPlan {
+        std::string name;
+        std::string type;
+        ValueKind kind = ValueKind::Unsupported;
+        bool array = false;
+        bool nullable = true;
+        bool hasDefault = false;
+        // Значение выводится из номера строки и не повторяется
+        bool unique = false;
+        // Различных уникальных значений; 0 - без ограничения
+        uint64_t capacity = 0;
+        int64_t maxValue = 0;
+        // Длина строки или битовой строки, 0 - без ограничения
+        size_t length = 0;
+        int scale = 0;
+        // Значения enum, set или разделов list
+        std::vector<std::string> choices;
+        // Полуинтервалы разделов range в единицах вида (дни, секунды, числа)
+        std::vector<std::pair<int64_t, int64_t>> ranges;
+        uint64_t salt = 0;
+
+        // Ссылка FK: значение колонки parentColumn строки родителя
+        bool reference = false;
+        Json::ArrayIndex parentTable = 0;
+        size_t parentColumn = 0;
+        // Строка родителя - номер строки (1:1), разряд номера (составной ключ из FK,
+        // делитель radixDivisor > 0) или случайная
+        bool sameRow = false;
+        uint64_t radixDivisor = 0;
+
+        // Колонки без генератора не попадают в загрузку: в них NULL или DEFAULT
+        bool loaded() const { return kind != ValueKind::Unsupported; }
+    };
+
+    struct TablePlan {
+        std::string name;
+        std::vector<ColumnPlan> columns;
+        uint64_t rows = 0;
+        uint64_t capacity = std::numeric_limits<uint64_t>::max();
+        size_t layer = 0;
+    };
+
+    static void parseType(Dialect dialect, ColumnPlan& column);
+    void planPartitions(const Json::Value& table, TablePlan& plan, std::vector<size_t>& keyColumns) const;
+    void planKeys(const Json::Value& table, Json::ArrayIndex index, const std::vector<bool>& referenced,
+                  const std::vector<size_t>& partitionColumns);
+    std::string columnList(const TablePlan& plan) const;
+
+    // false - NULL; иначе текст значения дописан в out
+    bool value(Json::ArrayIndex table, size_t column, uint64_t row, std::string& out) const;
+    void scalar(const ColumnPlan& column, uint64_t random, std::string& out) const;
+    void uniqueScalar(const ColumnPlan& column, uint64_t row, std::string& out) const;
+    void appendField(std::string_view text, std::string& out) const;
+    uint64_t hash(const ColumnPlan& column, uint64_t row, uint64_t stream) const;
+
+    Dialect dialect;
+    Options options;
+    std::vector<TablePlan> plans;
+    std::vector<std::vector<Json::ArrayIndex>> loadLayers;
+};
+
+} // namespace sql
@@ -0,0 +1,432 @@
+#include "DdlCompiler.h"
+#include "SchemaJson.h"
+#include <algorithm>
+#include <vector>
+
+namespace sql {
+
+namespace {
+
+// Запас на ключевые слова и разделители на таблицу и колонку
+constexpr size_t TABLE_OVERHEAD = 32;
+constexpr size_t COLUMN_OVERHEAD = 64;
+constexpr size_t INDEX_OVERHEAD = 96;
+
+} // namespace
+
+DdlCompiler::DdlCompiler(Dialect dialect) : dialect(dialect) {}
+
+size_t DdlCompiler::estimateSize(const Json::Value& tables) {
+    // Считаем только количество колонок, без обращения к их полям
+    size_t size = 0;
+    for (const auto& table : tables) {
+        size += TABLE_OVERHEAD + table["columns"].size() * COLUMN_OVERHEAD + table["indexes"].size() * INDEX_OVERHEAD;
+    }
+    return size;
+}
+
+size_t DdlCompiler::estimateSize(const CompactSchema& schema) {
+    size_t size = 0;
+    for (const auto& table : schema.tables()) {
+        size += TABLE_OVERHEAD + table.columnCount * COLUMN_OVERHEAD + table.indexCount * INDEX_OVERHEAD;
+    }
+    return size;
+}
+
+std::string DdlCompiler::compile(const Json::Value& tables) const {
+    return compile(CompactSchema(tables));
+}
+
+std::string DdlCompiler::compile(const CompactSchema& schema) const {
+    std::string out;
+    out.reserve(estimateSize(schema));
+    compileTables(schema, out);
+    return out;
+}
+
+void DdlCompiler::compileTables(const Json::Value& tables, std::string& out,
+                                const std::function<bool(std::string_view)>& exists) const {
+    compileTables(CompactSchema(tables), out, exists);
+}
+
+void DdlCompiler::compileTables(const CompactSchema& schema, std::string& out,
+                                const std::function<bool(std::string_view)>& exists) const {
+    if (!schema.tablesIsArray()) {
+        return;
+    }
+    SchemaGraph graph(schema);
+    std::vector<bool> created(schema.tables().size(), false);
+
+    // FK пишется прямо в CREATE TABLE, если цель уже создана; ссылки внутри
+    // цикла добавляются через ALTER TABLE после всех таблиц
+    std::string deferred;
+    for (Json::ArrayIndex index : graph.creationOrder()) {
+        std::string_view tableName = schema.text(schema.tables()[index].name);
+        if (exists && exists(tableName)) {
+            created[index] = true;
+            continue;
+        }
+        std::vector<ForeignKey> inlineKeys;
+        for (const auto& foreignKey : graph.foreignKeys(index)) {
+            if (foreignKey.targetTable == index || created[foreignKey.targetTable]) {
+                inlineKeys.push_back(foreignKey);
+                continue;
+            }
+            deferred += "ALTER TABLE ";
+            deferred.append(tableName);
+            deferred += " ADD ";
+            compileForeignKey(foreignKey, deferred);
+            deferred += ";\n";
+        }
+        compileTable(schema, index, out, inlineKeys);
+        created[index] = true;
+    }
+    out += deferred;
+}
+
+DdlPlan DdlCompiler::planTables(const Json::Value& tables,
+                                const std::function<bool(std::string_view)>& exists) const {
+    return planTables(CompactSchema(tables), exists);
+}
+
+DdlPlan DdlCompiler::planTables(const CompactSchema& schema,
+                                const std::function<bool(std::string_view)>& exists) const {
+    DdlPlan plan;
+    if (!schema.tablesIsArray()) {
+        return plan;
+    }
+    SchemaGraph graph(schema);
+    // Слой созданной таблицы + 1; 0 - таблица еще не создана, существующие - слой 0
+    std::vector<size_t> created(schema.tables().size(), 0);
+    std::string sql;
+    for (Json::ArrayIndex index : graph.creationOrder()) {
+        std::string_view tableName = schema.text(schema.tables()[index].name);
+        if (exists && exists(tableName)) {
+            created[index] = 1;
+            continue;
+        }
+        std::vector<ForeignKey> inlineKeys;
+        size_t layer = 0;
+        for (const auto& foreignKey : graph.foreignKeys(index)) {
+            if (foreignKey.targetTable == index) {
+                inlineKeys.push_back(foreignKey);
+            } else if (created[foreignKey.targetTable] != 0) {
+                inlineKeys.push_back(foreignKey);
+                layer = std::max(layer, created[foreignKey.targetTable]);
+            } else {
+                std::string deferred = "ALTER TABLE ";
+                deferred.append(tableName);
+                deferred += " ADD ";
+                compileForeignKey(foreignKey, deferred);
+                plan.deferred.push_back(std::move(deferred));
+            }
+        }
+        std::stable_sort(inlineKeys.begin(), inlineKeys.end(), [](const ForeignKey& lhs, const ForeignKey& rhs) {
+            return lhs.targetTable < rhs.targetTable;
+        });
+
+        sql.clear();
+        compileTable(schema, index, sql, inlineKeys);
+        if (plan.layers.size() <= layer) {
+            plan.layers.resize(layer + 1);
+        }
+        plan.layers[layer].push_back({std::string(tableName), splitStatements(sql)});
+        created[index] = layer + 1;
+    }
+    return plan;
+}
+
+std::vector<std::string> DdlCompiler::splitStatements(std::string_view sql) const {
+    std::vector<std::string> statements;
+    size_t start = 0;
+    char quote = 0;
+    for (size_t i = 0; i < sql.size(); ++i) {
+        char c = sql[i];
+        if (quote != 0) {
+            // '' внутри строки - та же строка; в MySQL кавычку экранирует и обратная косая черта
+            if (c == '\\' && quote == '\'' && dialect == Dialect::MySQL) {
+                ++i;
+            } else if (c == quote) {
+                quote = 0;
+            }
+            continue;
+        }
+        if (c == '\'' || c == '"' || c == '`') {
+            quote = c;
+        } else if (c == ';') {
+            std::string_view statement = sql.substr(start, i - start);
+            size_t first = statement.find_first_not_of(" \t\r\n");
+            if (first != std::string_view::npos) {
+                statements.emplace_back(statement.substr(first));
+            }
+            start = i + 1;
+        }
+    }
+    std::string_view rest = sql.substr(std::min(start, sql.size()));
+    size_t first = rest.find_first_not_of(" \t\r\n");
+    if (first != std::string_view::npos) {
+        statements.emplace_back(rest.substr(first));
+    }
+    return statements;
+}
+
+void DdlCompiler::compileTable(const CompactSchema& schema, Json::ArrayIndex table, std::string& out,
+                               const std::vector<ForeignKey>& foreignKeys) const {
+    std::string_view tableName = schema.text(schema.tables()[table].name);
+    out += "CREATE TABLE ";
+    out.append(tableName);
+    out += " (";
+
+    // Первичный ключ пишется ограничением таблицы: так один проход
+    // покрывает и обычный, и составной ключ
+    std::vector<std::string_view> primaryKey;
+    bool first = true;
+    for (const auto& column : schema.columns(table)) {
+        if (!first) {
+            out += ", ";
+        }
+        compileColumn(schema, column, out);
+        if (column.has(CompactSchema::PrimaryKey)) {
+            primaryKey.push_back(schema.text(column.name));
+        }
+        first = false;
+    }
+
+    if (!primaryKey.empty()) {
+        out += ", PRIMARY KEY (";
+        for (size_t i = 0; i < primaryKey.size(); ++i) {
+            if (i > 0) {
+                out += ", ";
+            }
+            out.append(primaryKey[i]);
+        }
+        out += ')';
+    }
+
+    for (const auto& foreignKey : foreignKeys) {
+        out += ", ";
+        compileForeignKey(foreignKey, out);
+    }
+
+    out += ')';
+    if (std::optional<PartitionSpec> spec = schema.partitionSpec(table)) {
+        compilePartitioning(tableName, *spec, out);
+    } else {
+        out += ";\n";
+    }
+
+    for (const auto& index : schema.indexDefinitions(table)) {
+        compileIndex(tableName, index, out);
+    }
+}
+
+void DdlCompiler::compileIndex(std::string_view table, const IndexDefinition& index, std::string& out) const {
+    out += index.unique ? "CREATE UNIQUE INDEX " : "CREATE INDEX ";
+    out += index.name;
+    out += " ON ";
+    out.append(table);
+    // В PostgreSQL метод идет перед колонками, в MySQL - после; btree там и там по умолчанию
+    if (dialect == Dialect::PostgreSQL && index.method != "btree") {
+        out += " USING ";
+        out += index.method;
+    }
+    out += " (";
+    for (size_t i = 0; i < index.columns.size(); ++i) {
+        if (i > 0) {
+            out += ", ";
+        }
+        out += index.columns[i];
+    }
+    out += ')';
+    if (dialect == Dialect::MySQL && index.method == "hash") {
+        out += " USING HASH";
+    }
+    if (dialect == Dialect::PostgreSQL && !index.where.empty()) {
+        out += " WHERE ";
+        out += index.where;
+    }
+    out += ";\n";
+}
+
+void DdlCompiler::compileForeignKey(const ForeignKey& foreignKey, std::string& out) const {
+    out += "CONSTRAINT ";
+    out += foreignKey.name;
+    out += " FOREIGN KEY (";
+    out += foreignKey.column;
+    out += ") REFERENCES ";
+    out += foreignKey.targetTableName;
+    out += " (";
+    out += foreignKey.targetColumn;
+    out += ')';
+}
+
+void DdlCompiler::compileColumn(const CompactSchema& schema, const CompactSchema::Column& column,
+                                std::string& out) const {
+    out.append(schema.text(column.name));
+    out += ' ';
+    out.append(schema.type(column));
+
+    if (column.has(CompactSchema::NotNull)) {
+        out += " NOT NULL";
+    }
+    if (column.defaultValue != 0) {
+        out += " DEFAULT ";
+        out.append(schema.text(column.defaultValue));
+    }
+}
+
+void DdlCompiler::compilePartitioning(std::string_view table, const PartitionSpec& spec, std::string& out) const {
+    std::vector<PartitionBound> bounds = spec.initialPartitions(CalendarDate::today());
+    std::string columns;
+    for (size_t i = 0; i < spec.columns.size(); ++i) {
+        if (i > 0) {
+            columns += ", ";
+        }
+        columns += spec.columns[i];
+    }
+
+    if (dialect == Dialect::PostgreSQL) {
+        // Декларативное секционирование: разделы - отдельные таблицы PARTITION OF
+        out += " PARTITION BY ";
+        out += PartitionSpec::strategyName(spec.strategy);
+        out += " (" + columns + ");\n";
+        for (const auto& bound : bounds) {
+            out += "CREATE TABLE ";
+            out.append(table).append(1, '_').append(bound.name);
+            out += ' ';
+            compilePartitionBound(table, spec, bound, out);
+            out += ";\n";
+        }
+        return;
+    }
+
+    // MySQL: KEY вместо HASH, чтобы ключом могла быть колонка любого типа
+    if (spec.strategy == PartitionStrategy::Hash) {
+        out += " PARTITION BY KEY (" + columns + ") PARTITIONS " + std::to_string(std::max(1, spec.modulus)) + ";\n";
+        return;
+    }
+    out += " PARTITION BY ";
+    out += PartitionSpec::strategyName(spec.strategy);
+    out += " COLUMNS(" + columns + ") (";
+    bool first = true;
+    for (const auto& bound : bounds) {
+        // Списку в MySQL раздел по умолчанию не положен
+        if (bound.isDefault && spec.strategy == PartitionStrategy::List) {
+            continue;
+        }
+        if (!first) {
+            out += ", ";
+        }
+        compilePartitionBound(table, spec, bound, out);
+        first = false;
+    }
+    out += ");\n";
+}
+
+void DdlCompiler::compilePartitionBound(std::string_view table, const PartitionSpec& spec,
+                                        const PartitionBound& bound, std::string& out) const {
+    auto joinValues = [&out](const std::vector<std::string>& values) {
+        for (size_t i = 0; i < values.size(); ++i) {
+            if (i > 0) {
+                out += ", ";
+            }
+            out += values[i];
+        }
+    };
+
+    if (dialect == Dialect::PostgreSQL) {
+        out += "PARTITION OF ";
+        out.append(table);
+        if (bound.isDefault) {
+            out += " DEFAULT";
+        } else if (spec.strategy == PartitionStrategy::Hash) {
+            out += " FOR VALUES WITH (MODULUS " + std::to_string(spec.modulus) + ", REMAINDER " +
+                   std::to_string(bound.remainder) + ")";
+        } else if (spec.strategy == PartitionStrategy::List) {
+            out += " FOR VALUES IN (";
+            joinValues(bound.values);
+            out += ')';
+        } else {
+            out += " FOR VALUES FROM (" + (bound.from.empty() ? std::string("MINVALUE") : bound.from) + ") TO (" +
+                   (bound.to.empty() ? std::string("MAXVALUE") : bound.to) + ")";
+        }
+        return;
+    }
+
+    out += "PARTITION ";
+    out += bound.name;
+    if (spec.strategy == PartitionStrategy::List) {
+        out += " VALUES IN (";
+        joinValues(bound.values);
+        out += ')';
+    } else {
+        // MySQL знает только верхнюю границу; раздел по умолчанию - до MAXVALUE
+        out += " VALUES LESS THAN (" + (bound.isDefault || bound.to.empty() ? std::string("MAXVALUE") : bound.to) + ")";
+    }
+}
+
+void DdlCompiler::compilePartitionMaintenance(const Json::Value& table, const std::vector<std::string>& existing,
+                                              CalendarDate today, int ahead, std::string& out) const {
+    std::optional<PartitionSpec> spec = PartitionSpec::fromTable(table);
+    if (!spec) {
+        return;
+    }
+    std::string_view tableName = jsonString(table["name"]);
+
+    std::vector<PartitionBound> missing;
+    for (auto& bound : spec->upcomingPartitions(today, ahead)) {
+        if (std::find(existing.begin(), existing.end(), bound.name) == existing.end()) {
+            missing.push_back(std::move(bound));
+        }
+    }
+    std::vector<std::string> expired = spec->expiredPartitions(existing, today);
+
+    if (dialect == Dialect::PostgreSQL) {
+        for (const auto& bound : missing) {
+            out += "CREATE TABLE IF NOT EXISTS ";
+            out.append(tableName).append(1, '_').append(bound.name);
+            out += ' ';
+            compilePartitionBound(tableName, *spec, bound, out);
+            out += ";\n";
+        }
+        for (const auto& name : expired) {
+            out += "DROP TABLE IF EXISTS ";
+            out.append(tableName).append(1, '_').append(name);
+            out += ";\n";
+        }
+        return;
+    }
+
+    // В MySQL новые разделы должны идти после всех существующих: раздел до MAXVALUE
+    // приходится делить через REORGANIZE
+    if (!missing.empty()) {
+        bool hasDefault = std::find(existing.begin(), existing.end(), "pdefault") != existing.end();
+        out += "ALTER TABLE ";
+        out.append(tableName);
+        out += hasDefault ? " REORGANIZE PARTITION pdefault INTO (" : " ADD PARTITION (";
+        for (size_t i = 0; i < missing.size(); ++i) {
+            if (i > 0) {
+                out += ", ";
+            }
+            compilePartitionBound(tableName, *spec, missing[i], out);
+        }
+        if (hasDefault) {
+            out += ", PARTITION pdefault VALUES LESS THAN (MAXVALUE)";
+        }
+        out += ");\n";
+    }
+    if (!expired.empty()) {
+        out += "ALTER TABLE ";
+        out.append(tableName);
+        out += " DROP PARTITION ";
+        for (size_t i = 0; i < expired.size(); ++i) {
+            if (i > 0) {
+                out += ", ";
+            }
+            out += expired[i];
+        }
+        out += ";\n";
+    }
+}
+
+} // namespace sql
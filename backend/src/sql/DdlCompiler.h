@@ -0,0 +1,84 @@
+#pragma once
+#include <json/json.h>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CompactSchema.h"
+#include "Dialect.h"
+#include "IndexDefinition.h"
+#include "Partitioning.h"
+#include "SchemaGraph.h"
+
+namespace sql {
+
+// DDL одной таблицы отдельными операторами без ';': CREATE TABLE, разделы, индексы
+struct TableDdl {
+    std::string table;
+    std::vector<std::string> statements;
+};
+
+// Создание таблиц слоями по FK: таблица ссылается только на таблицы прежних
+// слоев, на себя и на уже существующие, поэтому таблицы слоя можно создавать
+// одновременно. Ссылки внутри циклов FK - в deferred, после всех слоев
+struct DdlPlan {
+    std::vector<std::vector<TableDdl>> layers;
+    std::vector<std::string> deferred;
+};
+
+// Компилирует описание таблиц (массив tables из схемы или конфига деплоя)
+// в CREATE TABLE, CREATE INDEX и ограничения FK для выбранного диалекта.
+// Таблицы создаются в порядке зависимостей FK. Пишет прямо в выходной буфер,
+// который заранее резервируется по оценке размера. Перегрузки с Json::Value
+// собирают CompactSchema на один вызов; если по таблицам идет несколько
+// проходов, ее лучше собрать один раз и передавать.
+class DdlCompiler {
+public:
+    explicit DdlCompiler(Dialect dialect);
+
+    std::string compile(const Json::Value& tables) const;
+    std::string compile(const CompactSchema& schema) const;
+    // Дописывает DDL в конец out. Таблицы, для которых exists вернул true, уже есть
+    // в базе: они не создаются, но на них можно ссылаться
+    void compileTables(const Json::Value& tables, std::string& out,
+                       const std::function<bool(std::string_view)>& exists = {}) const;
+    void compileTables(const CompactSchema& schema, std::string& out,
+                       const std::function<bool(std::string_view)>& exists = {}) const;
+    // То же, что compileTables, но по слоям и по операторам - для выполнения
+    // через соединения с СУБД. Внутренние FK таблицы идут по номеру целевой
+    // таблицы: параллельные CREATE TABLE блокируют родителей в одном порядке
+    DdlPlan planTables(const Json::Value& tables,
+                       const std::function<bool(std::string_view)>& exists = {}) const;
+    DdlPlan planTables(const CompactSchema& schema,
+                       const std::function<bool(std::string_view)>& exists = {}) const;
+    // Делит SQL на операторы по ';' вне строк и идентификаторов в кавычках
+    std::vector<std::string> splitStatements(std::string_view sql) const;
+    // CREATE TABLE с переданными FK, разделы и индексы таблицы
+    void compileTable(const CompactSchema& schema, Json::ArrayIndex table, std::string& out,
+                      const std::vector<ForeignKey>& foreignKeys = {}) const;
+    // Определение колонки без PRIMARY KEY: "name type [NOT NULL] [DEFAULT x]"
+    void compileColumn(const CompactSchema& schema, const CompactSchema::Column& column, std::string& out) const;
+    // "CREATE [UNIQUE] INDEX ...;\n"
+    void compileIndex(std::string_view table, const IndexDefinition& index, std::string& out) const;
+    // "CONSTRAINT name FOREIGN KEY (column) REFERENCES table (column)"
+    void compileForeignKey(const ForeignKey& foreignKey, std::string& out) const;
+    // Обслуживание разделов по времени: недостающие разделы на ahead периодов вперед
+    // и удаление вышедших за retention. existing - имена уже созданных разделов (p202405)
+    void compilePartitionMaintenance(const Json::Value& table, const std::vector<std::string>& existing,
+                                     CalendarDate today, int ahead, std::string& out) const;
+
+    // Оценка размера DDL сверху, чтобы обойтись одним выделением памяти
+    static size_t estimateSize(const Json::Value& tables);
+    static size_t estimateSize(const CompactSchema& schema);
+
+private:
+    // Хвост CREATE TABLE после списка колонок: PARTITION BY и разделы
+    void compilePartitioning(std::string_view table, const PartitionSpec& spec, std::string& out) const;
+    // Определение раздела: "PARTITION OF t FOR VALUES ..." или "PARTITION p VALUES ..."
+    void compilePartitionBound(std::string_view table, const PartitionSpec& spec, const PartitionBound& bound,
+                               std::string& out) const;
+
+    Dialect dialect;
+};
+
+} // namespace sql
@@ -0,0 +1,30 @@
+#include "Dialect.h"
+#include <algorithm>
+#include <cctype>
+
+namespace sql {
+
+std::optional<Dialect> parseDialect(const std::string& name) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    if (lower == "postgresql" || lower == "postgres" || lower == "pg") {
+        return Dialect::PostgreSQL;
+    }
+    if (lower == "mysql") {
+        return Dialect::MySQL;
+    }
+    return std::nullopt;
+}
+
+const char* dialectName(Dialect dialect) {
+    switch (dialect) {
+    case Dialect::PostgreSQL:
+        return "postgresql";
+    case Dialect::MySQL:
+        return "mysql";
+    }
+    return "unknown";
+}
+
+} // namespace sql
@@ -0,0 +1,17 @@
+#pragma once
+#include <optional>
+#include <string>
+
+namespace sql {
+
+// Диалект SQL, под который генерируется DDL
+enum class Dialect {
+    PostgreSQL,
+    MySQL
+};
+
+// "postgresql"/"postgres"/"pg" или "mysql", регистр не важен
+std::optional<Dialect> parseDialect(const std::string& name);
+const char* dialectName(Dialect dialect);
+
+} // namespace sql
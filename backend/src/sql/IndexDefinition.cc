@@ -0,0 +1,106 @@
+#include "IndexDefinition.h"
+#include "SchemaJson.h"
+#include <algorithm>
+#include <cctype>
+
+namespace sql {
+
+namespace {
+
+std::string lowerString(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+} // namespace
+
+bool IndexDefinition::sameAs(const IndexDefinition& other) const {
+    return unique == other.unique && method == other.method && where == other.where &&
+           columnKeys == other.columnKeys;
+}
+
+std::string generatedIndexName(std::string_view table, const std::vector<std::string>& columns, bool unique) {
+    std::string name(table);
+    for (const auto& column : columns) {
+        name.append(1, '_').append(column);
+    }
+    // Лимит длины идентификатора PostgreSQL - 63 байта
+    name.resize(std::min<size_t>(name.size(), 63 - 4));
+    return name + (unique ? "_key" : "_idx");
+}
+
+bool isIndexMethod(Dialect dialect, std::string_view method) {
+    if (method == "btree" || method == "hash") {
+        return true;
+    }
+    return dialect == Dialect::PostgreSQL && (method == "gin" || method == "brin");
+}
+
+std::vector<IndexDefinition> tableIndexes(const Json::Value& table) {
+    std::string_view tableName = jsonString(table["name"]);
+    std::vector<IndexDefinition> indexes;
+
+    // Ведущие колонки первичного ключа и индексов: по ним уже есть поиск
+    std::vector<std::string> leading;
+    for (const auto& column : table["columns"]) {
+        if (isPrimaryKey(column)) {
+            leading.push_back(matchKey(column));
+            break;
+        }
+    }
+
+    const Json::Value* explicitIndexes = findMember(table, "indexes");
+    if (explicitIndexes != nullptr && explicitIndexes->isArray()) {
+        for (const auto& item : *explicitIndexes) {
+            IndexDefinition index;
+            for (const auto& key : item["columns"]) {
+                const Json::Value* column = findColumn(table, jsonString(key));
+                if (column == nullptr) {
+                    continue;
+                }
+                index.columns.emplace_back(jsonString((*column)["name"]));
+                index.columnKeys.push_back(matchKey(*column));
+            }
+            if (index.columns.empty()) {
+                continue;
+            }
+            index.unique = item.get("unique", false).asBool();
+            std::string_view method = jsonString(item["method"]);
+            if (!method.empty()) {
+                index.method = lowerString(method);
+            }
+            index.where = std::string(jsonString(item["where"]));
+            std::string_view name = jsonString(item["name"]);
+            index.name = name.empty() ? generatedIndexName(tableName, index.columns, index.unique) : std::string(name);
+            // Частичный индекс покрывает не все строки и для FK не годится
+            if (index.where.empty()) {
+                leading.push_back(index.columnKeys.front());
+            }
+            indexes.push_back(std::move(index));
+        }
+    }
+
+    // Без индекса на колонке FK каждое соединение и каждое удаление строки родителя
+    // превращается в полный просмотр дочерней таблицы
+    for (const auto& column : table["columns"]) {
+        if (references(column) == nullptr) {
+            continue;
+        }
+        std::string key = matchKey(column);
+        if (std::find(leading.begin(), leading.end(), key) != leading.end()) {
+            continue;
+        }
+        IndexDefinition index;
+        index.columns.emplace_back(jsonString(column["name"]));
+        index.columnKeys.push_back(key);
+        index.name = generatedIndexName(tableName, index.columns, false);
+        index.automatic = true;
+        leading.push_back(std::move(key));
+        indexes.push_back(std::move(index));
+    }
+    return indexes;
+}
+
+} // namespace sql
@@ -0,0 +1,38 @@
+#pragma once
+#include <json/json.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Dialect.h"
+
+namespace sql {
+
+// Индекс таблицы. В схеме индексы лежат в tables[].indexes:
+// {"name": "...", "columns": ["id или имя колонки", ...], "unique": true,
+//  "method": "btree|hash|gin|brin", "where": "условие частичного индекса"}
+struct IndexDefinition {
+    std::string name;
+    std::vector<std::string> columns;
+    // Ключи сопоставления колонок (id или имя в нижнем регистре) - для diff с учетом переименований
+    std::vector<std::string> columnKeys;
+    bool unique = false;
+    std::string method = "btree";
+    std::string where;
+    // Создан автоматически для колонки внешнего ключа
+    bool automatic = false;
+
+    // Одинаковое определение без учета имени индекса и переименований колонок
+    bool sameAs(const IndexDefinition& other) const;
+};
+
+// Явные индексы таблицы и индексы на колонки с references, если колонку не покрывает
+// первым столбцом первичный ключ или другой индекс. Неразрешимые колонки пропускаются.
+std::vector<IndexDefinition> tableIndexes(const Json::Value& table);
+
+// Имя по соглашению PostgreSQL: <таблица>_<колонки>_idx, для уникальных - _key
+std::string generatedIndexName(std::string_view table, const std::vector<std::string>& columns, bool unique);
+
+// btree и hash в обоих диалектах, gin и brin - только PostgreSQL
+bool isIndexMethod(Dialect dialect, std::string_view method);
+
+} // namespace sql
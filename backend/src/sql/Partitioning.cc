@@ -0,0 +1,296 @@
+#include "Partitioning.h"
+#include "SchemaJson.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+
+namespace sql {
+
+namespace {
+
+std::string lowerString(std::string_view text) {
+    std::string result(text);
+    std::transform(result.begin(), result.end(), result.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return result;
+}
+
+// Число, MINVALUE и MAXVALUE пишутся как есть, остальное - строковым литералом
+std::string boundLiteral(const Json::Value& value) {
+    if (value.isNumeric()) {
+        return value.asString();
+    }
+    std::string text = value.asString();
+    std::string upper = text;
+    std::transform(upper.begin(), upper.end(), upper.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::toupper(c)); });
+    if (upper == "MINVALUE" || upper == "MAXVALUE") {
+        return upper;
+    }
+    std::string literal = "'";
+    for (char c : text) {
+        if (c == '\'') {
+            literal += c;
+        }
+        literal += c;
+    }
+    return literal + "'";
+}
+
+} // namespace
+
+CalendarDate CalendarDate::today() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return fromDays(static_cast<long>(std::chrono::duration_cast<std::chrono::hours>(now).count() / 24));
+}
+
+// Алгоритмы days_from_civil/civil_from_days Говарда Хиннанта
+CalendarDate CalendarDate::fromDays(long days) {
+    days += 719468;
+    long era = (days >= 0 ? days : days - 146096) / 146097;
+    long dayOfEra = days - era * 146097;
+    long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    long monthIndex = (5 * dayOfYear + 2) / 153;
+    CalendarDate date;
+    date.day = static_cast<unsigned>(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    date.month = static_cast<unsigned>(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    date.year = static_cast<int>(yearOfEra + era * 400 + (date.month <= 2 ? 1 : 0));
+    return date;
+}
+
+long CalendarDate::toDays() const {
+    long y = year - (month <= 2 ? 1 : 0);
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yearOfEra = y - era * 400;
+    long dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+std::string CalendarDate::toString() const {
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u", year, month, day);
+    return buffer;
+}
+
+const char* PartitionSpec::strategyName(PartitionStrategy strategy) {
+    switch (strategy) {
+    case PartitionStrategy::Range:
+        return "RANGE";
+    case PartitionStrategy::Hash:
+        return "HASH";
+    case PartitionStrategy::List:
+        return "LIST";
+    }
+    return "RANGE";
+}
+
+std::optional<PartitionSpec> PartitionSpec::fromTable(const Json::Value& table) {
+    const Json::Value* json = findMember(table, "partitioning");
+    if (json == nullptr) {
+        return std::nullopt;
+    }
+    return fromJson(*json, [&table](std::string_view key, std::string& name, std::string& columnKey) {
+        const Json::Value* column = findColumn(table, key);
+        if (column == nullptr) {
+            return false;
+        }
+        name = std::string(jsonString((*column)["name"]));
+        columnKey = matchKey(*column);
+        return true;
+    });
+}
+
+std::optional<PartitionSpec> PartitionSpec::fromJson(const Json::Value& partitioning, const ColumnResolver& resolve) {
+    if (!partitioning.isObject()) {
+        return std::nullopt;
+    }
+
+    PartitionSpec spec;
+    std::string strategy = lowerString(jsonString(partitioning["strategy"]));
+    if (strategy == "hash") {
+        spec.strategy = PartitionStrategy::Hash;
+    } else if (strategy == "list") {
+        spec.strategy = PartitionStrategy::List;
+    }
+    std::string name;
+    std::string columnKey;
+    for (const auto& key : partitioning["columns"]) {
+        if (resolve(jsonString(key), name, columnKey)) {
+            spec.columns.push_back(std::move(name));
+            spec.columnKeys.push_back(std::move(columnKey));
+        }
+    }
+
+    std::string interval = lowerString(jsonString(partitioning["interval"]));
+    if (interval == "day") {
+        spec.interval = PartitionInterval::Day;
+    } else if (interval == "week") {
+        spec.interval = PartitionInterval::Week;
+    } else if (interval == "month") {
+        spec.interval = PartitionInterval::Month;
+    } else if (interval == "year") {
+        spec.interval = PartitionInterval::Year;
+    }
+    spec.modulus = partitioning.get("modulus", 0).asInt();
+    spec.premake = std::max(0, partitioning.get("premake", 0).asInt());
+    spec.retention = std::max(0, partitioning.get("retention", 0).asInt());
+    spec.withDefault = partitioning.get("default", false).asBool();
+
+    for (const auto& item : partitioning["partitions"]) {
+        PartitionBound bound;
+        bound.name = item["name"].asString();
+        if (item.isMember("from")) {
+            bound.from = boundLiteral(item["from"]);
+        }
+        if (item.isMember("to")) {
+            bound.to = boundLiteral(item["to"]);
+        }
+        for (const auto& value : item["values"]) {
+            bound.values.push_back(boundLiteral(value));
+        }
+        spec.partitions.push_back(std::move(bound));
+    }
+    return spec;
+}
+
+CalendarDate PartitionSpec::periodStart(CalendarDate date) const {
+    switch (interval) {
+    case PartitionInterval::Week: {
+        // Неделя с понедельника; 1970-01-01 - четверг
+        long days = date.toDays();
+        long weekday = ((days % 7) + 7 + 3) % 7;
+        return CalendarDate::fromDays(days - weekday);
+    }
+    case PartitionInterval::Month:
+        return CalendarDate{date.year, date.month, 1};
+    case PartitionInterval::Year:
+        return CalendarDate{date.year, 1, 1};
+    default:
+        return date;
+    }
+}
+
+CalendarDate PartitionSpec::addPeriods(CalendarDate start, int count) const {
+    switch (interval) {
+    case PartitionInterval::Day:
+        return CalendarDate::fromDays(start.toDays() + count);
+    case PartitionInterval::Week:
+        return CalendarDate::fromDays(start.toDays() + 7L * count);
+    case PartitionInterval::Month: {
+        long months = static_cast<long>(start.year) * 12 + (start.month - 1) + count;
+        long year = months >= 0 ? months / 12 : (months - 11) / 12;
+        return CalendarDate{static_cast<int>(year), static_cast<unsigned>(months - year * 12 + 1), 1};
+    }
+    case PartitionInterval::Year:
+        return CalendarDate{start.year + count, 1, 1};
+    default:
+        return start;
+    }
+}
+
+std::string PartitionSpec::periodName(CalendarDate start) const {
+    char buffer[16];
+    switch (interval) {
+    case PartitionInterval::Month:
+        std::snprintf(buffer, sizeof(buffer), "p%04d%02u", start.year, start.month);
+        break;
+    case PartitionInterval::Year:
+        std::snprintf(buffer, sizeof(buffer), "p%04d", start.year);
+        break;
+    default:
+        std::snprintf(buffer, sizeof(buffer), "p%04d%02u%02u", start.year, start.month, start.day);
+        break;
+    }
+    return buffer;
+}
+
+std::optional<CalendarDate> PartitionSpec::parsePeriodName(std::string_view name) const {
+    size_t digits = interval == PartitionInterval::Year ? 4 : interval == PartitionInterval::Month ? 6 : 8;
+    if (interval == PartitionInterval::None || name.size() != digits + 1 || name[0] != 'p' ||
+        !std::all_of(name.begin() + 1, name.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); })) {
+        return std::nullopt;
+    }
+    CalendarDate date;
+    date.year = std::stoi(std::string(name.substr(1, 4)));
+    if (digits >= 6) {
+        date.month = static_cast<unsigned>(std::stoi(std::string(name.substr(5, 2))));
+    }
+    if (digits == 8) {
+        date.day = static_cast<unsigned>(std::stoi(std::string(name.substr(7, 2))));
+    }
+    if (date.month < 1 || date.month > 12 || date.day < 1 || date.day > 31) {
+        return std::nullopt;
+    }
+    return date;
+}
+
+PartitionBound PartitionSpec::periodPartition(CalendarDate start) const {
+    PartitionBound bound;
+    bound.name = periodName(start);
+    bound.from = "'" + start.toString() + "'";
+    bound.to = "'" + addPeriods(start, 1).toString() + "'";
+    return bound;
+}
+
+std::vector<PartitionBound> PartitionSpec::upcomingPartitions(CalendarDate today, int ahead) const {
+    std::vector<PartitionBound> bounds;
+    if (strategy != PartitionStrategy::Range || interval == PartitionInterval::None) {
+        return bounds;
+    }
+    CalendarDate current = periodStart(today);
+    for (int i = 0; i <= ahead; ++i) {
+        bounds.push_back(periodPartition(addPeriods(current, i)));
+    }
+    return bounds;
+}
+
+std::vector<PartitionBound> PartitionSpec::initialPartitions(CalendarDate today) const {
+    // Разделы hash всегда p0..p<modulus-1>: явный список для них не нужен
+    std::vector<PartitionBound> bounds = strategy == PartitionStrategy::Hash ? std::vector<PartitionBound>() : partitions;
+    auto exists = [&bounds](const std::string& name) {
+        return std::any_of(bounds.begin(), bounds.end(),
+                           [&name](const PartitionBound& bound) { return bound.name == name; });
+    };
+
+    if (strategy == PartitionStrategy::Hash) {
+        for (int i = 0; i < modulus; ++i) {
+            PartitionBound bound;
+            bound.name = "p" + std::to_string(i);
+            bound.remainder = i;
+            bounds.push_back(std::move(bound));
+        }
+    }
+    for (auto& bound : upcomingPartitions(today, premake)) {
+        if (!exists(bound.name)) {
+            bounds.push_back(std::move(bound));
+        }
+    }
+    if (withDefault && strategy != PartitionStrategy::Hash) {
+        PartitionBound bound;
+        bound.name = "pdefault";
+        bound.isDefault = true;
+        bounds.push_back(std::move(bound));
+    }
+    return bounds;
+}
+
+std::vector<std::string> PartitionSpec::expiredPartitions(const std::vector<std::string>& existing,
+                                                          CalendarDate today) const {
+    std::vector<std::string> expired;
+    if (retention <= 0 || strategy != PartitionStrategy::Range || interval == PartitionInterval::None) {
+        return expired;
+    }
+    long oldest = addPeriods(periodStart(today), -retention).toDays();
+    for (const auto& name : existing) {
+        std::optional<CalendarDate> start = parsePeriodName(name);
+        if (start && start->toDays() < oldest) {
+            expired.push_back(name);
+        }
+    }
+    return expired;
+}
+
+} // namespace sql
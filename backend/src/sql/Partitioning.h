@@ -0,0 +1,87 @@
+#pragma once
+#include <json/json.h>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sql {
+
+// Календарная дата (UTC) для разделов по времени
+struct CalendarDate {
+    int year = 1970;
+    unsigned month = 1;
+    unsigned day = 1;
+
+    static CalendarDate today();
+    static CalendarDate fromDays(long days);
+    // Дни от 1970-01-01
+    long toDays() const;
+    // 'YYYY-MM-DD'
+    std::string toString() const;
+};
+
+enum class PartitionStrategy { Range, Hash, List };
+enum class PartitionInterval { None, Day, Week, Month, Year };
+
+// Один раздел. name - имя раздела в MySQL и суффикс таблицы-раздела в PostgreSQL
+struct PartitionBound {
+    std::string name;
+    // range: SQL-литералы границ [from, to)
+    std::string from;
+    std::string to;
+    // list: SQL-литералы значений
+    std::vector<std::string> values;
+    // hash: остаток от деления
+    int remainder = 0;
+    bool isDefault = false;
+};
+
+// Секционирование таблицы. В схеме лежит в tables[].partitioning:
+// {"strategy": "range|hash|list", "columns": ["id или имя колонки"],
+//  "interval": "day|week|month|year", "premake": 3, "retention": 12,
+//  "modulus": 8, "default": true,
+//  "partitions": [{"name": "p2023", "from": "2023-01-01", "to": "2024-01-01"},
+//                 {"name": "eu", "values": ["de", "fr"]}]}
+// interval - разделы по периодам для range по дате; premake - сколько будущих
+// периодов создать заранее; retention - сколько прошедших периодов хранить.
+struct PartitionSpec {
+    PartitionStrategy strategy = PartitionStrategy::Range;
+    std::vector<std::string> columns;
+    std::vector<std::string> columnKeys;
+    PartitionInterval interval = PartitionInterval::None;
+    int modulus = 0;
+    int premake = 0;
+    int retention = 0;
+    bool withDefault = false;
+    std::vector<PartitionBound> partitions;
+
+    // Ключ колонки из partitioning.columns -> имя и ключ сопоставления; false - колонки нет
+    using ColumnResolver = std::function<bool(std::string_view key, std::string& name, std::string& columnKey)>;
+
+    // nullopt - таблица не секционирована. Неразрешимые колонки пропускаются
+    static std::optional<PartitionSpec> fromTable(const Json::Value& table);
+    // То же по самому объекту partitioning; колонки ищет resolve
+    static std::optional<PartitionSpec> fromJson(const Json::Value& partitioning, const ColumnResolver& resolve);
+
+    // Явные разделы, разделы hash, периоды от текущего до premake вперед и раздел по умолчанию
+    std::vector<PartitionBound> initialPartitions(CalendarDate today) const;
+    // Периоды от текущего до ahead вперед
+    std::vector<PartitionBound> upcomingPartitions(CalendarDate today, int ahead) const;
+    // Разделы периодов из existing, которые старше окна retention
+    std::vector<std::string> expiredPartitions(const std::vector<std::string>& existing, CalendarDate today) const;
+
+    // Имена разделов периодов: p20240501 для дней и недель, p202405 для месяцев, p2024 для лет
+    std::string periodName(CalendarDate start) const;
+    std::optional<CalendarDate> parsePeriodName(std::string_view name) const;
+
+    static const char* strategyName(PartitionStrategy strategy);
+
+private:
+    CalendarDate periodStart(CalendarDate date) const;
+    CalendarDate addPeriods(CalendarDate start, int count) const;
+    PartitionBound periodPartition(CalendarDate start) const;
+};
+
+} // namespace sql
@@ -0,0 +1,271 @@
+#include "SchemaDiff.h"
+#include "DdlCompiler.h"
+#include "IndexDefinition.h"
+#include "SchemaGraph.h"
+#include "SchemaJson.h"
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+namespace sql {
+
+namespace {
+
+using Column = CompactSchema::Column;
+
+std::string name(const CompactSchema& schema, CompactSchema::Name value) {
+    return std::string(schema.text(value));
+}
+
+// Имена равны без учета регистра: строки в нижнем регистре из пулов двух схем
+bool sameName(const CompactSchema& fromSchema, CompactSchema::Name from, const CompactSchema& toSchema,
+              CompactSchema::Name to) {
+    return fromSchema.text(fromSchema.lowered(from)) == toSchema.text(toSchema.lowered(to));
+}
+
+template <typename Items>
+std::unordered_map<std::string, Json::ArrayIndex> indexByKey(const CompactSchema& schema, const Items& items) {
+    std::unordered_map<std::string, Json::ArrayIndex> index;
+    index.reserve(items.size());
+    for (Json::ArrayIndex i = 0; i < items.size(); ++i) {
+        index.emplace(schema.key(items[i]), i);
+    }
+    return index;
+}
+
+std::string primaryKeyColumns(const CompactSchema& schema, Json::ArrayIndex table) {
+    std::string columns;
+    for (const auto& column : schema.columns(table)) {
+        if (column.has(CompactSchema::PrimaryKey)) {
+            if (!columns.empty()) {
+                columns += ", ";
+            }
+            columns.append(schema.text(column.name));
+        }
+    }
+    return columns;
+}
+
+} // namespace
+
+SchemaDiff::SchemaDiff(Dialect dialect) : dialect(dialect) {}
+
+std::vector<std::string> SchemaDiff::diff(const Json::Value& fromTables, const Json::Value& toTables) const {
+    return diff(CompactSchema(fromTables), CompactSchema(toTables));
+}
+
+std::vector<std::string> SchemaDiff::diff(const CompactSchema& from, const CompactSchema& to) const {
+    std::vector<std::string> foreignKeyDrops;
+    std::vector<std::string> indexDrops;
+    std::vector<std::string> renames;
+    std::vector<std::string> creates;
+    std::vector<std::string> alters;
+    std::vector<std::string> indexCreates;
+    std::vector<std::string> foreignKeyAdds;
+    std::vector<std::string> drops;
+
+    auto fromIndex = indexByKey(from, from.tables());
+    auto toIndex = indexByKey(to, to.tables());
+    SchemaGraph fromGraph(from);
+    SchemaGraph toGraph(to);
+    DdlCompiler compiler(dialect);
+
+    for (Json::ArrayIndex i : toGraph.creationOrder()) {
+        const CompactSchema::Table& table = to.tables()[i];
+        auto it = fromIndex.find(to.key(table));
+        if (it == fromIndex.end()) {
+            // FK новых таблиц добавляются после всех CREATE и ALTER: цель может еще не существовать
+            std::string statement;
+            compiler.compileTable(to, i, statement);
+            creates.push_back(std::move(statement));
+            for (const auto& foreignKey : toGraph.foreignKeys(i)) {
+                foreignKeyAdds.push_back(addForeignKey(name(to, table.name), foreignKey));
+            }
+            continue;
+        }
+        const CompactSchema::Table& previous = from.tables()[it->second];
+        if (!sameName(from, previous.name, to, table.name)) {
+            renames.push_back("ALTER TABLE " + name(from, previous.name) + " RENAME TO " + name(to, table.name) +
+                              ";\n");
+        }
+        diffTable(from, it->second, to, i, alters);
+        diffIndexes(from, it->second, to, i, indexDrops, indexCreates);
+        diffForeignKeys(name(from, previous.name), fromGraph.foreignKeys(it->second), name(to, table.name),
+                        toGraph.foreignKeys(i), foreignKeyDrops, foreignKeyAdds);
+    }
+
+    // Удаляем в обратном порядке зависимостей: ссылающиеся таблицы раньше тех, на которые они ссылаются
+    const auto& fromOrder = fromGraph.creationOrder();
+    for (auto it = fromOrder.rbegin(); it != fromOrder.rend(); ++it) {
+        const CompactSchema::Table& table = from.tables()[*it];
+        if (toIndex.count(from.key(table)) == 0) {
+            drops.push_back("DROP TABLE " + name(from, table.name) + ";\n");
+        }
+    }
+
+    // Ограничения и индексы удаляются до переименований - по старым именам,
+    // а создаются после ALTER TABLE, когда все колонки уже на месте
+    std::vector<std::string> statements;
+    for (auto* group : {&foreignKeyDrops, &indexDrops, &renames, &creates, &alters, &indexCreates,
+                        &foreignKeyAdds, &drops}) {
+        std::move(group->begin(), group->end(), std::back_inserter(statements));
+    }
+    return statements;
+}
+
+void SchemaDiff::diffIndexes(const CompactSchema& fromSchema, Json::ArrayIndex from, const CompactSchema& toSchema,
+                             Json::ArrayIndex to, std::vector<std::string>& drops,
+                             std::vector<std::string>& creates) const {
+    // Индексы сравниваются по определению: переименование таблицы или колонки их не пересоздает
+    std::vector<IndexDefinition> fromIndexes = fromSchema.indexDefinitions(from);
+    std::vector<IndexDefinition> toIndexes = toSchema.indexDefinitions(to);
+    std::string fromTable = name(fromSchema, fromSchema.tables()[from].name);
+    std::string toTable = name(toSchema, toSchema.tables()[to].name);
+    auto contains = [](const std::vector<IndexDefinition>& indexes, const IndexDefinition& index) {
+        return std::any_of(indexes.begin(), indexes.end(),
+                           [&index](const IndexDefinition& other) { return other.sameAs(index); });
+    };
+
+    for (const auto& index : fromIndexes) {
+        if (!contains(toIndexes, index)) {
+            drops.push_back(dialect == Dialect::MySQL ? "DROP INDEX " + index.name + " ON " + fromTable + ";\n"
+                                                      : "DROP INDEX IF EXISTS " + index.name + ";\n");
+        }
+    }
+    DdlCompiler compiler(dialect);
+    for (const auto& index : toIndexes) {
+        if (!contains(fromIndexes, index)) {
+            std::string statement;
+            compiler.compileIndex(toTable, index, statement);
+            creates.push_back(std::move(statement));
+        }
+    }
+}
+
+void SchemaDiff::diffForeignKeys(const std::string& fromTable, const std::vector<ForeignKey>& from,
+                                 const std::string& toTable, const std::vector<ForeignKey>& to,
+                                 std::vector<std::string>& drops, std::vector<std::string>& adds) const {
+    // Ключ не меняется, если та же колонка ссылается на ту же колонку той же таблицы
+    auto find = [](const std::vector<ForeignKey>& keys, const ForeignKey& key) {
+        return std::find_if(keys.begin(), keys.end(), [&key](const ForeignKey& other) {
+            return other.columnKey == key.columnKey && other.targetKey == key.targetKey;
+        }) != keys.end();
+    };
+
+    for (const auto& key : from) {
+        if (!find(to, key)) {
+            drops.push_back("ALTER TABLE " + fromTable +
+                            (dialect == Dialect::MySQL ? " DROP FOREIGN KEY " : " DROP CONSTRAINT IF EXISTS ") +
+                            key.name + ";\n");
+        }
+    }
+    for (const auto& key : to) {
+        if (!find(from, key)) {
+            adds.push_back(addForeignKey(toTable, key));
+        }
+    }
+}
+
+std::string SchemaDiff::addForeignKey(const std::string& table, const ForeignKey& foreignKey) const {
+    std::string statement = "ALTER TABLE " + table + " ADD ";
+    DdlCompiler(dialect).compileForeignKey(foreignKey, statement);
+    statement += ";\n";
+    return statement;
+}
+
+void SchemaDiff::diffTable(const CompactSchema& fromSchema, Json::ArrayIndex from, const CompactSchema& toSchema,
+                           Json::ArrayIndex to, std::vector<std::string>& statements) const {
+    const std::string table = name(toSchema, toSchema.tables()[to].name);
+    auto fromColumns = fromSchema.columns(from);
+    auto toColumns = toSchema.columns(to);
+    auto fromIndex = indexByKey(fromSchema, fromColumns);
+    auto toIndex = indexByKey(toSchema, toColumns);
+    DdlCompiler compiler(dialect);
+
+    // Переименования колонок идут отдельными операторами, остальное - одним ALTER TABLE
+    std::vector<std::string> actions;
+    std::string oldPrimaryKey = primaryKeyColumns(fromSchema, from);
+    std::string newPrimaryKey = primaryKeyColumns(toSchema, to);
+    if (oldPrimaryKey != newPrimaryKey && !oldPrimaryKey.empty()) {
+        actions.push_back(dialect == Dialect::MySQL
+                              ? "DROP PRIMARY KEY"
+                              : "DROP CONSTRAINT " + name(fromSchema, fromSchema.tables()[from].name) + "_pkey");
+    }
+
+    for (const auto& column : fromColumns) {
+        if (toIndex.count(fromSchema.key(column)) == 0) {
+            actions.push_back("DROP COLUMN " + name(fromSchema, column.name));
+        }
+    }
+
+    for (const auto& column : toColumns) {
+        auto it = fromIndex.find(toSchema.key(column));
+        if (it == fromIndex.end()) {
+            std::string action = "ADD COLUMN ";
+            compiler.compileColumn(toSchema, column, action);
+            actions.push_back(std::move(action));
+            continue;
+        }
+        const Column& previous = fromColumns[it->second];
+        if (!sameName(fromSchema, previous.name, toSchema, column.name)) {
+            statements.push_back("ALTER TABLE " + table + " RENAME COLUMN " + name(fromSchema, previous.name) +
+                                 " TO " + name(toSchema, column.name) + ";\n");
+        }
+        alterColumn(fromSchema, previous, toSchema, column, actions);
+    }
+
+    if (oldPrimaryKey != newPrimaryKey && !newPrimaryKey.empty()) {
+        actions.push_back("ADD PRIMARY KEY (" + newPrimaryKey + ")");
+    }
+
+    if (actions.empty()) {
+        return;
+    }
+    std::string statement = "ALTER TABLE " + table + " ";
+    for (size_t i = 0; i < actions.size(); ++i) {
+        if (i > 0) {
+            statement += ", ";
+        }
+        statement += actions[i];
+    }
+    statement += ";\n";
+    statements.push_back(std::move(statement));
+}
+
+void SchemaDiff::alterColumn(const CompactSchema& fromSchema, const Column& from, const CompactSchema& toSchema,
+                             const Column& to, std::vector<std::string>& actions) const {
+    std::string column = name(toSchema, to.name);
+    std::string_view oldType = fromSchema.type(from);
+    std::string_view newType = toSchema.type(to);
+    bool typeChanged = !equalsIgnoreCase(oldType, newType);
+    bool notNullChanged = from.has(CompactSchema::NotNull) != to.has(CompactSchema::NotNull);
+    std::string_view oldDefault = fromSchema.text(from.defaultValue);
+    std::string_view newDefault = toSchema.text(to.defaultValue);
+    bool defaultChanged = oldDefault != newDefault;
+
+    if (!typeChanged && !notNullChanged && !defaultChanged) {
+        return;
+    }
+
+    if (dialect == Dialect::MySQL) {
+        // MySQL меняет колонку целиком одним MODIFY
+        std::string action = "MODIFY COLUMN ";
+        DdlCompiler(dialect).compileColumn(toSchema, to, action);
+        actions.push_back(std::move(action));
+        return;
+    }
+
+    if (typeChanged) {
+        actions.push_back("ALTER COLUMN " + column + " TYPE " + std::string(newType));
+    }
+    if (notNullChanged) {
+        actions.push_back("ALTER COLUMN " + column +
+                          (to.has(CompactSchema::NotNull) ? " SET NOT NULL" : " DROP NOT NULL"));
+    }
+    if (defaultChanged) {
+        actions.push_back("ALTER COLUMN " + column +
+                          (newDefault.empty() ? std::string(" DROP DEFAULT") : " SET DEFAULT " + std::string(newDefault)));
+    }
+}
+
+} // namespace sql
@@ -0,0 +1,38 @@
+#pragma once
+#include <json/json.h>
+#include <string>
+#include <vector>
+#include "Dialect.h"
+#include "SchemaGraph.h"
+
+namespace sql {
+
+// Сравнивает две версии массива tables и выдаёт минимальный упорядоченный
+// набор DDL для перехода от старой версии к новой:
+// удаление FK и индексов -> переименования -> новые таблицы -> ALTER TABLE по таблицам ->
+// новые индексы и FK -> удаление таблиц.
+// Таблицы и колонки сопоставляются по id (конструктор), иначе по имени.
+class SchemaDiff {
+public:
+    explicit SchemaDiff(Dialect dialect);
+
+    std::vector<std::string> diff(const Json::Value& fromTables, const Json::Value& toTables) const;
+    std::vector<std::string> diff(const CompactSchema& from, const CompactSchema& to) const;
+
+private:
+    void diffTable(const CompactSchema& fromSchema, Json::ArrayIndex from, const CompactSchema& toSchema,
+                   Json::ArrayIndex to, std::vector<std::string>& statements) const;
+    void alterColumn(const CompactSchema& fromSchema, const CompactSchema::Column& from,
+                     const CompactSchema& toSchema, const CompactSchema::Column& to,
+                     std::vector<std::string>& actions) const;
+    void diffIndexes(const CompactSchema& fromSchema, Json::ArrayIndex from, const CompactSchema& toSchema,
+                     Json::ArrayIndex to, std::vector<std::string>& drops, std::vector<std::string>& creates) const;
+    void diffForeignKeys(const std::string& fromTable, const std::vector<ForeignKey>& from,
+                         const std::string& toTable, const std::vector<ForeignKey>& to,
+                         std::vector<std::string>& drops, std::vector<std::string>& adds) const;
+    std::string addForeignKey(const std::string& table, const ForeignKey& foreignKey) const;
+
+    Dialect dialect;
+};
+
+} // namespace sql
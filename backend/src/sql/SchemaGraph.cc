@@ -0,0 +1,94 @@
+#include "SchemaGraph.h"
+#include <algorithm>
+
+namespace sql {
+
+SchemaGraph::SchemaGraph(const CompactSchema& schema) : schema(schema) {
+    keys.resize(schema.tables().size());
+    resolve();
+    sort();
+}
+
+SchemaGraph::SchemaGraph(const Json::Value& tables)
+    : owned(std::make_unique<const CompactSchema>(tables)), schema(*owned) {
+    keys.resize(schema.tables().size());
+    resolve();
+    sort();
+}
+
+std::optional<Json::ArrayIndex> SchemaGraph::findTable(std::string_view key) const {
+    return schema.findTable(key);
+}
+
+std::string SchemaGraph::foreignKeyName(std::string_view table, std::string_view column) {
+    std::string name;
+    name.append(table).append(1, '_').append(column);
+    // Лимит длины идентификатора PostgreSQL - 63 байта
+    name.resize(std::min<size_t>(name.size(), 63 - 5));
+    return name + "_fkey";
+}
+
+void SchemaGraph::resolve() {
+    // Ссылки разрешены при сборке CompactSchema: остается собрать имена
+    const auto& tables = schema.tables();
+    const auto& columns = schema.columns();
+    for (Json::ArrayIndex i = 0; i < tables.size(); ++i) {
+        std::string_view tableName = schema.text(tables[i].name);
+        for (const auto& column : schema.columns(i)) {
+            if (column.targetTable == CompactSchema::NONE) {
+                continue;
+            }
+            const CompactSchema::Table& targetTable = tables[column.targetTable];
+            const CompactSchema::Column& targetColumn = columns[column.targetColumn];
+
+            ForeignKey key;
+            key.column = std::string(schema.text(column.name));
+            key.columnKey = schema.key(column);
+            key.name = foreignKeyName(tableName, key.column);
+            key.targetTable = column.targetTable;
+            key.targetTableName = std::string(schema.text(targetTable.name));
+            key.targetColumn = std::string(schema.text(targetColumn.name));
+            key.targetKey = schema.key(targetTable) + "." + schema.key(targetColumn);
+            keys[i].push_back(std::move(key));
+        }
+    }
+}
+
+void SchemaGraph::sort() {
+    // Алгоритм Кана: сначала таблицы без исходящих ссылок. Самоссылки не мешают
+    // созданию, а таблицы из циклов дописываются в конец - их FK создаются отдельно
+    std::vector<size_t> pending(keys.size(), 0);
+    std::vector<std::vector<Json::ArrayIndex>> dependents(keys.size());
+    for (Json::ArrayIndex i = 0; i < keys.size(); ++i) {
+        for (const auto& key : keys[i]) {
+            if (key.targetTable != i) {
+                ++pending[i];
+                dependents[key.targetTable].push_back(i);
+            }
+        }
+    }
+
+    order.reserve(keys.size());
+    std::vector<bool> placed(keys.size(), false);
+    for (Json::ArrayIndex i = 0; i < keys.size(); ++i) {
+        if (pending[i] == 0) {
+            order.push_back(i);
+            placed[i] = true;
+        }
+    }
+    for (size_t next = 0; next < order.size(); ++next) {
+        for (Json::ArrayIndex dependent : dependents[order[next]]) {
+            if (--pending[dependent] == 0) {
+                order.push_back(dependent);
+                placed[dependent] = true;
+            }
+        }
+    }
+    for (Json::ArrayIndex i = 0; i < keys.size(); ++i) {
+        if (!placed[i]) {
+            order.push_back(i);
+        }
+    }
+}
+
+} // namespace sql
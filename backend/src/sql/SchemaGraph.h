@@ -0,0 +1,54 @@
+#pragma once
+#include <json/json.h>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "CompactSchema.h"
+
+namespace sql {
+
+// Внешний ключ колонки с разрешенными именами
+struct ForeignKey {
+    std::string name;
+    std::string column;
+    // Ключ сопоставления ссылающейся колонки
+    std::string columnKey;
+    Json::ArrayIndex targetTable = 0;
+    std::string targetTableName;
+    std::string targetColumn;
+
+    // Куда ссылается ключ с точностью до переименований: ключи сопоставления таблицы и колонки
+    std::string targetKey;
+};
+
+// Связи между таблицами массива tables: ссылки columns[].references по id или
+// имени, разрешенные в имена, и порядок создания таблиц по зависимостям FK.
+// Битые ссылки пропускаются: о них сообщает SchemaValidator. schema должна жить дольше графа.
+class SchemaGraph {
+public:
+    explicit SchemaGraph(const CompactSchema& schema);
+    // Строит CompactSchema из tables и держит ее сам
+    explicit SchemaGraph(const Json::Value& tables);
+
+    const std::vector<ForeignKey>& foreignKeys(Json::ArrayIndex table) const { return keys[table]; }
+    // Каждая таблица идет после тех, на которые ссылается; таблицы из циклов - в конце в исходном порядке
+    const std::vector<Json::ArrayIndex>& creationOrder() const { return order; }
+    // Таблица по id или имени без учета регистра
+    std::optional<Json::ArrayIndex> findTable(std::string_view key) const;
+
+    // Имя ограничения по соглашению PostgreSQL: <таблица>_<колонка>_fkey
+    static std::string foreignKeyName(std::string_view table, std::string_view column);
+
+private:
+    void resolve();
+    void sort();
+
+    std::unique_ptr<const CompactSchema> owned;
+    const CompactSchema& schema;
+    std::vector<std::vector<ForeignKey>> keys;
+    std::vector<Json::ArrayIndex> order;
+};
+
+} // namespace sql
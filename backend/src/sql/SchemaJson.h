@@ -0,0 +1,107 @@
+#pragma once
+#include <json/json.h>
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <string_view>
+
+namespace sql {
+
+// Доступ к полям таблиц и колонок. Конструктор на фронтенде пишет camelCase
+// (isPrimaryKey, isNotNull, defaultValue), конфиги деплоя - snake_case.
+
+inline std::string_view jsonString(const Json::Value& value) {
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    if (value.isString() && value.getString(&begin, &end)) {
+        return std::string_view(begin, static_cast<size_t>(end - begin));
+    }
+    return std::string_view();
+}
+
+// Поиск поля без создания временной std::string; nullptr, если поля нет
+inline const Json::Value* findMember(const Json::Value& object, std::string_view key) {
+    return object.isObject() ? object.find(key.data(), key.data() + key.size()) : nullptr;
+}
+
+inline bool jsonFlag(const Json::Value& object, std::string_view snakeKey, std::string_view camelKey) {
+    const Json::Value* value = findMember(object, snakeKey);
+    if (value == nullptr) {
+        value = findMember(object, camelKey);
+    }
+    return value != nullptr && value->isBool() && value->asBool();
+}
+
+inline bool isPrimaryKey(const Json::Value& column) {
+    return jsonFlag(column, "primary_key", "isPrimaryKey");
+}
+
+inline bool isNotNull(const Json::Value& column) {
+    return jsonFlag(column, "not_null", "isNotNull");
+}
+
+// Значение по умолчанию или nullptr, если оно не задано
+inline const Json::Value* defaultValue(const Json::Value& column) {
+    const Json::Value* value = findMember(column, "default");
+    if (value == nullptr) {
+        value = findMember(column, "defaultValue");
+    }
+    if (value == nullptr || value->isNull() || (value->isString() && jsonString(*value).empty())) {
+        return nullptr;
+    }
+    return value;
+}
+
+inline bool equalsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    return lhs.size() == rhs.size() &&
+           std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](char a, char b) {
+               return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+           });
+}
+
+// Ключ сопоставления таблицы или колонки между версиями: id, если он есть, иначе имя в нижнем регистре
+inline std::string matchKey(const Json::Value& value) {
+    std::string_view id = jsonString(value["id"]);
+    if (!id.empty()) {
+        return "#" + std::string(id);
+    }
+    std::string name(jsonString(value["name"]));
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return name;
+}
+
+// Колонка таблицы по id (конструктор) или по имени без учета регистра; nullptr, если нет
+inline const Json::Value* findColumn(const Json::Value& table, std::string_view key) {
+    if (key.empty()) {
+        return nullptr;
+    }
+    const Json::Value& columns = table["columns"];
+    for (const auto& column : columns) {
+        if (jsonString(column["id"]) == key) {
+            return &column;
+        }
+    }
+    for (const auto& column : columns) {
+        if (equalsIgnoreCase(jsonString(column["name"]), key)) {
+            return &column;
+        }
+    }
+    return nullptr;
+}
+
+// Ссылка FK колонки или nullptr. Конструктор пишет tableId/columnId, конфиги - table/column
+inline const Json::Value* references(const Json::Value& column) {
+    const Json::Value* value = findMember(column, "references");
+    return value != nullptr && value->isObject() ? value : nullptr;
+}
+
+inline std::string_view referenceKey(const Json::Value& reference, std::string_view key, std::string_view fallbackKey) {
+    const Json::Value* value = findMember(reference, key);
+    if (value == nullptr || !value->isString()) {
+        value = findMember(reference, fallbackKey);
+    }
+    return value != nullptr ? jsonString(*value) : std::string_view();
+}
+
+} // namespace sql
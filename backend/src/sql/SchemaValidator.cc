@@ -0,0 +1,543 @@
+#include "SchemaValidator.h"
+#include "IndexDefinition.h"
+#include "Partitioning.h"
+#include "SchemaJson.h"
+#include <algorithm>
+#include <cctype>
+
+namespace sql {
+
+namespace {
+
+const std::unordered_set<std::string>& postgresTypes() {
+    static const std::unordered_set<std::string> types = {
+        "smallint", "int2", "integer", "int", "int4", "bigint", "int8",
+        "smallserial", "serial2", "serial", "serial4", "bigserial", "serial8",
+        "decimal", "numeric", "real", "float4", "double precision", "float8", "float", "money",
+        "text", "varchar", "character varying", "char", "character", "bpchar", "citext",
+        "bytea", "boolean", "bool",
+        "date", "time", "timetz", "time with time zone", "time without time zone",
+        "timestamp", "timestamptz", "timestamp with time zone", "timestamp without time zone",
+        "interval", "uuid", "json", "jsonb", "xml",
+        "inet", "cidr", "macaddr", "macaddr8",
+        "point", "line", "lseg", "box", "path", "polygon", "circle",
+        "tsvector", "tsquery", "bit", "bit varying", "varbit",
+        "int4range", "int8range", "numrange", "tsrange", "tstzrange", "daterange", "oid"
+    };
+    return types;
+}
+
+const std::unordered_set<std::string>& mysqlTypes() {
+    static const std::unordered_set<std::string> types = {
+        "tinyint", "smallint", "mediumint", "int", "integer", "bigint", "serial",
+        "decimal", "dec", "numeric", "fixed", "float", "double", "double precision", "real",
+        "bit", "bool", "boolean",
+        "date", "datetime", "timestamp", "time", "year",
+        "char", "varchar", "binary", "varbinary",
+        "tinyblob", "blob", "mediumblob", "longblob",
+        "tinytext", "text", "mediumtext", "longtext",
+        "enum", "set", "json",
+        "geometry", "point", "linestring", "polygon"
+    };
+    return types;
+}
+
+// "VARCHAR(255)" -> "varchar", "timestamp(3) with  time zone" -> "timestamp with time zone",
+// "int[]" -> "int", "int unsigned" -> "int"
+std::string normalizeType(std::string_view type) {
+    std::string result;
+    result.reserve(type.size());
+    int depth = 0;
+    bool pendingSpace = false;
+    for (char c : type) {
+        if (c == '(') {
+            ++depth;
+            continue;
+        }
+        if (c == ')') {
+            --depth;
+            continue;
+        }
+        if (depth > 0 || c == '[' || c == ']') {
+            continue;
+        }
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pendingSpace = !result.empty();
+            continue;
+        }
+        if (pendingSpace) {
+            result += ' ';
+            pendingSpace = false;
+        }
+        result += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    for (std::string_view suffix : {" unsigned", " signed", " zerofill"}) {
+        while (result.size() > suffix.size() &&
+               result.compare(result.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            result.erase(result.size() - suffix.size());
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+Json::Value ValidationError::toJson() const {
+    Json::Value json;
+    json["path"] = path;
+    json["message"] = message;
+    return json;
+}
+
+SchemaValidator::SchemaValidator(Dialect dialect) : dialect(dialect) {}
+
+bool SchemaValidator::isKnownType(Dialect dialect, std::string_view type) {
+    const auto& types = dialect == Dialect::MySQL ? mysqlTypes() : postgresTypes();
+    return types.count(normalizeType(type)) > 0;
+}
+
+bool SchemaValidator::isValidIdentifier(Dialect dialect, std::string_view name) {
+    size_t maxLength = dialect == Dialect::MySQL ? 64 : 63;
+    if (name.empty() || name.size() > maxLength) {
+        return false;
+    }
+    if (!std::isalpha(static_cast<unsigned char>(name[0])) && name[0] != '_') {
+        return false;
+    }
+    return std::all_of(name.begin(), name.end(), [](char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    });
+}
+
+std::string SchemaValidator::tablePath(Json::ArrayIndex table) {
+    return "tables[" + std::to_string(table) + "]";
+}
+
+std::string SchemaValidator::columnPath(Json::ArrayIndex table, Json::ArrayIndex column) {
+    return tablePath(table) + ".columns[" + std::to_string(column) + "]";
+}
+
+std::vector<ValidationError> SchemaValidator::validate(const Json::Value& tables, const Json::Value& relations) {
+    return validate(CompactSchema(tables, relations));
+}
+
+std::vector<ValidationError> SchemaValidator::validate(const CompactSchema& compact) {
+    schema = &compact;
+    tableInfos.clear();
+    tablesByName.clear();
+    tablesById.clear();
+    indexNames.clear();
+    columnEndpoints.clear();
+    foreignKeys.clear();
+    errors.clear();
+    validColumnNames.assign(compact.columns().size(), false);
+    knownTypes.assign(compact.types().size(), -1);
+
+    if (!compact.tablesIsArray()) {
+        addError("tables", "must be an array");
+        return std::move(errors);
+    }
+
+    size_t tableCount = compact.tables().size();
+    tableInfos.resize(tableCount);
+    foreignKeys.resize(tableCount);
+    tablesByName.reserve(tableCount);
+    tablesById.reserve(tableCount);
+    for (Json::ArrayIndex i = 0; i < tableCount; ++i) {
+        validateTable(i);
+    }
+    validateReferences();
+
+    if (compact.relationsShape() == CompactSchema::RelationsShape::Array) {
+        const auto& relations = compact.relations();
+        for (Json::ArrayIndex i = 0; i < relations.size(); ++i) {
+            validateRelation(relations[i], i);
+        }
+    } else if (compact.relationsShape() == CompactSchema::RelationsShape::Invalid) {
+        addError("relations", "must be an array");
+    }
+
+    findForeignKeyCycles();
+    schema = nullptr;
+    return std::move(errors);
+}
+
+void SchemaValidator::validateTable(Json::ArrayIndex index) {
+    const CompactSchema::Table& table = schema->tables()[index];
+    if (!table.has(CompactSchema::TableObject)) {
+        addError(tablePath(index), "table must be an object");
+        return;
+    }
+
+    TableInfo& info = tableInfos[index];
+    std::string_view name = schema->text(table.name);
+    if (name.empty()) {
+        addError(tablePath(index) + ".name", "table name is required");
+    } else if (!isValidIdentifier(dialect, name)) {
+        addError(tablePath(index) + ".name", "invalid table name '" + std::string(name) + "'");
+    } else {
+        info.name = name;
+        auto [it, inserted] = tablesByName.emplace(schema->lowered(table.name), index);
+        if (!inserted) {
+            addError(tablePath(index) + ".name", "duplicate table name '" + std::string(name) + "' (also tables[" +
+                                                     std::to_string(it->second) + "])");
+        }
+    }
+
+    if (table.id != 0) {
+        tablesById.emplace(table.id, index);
+    }
+
+    if (!table.has(CompactSchema::ColumnsArray) || table.columnCount == 0) {
+        addError(tablePath(index) + ".columns", "table must have at least one column");
+        return;
+    }
+    columnsByName.clear();
+    for (Json::ArrayIndex j = 0; j < table.columnCount; ++j) {
+        validateColumn(index, j, info);
+    }
+    if (!info.hasPrimaryKey) {
+        addError(tablePath(index), "table has no primary key");
+    }
+
+    if (const Json::Value* partitioning = schema->partitioning(index)) {
+        validatePartitioning(*partitioning, index, info);
+    }
+
+    if (table.has(CompactSchema::IndexesPresent)) {
+        if (!table.has(CompactSchema::IndexesArray)) {
+            addError(tablePath(index) + ".indexes", "must be an array");
+            return;
+        }
+        auto indexes = schema->indexes(index);
+        for (Json::ArrayIndex j = 0; j < indexes.size(); ++j) {
+            validateIndex(indexes[j], index, j);
+        }
+    }
+}
+
+void SchemaValidator::validatePartitioning(const Json::Value& partitioning, Json::ArrayIndex tableIndex,
+                                           TableInfo& info) {
+    std::string path = tablePath(tableIndex) + ".partitioning";
+    if (!partitioning.isObject()) {
+        addError(path, "must be an object");
+        return;
+    }
+    info.partitioned = true;
+
+    std::string_view strategy = jsonString(partitioning["strategy"]);
+    if (strategy != "range" && strategy != "hash" && strategy != "list") {
+        addError(path + ".strategy", "strategy must be range, hash or list");
+        return;
+    }
+
+    const Json::Value& columns = partitioning["columns"];
+    if (!columns.isArray() || columns.empty()) {
+        addError(path + ".columns", "partition key must have at least one column");
+        return;
+    }
+    for (Json::ArrayIndex k = 0; k < columns.size(); ++k) {
+        std::string_view key = jsonString(columns[k]);
+        std::string lowerKey(key);
+        std::transform(lowerKey.begin(), lowerKey.end(), lowerKey.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (!hasColumn(tableIndex, schema->find(key), schema->find(lowerKey))) {
+            addError(path + ".columns[" + std::to_string(k) + "]", "unknown column '" + std::string(key) + "'");
+            return;
+        }
+    }
+    std::optional<PartitionSpec> spec = schema->partitionSpec(tableIndex);
+    if (!spec) {
+        return;
+    }
+
+    // Уникальность проверяется внутри раздела, поэтому PostgreSQL и MySQL требуют
+    // ключ секционирования в первичном ключе и каждом уникальном индексе
+    auto coversKey = [&spec](const std::vector<std::string>& keys) {
+        return std::all_of(spec->columnKeys.begin(), spec->columnKeys.end(), [&keys](const std::string& key) {
+            return std::find(keys.begin(), keys.end(), key) != keys.end();
+        });
+    };
+    std::vector<std::string> primaryKey;
+    for (const auto& column : schema->columns(tableIndex)) {
+        if (column.has(CompactSchema::PrimaryKey)) {
+            primaryKey.push_back(schema->key(column));
+        }
+    }
+    if (!primaryKey.empty() && !coversKey(primaryKey)) {
+        addError(path + ".columns", "primary key must include all partition key columns");
+    }
+    for (const auto& index : schema->indexDefinitions(tableIndex)) {
+        if (index.unique && !coversKey(index.columnKeys)) {
+            addError(path + ".columns", "unique index " + index.name + " must include all partition key columns");
+        }
+    }
+
+    std::string_view interval = jsonString(partitioning["interval"]);
+    if (!interval.empty()) {
+        if (spec->interval == PartitionInterval::None) {
+            addError(path + ".interval", "interval must be day, week, month or year");
+        } else if (spec->strategy != PartitionStrategy::Range || spec->columns.size() != 1) {
+            addError(path + ".interval", "interval requires range partitioning by one column");
+        }
+    }
+    if (spec->retention > 0 && spec->interval == PartitionInterval::None) {
+        addError(path + ".retention", "retention requires an interval");
+    }
+
+    if (spec->strategy == PartitionStrategy::Hash) {
+        if (spec->modulus < 1 || spec->modulus > 1024) {
+            addError(path + ".modulus", "hash partitioning requires modulus from 1 to 1024");
+        }
+        return;
+    }
+
+    std::unordered_set<std::string> names;
+    for (size_t k = 0; k < spec->partitions.size(); ++k) {
+        const PartitionBound& bound = spec->partitions[k];
+        std::string boundPath = path + ".partitions[" + std::to_string(k) + "]";
+        if (!isValidIdentifier(dialect, bound.name)) {
+            addError(boundPath + ".name", "invalid partition name '" + bound.name + "'");
+        } else if (!names.insert(bound.name).second) {
+            addError(boundPath + ".name", "duplicate partition name '" + bound.name + "'");
+        }
+        if (spec->strategy == PartitionStrategy::List && bound.values.empty()) {
+            addError(boundPath + ".values", "list partition must have values");
+        }
+        if (spec->strategy == PartitionStrategy::Range && bound.to.empty() &&
+            (dialect == Dialect::MySQL || bound.from.empty())) {
+            addError(boundPath, dialect == Dialect::MySQL ? "range partition requires 'to' bound"
+                                                          : "range partition requires 'from' or 'to' bound");
+        }
+    }
+    bool hasPartitions = !spec->partitions.empty() || spec->interval != PartitionInterval::None ||
+                         (spec->withDefault && !(dialect == Dialect::MySQL && spec->strategy == PartitionStrategy::List));
+    if (!hasPartitions) {
+        addError(path + ".partitions", "at least one partition, an interval or a default partition is required");
+    }
+}
+
+void SchemaValidator::validateIndex(const CompactSchema::Index& index, Json::ArrayIndex tableIndex,
+                                    Json::ArrayIndex indexIndex) {
+    std::string path = tablePath(tableIndex) + ".indexes[" + std::to_string(indexIndex) + "]";
+    if (!index.has(CompactSchema::IndexObject)) {
+        addError(path, "index must be an object");
+        return;
+    }
+
+    // Имена индексов в PostgreSQL уникальны в пределах схемы, а не таблицы
+    std::string_view name = schema->text(index.name);
+    if (!name.empty()) {
+        if (!isValidIdentifier(dialect, name)) {
+            addError(path + ".name", "invalid index name '" + std::string(name) + "'");
+        } else {
+            auto [it, inserted] = indexNames.emplace(schema->lowered(index.name), path);
+            if (!inserted) {
+                addError(path + ".name", "duplicate index name '" + std::string(name) + "' (also " + it->second + ")");
+            }
+        }
+    }
+
+    auto keys = schema->keys(index);
+    if (!index.has(CompactSchema::IndexColumnsArray) || keys.empty()) {
+        addError(path + ".columns", "index must have at least one column");
+    } else {
+        for (Json::ArrayIndex k = 0; k < keys.size(); ++k) {
+            if (!hasColumn(tableIndex, keys[k].key, schema->lowered(keys[k].key))) {
+                addError(path + ".columns[" + std::to_string(k) + "]",
+                         "unknown column '" + std::string(schema->text(keys[k].key)) + "'");
+            }
+        }
+    }
+
+    std::string_view method = schema->text(index.method);
+    std::string_view lowerMethod = schema->text(schema->lowered(index.method));
+    if (!method.empty() && !isIndexMethod(dialect, lowerMethod)) {
+        addError(path + ".method", "index method '" + std::string(method) + "' is not supported by " +
+                                       dialectName(dialect));
+    }
+    // Уникальность в PostgreSQL поддерживает только btree
+    if (dialect == Dialect::PostgreSQL && index.has(CompactSchema::Unique) && !lowerMethod.empty() &&
+        lowerMethod != "btree") {
+        addError(path + ".unique", "unique index requires btree method");
+    }
+    if (index.where != 0 && dialect == Dialect::MySQL) {
+        addError(path + ".where", "partial indexes are not supported by mysql");
+    }
+}
+
+void SchemaValidator::validateColumn(Json::ArrayIndex tableIndex, Json::ArrayIndex columnIndex, TableInfo& info) {
+    const CompactSchema::Table& table = schema->tables()[tableIndex];
+    uint32_t number = table.firstColumn + columnIndex;
+    const CompactSchema::Column& column = schema->columns()[number];
+    if (!column.has(CompactSchema::ColumnObject)) {
+        addError(columnPath(tableIndex, columnIndex), "column must be an object");
+        return;
+    }
+
+    std::string_view name = schema->text(column.name);
+    if (name.empty()) {
+        addError(columnPath(tableIndex, columnIndex) + ".name", "column name is required");
+    } else if (!isValidIdentifier(dialect, name)) {
+        addError(columnPath(tableIndex, columnIndex) + ".name", "invalid column name '" + std::string(name) + "'");
+    } else {
+        validColumnNames[number] = true;
+        auto [it, inserted] = columnsByName.emplace(schema->lowered(column.name), columnIndex);
+        if (!inserted) {
+            addError(columnPath(tableIndex, columnIndex) + ".name",
+                     "duplicate column name '" + std::string(name) + "' (also columns[" +
+                         std::to_string(it->second) + "])");
+        }
+    }
+
+    if (column.id != 0 && table.id != 0) {
+        std::string_view tableId = schema->text(table.id);
+        std::string_view columnId = schema->text(column.id);
+        std::string endpoint;
+        endpoint.reserve(tableId.size() + 1 + columnId.size());
+        endpoint.append(tableId).append(1, '-').append(columnId);
+        columnEndpoints.insert(std::move(endpoint));
+    }
+
+    std::string_view type = schema->type(column);
+    if (type.empty()) {
+        addError(columnPath(tableIndex, columnIndex) + ".type", "column type is required");
+    } else if (!isKnownTypeCached(column.type)) {
+        addError(columnPath(tableIndex, columnIndex) + ".type",
+                 "type '" + std::string(type) + "' is not supported by " + dialectName(dialect));
+    }
+
+    if (column.has(CompactSchema::PrimaryKey)) {
+        info.hasPrimaryKey = true;
+    }
+}
+
+bool SchemaValidator::isKnownTypeCached(uint32_t type) {
+    if (knownTypes[type] < 0) {
+        knownTypes[type] = isKnownType(dialect, schema->text(schema->types()[type])) ? 1 : 0;
+    }
+    return knownTypes[type] == 1;
+}
+
+long SchemaValidator::findTable(Name key) const {
+    auto byId = tablesById.find(key);
+    if (byId != tablesById.end()) {
+        return static_cast<long>(byId->second);
+    }
+    auto byName = tablesByName.find(schema->lowered(key));
+    if (byName != tablesByName.end()) {
+        return static_cast<long>(byName->second);
+    }
+    return -1;
+}
+
+bool SchemaValidator::hasColumn(Json::ArrayIndex table, Name key, Name lowerKey) const {
+    // Колонок в таблице немного: просмотр подряд дешевле хэш-таблицы на каждую таблицу
+    const CompactSchema::Table& item = schema->tables()[table];
+    const auto& columns = schema->columns();
+    for (uint32_t c = item.firstColumn; c < item.firstColumn + item.columnCount; ++c) {
+        if ((key != 0 && columns[c].id == key) ||
+            (lowerKey != 0 && validColumnNames[c] && schema->lowered(columns[c].name) == lowerKey)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void SchemaValidator::validateReferences() {
+    const auto& tables = schema->tables();
+    for (Json::ArrayIndex i = 0; i < tables.size(); ++i) {
+        auto columns = schema->columns(i);
+        for (Json::ArrayIndex j = 0; j < columns.size(); ++j) {
+            const CompactSchema::Column& column = columns[j];
+            if (!column.has(CompactSchema::HasReference)) {
+                continue;
+            }
+            long target = findTable(column.referenceTable);
+            if (target < 0) {
+                addError(columnPath(i, j) + ".references",
+                         "references unknown table '" + std::string(schema->text(column.referenceTable)) + "'");
+                continue;
+            }
+            const TableInfo& targetInfo = tableInfos[static_cast<size_t>(target)];
+            if (!hasColumn(static_cast<Json::ArrayIndex>(target), column.referenceColumn,
+                           schema->lowered(column.referenceColumn))) {
+                addError(columnPath(i, j) + ".references",
+                         "references unknown column '" + std::string(schema->text(column.referenceColumn)) +
+                             "' in table '" + std::string(targetInfo.name) + "'");
+                continue;
+            }
+            // InnoDB не поддерживает внешние ключи у секционированных таблиц ни с одной стороны
+            if (dialect == Dialect::MySQL && (tableInfos[i].partitioned || targetInfo.partitioned)) {
+                addError(columnPath(i, j) + ".references",
+                         "foreign keys are not supported for partitioned tables in mysql");
+            }
+            if (static_cast<Json::ArrayIndex>(target) != i) {
+                foreignKeys[i].push_back(static_cast<size_t>(target));
+            }
+        }
+    }
+}
+
+void SchemaValidator::validateRelation(const CompactSchema::Relation& relation, Json::ArrayIndex index) {
+    std::string path = "relations[" + std::to_string(index) + "]";
+    if (!relation.object) {
+        addError(path, "relation must be an object");
+        return;
+    }
+    for (auto [key, name] : {std::pair<std::string_view, Name>("sourceId", relation.source),
+                             std::pair<std::string_view, Name>("targetId", relation.target)}) {
+        std::string endpoint(schema->text(name));
+        if (endpoint.empty() || columnEndpoints.count(endpoint) == 0) {
+            addError(path + "." + std::string(key), "unknown column '" + endpoint + "'");
+        }
+    }
+    std::string_view type = schema->text(relation.type);
+    if (!type.empty() && type != "one-to-one" && type != "one-to-many" &&
+        type != "many-to-one" && type != "many-to-many") {
+        addError(path + ".type", "unknown relation type '" + std::string(type) + "'");
+    }
+}
+
+void SchemaValidator::findForeignKeyCycles() {
+    // Итеративный DFS с тремя цветами: O(V+E), обратное ребро означает цикл
+    enum class Color { White, Gray, Black };
+    std::vector<Color> colors(foreignKeys.size(), Color::White);
+    std::vector<size_t> stack;
+    std::vector<size_t> nextEdge(foreignKeys.size(), 0);
+
+    for (size_t root = 0; root < foreignKeys.size(); ++root) {
+        if (colors[root] != Color::White) {
+            continue;
+        }
+        stack.push_back(root);
+        colors[root] = Color::Gray;
+        while (!stack.empty()) {
+            size_t node = stack.back();
+            if (nextEdge[node] == foreignKeys[node].size()) {
+                colors[node] = Color::Black;
+                stack.pop_back();
+                continue;
+            }
+            size_t target = foreignKeys[node][nextEdge[node]++];
+            if (colors[target] == Color::White) {
+                colors[target] = Color::Gray;
+                stack.push_back(target);
+            } else if (colors[target] == Color::Gray) {
+                auto start = std::find(stack.begin(), stack.end(), target);
+                std::string cycle;
+                for (auto it = start; it != stack.end(); ++it) {
+                    cycle.append(tableInfos[*it].name).append(" -> ");
+                }
+                cycle.append(tableInfos[target].name);
+                addError(tablePath(static_cast<Json::ArrayIndex>(target)), "foreign key cycle: " + cycle);
+            }
+        }
+    }
+}
+
+void SchemaValidator::addError(std::string path, std::string message) {
+    errors.push_back(ValidationError{std::move(path), std::move(message)});
+}
+
+} // namespace sql
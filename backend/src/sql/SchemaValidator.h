@@ -0,0 +1,85 @@
+#pragma once
+#include <json/json.h>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "CompactSchema.h"
+#include "Dialect.h"
+
+namespace sql {
+
+// Ошибка валидации с путём до поля, например tables[2].columns[0].type
+struct ValidationError {
+    std::string path;
+    std::string message;
+
+    Json::Value toJson() const;
+};
+
+// Проверка схемы за один проход по CompactSchema: дубликаты таблиц, колонок и индексов,
+// битые ссылки, наличие первичного ключа, допустимые типы диалекта, методы индексов,
+// секционирование и циклы FK. Имена сравниваются номерами строк пула.
+// Собирает все ошибки, а не только первую.
+class SchemaValidator {
+public:
+    explicit SchemaValidator(Dialect dialect);
+
+    std::vector<ValidationError> validate(const Json::Value& tables, const Json::Value& relations);
+    // schema должна быть собрана вместе с relations
+    std::vector<ValidationError> validate(const CompactSchema& schema);
+
+    // Проверка имени типа по белому списку диалекта (без учёта длины и модификаторов)
+    static bool isKnownType(Dialect dialect, std::string_view type);
+    static bool isValidIdentifier(Dialect dialect, std::string_view name);
+
+private:
+    using Name = CompactSchema::Name;
+
+    struct TableInfo {
+        std::string_view name;
+        bool hasPrimaryKey = false;
+        bool partitioned = false;
+    };
+
+    void validateTable(Json::ArrayIndex index);
+    void validateColumn(Json::ArrayIndex tableIndex, Json::ArrayIndex columnIndex, TableInfo& info);
+    void validatePartitioning(const Json::Value& partitioning, Json::ArrayIndex tableIndex, TableInfo& info);
+    void validateIndex(const CompactSchema::Index& index, Json::ArrayIndex tableIndex, Json::ArrayIndex indexIndex);
+    void validateReferences();
+    void validateRelation(const CompactSchema::Relation& relation, Json::ArrayIndex index);
+    void findForeignKeyCycles();
+
+    // Поиск таблицы по id или по имени; -1, если не найдена
+    long findTable(Name key) const;
+    // Колонка с таким id или с таким допустимым именем без учета регистра
+    bool hasColumn(Json::ArrayIndex table, Name key, Name lowerKey) const;
+    bool isKnownTypeCached(uint32_t type);
+    void addError(std::string path, std::string message);
+    static std::string tablePath(Json::ArrayIndex table);
+    static std::string columnPath(Json::ArrayIndex table, Json::ArrayIndex column);
+
+    Dialect dialect;
+    // Проверяемая схема, пока идет validate
+    const CompactSchema* schema = nullptr;
+    std::vector<TableInfo> tableInfos;
+    // Ключи - имена в нижнем регистре
+    std::unordered_map<Name, size_t> tablesByName;
+    std::unordered_map<Name, size_t> tablesById;
+    // Колонки текущей таблицы по имени в нижнем регистре
+    std::unordered_map<Name, Json::ArrayIndex> columnsByName;
+    // Допустимое ли имя у колонки (номер в schema->columns())
+    std::vector<bool> validColumnNames;
+    // Имя индекса в нижнем регистре -> путь, где оно впервые встретилось
+    std::unordered_map<Name, std::string> indexNames;
+    // "tableId-columnId", как их пишет конструктор в relations
+    std::unordered_set<std::string> columnEndpoints;
+    // Рёбра FK: индекс ссылающейся таблицы -> индексы таблиц, на которые она ссылается
+    std::vector<std::vector<size_t>> foreignKeys;
+    // Известен ли тип (номер в schema->types()): -1 - еще не проверяли
+    std::vector<int8_t> knownTypes;
+    std::vector<ValidationError> errors;
+};
+
+} // namespace sql
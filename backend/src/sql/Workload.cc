@@ -0,0 +1,203 @@
+#include "Workload.h"
+#include "IndexDefinition.h"
+#include "SchemaGraph.h"
+#include "SchemaJson.h"
+#include <algorithm>
+#include <array>
+
+namespace sql {
+
+namespace {
+
+// splitmix64: тот же перемешиватель, что и в DataGenerator
+uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Попыток найти строку с непустым значением для границы диапазона
+constexpr uint64_t RANGE_ATTEMPTS = 8;
+
+} // namespace
+
+Workload::Workload(const DataGenerator& generator, const Json::Value& tables, Options options)
+    : generator(generator), options(std::move(options)) {
+    if (!tables.isArray() || tables.size() != generator.tableCount()) {
+        return;
+    }
+    SchemaGraph graph(tables);
+    std::array<std::vector<Shape>, 4> byKind;
+    for (Json::ArrayIndex i = 0; i < tables.size(); ++i) {
+        if (generator.rowCount(i) == 0) {
+            continue;
+        }
+        const std::string& name = generator.tableName(i);
+        size_t columnCount = generator.columnCount(i);
+        auto usable = [&generator, i, columnCount](size_t c) {
+            return c < columnCount && generator.generated(i, c);
+        };
+
+        // Поиск по всему первичному ключу, в том числе составному
+        Shape lookup;
+        lookup.name = "pk_lookup:" + name;
+        lookup.kind = ShapeKind::PointLookup;
+        lookup.table = i;
+        bool complete = true;
+        for (const auto& column : tables[i]["columns"]) {
+            if (isPrimaryKey(column)) {
+                size_t c = generator.columnIndex(i, jsonString(column["name"]));
+                complete = complete && usable(c);
+                lookup.columns.push_back(c);
+            }
+        }
+        if (complete && !lookup.columns.empty()) {
+            byKind[0].push_back(lookup);
+        }
+
+        // Дети строки родителя вместе с самой строкой: ходит по индексу колонки FK
+        for (const auto& key : graph.foreignKeys(i)) {
+            size_t c = generator.columnIndex(i, key.column);
+            size_t parent = generator.columnIndex(key.targetTable, key.targetColumn);
+            if (!usable(c) || parent >= generator.columnCount(key.targetTable) ||
+                !generator.generated(key.targetTable, parent) || generator.rowCount(key.targetTable) == 0) {
+                continue;
+            }
+            Shape join;
+            join.name = "fk_join:" + name + "." + generator.columnName(i, c);
+            join.kind = ShapeKind::ForeignKeyJoin;
+            join.table = i;
+            join.columns = {c};
+            join.parentTable = key.targetTable;
+            join.parentColumn = parent;
+            byKind[1].push_back(std::move(join));
+        }
+
+        // Диапазон по ведущей колонке первичного ключа и btree-индексов без условия
+        std::vector<size_t> leading;
+        if (complete && !lookup.columns.empty()) {
+            leading.push_back(lookup.columns.front());
+        }
+        for (const auto& index : tableIndexes(tables[i])) {
+            if (index.method == "btree" && index.where.empty() && !index.columns.empty()) {
+                leading.push_back(generator.columnIndex(i, index.columns.front()));
+            }
+        }
+        std::vector<size_t> seen;
+        for (size_t c : leading) {
+            if (!usable(c) || !generator.ordered(i, c) || std::find(seen.begin(), seen.end(), c) != seen.end()) {
+                continue;
+            }
+            seen.push_back(c);
+            Shape range;
+            range.name = "range_scan:" + name + "." + generator.columnName(i, c);
+            range.kind = ShapeKind::RangeScan;
+            range.table = i;
+            range.columns = {c};
+            byKind[2].push_back(std::move(range));
+        }
+
+        // Вставки - только если уникальным колонкам хватит значений на новые строки
+        bool anyColumn = false;
+        for (size_t c = 0; c < columnCount; ++c) {
+            anyColumn = anyColumn || generator.generated(i, c);
+        }
+        if (anyColumn && generator.rowCapacity(i) - generator.rowCount(i) >= this->options.inserts) {
+            Shape insert;
+            insert.name = "insert:" + name;
+            insert.kind = ShapeKind::Insert;
+            insert.table = i;
+            byKind[3].push_back(std::move(insert));
+        }
+    }
+
+    // Виды по очереди, пока не наберется maxShapes: большая схема не вытесняет вставки поисками
+    std::array<size_t, 4> taken{};
+    size_t total = 0;
+    for (bool added = true; added && total < this->options.maxShapes;) {
+        added = false;
+        for (size_t kind = 0; kind < byKind.size() && total < this->options.maxShapes; ++kind) {
+            if (taken[kind] < byKind[kind].size()) {
+                ++taken[kind];
+                ++total;
+                added = true;
+            }
+        }
+    }
+    for (size_t kind = 0; kind < byKind.size(); ++kind) {
+        for (size_t s = 0; s < taken[kind]; ++s) {
+            workloadShapes.push_back(std::move(byKind[kind][s]));
+        }
+    }
+}
+
+const char* Workload::kindName(ShapeKind kind) {
+    switch (kind) {
+    case ShapeKind::PointLookup:
+        return "pk_lookup";
+    case ShapeKind::ForeignKeyJoin:
+        return "fk_join";
+    case ShapeKind::RangeScan:
+        return "range_scan";
+    case ShapeKind::Insert:
+        return "insert";
+    }
+    return "";
+}
+
+uint64_t Workload::randomRow(Json::ArrayIndex table, size_t shape, uint64_t sequence) const {
+    return mix(options.seed ^ mix((static_cast<uint64_t>(shape) << 40) + sequence)) % generator.rowCount(table);
+}
+
+void Workload::writeQuery(size_t index, uint64_t sequence, std::string& out) const {
+    const Shape& shape = workloadShapes[index];
+    const std::string& table = generator.tableName(shape.table);
+    switch (shape.kind) {
+    case ShapeKind::PointLookup: {
+        uint64_t row = randomRow(shape.table, index, sequence);
+        out += "SELECT * FROM " + table + " WHERE ";
+        for (size_t k = 0; k < shape.columns.size(); ++k) {
+            if (k > 0) {
+                out += " AND ";
+            }
+            out += generator.columnName(shape.table, shape.columns[k]) + " = ";
+            generator.writeLiteral(shape.table, shape.columns[k], row, out);
+        }
+        break;
+    }
+    case ShapeKind::ForeignKeyJoin: {
+        const std::string& column = generator.columnName(shape.table, shape.columns.front());
+        const std::string& parentColumn = generator.columnName(shape.parentTable, shape.parentColumn);
+        out += "SELECT * FROM " + table + " c JOIN " + generator.tableName(shape.parentTable) + " p ON p." +
+               parentColumn + " = c." + column + " WHERE p." + parentColumn + " = ";
+        generator.writeLiteral(shape.parentTable, shape.parentColumn, randomRow(shape.parentTable, index, sequence),
+                               out);
+        out += " LIMIT " + std::to_string(options.limit);
+        break;
+    }
+    case ShapeKind::RangeScan: {
+        // Граница - значение случайной строки; NULL ничего бы не нашел
+        size_t column = shape.columns.front();
+        std::string bound;
+        for (uint64_t attempt = 0; attempt < RANGE_ATTEMPTS; ++attempt) {
+            bound.clear();
+            generator.writeLiteral(shape.table, column, randomRow(shape.table, index, sequence * RANGE_ATTEMPTS + attempt),
+                                   bound);
+            if (bound != "NULL") {
+                break;
+            }
+        }
+        const std::string& name = generator.columnName(shape.table, column);
+        out += "SELECT * FROM " + table + " WHERE " + name + " >= " + bound + " ORDER BY " + name + " LIMIT " +
+               std::to_string(options.limit);
+        break;
+    }
+    case ShapeKind::Insert:
+        out += generator.insertStatement(shape.table, generator.rowCount(shape.table) + sequence);
+        break;
+    }
+    out += ";\n";
+}
+
+} // namespace sql
@@ -0,0 +1,59 @@
+#pragma once
+#include <json/json.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "DataGenerator.h"
+
+namespace sql {
+
+// Нагрузка для замера развернутой схемы, выведенная из самой схемы: поиск по
+// первичному ключу, соединение по внешнему ключу, диапазон по btree-индексу и
+// вставка. Значения в условиях берутся из DataGenerator с теми же параметрами,
+// что и при заполнении базы, поэтому запросы попадают в существующие строки,
+// а вставки идут строками после загруженных и не конфликтуют по ключам.
+class Workload {
+public:
+    enum class ShapeKind { PointLookup, ForeignKeyJoin, RangeScan, Insert };
+
+    // Форма запроса: один шаблон SQL, меняются только значения
+    struct Shape {
+        // pk_lookup:<таблица>, fk_join:<таблица>.<колонка>, range_scan:<таблица>.<колонка>, insert:<таблица>
+        std::string name;
+        ShapeKind kind = ShapeKind::PointLookup;
+        Json::ArrayIndex table = 0;
+        // Колонки ключа, ссылка FK или ведущая колонка индекса
+        std::vector<size_t> columns;
+        Json::ArrayIndex parentTable = 0;
+        size_t parentColumn = 0;
+    };
+
+    struct Options {
+        // Не больше стольких форм: виды чередуются, чтобы попали все
+        size_t maxShapes = 24;
+        // Вставок на форму за прогон: таблице должно хватить места под новые строки
+        uint64_t inserts = 1000;
+        // Строк в выдаче соединения и диапазона
+        size_t limit = 100;
+        uint64_t seed = 1;
+    };
+
+    // tables - те же таблицы, по которым построен generator
+    Workload(const DataGenerator& generator, const Json::Value& tables, Options options);
+
+    const std::vector<Shape>& shapes() const { return workloadShapes; }
+    static const char* kindName(ShapeKind kind);
+
+    // Дописывает в out запрос номер sequence формы shape с ";\n". Номера
+    // вставок должны быть различны в пределах прогона и меньше options.inserts
+    void writeQuery(size_t shape, uint64_t sequence, std::string& out) const;
+
+private:
+    uint64_t randomRow(Json::ArrayIndex table, size_t shape, uint64_t sequence) const;
+
+    const DataGenerator& generator;
+    Options options;
+    std::vector<Shape> workloadShapes;
+};
+
+} // namespace sql
@@ -0,0 +1,58 @@
+#include "BoundedThreadPool.h"
+
+namespace utils {
+
+BoundedThreadPool::BoundedThreadPool(size_t threadCount, size_t queueCapacity)
+    : capacity(queueCapacity) {
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this]() { run(); });
+    }
+}
+
+BoundedThreadPool::~BoundedThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    condition.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+bool BoundedThreadPool::trySubmit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping || tasks.size() >= capacity) {
+            ++rejectedCount;
+            return false;
+        }
+        tasks.push_back(std::move(task));
+    }
+    condition.notify_one();
+    return true;
+}
+
+size_t BoundedThreadPool::queueDepth() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return tasks.size();
+}
+
+void BoundedThreadPool::run() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace utils
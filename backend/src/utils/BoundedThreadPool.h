@@ -0,0 +1,42 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils {
+
+// Пул с фиксированным числом потоков и ограниченной очередью.
+// Если очередь заполнена, задача не ставится и trySubmit возвращает false.
+class BoundedThreadPool {
+public:
+    BoundedThreadPool(size_t threadCount, size_t queueCapacity);
+    ~BoundedThreadPool();
+
+    BoundedThreadPool(const BoundedThreadPool&) = delete;
+    BoundedThreadPool& operator=(const BoundedThreadPool&) = delete;
+
+    bool trySubmit(std::function<void()> task);
+
+    size_t threadCount() const { return workers.size(); }
+    size_t queueCapacity() const { return capacity; }
+    size_t queueDepth() const;
+    uint64_t rejected() const { return rejectedCount.load(); }
+
+private:
+    void run();
+
+    size_t capacity;
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    mutable std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+    std::atomic<uint64_t> rejectedCount{0};
+};
+
+} // namespace utils
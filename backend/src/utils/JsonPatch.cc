@@ -0,0 +1,340 @@
+#include "JsonPatch.h"
+#include <algorithm>
+#include <cctype>
+
+namespace utils {
+
+namespace {
+
+// Индекс массива по RFC 6901: десятичное число без ведущих нулей
+bool parseIndex(const std::string& token, Json::ArrayIndex& index) {
+    if (token.empty() || token.size() > 9 || (token.size() > 1 && token[0] == '0') ||
+        !std::all_of(token.begin(), token.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        return false;
+    }
+    index = static_cast<Json::ArrayIndex>(std::stoul(token));
+    return true;
+}
+
+// Числа равны по значению (1 и 1.0), остальное - по типу и содержимому
+bool jsonEquals(const Json::Value& a, const Json::Value& b) {
+    if (a.isNumeric() && b.isNumeric() && !a.isBool() && !b.isBool()) {
+        return a.asDouble() == b.asDouble();
+    }
+    if (a.type() != b.type()) {
+        return false;
+    }
+    if (a.isArray()) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (Json::ArrayIndex i = 0; i < a.size(); ++i) {
+            if (!jsonEquals(a[i], b[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (a.isObject()) {
+        if (a.size() != b.size()) {
+            return false;
+        }
+        for (const auto& name : a.getMemberNames()) {
+            if (!b.isMember(name) || !jsonEquals(a[name], b[name])) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return a == b;
+}
+
+// Значение по пути или nullptr
+Json::Value* resolve(Json::Value& document, const std::vector<std::string>& path, size_t length) {
+    Json::Value* current = &document;
+    for (size_t i = 0; i < length; ++i) {
+        const std::string& token = path[i];
+        if (current->isObject()) {
+            if (!current->isMember(token)) {
+                return nullptr;
+            }
+            current = &(*current)[token];
+        } else if (current->isArray()) {
+            Json::ArrayIndex index = 0;
+            if (!parseIndex(token, index) || index >= current->size()) {
+                return nullptr;
+            }
+            current = &(*current)[index];
+        } else {
+            return nullptr;
+        }
+    }
+    return current;
+}
+
+std::string pointerText(const std::vector<std::string>& path) {
+    std::string text;
+    for (const auto& token : path) {
+        text += '/';
+        for (char c : token) {
+            if (c == '~') {
+                text += "~0";
+            } else if (c == '/') {
+                text += "~1";
+            } else {
+                text += c;
+            }
+        }
+    }
+    return text;
+}
+
+// Обратное действие для отката: документ правится на месте, без копии целиком
+struct Undo {
+    enum class Kind {
+        // Записать value по path (член объекта создается заново)
+        Restore,
+        // Удалить path
+        Erase,
+        // Вставить value в массив перед элементом path
+        Reinsert
+    };
+    Kind kind;
+    std::vector<std::string> path;
+    Json::Value value;
+};
+
+class Applier {
+public:
+    Applier(Json::Value& document, std::vector<JsonPatch::Edit>& edits, std::vector<Undo>& undo,
+            size_t index)
+        : document(document), edits(edits), undo(undo), index(index) {}
+
+    const Json::Value& get(const std::vector<std::string>& path) {
+        Json::Value* target = resolve(document, path, path.size());
+        if (target == nullptr) {
+            fail("path " + pointerText(path) + " does not exist");
+        }
+        return *target;
+    }
+
+    void add(std::vector<std::string> path, Json::Value value) {
+        if (path.empty()) {
+            undo.push_back({Undo::Kind::Restore, {}, std::move(document)});
+            document = value;
+            edits.push_back({JsonPatch::Edit::Kind::Set, {}, std::move(value)});
+            return;
+        }
+        Json::Value* parent = resolve(document, path, path.size() - 1);
+        if (parent == nullptr) {
+            fail("parent of " + pointerText(path) + " does not exist");
+        }
+        std::string& last = path.back();
+        if (parent->isArray()) {
+            Json::ArrayIndex position = parent->size();
+            if (last != "-" && (!parseIndex(last, position) || position > parent->size())) {
+                fail("index " + last + " is out of range");
+            }
+            last = std::to_string(position);
+            parent->insert(position, value);
+            undo.push_back({Undo::Kind::Erase, path, Json::Value()});
+            edits.push_back({JsonPatch::Edit::Kind::Insert, std::move(path), std::move(value)});
+        } else if (parent->isObject()) {
+            if (parent->isMember(last)) {
+                undo.push_back({Undo::Kind::Restore, path, std::move((*parent)[last])});
+            } else {
+                undo.push_back({Undo::Kind::Erase, path, Json::Value()});
+            }
+            (*parent)[last] = value;
+            edits.push_back({JsonPatch::Edit::Kind::Set, std::move(path), std::move(value)});
+        } else {
+            fail("parent of " + pointerText(path) + " is not a container");
+        }
+    }
+
+    void remove(const std::vector<std::string>& path) {
+        if (path.empty()) {
+            fail("the whole document cannot be removed");
+        }
+        get(path);
+        Json::Value* parent = resolve(document, path, path.size() - 1);
+        Json::Value removed;
+        if (parent->isArray()) {
+            parent->removeIndex(static_cast<Json::ArrayIndex>(std::stoul(path.back())), &removed);
+            undo.push_back({Undo::Kind::Reinsert, path, std::move(removed)});
+        } else {
+            parent->removeMember(path.back(), &removed);
+            undo.push_back({Undo::Kind::Restore, path, std::move(removed)});
+        }
+        edits.push_back({JsonPatch::Edit::Kind::Remove, path, Json::Value()});
+    }
+
+    void replace(const std::vector<std::string>& path, Json::Value value) {
+        get(path);
+        Json::Value& target = *resolve(document, path, path.size());
+        undo.push_back({Undo::Kind::Restore, path, std::move(target)});
+        target = value;
+        edits.push_back({JsonPatch::Edit::Kind::Set, path, std::move(value)});
+    }
+
+    [[noreturn]] void fail(const std::string& message, bool conflict = false) {
+        throw JsonPatch::Error(index, conflict, message);
+    }
+
+private:
+    Json::Value& document;
+    std::vector<JsonPatch::Edit>& edits;
+    std::vector<Undo>& undo;
+    size_t index;
+};
+
+// Откат в обратном порядке: каждый путь снова указывает туда же, куда при правке
+void rollback(Json::Value& document, std::vector<Undo>& undo) {
+    for (auto it = undo.rbegin(); it != undo.rend(); ++it) {
+        if (it->path.empty()) {
+            document = std::move(it->value);
+            continue;
+        }
+        Json::Value& parent = *resolve(document, it->path, it->path.size() - 1);
+        const std::string& last = it->path.back();
+        if (it->kind == Undo::Kind::Reinsert) {
+            parent.insert(static_cast<Json::ArrayIndex>(std::stoul(last)), std::move(it->value));
+        } else if (it->kind == Undo::Kind::Erase) {
+            Json::Value removed;
+            if (parent.isArray()) {
+                parent.removeIndex(static_cast<Json::ArrayIndex>(std::stoul(last)), &removed);
+            } else {
+                parent.removeMember(last, &removed);
+            }
+        } else if (parent.isArray()) {
+            parent[static_cast<Json::ArrayIndex>(std::stoul(last))] = std::move(it->value);
+        } else {
+            parent[last] = std::move(it->value);
+        }
+    }
+}
+
+} // namespace
+
+JsonPatch::JsonPatch(const Json::Value& list) {
+    if (!list.isArray()) {
+        throw Error(0, false, "patch must be an array of operations");
+    }
+    for (Json::ArrayIndex i = 0; i < list.size(); ++i) {
+        const Json::Value& item = list[i];
+        if (!item.isObject() || !item["op"].isString() || !item["path"].isString()) {
+            throw Error(i, false, "op and path are required");
+        }
+        Operation operation;
+        std::string op = item["op"].asString();
+        if (op == "add") {
+            operation.op = Op::Add;
+        } else if (op == "remove") {
+            operation.op = Op::Remove;
+        } else if (op == "replace") {
+            operation.op = Op::Replace;
+        } else if (op == "move") {
+            operation.op = Op::Move;
+        } else if (op == "copy") {
+            operation.op = Op::Copy;
+        } else if (op == "test") {
+            operation.op = Op::Test;
+        } else {
+            throw Error(i, false, "unknown op " + op);
+        }
+        try {
+            operation.path = parsePointer(item["path"].asString());
+            if (operation.op == Op::Move || operation.op == Op::Copy) {
+                if (!item["from"].isString()) {
+                    throw Error(i, false, "from is required for " + op);
+                }
+                operation.from = parsePointer(item["from"].asString());
+            }
+        } catch (const std::invalid_argument& e) {
+            throw Error(i, false, e.what());
+        }
+        if (operation.op == Op::Add || operation.op == Op::Replace || operation.op == Op::Test) {
+            if (!item.isMember("value")) {
+                throw Error(i, false, "value is required for " + op);
+            }
+            operation.value = item["value"];
+        }
+        operations.push_back(std::move(operation));
+    }
+}
+
+std::vector<std::string> JsonPatch::parsePointer(const std::string& pointer) {
+    std::vector<std::string> path;
+    if (pointer.empty()) {
+        return path;
+    }
+    if (pointer[0] != '/') {
+        throw std::invalid_argument("JSON pointer must start with /: " + pointer);
+    }
+    std::string token;
+    for (size_t i = 1; i <= pointer.size(); ++i) {
+        if (i == pointer.size() || pointer[i] == '/') {
+            path.push_back(std::move(token));
+            token.clear();
+        } else if (pointer[i] == '~') {
+            if (i + 1 >= pointer.size() || (pointer[i + 1] != '0' && pointer[i + 1] != '1')) {
+                throw std::invalid_argument("Invalid escape in JSON pointer: " + pointer);
+            }
+            token += pointer[++i] == '0' ? '~' : '/';
+        } else {
+            token += pointer[i];
+        }
+    }
+    return path;
+}
+
+std::vector<JsonPatch::Edit> JsonPatch::apply(Json::Value& document) const {
+    // Копия большой схемы дороже самих правок: при ошибке они откатываются по журналу
+    std::vector<Edit> edits;
+    std::vector<Undo> undo;
+    try {
+        for (size_t i = 0; i < operations.size(); ++i) {
+            const Operation& operation = operations[i];
+            Applier applier(document, edits, undo, i);
+            switch (operation.op) {
+            case Op::Add:
+                applier.add(operation.path, operation.value);
+                break;
+            case Op::Remove:
+                applier.remove(operation.path);
+                break;
+            case Op::Replace:
+                applier.replace(operation.path, operation.value);
+                break;
+            case Op::Copy:
+                applier.add(operation.path, applier.get(operation.from));
+                break;
+            case Op::Move: {
+                if (operation.path.size() > operation.from.size() &&
+                    std::equal(operation.from.begin(), operation.from.end(), operation.path.begin())) {
+                    applier.fail("cannot move a value into its own child");
+                }
+                if (operation.path == operation.from) {
+                    applier.get(operation.from);
+                    break;
+                }
+                Json::Value value = applier.get(operation.from);
+                applier.remove(operation.from);
+                applier.add(operation.path, std::move(value));
+                break;
+            }
+            case Op::Test:
+                if (!jsonEquals(applier.get(operation.path), operation.value)) {
+                    applier.fail("test failed at " + pointerText(operation.path), true);
+                }
+                break;
+            }
+        }
+    } catch (const Error&) {
+        rollback(document, undo);
+        throw;
+    }
+    return edits;
+}
+
+} // namespace utils
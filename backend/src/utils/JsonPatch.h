@@ -0,0 +1,66 @@
+#pragma once
+#include <json/json.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+// JSON Patch (RFC 6902) поверх jsoncpp: add, remove, replace, move, copy, test
+// с путями JSON Pointer (RFC 6901). Кроме самого применения возвращает правки
+// в виде, который повторяется в базе через jsonb_set / jsonb_insert / #-,
+// так что сохранять документ целиком не нужно.
+class JsonPatch {
+public:
+    // Примитивная правка после разбора операций: индексы массивов уже
+    // конкретные ("-" заменен на длину массива), move - это Remove и вставка
+    struct Edit {
+        enum class Kind {
+            // Заменить или создать член объекта / заменить элемент массива
+            Set,
+            // Вставить в массив перед элементом path (индекс = длина - в конец)
+            Insert,
+            Remove
+        };
+        Kind kind = Kind::Set;
+        std::vector<std::string> path;
+        Json::Value value;
+    };
+
+    // Ошибка операции index: conflict - не прошел test (документ не тот, что
+    // ожидал клиент), иначе операция неприменима к документу
+    class Error : public std::runtime_error {
+    public:
+        Error(size_t index, bool conflict, const std::string& message)
+            : std::runtime_error("Operation " + std::to_string(index) + ": " + message),
+              index(index), conflict(conflict) {}
+        size_t index;
+        bool conflict;
+    };
+
+    // Бросает Error, если операция записана неверно (нет op, path, value)
+    explicit JsonPatch(const Json::Value& operations);
+
+    size_t size() const { return operations.size(); }
+
+    // Все операции по порядку над document; при ошибке бросает Error, а
+    // document остается прежним
+    std::vector<Edit> apply(Json::Value& document) const;
+
+    // "/a/b~1c" -> {"a", "b/c"}; пустая строка - весь документ
+    static std::vector<std::string> parsePointer(const std::string& pointer);
+
+private:
+    enum class Op { Add, Remove, Replace, Move, Copy, Test };
+
+    struct Operation {
+        Op op;
+        std::vector<std::string> path;
+        std::vector<std::string> from;
+        Json::Value value;
+    };
+
+    std::vector<Operation> operations;
+};
+
+} // namespace utils
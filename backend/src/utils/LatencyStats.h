@@ -0,0 +1,39 @@
+#pragma once
+#include <json/json.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace utils {
+
+// Счётчик длительностей без блокировок: число замеров, среднее и максимум
+class LatencyStats {
+public:
+    void record(std::chrono::steady_clock::duration elapsed) {
+        uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        ++count;
+        totalMicros += micros;
+        uint64_t currentMax = maxMicros.load(std::memory_order_relaxed);
+        while (micros > currentMax &&
+               !maxMicros.compare_exchange_weak(currentMax, micros, std::memory_order_relaxed)) {
+        }
+    }
+
+    uint64_t samples() const { return count.load(); }
+
+    Json::Value toJson() const {
+        uint64_t samples = count.load();
+        Json::Value json;
+        json["count"] = static_cast<Json::UInt64>(samples);
+        json["avg_ms"] = samples == 0 ? 0.0 : totalMicros.load() / 1000.0 / samples;
+        json["max_ms"] = maxMicros.load() / 1000.0;
+        return json;
+    }
+
+private:
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> totalMicros{0};
+    std::atomic<uint64_t> maxMicros{0};
+};
+
+} // namespace utils
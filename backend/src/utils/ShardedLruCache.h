@@ -0,0 +1,137 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace utils {
+
+// Потокобезопасный LRU-кэш, разбитый на шарды с отдельными мьютексами,
+// чтобы IO-потоки не конкурировали за одну блокировку.
+// Без weigher capacity - число элементов; с ним - суммарный вес (например, байты),
+// элемент тяжелее шарда целиком не кэшируется
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedLruCache {
+public:
+    using Weigher = std::function<size_t(const Value&)>;
+
+    ShardedLruCache(size_t capacity, size_t shardCount = 16, Weigher weigher = nullptr)
+        : shardCapacity(std::max<size_t>(1, capacity / std::max<size_t>(1, shardCount))),
+          weigher(std::move(weigher)) {
+        shards.reserve(std::max<size_t>(1, shardCount));
+        for (size_t i = 0; i < std::max<size_t>(1, shardCount); ++i) {
+            shards.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    std::optional<Value> get(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            ++missCount;
+            return std::nullopt;
+        }
+        shard.items.splice(shard.items.begin(), shard.items, it->second);
+        ++hitCount;
+        return it->second->value;
+    }
+
+    void put(const Key& key, Value value) {
+        size_t weight = weigher ? weigher(value) : 1;
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.weight -= it->second->weight;
+            shard.items.erase(it->second);
+            shard.index.erase(it);
+        }
+        if (weight > shardCapacity) {
+            return;
+        }
+        shard.items.push_front({key, std::move(value), weight});
+        shard.index.emplace(key, shard.items.begin());
+        shard.weight += weight;
+        while (shard.weight > shardCapacity) {
+            shard.weight -= shard.items.back().weight;
+            shard.index.erase(shard.items.back().key);
+            shard.items.pop_back();
+        }
+    }
+
+    void erase(const Key& key) {
+        Shard& shard = shardFor(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.weight -= it->second->weight;
+            shard.items.erase(it->second);
+            shard.index.erase(it);
+        }
+    }
+
+    void clear() {
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->items.clear();
+            shard->index.clear();
+            shard->weight = 0;
+        }
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total += shard->items.size();
+        }
+        return total;
+    }
+
+    // Суммарный вес элементов; без weigher совпадает с size()
+    size_t weight() const {
+        size_t total = 0;
+        for (const auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            total += shard->weight;
+        }
+        return total;
+    }
+
+    uint64_t hits() const { return hitCount.load(); }
+    uint64_t misses() const { return missCount.load(); }
+
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        size_t weight;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::list<Entry> items;
+        std::unordered_map<Key, typename std::list<Entry>::iterator, Hash> index;
+        size_t weight = 0;
+    };
+
+    Shard& shardFor(const Key& key) {
+        return *shards[Hash{}(key) % shards.size()];
+    }
+
+    size_t shardCapacity;
+    Weigher weigher;
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::atomic<uint64_t> hitCount{0};
+    std::atomic<uint64_t> missCount{0};
+};
+
+} // namespace utils
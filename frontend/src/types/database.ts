@@ -20,10 +20,42 @@ export interface Column {
   };
 }
 
+export type IndexMethod = 'btree' | 'hash' | 'gin' | 'brin';
+
+export interface TableIndex {
+  name?: string;
+  columns: string[];
+  unique?: boolean;
+  method?: IndexMethod;
+  where?: string;
+}
+
+export type PartitionStrategy = 'range' | 'hash' | 'list';
+
+export interface PartitionDefinition {
+  name: string;
+  from?: string | number;
+  to?: string | number;
+  values?: Array<string | number>;
+}
+
+export interface TablePartitioning {
+  strategy: PartitionStrategy;
+  columns: string[];
+  interval?: 'day' | 'week' | 'month' | 'year';
+  premake?: number;
+  retention?: number;
+  modulus?: number;
+  default?: boolean;
+  partitions?: PartitionDefinition[];
+}
+
 export interface Table {
   id: string;
   name: string;
   columns: Column[];
+  indexes?: TableIndex[];
+  partitioning?: TablePartitioning;
   position: {
     x: number;
     y: number;